@@ -0,0 +1,379 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * app-profile-bench.c - generate a synthetic application profile
+ * configuration in a directory, then apply single edits to it the way
+ * the Application Profiles page does (duplicate, edit, validate, save,
+ * reload), and report the time taken and the number of bytes written to
+ * disk by each save.  The load time and the peak resident set size after
+ * loading are reported as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "common-utils.h"
+#include "msg.h"
+#include "app-profiles.h"
+
+typedef struct {
+    int files;
+    int megabytes;
+    int rules;
+    int profiles;
+    int edits;
+    int backup;
+    const char *dir;
+} BenchOptions;
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) < 0) {
+        return -1;
+    }
+
+    return usage.ru_maxrss;
+}
+
+
+
+/*
+ * write_config_file() - write one file of the synthetic configuration,
+ * with 'rules' rules and 'profiles' profiles of four settings each.  Like
+ * hand-written files, each rule is preceded by a comment, and some
+ * settings are written as hexadecimal integers.  Returns the size of the
+ * file, or -1 on error.
+ */
+
+static long write_config_file(const char *filename, int file,
+                              int rules, int profiles)
+{
+    FILE *fp;
+    long size;
+    int i;
+
+    fp = fopen(filename, "w");
+    if (!fp) {
+        fprintf(stderr, "Unable to create \"%s\" (%s).\n",
+                filename, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\n    \"rules\": [\n");
+    for (i = 0; i < rules; i++) {
+        fprintf(fp, "        # rule %d of file %d\n"
+                    "        {\n"
+                    "            \"pattern\": {\n"
+                    "                \"feature\": \"procname\",\n"
+                    "                \"matches\": \"bench-app-%d-%d\"\n"
+                    "            },\n"
+                    "            \"profile\": \"bench-profile-%d-%d\"\n"
+                    "        }%s\n",
+                i, file, file, i, file, profiles ? i % profiles : 0,
+                (i + 1 < rules) ? "," : "");
+    }
+    fprintf(fp, "    ],\n    \"profiles\": [\n");
+    for (i = 0; i < profiles; i++) {
+        fprintf(fp, "        {\n"
+                    "            \"name\": \"bench-profile-%d-%d\",\n"
+                    "            \"settings\": [\n"
+                    "                { \"key\": \"GLSyncToVblank\", \"value\": %d },\n"
+                    "                { \"key\": \"GLFSAAMode\", \"value\": 0x%x },\n"
+                    "                { \"key\": \"GLLogMaxAniso\", \"value\": %d },\n"
+                    "                { \"key\": \"GLThreadedOptimizations\", \"value\": true }\n"
+                    "            ]\n"
+                    "        }%s\n",
+                file, i, i & 1, i % 8, i % 5,
+                (i + 1 < profiles) ? "," : "");
+    }
+    fprintf(fp, "    ]\n}\n");
+
+    size = ftell(fp);
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Unable to write \"%s\" (%s).\n",
+                filename, strerror(errno));
+        return -1;
+    }
+
+    return size;
+}
+
+
+
+/*
+ * generate_config() - write the synthetic configuration: a directory
+ * "rc.d" in the search path with 'files' files, or with as many files as
+ * it takes to reach 'megabytes' if that is set.  Returns the total size
+ * of the files, or -1 on error.
+ */
+
+static long generate_config(BenchOptions *op)
+{
+    char *rc_d, *filename;
+    long size, total = 0;
+    int i;
+
+    rc_d = nvstrcat(op->dir, "/rc.d", NULL);
+
+    if ((mkdir(rc_d, 0777) < 0) && (errno != EEXIST)) {
+        fprintf(stderr, "Unable to create \"%s\" (%s).\n",
+                rc_d, strerror(errno));
+        nvfree(rc_d);
+        return -1;
+    }
+
+    for (i = 0; (op->megabytes > 0) ?
+                (total < op->megabytes * 1024L * 1024L) : (i < op->files);
+         i++) {
+        filename = nvasprintf("%s/%04d-bench", rc_d, i);
+        size = write_config_file(filename, i, op->rules, op->profiles);
+        nvfree(filename);
+
+        if (size < 0) {
+            total = -1;
+            break;
+        }
+        total += size;
+    }
+
+    op->files = i;
+
+    nvfree(rc_d);
+
+    return total;
+}
+
+
+
+static AppProfileConfig *load_config(const BenchOptions *op)
+{
+    char *search_path[2];
+    AppProfileConfig *config;
+
+    search_path[0] = nvstrcat(op->dir, "/rc", NULL);
+    search_path[1] = nvstrcat(op->dir, "/rc.d", NULL);
+
+    config = nv_app_profile_config_load(NULL, search_path, 2);
+
+    nvfree(search_path[0]);
+    nvfree(search_path[1]);
+
+    return config;
+}
+
+
+
+/*
+ * edit_config() - apply edit number 'edit' to 'config': even edits raise
+ * the priority of a rule, odd edits toggle a setting of a profile.
+ */
+
+static void edit_config(AppProfileConfig *config, int edit)
+{
+    size_t num_rules = nv_app_profile_config_count_rules(config);
+
+    if (((edit % 2) == 0) && (num_rules > 1)) {
+        AppProfileConfigRuleIter *iter;
+        json_t *rule;
+        int id = INVALID_RULE_ID, skip;
+
+        /* pick a rule spread over the configuration, but not the first */
+
+        skip = 1 + (edit * 7919) % (num_rules - 1);
+        for (iter = nv_app_profile_config_rule_iter(config);
+             iter; iter = nv_app_profile_config_rule_iter_next(iter)) {
+            if (skip-- == 0) {
+                rule = nv_app_profile_config_rule_iter_val(iter);
+                id = json_integer_value(json_object_get(rule, "id"));
+                free(iter);
+                break;
+            }
+        }
+
+        if (id != INVALID_RULE_ID) {
+            nv_app_profile_config_change_rule_priority(config, id, -1);
+        }
+    } else {
+        AppProfileConfigProfileIter *iter;
+        const char *name = NULL, *filename;
+        json_t *profile, *setting;
+        int skip = edit * 7919;
+
+        for (iter = nv_app_profile_config_profile_iter(config); iter; ) {
+            name = nv_app_profile_config_profile_iter_name(iter);
+            iter = nv_app_profile_config_profile_iter_next(iter);
+            if (skip-- == 0) {
+                free(iter);
+                break;
+            }
+            if (!iter) {
+                /* wrap around */
+                iter = nv_app_profile_config_profile_iter(config);
+            }
+        }
+
+        if (!name) {
+            return;
+        }
+
+        filename = nv_app_profile_config_get_profile_filename(config, name);
+        profile = json_deep_copy(nv_app_profile_config_get_profile(config,
+                                                                   name));
+        setting = json_array_get(json_object_get(profile, "settings"), 0);
+        json_object_set_new(setting, "value",
+                            json_integer(!json_integer_value(
+                                json_object_get(setting, "value"))));
+
+        nv_app_profile_config_update_profile(config, filename, name, profile);
+        json_decref(profile);
+    }
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-f FILES | -m MEGABYTES] [-r RULES] [-p PROFILES] "
+            "[-e EDITS] [-b] DIR\n\n"
+            "  -f FILES     number of files in the search path directory "
+            "(default 16)\n"
+            "  -m MEGABYTES write as many files as it takes to reach this "
+            "size\n"
+            "  -r RULES     number of rules per file (default 1000)\n"
+            "  -p PROFILES  number of profiles per file (default 1000)\n"
+            "  -e EDITS     number of edits to save (default 10)\n"
+            "  -b           back up the files before saving them\n"
+            "  DIR          empty directory to generate the configuration "
+            "in\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 16, 0, 1000, 1000, 10, 0, NULL };
+    AppProfileConfig *gold, *config;
+    json_t *updates;
+    size_t bytes, total_bytes = 0;
+    long size, rss_kb;
+    double start, load_ms, edit_ms, save_ms, total_save_ms = 0.0;
+    int c, edit, ret = 0;
+
+    while ((c = getopt(argc, argv, "f:m:r:p:e:b")) != -1) {
+        switch (c) {
+        case 'f': op.files = atoi(optarg); break;
+        case 'm': op.megabytes = atoi(optarg); break;
+        case 'r': op.rules = atoi(optarg); break;
+        case 'p': op.profiles = atoi(optarg); break;
+        case 'e': op.edits = atoi(optarg); break;
+        case 'b': op.backup = 1; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    op.dir = argv[optind];
+
+    nv_set_verbosity(NV_VERBOSITY_WARNING);
+
+    size = generate_config(&op);
+    if (size < 0) {
+        return 1;
+    }
+
+    printf("config: %d file(s), %d rule(s) and %d profile(s) each, "
+           "%ld bytes\n", op.files, op.rules, op.profiles, size);
+
+    rss_kb = peak_rss_kb();
+    start = now_ms();
+    gold = load_config(&op);
+    load_ms = now_ms() - start;
+
+    printf("load: %.3f ms, peak RSS %ld KiB (%ld KiB before loading)\n",
+           load_ms, peak_rss_kb(), rss_kb);
+
+    for (edit = 0; edit < op.edits; edit++) {
+        config = nv_app_profile_config_dup(gold);
+
+        start = now_ms();
+        edit_config(config, edit);
+        updates = nv_app_profile_config_validate(config, gold);
+        edit_ms = now_ms() - start;
+
+        bytes = config->bytes_written;
+        start = now_ms();
+        if (nv_app_profile_config_save_updates(config, updates,
+                                               op.backup, NULL) < 0) {
+            ret = 1;
+        }
+        save_ms = now_ms() - start;
+        bytes = config->bytes_written - bytes;
+
+        printf("edit %3d (%s): edit+validate %.3f ms, save %.3f ms, "
+               "%zu file(s), %zu bytes written\n",
+               edit, (edit % 2) ? "profile setting" : "rule priority",
+               edit_ms, save_ms, json_array_size(updates), bytes);
+
+        total_bytes += bytes;
+        total_save_ms += save_ms;
+
+        json_decref(updates);
+        nv_app_profile_config_free(config);
+
+        /* like the page, reload the configuration after saving */
+
+        nv_app_profile_config_free(gold);
+        gold = load_config(&op);
+    }
+
+    if (op.edits > 0) {
+        printf("average: %.3f ms, %zu bytes written per edit\n",
+               total_save_ms / op.edits, total_bytes / op.edits);
+    }
+
+    nv_app_profile_config_free(gold);
+
+    return ret;
+}
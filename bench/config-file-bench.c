@@ -0,0 +1,288 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * config-file-bench.c - generate a synthetic .nvidia-settings-rc file,
+ * parse it the way nv_read_config_file() does, and report the time
+ * taken and the number of heap allocations made by the parse.
+ *
+ * parse_config_file() is static, so config-file.c is included here
+ * rather than linked; the benchmark is linked with --gc-sections, which
+ * drops the parts of config-file.c that need an X server.  Allocations
+ * are counted by interposing malloc(), calloc() and realloc(), which
+ * forward to the glibc implementations.
+ */
+
+#include "config-file.c"
+
+typedef struct {
+    int lines;
+    int runs;
+    const char *file;
+} BenchOptions;
+
+
+static unsigned long alloc_count;
+static size_t alloc_bytes;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, nmemb * size, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+
+/*
+ * generate_rc_file() - write a configuration file of about 'lines'
+ * lines, laid out like the ones nv_write_config_file() writes: a
+ * comment header, the config properties, then integer attribute
+ * assignments spread over X screens, GPUs and display devices, with a
+ * blank line between targets.  Returns the size of the file, or -1 on
+ * error.
+ */
+
+static long generate_rc_file(const BenchOptions *op)
+{
+    const AttributeTableEntry **attrs;
+    FILE *fp;
+    long size;
+    int i, n = 0, line = 0, target = 0;
+
+    /* plain integer attributes that the config file may hold */
+
+    attrs = nvalloc(sizeof(*attrs) * attributeTableLen);
+    for (i = 0; i < attributeTableLen; i++) {
+        const AttributeTableEntry *a = &attributeTable[i];
+
+        if ((a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+            !a->flags.no_config_write &&
+            !a->f.int_flags.is_packed &&
+            !a->f.int_flags.is_display_mask &&
+            !a->f.int_flags.is_display_id &&
+            !a->f.int_flags.is_switch_display) {
+            attrs[n++] = a;
+        }
+    }
+
+    fp = fopen(op->file, "w");
+    if (!fp) {
+        fprintf(stderr, "Unable to create \"%s\" (%s).\n",
+                op->file, strerror(errno));
+        nvfree(attrs);
+        return -1;
+    }
+
+    fprintf(fp, "#\n# %s\n#\n# Configuration file for nvidia-settings - "
+                "the NVIDIA Settings utility\n#\n", op->file);
+    fprintf(fp, "\n# ConfigProperties:\n\nRcFileLocale = C\n");
+    fprintf(fp, "DisplayStatusBar = Yes\nSliderTextEntries = Yes\n");
+    fprintf(fp, "Timer = PowerMizer_Monitor_(GPU_0),Yes,1000\n");
+    fprintf(fp, "\n# Attributes:\n\n");
+    line = 16;
+
+    while (line < op->lines) {
+        const AttributeTableEntry *a = attrs[line % n];
+
+        if ((line % 64) == 0) {
+            fprintf(fp, "\n");
+            target++;
+        } else if ((target % 3) == 0) {
+            fprintf(fp, ":0.%d/%s=%d\n", target % 4, a->name, line % 7);
+        } else if ((target % 3) == 1) {
+            fprintf(fp, "[gpu:%d]/%s=%d\n", target % 32, a->name, line % 7);
+        } else {
+            fprintf(fp, "[DPY:DP-%d]/%s=%d\n", target % 128, a->name,
+                    line % 7);
+        }
+        line++;
+    }
+
+    size = ftell(fp);
+
+    nvfree(attrs);
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Unable to write \"%s\" (%s).\n",
+                op->file, strerror(errno));
+        return -1;
+    }
+
+    return size;
+}
+
+
+
+/*
+ * parse_rc_file() - map and parse the file like nv_read_config_file(),
+ * without processing the parsed attributes.  Returns the number of
+ * parsed attributes, or -1 on error.
+ */
+
+static int parse_rc_file(const BenchOptions *op, ConfigProperties *conf)
+{
+    ParsedAttributeWrapper *w;
+    struct stat stat_buf;
+    char *buf;
+    int fd, n = -1;
+
+    fd = open(op->file, O_RDONLY);
+    if (fd == -1 || fstat(fd, &stat_buf) == -1) {
+        fprintf(stderr, "Unable to open \"%s\" (%s).\n",
+                op->file, strerror(errno));
+        goto done;
+    }
+
+    buf = mmap(0, stat_buf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+               fd, 0);
+    if (buf == (void *) -1) {
+        fprintf(stderr, "Unable to mmap \"%s\" (%s).\n",
+                op->file, strerror(errno));
+        goto done;
+    }
+
+    w = parse_config_file(buf, op->file, stat_buf.st_size, conf);
+
+    munmap(buf, stat_buf.st_size);
+
+    /* only integer attributes are generated, so no value is allocated */
+
+    if (w) {
+        for (n = 0; w[n].line != -1; n++) {
+            nvfree(w[n].a.display);
+            nvfree(w[n].a.target_specification);
+        }
+        free(w);
+    }
+
+ done:
+    if (fd != -1) {
+        close(fd);
+    }
+
+    return n;
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n LINES] [-r RUNS] FILE\n\n"
+            "  -n LINES  number of lines in the file (default 100000)\n"
+            "  -r RUNS   number of times to parse it (default 5)\n"
+            "  FILE      file to generate the configuration in\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 100000, 5, NULL };
+    ConfigProperties conf;
+    unsigned long allocs;
+    size_t bytes;
+    long size;
+    double start, ms;
+    int c, run, n;
+
+    while ((c = getopt(argc, argv, "n:r:")) != -1) {
+        switch (c) {
+        case 'n': op.lines = atoi(optarg); break;
+        case 'r': op.runs = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    op.file = argv[optind];
+
+    nv_set_verbosity(NV_VERBOSITY_WARNING);
+
+    size = generate_rc_file(&op);
+    if (size < 0) {
+        return 1;
+    }
+
+    printf("config: %d line(s), %ld bytes\n", op.lines, size);
+
+    for (run = 0; run < op.runs; run++) {
+        init_config_properties(&conf);
+
+        allocs = alloc_count;
+        bytes = alloc_bytes;
+        start = now_ms();
+
+        n = parse_rc_file(&op, &conf);
+
+        ms = now_ms() - start;
+        allocs = alloc_count - allocs;
+        bytes = alloc_bytes - bytes;
+
+        setlocale(LC_NUMERIC, conf.locale);
+        free(conf.locale);
+        while (conf.timers) {
+            TimerConfigProperty *t = conf.timers;
+            conf.timers = t->next;
+            free(t->description);
+            free(t);
+        }
+
+        if (n < 0) {
+            return 1;
+        }
+
+        printf("parse: %d attribute(s), %.3f ms, %lu allocation(s), "
+               "%zu bytes allocated\n", n, ms, allocs, bytes);
+    }
+
+    return 0;
+}
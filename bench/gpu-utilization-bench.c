@@ -0,0 +1,315 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * gpu-utilization-bench.c - sample the utilization of a GPU SAMPLES times
+ * as the GPU monitor does on each tick, once through the
+ * NV_CTRL_STRING_GPU_UTILIZATION string and once through the
+ * NV_CTRL_BINARY_DATA_GPU_UTILIZATION structure, and report the time
+ * taken per sample by each.
+ *
+ * Both are queried from the NVML backend, with the NVML functions it
+ * calls answered by this program, so that only the cost of formatting
+ * and parsing the values is measured.  The string is parsed with
+ * parse_token_value_pairs(), as the GPU page did.  The string reported by
+ * the X driver is then parsed both that way and the way the NV-CONTROL
+ * backend fills the structure.  The values returned by each are checked
+ * against each other.
+ *
+ * The backend functions are static, so NvCtrlAttributesNvml.c and
+ * NvCtrlAttributesNvControl.c are included here rather than linked; the
+ * benchmark is linked with --gc-sections, which drops the rest of them.
+ */
+
+#include "libXNVCtrlAttributes/NvCtrlAttributesNvml.c"
+#include "libXNVCtrlAttributes/NvCtrlAttributesNvControl.c"
+
+#include <time.h>
+
+typedef struct {
+    int samples;
+    int runs;
+} BenchOptions;
+
+static unsigned int sample_count;
+
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+
+
+/*
+ * The NVML functions called for the utilization; every call returns
+ * different values.
+ */
+
+static nvmlReturn_t stub_get_handle_by_index(unsigned int index,
+                                             nvmlDevice_t *device)
+{
+    *device = (nvmlDevice_t) (uintptr_t) (index + 1);
+    return NVML_SUCCESS;
+}
+
+static nvmlReturn_t stub_get_utilization_rates(nvmlDevice_t device,
+                                               nvmlUtilization_t *util)
+{
+    sample_count++;
+    util->gpu = sample_count % 101;
+    util->memory = (sample_count * 7) % 101;
+    return NVML_SUCCESS;
+}
+
+
+
+/*
+ * apply_utilization_token() - the token callback the GPU page used to
+ * parse the utilization string with.
+ */
+
+static void apply_utilization_token(char *token, char *value, void *data)
+{
+    CtrlGpuUtilization *util = data;
+
+    if (!strcasecmp("graphics", token)) {
+        util->graphics = atoi(value);
+        util->valid |= CTRL_GPU_UTILIZATION_GRAPHICS;
+    } else if (!strcasecmp("memory", token)) {
+        util->memory = atoi(value);
+        util->valid |= CTRL_GPU_UTILIZATION_MEMORY;
+    } else if (!strcasecmp("video", token)) {
+        util->video = atoi(value);
+        util->valid |= CTRL_GPU_UTILIZATION_VIDEO;
+    } else if (!strcasecmp("pcie", token)) {
+        util->pcie = atoi(value);
+        util->valid |= CTRL_GPU_UTILIZATION_PCIE;
+    }
+}
+
+
+
+static int same_utilization(const CtrlGpuUtilization *a,
+                            const CtrlGpuUtilization *b)
+{
+    return a->valid == b->valid &&
+           a->graphics == b->graphics && a->memory == b->memory &&
+           a->video == b->video && a->pcie == b->pcie;
+}
+
+
+
+/*
+ * sample_string() and sample_binary() - query the utilization through
+ * the NVML backend as a string and parse it, or as a structure.  Return
+ * NV_TRUE on success.
+ */
+
+static int sample_string(const CtrlTarget *t, CtrlGpuUtilization *util)
+{
+    char *str;
+
+    if (NvCtrlNvmlGetGPUStringAttribute(t, NV_CTRL_STRING_GPU_UTILIZATION,
+                                        &str) != NvCtrlSuccess) {
+        return NV_FALSE;
+    }
+
+    memset(util, 0, sizeof(*util));
+    parse_token_value_pairs(str, apply_utilization_token, util);
+    free(str);
+
+    return NV_TRUE;
+}
+
+static int sample_binary(const CtrlTarget *t, CtrlGpuUtilization *util)
+{
+    unsigned char *data;
+    int len;
+
+    if (NvCtrlNvmlGetGPUBinaryAttribute(t, NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                                        &data, &len) != NvCtrlSuccess ||
+        len != sizeof(CtrlGpuUtilization)) {
+        return NV_FALSE;
+    }
+
+    *util = *(CtrlGpuUtilization *) data;
+    nvfree(data);
+
+    return NV_TRUE;
+}
+
+
+
+/*
+ * time_nvml() - sample the utilization op->samples times with 'func',
+ * and return the mean time taken per sample, in nanoseconds, or -1 if a
+ * sample failed.  The values of the last sample are returned in 'last'.
+ */
+
+static double time_nvml(const BenchOptions *op, const CtrlTarget *t,
+                        int (*func)(const CtrlTarget *, CtrlGpuUtilization *),
+                        CtrlGpuUtilization *last)
+{
+    double start;
+    int i;
+
+    sample_count = 0;
+    start = now_ns();
+
+    for (i = 0; i < op->samples; i++) {
+        if (!func(t, last)) {
+            return -1.0;
+        }
+    }
+
+    return (now_ns() - start) / op->samples;
+}
+
+
+
+/*
+ * time_x_string() - parse the utilization string reported by the X
+ * driver op->samples times, copying it first as it is copied out of the
+ * X reply, either with parse_token_value_pairs() or with
+ * ParseGpuUtilization().  Returns the mean time taken per parse, in
+ * nanoseconds.
+ */
+
+static double time_x_string(const BenchOptions *op, const char *str,
+                            int tokens, CtrlGpuUtilization *last)
+{
+    double start;
+    char *tmp;
+    int i;
+
+    start = now_ns();
+
+    for (i = 0; i < op->samples; i++) {
+        tmp = strdup(str);
+        memset(last, 0, sizeof(*last));
+        if (tokens) {
+            parse_token_value_pairs(tmp, apply_utilization_token, last);
+        } else {
+            ParseGpuUtilization(tmp, last);
+        }
+        free(tmp);
+    }
+
+    return (now_ns() - start) / op->samples;
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n SAMPLES] [-r RUNS]\n\n"
+            "  -n SAMPLES  number of samples per run (default 1000000)\n"
+            "  -r RUNS     number of runs (default 5)\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    static const char x_string[] =
+        "graphics=42, memory=17, video=3, PCIe=8";
+    BenchOptions op = { 1000000, 5 };
+    NvCtrlNvmlContext ctx;
+    NvCtrlNvmlAttributes nvml;
+    NvCtrlAttributePrivateHandle h;
+    CtrlSystem system;
+    CtrlTarget target;
+    CtrlGpuUtilization a, b;
+    double string_ns, binary_ns;
+    int c, run;
+
+    while ((c = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (c) {
+        case 'n': op.samples = atoi(optarg); break;
+        case 'r': op.runs = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc || op.samples < 1 || op.runs < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* a GPU of a system without NV-CONTROL, queried through NVML */
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.lib.DeviceGetHandleByIndex = stub_get_handle_by_index;
+    ctx.lib.DeviceGetUtilizationRates = stub_get_utilization_rates;
+
+    memset(&nvml, 0, sizeof(nvml));
+    nvml.ctx = &ctx;
+
+    memset(&h, 0, sizeof(h));
+    h.target_type = GPU_TARGET;
+    h.nvml = &nvml;
+
+    memset(&system, 0, sizeof(system));
+    system.has_nvml = True;
+
+    memset(&target, 0, sizeof(target));
+    target.h = (NvCtrlAttributeHandle *) &h;
+    target.system = &system;
+
+    printf("utilization: %d sample(s) per run, %d run(s)\n",
+           op.samples, op.runs);
+
+    for (run = 0; run < op.runs; run++) {
+        string_ns = time_nvml(&op, &target, sample_string, &a);
+        binary_ns = time_nvml(&op, &target, sample_binary, &b);
+
+        if (string_ns < 0.0 || binary_ns < 0.0) {
+            fprintf(stderr, "Unable to query the utilization.\n");
+            return 1;
+        }
+        if (!same_utilization(&a, &b)) {
+            fprintf(stderr, "The string and the structure differ.\n");
+            return 1;
+        }
+
+        printf("nvml: string %.1f ns/sample, structure %.1f ns/sample "
+               "(%.1fx)\n", string_ns, binary_ns,
+               (binary_ns > 0.0) ? string_ns / binary_ns : 0.0);
+
+        string_ns = time_x_string(&op, x_string, NV_TRUE, &a);
+        binary_ns = time_x_string(&op, x_string, NV_FALSE, &b);
+
+        if (!same_utilization(&a, &b)) {
+            fprintf(stderr, "The parsed X driver strings differ.\n");
+            return 1;
+        }
+
+        printf("x:    tokens %.1f ns/parse, in place %.1f ns/parse "
+               "(%.1fx)\n", string_ns, binary_ns,
+               (binary_ns > 0.0) ? string_ns / binary_ns : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * graph-redraw-bench.c - record synthetic ticks of the GPU monitor into
+ * the histories of a CtkEvent, as ctk_event_sample() does, and bring
+ * GRAPHS graphs up to date after each tick, as the graphs of the GPU,
+ * PowerMizer and thermal pages do while they are shown.  This is done
+ * twice: once scrolling each graph and plotting only the new tick, and
+ * once replotting the whole history on every tick.  Reports the time
+ * taken per tick by each, and the number of pixels in which the final
+ * plots differ.
+ *
+ * The history and plotting functions are static, so ctkevent.c and
+ * ctkgraph.c are included here rather than linked, and no widget is
+ * created; the benchmark is linked with --gc-sections, which drops the
+ * widget and X event code.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include "gtk+-2.x/ctkevent.c"
+#include "gtk+-2.x/ctkgraph.c"
+
+#include "common-utils.h"
+
+typedef struct {
+    int graphs;
+    int ticks;
+    int width;
+    int height;
+    int runs;
+} BenchOptions;
+
+/* a CtkEvent sampling one integer attribute per graph */
+
+typedef struct {
+    CtkEvent event;
+    CtkEventSample *samples;
+    CtkGraph *graphs;
+    int n;
+} GraphSet;
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+
+
+/*
+ * create_graph_set() - create 'op->graphs' histories, each recorded from
+ * a sample of its own, and a graph of 0-100 plotting each of them into a
+ * surface of op->width by op->height pixels.
+ */
+
+static GraphSet *create_graph_set(const BenchOptions *op)
+{
+    GraphSet *set = nvalloc(sizeof(GraphSet));
+    int i;
+
+    set->n = op->graphs;
+    set->samples = nvalloc(sizeof(CtkEventSample) * set->n);
+    set->graphs = nvalloc(sizeof(CtkGraph) * set->n);
+
+    for (i = 0; i < set->n; i++) {
+        CtkEventHistory *history;
+        CtkGraph *graph = &set->graphs[i];
+
+        history = ctk_event_add_history(&set->event, NULL, i,
+                                        CTRL_ATTRIBUTE_TYPE_INTEGER, 0);
+
+        set->samples[i].attribute = i;
+        set->samples[i].type = CTRL_ATTRIBUTE_TYPE_INTEGER;
+        history->sample = &set->samples[i];
+
+        graph->ctk_event = &set->event;
+        graph->history = history;
+        graph->lower = 0;
+        graph->upper = 100;
+        graph->width = op->width;
+        graph->height = op->height;
+        graph->c_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                      op->width,
+                                                      op->height);
+    }
+
+    return set;
+}
+
+
+
+static void free_graph_set(GraphSet *set)
+{
+    CtkEventHistory *history;
+    CtkEventSample *sample;
+    int i;
+
+    for (i = 0; i < set->n; i++) {
+        cairo_surface_destroy(set->graphs[i].c_surface);
+    }
+
+    while (set->event.histories) {
+        history = set->event.histories;
+        set->event.histories = history->next;
+        g_free(history->values);
+        g_free(history);
+    }
+
+    /* the samples registered by ctk_event_add_history() */
+
+    while (set->event.samples) {
+        sample = set->event.samples;
+        set->event.samples = sample->next;
+        g_free(sample);
+    }
+
+    nvfree(set->graphs);
+    nvfree(set->samples);
+    nvfree(set);
+}
+
+
+
+/*
+ * sample_tick() - set the samples to the synthetic values of the given
+ * tick, and record them into the histories.  Every 97th sample fails, to
+ * break the plotted lines as a failed query does.
+ */
+
+static void sample_tick(GraphSet *set, int tick)
+{
+    int i;
+
+    for (i = 0; i < set->n; i++) {
+        CtkEventSample *sample = &set->samples[i];
+
+        sample->sampled = TRUE;
+        sample->status = ((tick + i) % 97 == 0) ?
+            NvCtrlAttributeNotAvailable : NvCtrlSuccess;
+        sample->value = (tick * 7 + i * 13) % 91 + (tick / 5 + i) % 10;
+    }
+
+    record_histories(&set->event);
+}
+
+
+
+/*
+ * replay_ticks() - record op->ticks ticks, bringing every graph up to
+ * date after each one; if 'replot' is set, each graph is replotted as a
+ * whole, as when its surface is new.  Returns the mean time taken per
+ * tick, in microseconds.
+ */
+
+static double replay_ticks(const BenchOptions *op, GraphSet *set,
+                           int replot)
+{
+    double start, total = 0.0;
+    int tick, i;
+
+    for (tick = 0; tick < op->ticks; tick++) {
+        sample_tick(set, tick);
+
+        start = now_us();
+
+        for (i = 0; i < set->n; i++) {
+            if (replot) {
+                set->graphs[i].serial = 0;
+            }
+            update(&set->graphs[i]);
+        }
+
+        total += now_us() - start;
+    }
+
+    return total / op->ticks;
+}
+
+
+
+/*
+ * count_differences() - the number of pixels that differ between the
+ * plots of the two graph sets.
+ */
+
+static long count_differences(GraphSet *a, GraphSet *b)
+{
+    long differences = 0;
+    int i, x, y;
+
+    for (i = 0; i < a->n; i++) {
+        cairo_surface_t *sa = a->graphs[i].c_surface;
+        cairo_surface_t *sb = b->graphs[i].c_surface;
+        unsigned char *da, *db;
+        int stride;
+
+        cairo_surface_flush(sa);
+        cairo_surface_flush(sb);
+
+        da = cairo_image_surface_get_data(sa);
+        db = cairo_image_surface_get_data(sb);
+        stride = cairo_image_surface_get_stride(sa);
+
+        for (y = 0; y < a->graphs[i].height; y++) {
+            guint32 *pa = (guint32 *) (da + y * stride);
+            guint32 *pb = (guint32 *) (db + y * stride);
+
+            for (x = 0; x < a->graphs[i].width; x++) {
+                /* the high byte of RGB24 pixels is unused */
+                if ((pa[x] ^ pb[x]) & 0x00ffffff) {
+                    differences++;
+                }
+            }
+        }
+    }
+
+    return differences;
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-g GRAPHS] [-t TICKS] [-w WIDTH] [-y HEIGHT] "
+            "[-r RUNS]\n\n"
+            "  -g GRAPHS  number of graphs shown (default 4)\n"
+            "  -t TICKS   number of ticks to record (default 3000)\n"
+            "  -w WIDTH   width of the graphs (default %d)\n"
+            "  -y HEIGHT  height of the graphs (default %d)\n"
+            "  -r RUNS    number of times to replay the ticks (default 5)\n",
+            argv0, REQUESTED_WIDTH, REQUESTED_HEIGHT);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 4, 3000, REQUESTED_WIDTH, REQUESTED_HEIGHT, 5 };
+    GraphSet *incremental, *replotted;
+    double inc_us, replot_us;
+    long differences;
+    int c, run;
+
+    while ((c = getopt(argc, argv, "g:t:w:y:r:h")) != -1) {
+        switch (c) {
+        case 'g': op.graphs = atoi(optarg); break;
+        case 't': op.ticks = atoi(optarg); break;
+        case 'w': op.width = atoi(optarg); break;
+        case 'y': op.height = atoi(optarg); break;
+        case 'r': op.runs = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc || op.graphs < 1 || op.ticks < 1 ||
+        op.width <= STEP || op.height < 2 || op.runs < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("graphs: %d of %dx%d pixels, %d tick(s), %d tick(s) visible\n",
+           op.graphs, op.width, op.height, op.ticks,
+           NV_MIN(op.width / STEP + 1, CTK_EVENT_HISTORY_LENGTH));
+
+    for (run = 0; run < op.runs; run++) {
+        incremental = create_graph_set(&op);
+        replotted = create_graph_set(&op);
+
+        inc_us = replay_ticks(&op, incremental, FALSE);
+        replot_us = replay_ticks(&op, replotted, TRUE);
+
+        differences = count_differences(incremental, replotted);
+
+        printf("update: scroll %.2f us/tick, replot %.2f us/tick (%.1fx), "
+               "%ld pixel(s) differ\n", inc_us, replot_us,
+               (inc_us > 0.0) ? replot_us / inc_us : 0.0, differences);
+
+        free_graph_set(replotted);
+        free_graph_set(incremental);
+    }
+
+    return 0;
+}
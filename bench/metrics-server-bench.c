@@ -0,0 +1,378 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * metrics-server-bench.c - scrape the metrics server used by --serve from
+ * several clients at once, for DURATION_MS, while a sampling thread
+ * publishes new metrics, and report the scrape latencies.
+ *
+ * The sampling thread stands in for the driver queries of --serve: each
+ * sample takes SAMPLE_MS, after which the metrics of GPUS GPUs are
+ * rendered in the Prometheus text format and published.  Since scrapes
+ * are answered from the last published sample, their latency should not
+ * depend on SAMPLE_MS.
+ *
+ * The benchmark is linked with --gc-sections, which drops the parts of
+ * metrics-server.c that query attributes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "common-utils.h"
+#include "msg.h"
+#include "metrics-server.h"
+
+typedef struct {
+    int clients;
+    int duration_ms;
+    int sample_ms;
+    int gpus;
+    const char *dir;
+} BenchOptions;
+
+typedef struct {
+    const BenchOptions *op;
+    MetricsServer *server;
+    int stop;
+    int samples;
+} SampleThread;
+
+typedef struct {
+    const BenchOptions *op;
+    const char *path;
+    double *latencies;
+    int scrapes;
+    int failed;
+} ClientThread;
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+
+/*
+ * render_metrics() - render sample number 'sample' of the metrics of
+ * 'gpus' GPUs, like --serve does with its default attributes.  Returns
+ * a malloc()ed string, and its length in '*len'.
+ */
+
+static char *render_metrics(int gpus, int sample, size_t *len)
+{
+    static const char *metrics[] = {
+        "gpu_core_temp", "gpu_current_fan_speed_rpm",
+        "gpu_current_clock_freqs", "gpu_utilization",
+        "used_dedicated_gpu_memory", "gpu_current_power_draw",
+    };
+    char *text = NULL;
+    FILE *out;
+    int i, j;
+
+    out = open_memstream(&text, len);
+    if (!out) {
+        return NULL;
+    }
+
+    for (i = 0; i < ARRAY_LEN(metrics); i++) {
+        fprintf(out, "# HELP nvidia_settings_%s Synthetic metric.\n"
+                     "# TYPE nvidia_settings_%s gauge\n",
+                metrics[i], metrics[i]);
+        for (j = 0; j < gpus; j++) {
+            fprintf(out, "nvidia_settings_%s{target=\"gpu\",id=\"%d\","
+                         "uuid=\"GPU-%08x-0000-0000-0000-000000000000\"} "
+                         "%d\n", metrics[i], j, j, (sample + i * j) % 100);
+        }
+    }
+
+    fprintf(out, "nvidia_settings_last_sample_timestamp_seconds %d.000\n",
+            sample);
+
+    if (fclose(out) != 0) {
+        free(text);
+        return NULL;
+    }
+
+    return text;
+}
+
+
+
+/*
+ * sample_thread() - publish a new sample every op->sample_ms
+ * milliseconds, sleeping in between as --serve does while it queries the
+ * driver, until told to stop.
+ */
+
+static void *sample_thread(void *data)
+{
+    SampleThread *t = data;
+    struct timespec delay;
+    char *text;
+    size_t len;
+
+    delay.tv_sec = t->op->sample_ms / 1000;
+    delay.tv_nsec = (t->op->sample_ms % 1000) * 1000000;
+
+    while (!__atomic_load_n(&t->stop, __ATOMIC_ACQUIRE)) {
+        nanosleep(&delay, NULL);
+
+        text = render_metrics(t->op->gpus, ++t->samples, &len);
+        if (text) {
+            nv_metrics_server_publish(t->server, text, len);
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * scrape() - request the metrics at the UNIX domain socket 'path' and
+ * read the whole response.  Returns NV_TRUE if it was successful.
+ */
+
+static int scrape(const char *path)
+{
+    static const char request[] =
+        "GET /metrics HTTP/1.0\r\nAccept: text/plain\r\n\r\n";
+    struct sockaddr_un addr;
+    char buf[65536], status[16];
+    size_t got = 0;
+    ssize_t n;
+    int fd, ret = NV_FALSE;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return NV_FALSE;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+        write(fd, request, sizeof(request) - 1) !=
+        (ssize_t) (sizeof(request) - 1)) {
+        goto done;
+    }
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (got < sizeof(status)) {
+            memcpy(status + got, buf,
+                   NV_MIN(sizeof(status) - got, (size_t) n));
+        }
+        got += n;
+    }
+
+    ret = (n == 0 && got >= sizeof(status) &&
+           strncmp(status, "HTTP/1.0 200", 12) == 0);
+
+ done:
+    close(fd);
+
+    return ret;
+}
+
+
+
+/*
+ * client_thread() - scrape the metrics back to back for op->duration_ms
+ * milliseconds, recording the latency of each scrape.
+ */
+
+static void *client_thread(void *data)
+{
+    ClientThread *t = data;
+    double start, end;
+    int max = 0;
+
+    end = now_ms() + t->op->duration_ms;
+
+    while ((start = now_ms()) < end) {
+        if (!scrape(t->path)) {
+            t->failed++;
+        }
+        if (t->scrapes == max) {
+            max = NV_MAX(max * 2, 1024);
+            t->latencies = nvrealloc(t->latencies, sizeof(double) * max);
+        }
+        t->latencies[t->scrapes++] = now_ms() - start;
+    }
+
+    return NULL;
+}
+
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-c CLIENTS] [-d DURATION_MS] [-s SAMPLE_MS] "
+            "[-g GPUS] DIR\n\n"
+            "  -c CLIENTS      number of concurrent clients (default 8)\n"
+            "  -d DURATION_MS  time to scrape for (default 2000)\n"
+            "  -s SAMPLE_MS    time taken by each sample (default 250)\n"
+            "  -g GPUS         number of GPUs in the metrics (default 8)\n"
+            "  DIR             directory to create the socket in\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 8, 2000, 250, 8, NULL };
+    SampleThread sampler;
+    ClientThread *clients;
+    pthread_t sample_tid, *client_tids;
+    MetricsServer *server;
+    char *address, *text;
+    double *latencies, start, ms;
+    int c, i, total = 0, failed = 0;
+    size_t len;
+
+    while ((c = getopt(argc, argv, "c:d:s:g:")) != -1) {
+        switch (c) {
+        case 'c': op.clients = atoi(optarg); break;
+        case 'd': op.duration_ms = atoi(optarg); break;
+        case 's': op.sample_ms = atoi(optarg); break;
+        case 'g': op.gpus = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc - 1 || op.clients < 1 || op.duration_ms < 1 ||
+        op.sample_ms < 0 || op.gpus < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    op.dir = argv[optind];
+
+    address = nvstrcat("unix:", op.dir, "/metrics.sock", NULL);
+
+    server = nv_metrics_server_start(address);
+    if (!server) {
+        return 1;
+    }
+
+    text = render_metrics(op.gpus, 0, &len);
+    if (!text) {
+        fprintf(stderr, "Unable to render the metrics.\n");
+        return 1;
+    }
+    nv_metrics_server_publish(server, text, len);
+
+    printf("metrics: %d GPU(s), %zu bytes, a sample every %d ms\n",
+           op.gpus, len, op.sample_ms);
+
+    memset(&sampler, 0, sizeof(sampler));
+    sampler.op = &op;
+    sampler.server = server;
+    if (pthread_create(&sample_tid, NULL, sample_thread, &sampler) != 0) {
+        fprintf(stderr, "Unable to create the sampling thread.\n");
+        return 1;
+    }
+
+    clients = nvalloc(sizeof(ClientThread) * op.clients);
+    client_tids = nvalloc(sizeof(pthread_t) * op.clients);
+
+    start = now_ms();
+
+    for (i = 0; i < op.clients; i++) {
+        clients[i].op = &op;
+        clients[i].path = address + strlen("unix:");
+        if (pthread_create(&client_tids[i], NULL, client_thread,
+                           &clients[i]) != 0) {
+            fprintf(stderr, "Unable to create client thread %d.\n", i);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < op.clients; i++) {
+        pthread_join(client_tids[i], NULL);
+    }
+
+    ms = now_ms() - start;
+
+    __atomic_store_n(&sampler.stop, NV_TRUE, __ATOMIC_RELEASE);
+    pthread_join(sample_tid, NULL);
+
+    nv_metrics_server_stop(server);
+
+    for (i = 0; i < op.clients; i++) {
+        total += clients[i].scrapes;
+    }
+    latencies = nvalloc(sizeof(double) * NV_MAX(total, 1));
+    for (i = 0, total = 0; i < op.clients; i++) {
+        memcpy(latencies + total, clients[i].latencies,
+               sizeof(double) * clients[i].scrapes);
+        total += clients[i].scrapes;
+        failed += clients[i].failed;
+        nvfree(clients[i].latencies);
+    }
+
+    if (total == 0) {
+        fprintf(stderr, "No scrapes were made.\n");
+        return 1;
+    }
+
+    qsort(latencies, total, sizeof(double), compare_doubles);
+
+    printf("scrapes: %d by %d client(s) in %.1f ms, %d sample(s) "
+           "published\n", total, op.clients, ms, sampler.samples);
+    printf("latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           latencies[total / 2], latencies[(total * 99) / 100],
+           latencies[total - 1]);
+
+    nvfree(client_tids);
+    nvfree(clients);
+    nvfree(latencies);
+    nvfree(address);
+
+    if (failed) {
+        fprintf(stderr, "%d scrape(s) failed.\n", failed);
+        return 1;
+    }
+
+    return 0;
+}
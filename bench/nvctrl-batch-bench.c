@@ -0,0 +1,603 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * nvctrl-batch-bench.c - query NV-CONTROL attribute values and valid
+ * values one at a time and in batches, against a stub X server running
+ * in a thread of this process, and report the time taken and the number
+ * of round trips each needed.
+ *
+ * The stub server only implements what the queries need: the connection
+ * setup, GetProperty (for the resource database, which it reports as
+ * empty), GetInputFocus (for XSync()), QueryExtension, and the NV-CONTROL
+ * QueryExtension, QueryAttribute and QueryValidAttributeValues requests.
+ * It reports NV-CONTROL 1.20, so that 32-bit requests are used.  Each
+ * time it has read requests that need replies, it waits for the
+ * simulated network latency before replying, and counts a round trip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xmd.h>
+
+#include "NVCtrl.h"
+#include "NVCtrlLib.h"
+#include "nv_control.h"
+
+#define STUB_DISPLAY_FIRST 1000
+#define STUB_DISPLAY_LAST  1099
+#define STUB_NVCTRL_OPCODE 128
+
+#define X_GetProperty    20
+#define X_GetInputFocus  43
+#define X_QueryExtension 98
+
+typedef struct {
+    int targets;
+    int attributes;
+    int latency_us;
+    int runs;
+} BenchOptions;
+
+typedef struct {
+    int listen_fd;
+    int latency_us;
+    char path[64];
+
+    pthread_mutex_t lock;
+    unsigned long round_trips;
+    unsigned long requests;
+} StubServer;
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void put16(unsigned char *p, unsigned int v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    put16(p, v & 0xffff);
+    put16(p + 2, v >> 16);
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int get32(const unsigned char *p)
+{
+    return get16(p) | (get16(p + 2) << 16);
+}
+
+
+
+/*
+ * The value and valid values the stub server reports for attribute
+ * 'attr' of target 'id'.  Odd attributes of odd targets do not exist.
+ */
+
+static int stub_exists(int id, int attr)
+{
+    return !((id & 1) && (attr & 1));
+}
+
+static int stub_value(int id, int attr)
+{
+    return id * 100000 + attr;
+}
+
+
+
+static int write_all(int fd, const unsigned char *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    return 1;
+}
+
+
+
+/*
+ * stub_setup() - read the connection setup request and send a setup reply
+ * describing a single 640x480 screen.
+ */
+
+static int stub_setup(int fd)
+{
+    static const char vendor[] = "nvctrl-batch-bench";
+    unsigned char req[12], reply[512];
+    size_t vendor_len = sizeof(vendor) - 1, vendor_pad, len;
+    unsigned char *p;
+    size_t got = 0;
+    ssize_t n;
+
+    /* byte order, protocol version and empty authorization */
+
+    while (got < sizeof(req)) {
+        n = read(fd, req + got, sizeof(req) - got);
+        if (n <= 0) {
+            return 0;
+        }
+        got += n;
+    }
+
+    if (req[0] != 'l') {
+        return 0; /* the replies below are little endian */
+    }
+
+    vendor_pad = (vendor_len + 3) & ~3;
+
+    memset(reply, 0, sizeof(reply));
+    p = reply + 8;
+
+    put32(p + 4, 0x00200000);     /* resource id base */
+    put32(p + 8, 0x001fffff);     /* resource id mask */
+    put16(p + 16, vendor_len);
+    put16(p + 18, 65535);         /* maximum request length */
+    p[20] = 1;                    /* screens */
+    p[21] = 1;                    /* pixmap formats */
+    p[24] = 32;                   /* bitmap scanline unit */
+    p[25] = 32;                   /* bitmap scanline pad */
+    p[26] = 8;                    /* min keycode */
+    p[27] = 255;                  /* max keycode */
+    memcpy(p + 32, vendor, vendor_len);
+    p += 32 + vendor_pad;
+
+    p[0] = 24;                    /* format: depth, bpp, scanline pad */
+    p[1] = 32;
+    p[2] = 32;
+    p += 8;
+
+    put32(p, 0x20);               /* root window */
+    put32(p + 4, 0x21);           /* default colormap */
+    put16(p + 20, 640);
+    put16(p + 22, 480);
+    put16(p + 24, 160);
+    put16(p + 26, 120);
+    put16(p + 28, 1);             /* min installed maps */
+    put16(p + 30, 1);             /* max installed maps */
+    put32(p + 32, 0x22);          /* root visual */
+    p[38] = 24;                   /* root depth */
+    p[39] = 1;                    /* allowed depths */
+    p += 40;
+
+    p[0] = 24;                    /* depth, without visuals */
+    p += 8;
+
+    len = p - reply;
+
+    reply[0] = 1;                 /* success */
+    put16(reply + 2, 11);         /* protocol major version */
+    put16(reply + 6, (len - 8) / 4);
+
+    return write_all(fd, reply, len);
+}
+
+
+
+/*
+ * stub_reply() - fill in 'reply' with the reply to the request 'req' of
+ * sequence number 'seq'.  Returns 0 if the request has no reply.
+ */
+
+static int stub_reply(const unsigned char *req, unsigned int seq,
+                      unsigned char *reply)
+{
+    unsigned int id, attr;
+
+    memset(reply, 0, 32);
+    reply[0] = 1;
+    put16(reply + 2, seq);
+
+    if (req[0] == X_QueryExtension) {
+        unsigned int len = get16(req + 4);
+
+        if (len == strlen(NV_CONTROL_NAME) &&
+            memcmp(req + 8, NV_CONTROL_NAME, len) == 0) {
+            reply[8] = 1;                     /* present */
+            reply[9] = STUB_NVCTRL_OPCODE;    /* major opcode */
+            reply[10] = 64;                   /* first event */
+            reply[11] = 128;                  /* first error */
+        }
+        return 1;
+    }
+
+    if (req[0] == X_GetProperty || req[0] == X_GetInputFocus) {
+        return 1;
+    }
+
+    if (req[0] != STUB_NVCTRL_OPCODE) {
+        return 0;
+    }
+
+    id = get16(req + 4);
+    attr = get32(req + 12);
+
+    switch (req[1]) {
+    case X_nvCtrlQueryExtension:
+        put16(reply + 8, 1);
+        put16(reply + 10, 20);
+        return 1;
+
+    case X_nvCtrlQueryAttribute:
+        if (stub_exists(id, attr)) {
+            put32(reply + 8, 1);
+            put32(reply + 12, stub_value(id, attr));
+        }
+        return 1;
+
+    case X_nvCtrlQueryValidAttributeValues:
+        if (stub_exists(id, attr)) {
+            put32(reply + 8, 1);
+            put32(reply + 12, ATTRIBUTE_TYPE_RANGE);
+            put32(reply + 16, 0);
+            put32(reply + 20, stub_value(id, attr));
+            put32(reply + 28, ATTRIBUTE_TYPE_READ);
+        }
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+
+
+/*
+ * stub_serve() - answer the requests of one client until it disconnects.
+ */
+
+static void stub_serve(StubServer *server, int fd)
+{
+    unsigned char *in, *out;
+    size_t in_size = 1 << 20, in_len = 0, out_len, used, len;
+    unsigned int seq = 0;
+    struct timespec latency;
+    ssize_t n;
+
+    if (!stub_setup(fd)) {
+        return;
+    }
+
+    in = malloc(in_size);
+    out = malloc(in_size * 8);
+    if (!in || !out) {
+        goto done;
+    }
+
+    latency.tv_sec = server->latency_us / 1000000;
+    latency.tv_nsec = (server->latency_us % 1000000) * 1000;
+
+    while ((n = read(fd, in + in_len, in_size - in_len)) > 0) {
+        unsigned long requests = 0;
+
+        in_len += n;
+        out_len = 0;
+
+        for (used = 0; in_len - used >= 4; used += len) {
+            len = get16(in + used + 2) * 4;
+            if (len == 0 || in_len - used < len) {
+                break;
+            }
+            seq++;
+            requests++;
+            if (stub_reply(in + used, seq, out + out_len)) {
+                out_len += 32;
+            }
+        }
+
+        memmove(in, in + used, in_len - used);
+        in_len -= used;
+
+        pthread_mutex_lock(&server->lock);
+        server->requests += requests;
+        if (out_len > 0) {
+            server->round_trips++;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        if (out_len > 0) {
+            if (server->latency_us > 0) {
+                nanosleep(&latency, NULL);
+            }
+            if (!write_all(fd, out, out_len)) {
+                break;
+            }
+        }
+    }
+
+ done:
+    free(in);
+    free(out);
+}
+
+static void *stub_thread(void *data)
+{
+    StubServer *server = data;
+    int fd;
+
+    while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        stub_serve(server, fd);
+        close(fd);
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * stub_start() - listen on the first free display number, and start
+ * answering clients.  Returns the display number, or -1 on failure.
+ */
+
+static int stub_start(StubServer *server)
+{
+    struct sockaddr_un addr;
+    pthread_t thread;
+    int display;
+
+    mkdir("/tmp/.X11-unix", 01777);
+
+    for (display = STUB_DISPLAY_FIRST; display <= STUB_DISPLAY_LAST;
+         display++) {
+        server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server->listen_fd < 0) {
+            return -1;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(server->path, sizeof(server->path),
+                 "/tmp/.X11-unix/X%d", display);
+        strcpy(addr.sun_path, server->path);
+
+        if (bind(server->listen_fd, (struct sockaddr *) &addr,
+                 sizeof(addr)) == 0 && listen(server->listen_fd, 1) == 0) {
+            break;
+        }
+        close(server->listen_fd);
+    }
+
+    if (display > STUB_DISPLAY_LAST) {
+        fprintf(stderr, "Unable to find a free display number.\n");
+        return -1;
+    }
+
+    pthread_mutex_init(&server->lock, NULL);
+
+    if (pthread_create(&thread, NULL, stub_thread, server) != 0) {
+        unlink(server->path);
+        return -1;
+    }
+    pthread_detach(thread);
+
+    return display;
+}
+
+static unsigned long stub_round_trips(StubServer *server)
+{
+    unsigned long ret;
+
+    pthread_mutex_lock(&server->lock);
+    ret = server->round_trips;
+    pthread_mutex_unlock(&server->lock);
+
+    return ret;
+}
+
+
+
+static void report(const char *what, int count, double ms,
+                   unsigned long round_trips)
+{
+    printf("%-28s %8d queries %10.3f ms %8lu round trips\n",
+           what, count, ms, round_trips);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-t TARGETS] [-a ATTRIBUTES] [-l LATENCY_US] "
+            "[-r RUNS]\n\n"
+            "  -t TARGETS     number of GPUs to query (default 8)\n"
+            "  -a ATTRIBUTES  number of attributes per GPU (default 300)\n"
+            "  -l LATENCY_US  simulated round trip latency (default 500)\n"
+            "  -r RUNS        number of runs (default 3)\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 8, 300, 500, 3 };
+    StubServer server;
+    XNVCTRLAttributeQuery *queries;
+    XNVCTRLValidValuesQuery *valid_queries;
+    NVCTRLAttributeValidValuesRec values;
+    Display *dpy;
+    char name[16];
+    double start;
+    unsigned long rt;
+    int c, display, count, run, t, a, i, val, exists, ret = 0;
+
+    while ((c = getopt(argc, argv, "t:a:l:r:")) != -1) {
+        switch (c) {
+        case 't': op.targets = atoi(optarg); break;
+        case 'a': op.attributes = atoi(optarg); break;
+        case 'l': op.latency_us = atoi(optarg); break;
+        case 'r': op.runs = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (optind != argc || op.targets < 1 || op.attributes < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.latency_us = op.latency_us;
+
+    display = stub_start(&server);
+    if (display < 0) {
+        return 1;
+    }
+
+    snprintf(name, sizeof(name), ":%d", display);
+    dpy = XOpenDisplay(name);
+    unlink(server.path);
+
+    if (!dpy) {
+        fprintf(stderr, "Unable to connect to the stub X server.\n");
+        return 1;
+    }
+
+    count = op.targets * op.attributes;
+    queries = calloc(count, sizeof(*queries));
+    valid_queries = calloc(count, sizeof(*valid_queries));
+    if (!queries || !valid_queries) {
+        return 1;
+    }
+
+    for (t = 0, i = 0; t < op.targets; t++) {
+        for (a = 0; a < op.attributes; a++, i++) {
+            queries[i].target_type = NV_CTRL_TARGET_TYPE_GPU;
+            queries[i].target_id = t;
+            queries[i].attribute = a;
+            valid_queries[i].target_type = NV_CTRL_TARGET_TYPE_GPU;
+            valid_queries[i].target_id = t;
+            valid_queries[i].attribute = a;
+        }
+    }
+
+    /* query the extension version now, so that no run pays for it */
+
+    if (!XNVCTRLQueryExtension(dpy, NULL, NULL) ||
+        !XNVCTRLQueryVersion(dpy, NULL, NULL)) {
+        fprintf(stderr, "The stub X server does not have NV-CONTROL.\n");
+        return 1;
+    }
+
+    printf("%d GPU(s), %d attribute(s) each, %d us latency\n",
+           op.targets, op.attributes, op.latency_us);
+
+    for (run = 0; run < op.runs; run++) {
+
+        rt = stub_round_trips(&server);
+        start = now_ms();
+        for (i = 0; i < count; i++) {
+            XNVCTRLQueryTargetAttribute(dpy, queries[i].target_type,
+                                        queries[i].target_id, 0,
+                                        queries[i].attribute, &val);
+        }
+        report("values, one at a time", count, now_ms() - start,
+               stub_round_trips(&server) - rt);
+
+        /* one batch per GPU, as query_all() does */
+
+        rt = stub_round_trips(&server);
+        start = now_ms();
+        for (t = 0; t < op.targets; t++) {
+            XNVCTRLQueryTargetAttributesBatch(dpy,
+                                              queries + t * op.attributes,
+                                              op.attributes);
+        }
+        report("values, batched per GPU", count, now_ms() - start,
+               stub_round_trips(&server) - rt);
+
+        rt = stub_round_trips(&server);
+        start = now_ms();
+        for (i = 0; i < count; i++) {
+            XNVCTRLQueryValidTargetAttributeValues(dpy,
+                                                   queries[i].target_type,
+                                                   queries[i].target_id, 0,
+                                                   queries[i].attribute,
+                                                   &values);
+        }
+        report("valid values, one at a time", count, now_ms() - start,
+               stub_round_trips(&server) - rt);
+
+        rt = stub_round_trips(&server);
+        start = now_ms();
+        for (t = 0; t < op.targets; t++) {
+            XNVCTRLQueryValidTargetAttributeValuesBatch(
+                dpy, valid_queries + t * op.attributes, op.attributes);
+        }
+        report("valid values, batched", count, now_ms() - start,
+               stub_round_trips(&server) - rt);
+    }
+
+    /* check that the batches returned what single queries return */
+
+    for (i = 0; i < count; i++) {
+        exists = XNVCTRLQueryTargetAttribute(dpy, queries[i].target_type,
+                                             queries[i].target_id, 0,
+                                             queries[i].attribute, &val);
+        if (!exists != !queries[i].exists ||
+            (exists && val != queries[i].value) ||
+            !exists != !valid_queries[i].exists ||
+            (exists && valid_queries[i].values.u.range.max != val)) {
+            fprintf(stderr, "Batched result %d differs from the single "
+                    "query result.\n", i);
+            ret = 1;
+            break;
+        }
+    }
+
+    XCloseDisplay(dpy);
+    free(queries);
+    free(valid_queries);
+
+    return ret;
+}
@@ -0,0 +1,668 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * A stand-in for libnvidia-ml.so.1, loaded by nvidia-settings through
+ * NVIDIA_SETTINGS_NVML_LIBRARY, so that the NVML code paths can be timed
+ * on systems without NVIDIA GPUs.
+ *
+ * The stub is configured through the environment:
+ *
+ *   NVML_STUB_GPUS        number of GPUs (default 1)
+ *   NVML_STUB_FANS        number of fans per GPU (default 1)
+ *   NVML_STUB_SENSORS     number of thermal sensors per GPU (default 1,
+ *                         at most NVML_MAX_THERMAL_SENSORS_PER_GPU)
+ *   NVML_STUB_LATENCY_US  time each call takes, in microseconds (default 0)
+ *   NVML_STUB_STATS       file to which the number of calls made to each
+ *                         function is written when the library is unloaded
+ *
+ * Functions of the NvCtrlNvmlAttributes function table that are not
+ * implemented here are optional, and are replaced by nvidia-settings with
+ * a function returning NVML_ERROR_FUNCTION_NOT_FOUND.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nvml.h"
+
+
+#define STUB_FUNCTIONS(X)                       \
+    X(Init)                                     \
+    X(Shutdown)                                 \
+    X(DeviceGetHandleByIndex)                   \
+    X(DeviceGetUUID)                            \
+    X(DeviceGetCount)                           \
+    X(DeviceGetTemperatureV)                    \
+    X(DeviceGetName)                            \
+    X(DeviceGetVbiosVersion)                    \
+    X(DeviceGetMemoryInfo)                      \
+    X(DeviceGetPciInfo)                         \
+    X(DeviceGetCurrPcieLinkWidth)               \
+    X(DeviceGetMaxPcieLinkGeneration)           \
+    X(DeviceGetMaxPcieLinkWidth)                \
+    X(DeviceGetVirtualizationMode)              \
+    X(DeviceGetUtilizationRates)                \
+    X(DeviceGetTemperatureThreshold)            \
+    X(DeviceGetFanSpeed_v2)                     \
+    X(SystemGetDriverVersion)                   \
+    X(DeviceGetEccMode)                         \
+    X(DeviceSetEccMode)                         \
+    X(DeviceGetTotalEccErrors)                  \
+    X(DeviceClearEccErrorCounts)                \
+    X(SystemGetNVMLVersion)                     \
+    X(DeviceGetMemoryErrorCounter)              \
+    X(DeviceGetNumGpuCores)                     \
+    X(DeviceGetMemoryBusWidth)                  \
+    X(DeviceGetIrqNum)                          \
+    X(DeviceGetPowerSource)                     \
+    X(DeviceGetNumFans)                         \
+    X(DeviceGetDefaultEccMode)                  \
+    X(DeviceGetGspFirmwareMode)                 \
+    X(DeviceGetMemoryInfo_v2)                   \
+    X(DeviceGetTargetFanSpeed)                  \
+    X(DeviceGetMinMaxFanSpeed)                  \
+    X(DeviceGetFanControlPolicy_v2)             \
+    X(DeviceGetPowerUsage)                      \
+    X(DeviceGetPowerManagementLimitConstraints) \
+    X(DeviceGetPowerManagementDefaultLimit)     \
+    X(DeviceGetThermalSettings)                 \
+    X(DeviceGetFanSpeedRPM)                     \
+    X(DeviceGetCoolerInfo)                      \
+    X(DeviceGetPerformanceState)                \
+    X(DeviceGetArchitecture)                    \
+    X(DeviceGetPcieLinkMaxSpeed)                \
+    X(DeviceGetPcieSpeed)
+
+#define STUB_ENUM(_proc) STUB_ ## _proc,
+#define STUB_NAME(_proc) "nvml" #_proc,
+
+enum {
+    STUB_FUNCTIONS(STUB_ENUM)
+    STUB_NUM_FUNCTIONS
+};
+
+static const char *stubFunctionNames[] = {
+    STUB_FUNCTIONS(STUB_NAME)
+};
+
+struct nvmlDevice_st {
+    unsigned int index;
+};
+
+static struct {
+    unsigned int numGpus;
+    unsigned int numFans;
+    unsigned int numSensors;
+    struct timespec latency;
+    const char *statsFile;
+
+    struct nvmlDevice_st *devices;
+
+    unsigned long calls[STUB_NUM_FUNCTIONS];
+} stub;
+
+
+
+static unsigned int getEnvUInt(const char *name, unsigned int def)
+{
+    const char *str = getenv(name);
+
+    if (!str || !*str) {
+        return def;
+    }
+
+    return strtoul(str, NULL, 0);
+}
+
+
+
+static void __attribute__((constructor)) stubLoad(void)
+{
+    unsigned long latency;
+    unsigned int i;
+
+    stub.numGpus = getEnvUInt("NVML_STUB_GPUS", 1);
+    stub.numFans = getEnvUInt("NVML_STUB_FANS", 1);
+    stub.numSensors = getEnvUInt("NVML_STUB_SENSORS", 1);
+    if (stub.numSensors > NVML_MAX_THERMAL_SENSORS_PER_GPU) {
+        stub.numSensors = NVML_MAX_THERMAL_SENSORS_PER_GPU;
+    }
+
+    latency = getEnvUInt("NVML_STUB_LATENCY_US", 0);
+    stub.latency.tv_sec = latency / 1000000;
+    stub.latency.tv_nsec = (latency % 1000000) * 1000;
+
+    stub.statsFile = getenv("NVML_STUB_STATS");
+
+    stub.devices = calloc(stub.numGpus ? stub.numGpus : 1,
+                          sizeof(*stub.devices));
+    for (i = 0; i < stub.numGpus; i++) {
+        stub.devices[i].index = i;
+    }
+}
+
+
+
+static void __attribute__((destructor)) stubUnload(void)
+{
+    unsigned long total = 0;
+    FILE *fp;
+    int i;
+
+    free(stub.devices);
+    stub.devices = NULL;
+
+    if (!stub.statsFile || !*stub.statsFile) {
+        return;
+    }
+
+    fp = fopen(stub.statsFile, "w");
+    if (!fp) {
+        return;
+    }
+
+    for (i = 0; i < STUB_NUM_FUNCTIONS; i++) {
+        if (stub.calls[i]) {
+            fprintf(fp, "%s %lu\n", stubFunctionNames[i], stub.calls[i]);
+            total += stub.calls[i];
+        }
+    }
+    fprintf(fp, "total %lu\n", total);
+
+    fclose(fp);
+}
+
+
+
+/*
+ * Count the call and simulate the time it takes; nvidia-settings may call
+ * NVML from several threads.
+ */
+
+#define STUB_ENTER(_proc)                                               \
+    do {                                                                \
+        __atomic_fetch_add(&stub.calls[STUB_ ## _proc], 1,              \
+                           __ATOMIC_RELAXED);                           \
+        if (stub.latency.tv_sec || stub.latency.tv_nsec) {              \
+            nanosleep(&stub.latency, NULL);                             \
+        }                                                               \
+    } while (0)
+
+#define STUB_DEVICE(_device)                                            \
+    do {                                                                \
+        if (((_device) < stub.devices) ||                               \
+            ((_device) >= stub.devices + stub.numGpus)) {               \
+            return NVML_ERROR_INVALID_ARGUMENT;                         \
+        }                                                               \
+    } while (0)
+
+#define STUB_FAN(_device, _fan)                                         \
+    do {                                                                \
+        STUB_DEVICE(_device);                                           \
+        if ((_fan) >= stub.numFans) {                                   \
+            return NVML_ERROR_INVALID_ARGUMENT;                         \
+        }                                                               \
+    } while (0)
+
+static nvmlReturn_t copyString(char *dst, unsigned int length,
+                               const char *src)
+{
+    if (strlen(src) >= length) {
+        return NVML_ERROR_INSUFFICIENT_SIZE;
+    }
+    strcpy(dst, src);
+    return NVML_SUCCESS;
+}
+
+
+
+nvmlReturn_t nvmlInit(void)
+{
+    STUB_ENTER(Init);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlShutdown(void)
+{
+    STUB_ENTER(Shutdown);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCount(unsigned int *deviceCount)
+{
+    STUB_ENTER(DeviceGetCount);
+    *deviceCount = stub.numGpus;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex(unsigned int index,
+                                        nvmlDevice_t *device)
+{
+    STUB_ENTER(DeviceGetHandleByIndex);
+    if (index >= stub.numGpus) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+    *device = &stub.devices[index];
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetUUID(nvmlDevice_t device, char *uuid,
+                               unsigned int length)
+{
+    char str[NVML_DEVICE_UUID_V2_BUFFER_SIZE];
+
+    STUB_ENTER(DeviceGetUUID);
+    STUB_DEVICE(device);
+    snprintf(str, sizeof(str), "GPU-5e1f0000-0000-4000-8000-%012x",
+             device->index);
+    return copyString(uuid, length, str);
+}
+
+nvmlReturn_t nvmlDeviceGetTemperatureV(nvmlDevice_t device,
+                                       nvmlTemperature_t *temperature)
+{
+    STUB_ENTER(DeviceGetTemperatureV);
+    STUB_DEVICE(device);
+    temperature->temperature = 40 + device->index;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetName(nvmlDevice_t device, char *name,
+                               unsigned int length)
+{
+    STUB_ENTER(DeviceGetName);
+    STUB_DEVICE(device);
+    return copyString(name, length, "NVIDIA Stub GPU");
+}
+
+nvmlReturn_t nvmlDeviceGetVbiosVersion(nvmlDevice_t device, char *version,
+                                       unsigned int length)
+{
+    STUB_ENTER(DeviceGetVbiosVersion);
+    STUB_DEVICE(device);
+    return copyString(version, length, "00.00.00.00.00");
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryInfo(nvmlDevice_t device, nvmlMemory_t *memory)
+{
+    STUB_ENTER(DeviceGetMemoryInfo);
+    STUB_DEVICE(device);
+    memory->total = 8ULL << 30;
+    memory->used = 1ULL << 30;
+    memory->free = memory->total - memory->used;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryInfo_v2(nvmlDevice_t device,
+                                        nvmlMemory_v2_t *memory)
+{
+    STUB_ENTER(DeviceGetMemoryInfo_v2);
+    STUB_DEVICE(device);
+    memory->total = 8ULL << 30;
+    memory->reserved = 256ULL << 20;
+    memory->used = 1ULL << 30;
+    memory->free = memory->total - memory->reserved - memory->used;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPciInfo(nvmlDevice_t device, nvmlPciInfo_t *pci)
+{
+    STUB_ENTER(DeviceGetPciInfo);
+    STUB_DEVICE(device);
+    memset(pci, 0, sizeof(*pci));
+    pci->domain = 0;
+    pci->bus = device->index + 1;
+    pci->device = 0;
+    pci->pciDeviceId = (0x2204 << 16) | 0x10de;
+    snprintf(pci->busIdLegacy, sizeof(pci->busIdLegacy),
+             NVML_DEVICE_PCI_BUS_ID_LEGACY_FMT,
+             NVML_DEVICE_PCI_BUS_ID_FMT_ARGS(pci));
+    snprintf(pci->busId, sizeof(pci->busId), NVML_DEVICE_PCI_BUS_ID_FMT,
+             NVML_DEVICE_PCI_BUS_ID_FMT_ARGS(pci));
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCurrPcieLinkWidth(nvmlDevice_t device,
+                                            unsigned int *currLinkWidth)
+{
+    STUB_ENTER(DeviceGetCurrPcieLinkWidth);
+    STUB_DEVICE(device);
+    *currLinkWidth = 16;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMaxPcieLinkGeneration(nvmlDevice_t device,
+                                                unsigned int *maxLinkGen)
+{
+    STUB_ENTER(DeviceGetMaxPcieLinkGeneration);
+    STUB_DEVICE(device);
+    *maxLinkGen = 4;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMaxPcieLinkWidth(nvmlDevice_t device,
+                                           unsigned int *maxLinkWidth)
+{
+    STUB_ENTER(DeviceGetMaxPcieLinkWidth);
+    STUB_DEVICE(device);
+    *maxLinkWidth = 16;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPcieLinkMaxSpeed(nvmlDevice_t device,
+                                           unsigned int *maxSpeed)
+{
+    STUB_ENTER(DeviceGetPcieLinkMaxSpeed);
+    STUB_DEVICE(device);
+    *maxSpeed = NVML_PCIE_LINK_MAX_SPEED_16000MBPS;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPcieSpeed(nvmlDevice_t device,
+                                    unsigned int *pcieSpeed)
+{
+    STUB_ENTER(DeviceGetPcieSpeed);
+    STUB_DEVICE(device);
+    *pcieSpeed = 16000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetVirtualizationMode(nvmlDevice_t device,
+                                      nvmlGpuVirtualizationMode_t *pVirtualMode)
+{
+    STUB_ENTER(DeviceGetVirtualizationMode);
+    STUB_DEVICE(device);
+    *pVirtualMode = NVML_GPU_VIRTUALIZATION_MODE_NONE;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetUtilizationRates(nvmlDevice_t device,
+                                           nvmlUtilization_t *utilization)
+{
+    STUB_ENTER(DeviceGetUtilizationRates);
+    STUB_DEVICE(device);
+    utilization->gpu = 10;
+    utilization->memory = 5;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTemperatureThreshold(nvmlDevice_t device,
+                                     nvmlTemperatureThresholds_t thresholdType,
+                                     unsigned int *temp)
+{
+    STUB_ENTER(DeviceGetTemperatureThreshold);
+    STUB_DEVICE(device);
+    *temp = 90;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetNumFans(nvmlDevice_t device, unsigned int *numFans)
+{
+    STUB_ENTER(DeviceGetNumFans);
+    STUB_DEVICE(device);
+    *numFans = stub.numFans;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetFanSpeed_v2(nvmlDevice_t device, unsigned int fan,
+                                      unsigned int *speed)
+{
+    STUB_ENTER(DeviceGetFanSpeed_v2);
+    STUB_FAN(device, fan);
+    *speed = 30;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTargetFanSpeed(nvmlDevice_t device, unsigned int fan,
+                                         unsigned int *targetSpeed)
+{
+    STUB_ENTER(DeviceGetTargetFanSpeed);
+    STUB_FAN(device, fan);
+    *targetSpeed = 30;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMinMaxFanSpeed(nvmlDevice_t device,
+                                         unsigned int *minSpeed,
+                                         unsigned int *maxSpeed)
+{
+    STUB_ENTER(DeviceGetMinMaxFanSpeed);
+    STUB_DEVICE(device);
+    *minSpeed = 0;
+    *maxSpeed = 100;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetFanControlPolicy_v2(nvmlDevice_t device,
+                                              unsigned int fan,
+                                              nvmlFanControlPolicy_t *policy)
+{
+    STUB_ENTER(DeviceGetFanControlPolicy_v2);
+    STUB_FAN(device, fan);
+    *policy = NVML_FAN_POLICY_TEMPERATURE_CONTINOUS_SW;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetFanSpeedRPM(nvmlDevice_t device,
+                                      nvmlFanSpeedInfo_t *fanSpeed)
+{
+    STUB_ENTER(DeviceGetFanSpeedRPM);
+    STUB_FAN(device, fanSpeed->fan);
+    fanSpeed->speed = 1500;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCoolerInfo(nvmlDevice_t device,
+                                     nvmlCoolerInfo_t *coolerInfo)
+{
+    STUB_ENTER(DeviceGetCoolerInfo);
+    STUB_FAN(device, coolerInfo->index);
+    coolerInfo->signalType = NVML_THERMAL_COOLER_SIGNAL_VARIABLE;
+    coolerInfo->target = NVML_THERMAL_COOLER_TARGET_GPU_RELATED;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetThermalSettings(nvmlDevice_t device,
+                                     unsigned int sensorIndex,
+                                     nvmlGpuThermalSettings_t *pThermalSettings)
+{
+    unsigned int i;
+
+    STUB_ENTER(DeviceGetThermalSettings);
+    STUB_DEVICE(device);
+
+    memset(pThermalSettings, 0, sizeof(*pThermalSettings));
+    pThermalSettings->count = stub.numSensors;
+
+    for (i = 0; i < stub.numSensors; i++) {
+        pThermalSettings->sensor[i].controller =
+            NVML_THERMAL_CONTROLLER_GPU_INTERNAL;
+        pThermalSettings->sensor[i].defaultMinTemp = 0;
+        pThermalSettings->sensor[i].defaultMaxTemp = 90;
+        pThermalSettings->sensor[i].currentTemp = 40 + device->index + i;
+        pThermalSettings->sensor[i].target = NVML_THERMAL_TARGET_GPU;
+    }
+
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlSystemGetDriverVersion(char *version, unsigned int length)
+{
+    STUB_ENTER(SystemGetDriverVersion);
+    return copyString(version, length, "999.99.99");
+}
+
+nvmlReturn_t nvmlSystemGetNVMLVersion(char *version, unsigned int length)
+{
+    STUB_ENTER(SystemGetNVMLVersion);
+    return copyString(version, length, "99.999.99");
+}
+
+nvmlReturn_t nvmlDeviceGetEccMode(nvmlDevice_t device,
+                                  nvmlEnableState_t *current,
+                                  nvmlEnableState_t *pending)
+{
+    STUB_ENTER(DeviceGetEccMode);
+    STUB_DEVICE(device);
+    *current = NVML_FEATURE_DISABLED;
+    *pending = NVML_FEATURE_DISABLED;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetDefaultEccMode(nvmlDevice_t device,
+                                         nvmlEnableState_t *defaultMode)
+{
+    STUB_ENTER(DeviceGetDefaultEccMode);
+    STUB_DEVICE(device);
+    *defaultMode = NVML_FEATURE_DISABLED;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceSetEccMode(nvmlDevice_t device, nvmlEnableState_t ecc)
+{
+    STUB_ENTER(DeviceSetEccMode);
+    STUB_DEVICE(device);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTotalEccErrors(nvmlDevice_t device,
+                                         nvmlMemoryErrorType_t errorType,
+                                         nvmlEccCounterType_t counterType,
+                                         unsigned long long *eccCounts)
+{
+    STUB_ENTER(DeviceGetTotalEccErrors);
+    STUB_DEVICE(device);
+    *eccCounts = 0;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceClearEccErrorCounts(nvmlDevice_t device,
+                                           nvmlEccCounterType_t counterType)
+{
+    STUB_ENTER(DeviceClearEccErrorCounts);
+    STUB_DEVICE(device);
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryErrorCounter(nvmlDevice_t device,
+                                             nvmlMemoryErrorType_t errorType,
+                                             nvmlEccCounterType_t counterType,
+                                             nvmlMemoryLocation_t locationType,
+                                             unsigned long long *count)
+{
+    STUB_ENTER(DeviceGetMemoryErrorCounter);
+    STUB_DEVICE(device);
+    *count = 0;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetNumGpuCores(nvmlDevice_t device,
+                                      unsigned int *numCores)
+{
+    STUB_ENTER(DeviceGetNumGpuCores);
+    STUB_DEVICE(device);
+    *numCores = 1024;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetMemoryBusWidth(nvmlDevice_t device,
+                                         unsigned int *busWidth)
+{
+    STUB_ENTER(DeviceGetMemoryBusWidth);
+    STUB_DEVICE(device);
+    *busWidth = 256;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetIrqNum(nvmlDevice_t device, unsigned int *irqNum)
+{
+    STUB_ENTER(DeviceGetIrqNum);
+    STUB_DEVICE(device);
+    *irqNum = 100 + device->index;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerSource(nvmlDevice_t device,
+                                      nvmlPowerSource_t *powerSource)
+{
+    STUB_ENTER(DeviceGetPowerSource);
+    STUB_DEVICE(device);
+    *powerSource = NVML_POWER_SOURCE_AC;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetGspFirmwareMode(nvmlDevice_t device,
+                                          unsigned int *isEnabled,
+                                          unsigned int *defaultMode)
+{
+    STUB_ENTER(DeviceGetGspFirmwareMode);
+    STUB_DEVICE(device);
+    *isEnabled = 1;
+    *defaultMode = 1;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device, unsigned int *power)
+{
+    STUB_ENTER(DeviceGetPowerUsage);
+    STUB_DEVICE(device);
+    *power = 100000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerManagementLimitConstraints(nvmlDevice_t device,
+                                                          unsigned int *minLimit,
+                                                          unsigned int *maxLimit)
+{
+    STUB_ENTER(DeviceGetPowerManagementLimitConstraints);
+    STUB_DEVICE(device);
+    *minLimit = 100000;
+    *maxLimit = 300000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPowerManagementDefaultLimit(nvmlDevice_t device,
+                                                      unsigned int *defaultLimit)
+{
+    STUB_ENTER(DeviceGetPowerManagementDefaultLimit);
+    STUB_DEVICE(device);
+    *defaultLimit = 250000;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetPerformanceState(nvmlDevice_t device,
+                                           nvmlPstates_t *pState)
+{
+    STUB_ENTER(DeviceGetPerformanceState);
+    STUB_DEVICE(device);
+    *pState = NVML_PSTATE_0;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetArchitecture(nvmlDevice_t device,
+                                       nvmlDeviceArchitecture_t *arch)
+{
+    STUB_ENTER(DeviceGetArchitecture);
+    STUB_DEVICE(device);
+    *arch = NVML_DEVICE_ARCH_AMPERE;
+    return NVML_SUCCESS;
+}
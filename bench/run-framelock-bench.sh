@@ -0,0 +1,176 @@
+#!/bin/sh
+#
+# nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+# and Linux systems.
+#
+# Copyright (C) 2026 NVIDIA Corporation.
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses>.
+#
+
+#
+# Time 'nvidia-settings --framelock-status' against clusters of stub X
+# servers, and check that a slow X server does not hold up the others.
+#
+# usage: run-framelock-bench.sh [-r RUNS] [-n HOSTS] [-l LATENCY_MS]
+#                               [-s SLOW_MS] NVIDIA_SETTINGS
+#
+# X servers named "stub:NAME@MS" are not connected to; nvidia-settings
+# simulates them, with one frame lock board tied to two GPUs, taking MS
+# milliseconds per sample.  For each of the space-separated numbers of X
+# servers in HOSTS, the sync matrix of that many stub X servers taking
+# LATENCY_MS each is printed once; as they are sampled concurrently, this
+# should take about LATENCY_MS however many there are.  The number of
+# rows printed is checked against the number of GPUs.
+#
+# Then the matrix of 16 stub X servers and one taking SLOW_MS is watched
+# for WATCH_SECONDS seconds, printing it every half second: the prints
+# should keep coming at that rate, with the slow X server showing its
+# last sample.
+#
+
+RUNS=5
+HOSTS="1 16 64 256"
+LATENCY_MS=100
+SLOW_MS=3000
+WATCH_SECONDS=4
+
+usage()
+{
+    echo "usage: $0 [-r RUNS] [-n HOSTS] [-l LATENCY_MS] [-s SLOW_MS]" \
+         "NVIDIA_SETTINGS" >&2
+    exit 2
+}
+
+while getopts "r:n:l:s:" opt; do
+    case "$opt" in
+        r) RUNS="$OPTARG" ;;
+        n) HOSTS="$OPTARG" ;;
+        l) LATENCY_MS="$OPTARG" ;;
+        s) SLOW_MS="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ]; then
+    usage
+fi
+
+NVIDIA_SETTINGS="$1"
+
+if [ ! -x "$NVIDIA_SETTINGS" ]; then
+    echo "$0: '$NVIDIA_SETTINGS' is not executable; build nvidia-settings first." >&2
+    exit 1
+fi
+
+TMPDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT
+
+NO_DISPLAY=":${BENCH_NO_DISPLAY:-4095}"
+
+now_ns()
+{
+    date +%s%N
+}
+
+# stub_hosts COUNT LATENCY_MS
+stub_hosts()
+{
+    list=
+    i=1
+    while [ $i -le "$1" ]; do
+        list="$list${list:+,}stub:wall-$i@$2"
+        i=$((i + 1))
+    done
+    echo "$list"
+}
+
+# run_status NAME EXPECTED_ROWS ARGS...
+run_status()
+{
+    name="$1"
+    expected="$2"
+    shift 2
+
+    total=0
+    min=
+
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        start=$(now_ns)
+        "$NVIDIA_SETTINGS" --config="$TMPDIR/rc" \
+            --ctrl-display="$NO_DISPLAY" --output=csv "$@" \
+            > "$TMPDIR/stdout" 2> "$TMPDIR/stderr"
+        status=$?
+        end=$(now_ns)
+
+        if [ $status -ne 0 ]; then
+            echo "$name: nvidia-settings exited with status $status:" >&2
+            cat "$TMPDIR/stderr" >&2
+            return 1
+        fi
+
+        # the CSV header, then one row per GPU
+        rows=$(($(wc -l < "$TMPDIR/stdout") - 1))
+        if [ $rows -ne "$expected" ]; then
+            echo "$name: $rows row(s) printed, expected $expected" >&2
+            return 1
+        fi
+
+        elapsed=$(( (end - start) / 1000 ))
+        total=$((total + elapsed))
+        if [ -z "$min" ] || [ $elapsed -lt $min ]; then
+            min=$elapsed
+        fi
+        i=$((i + 1))
+    done
+
+    printf "%-22s min %8d us  avg %8d us  rows %5d\n" \
+        "$name" "$min" $((total / RUNS)) "$rows"
+}
+
+echo "stub X servers: $LATENCY_MS ms/sample; $RUNS run(s)"
+
+for hosts in $HOSTS; do
+    run_status "status, $hosts host(s)" $((hosts * 2)) \
+        --framelock-status="$(stub_hosts "$hosts" "$LATENCY_MS")" || exit 1
+done
+
+# Watch 16 hosts and a slow one, and count the matrices printed: each
+# starts with a time stamp line in the text output.
+
+hosts="$(stub_hosts 16 "$LATENCY_MS"),stub:slow@$SLOW_MS"
+
+"$NVIDIA_SETTINGS" --config="$TMPDIR/rc" --ctrl-display="$NO_DISPLAY" \
+    --framelock-status="$hosts" \
+    --watch=0.5 \
+    > "$TMPDIR/watch" 2> "$TMPDIR/stderr" &
+pid=$!
+
+sleep "$WATCH_SECONDS"
+kill -TERM $pid
+wait $pid
+
+prints=$(grep -c '^[0-9][0-9]:[0-9][0-9]:[0-9][0-9]\.[0-9][0-9][0-9]$' \
+         "$TMPDIR/watch")
+expected=$((WATCH_SECONDS * 2))
+
+printf "%-22s %d print(s) in %d s, expected about %d\n" \
+    "watch, 1 slow host" "$prints" "$WATCH_SECONDS" "$expected"
+
+if [ "$prints" -lt $((expected / 2)) ]; then
+    echo "The slow X server held up the sync matrix:" >&2
+    cat "$TMPDIR/stderr" >&2
+    exit 1
+fi
@@ -0,0 +1,152 @@
+#!/bin/sh
+#
+# nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+# and Linux systems.
+#
+# Copyright (C) 2026 NVIDIA Corporation.
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms and conditions of the GNU General Public License,
+# version 2, as published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses>.
+#
+
+#
+# Time the nvidia-settings command line against the stub NVML library and
+# report how many NVML calls each command makes.
+#
+# usage: run-nvml-bench.sh [-r RUNS] [-s GPUS] NVIDIA_SETTINGS NVML_STUB
+#
+# The stub is configured through NVML_STUB_GPUS, NVML_STUB_FANS,
+# NVML_STUB_SENSORS and NVML_STUB_LATENCY_US, which are passed through
+# from the environment (see nvml-stub.c).
+#
+# Without an X server, nvidia-settings falls back to NVML for '-q all' and
+# '-L'; the ctrl-display is pointed at a display that does not exist so
+# that the NVML path is measured even when DISPLAY is set.  '-r' needs an
+# X server with NV-CONTROL and is only run if BENCH_DISPLAY names one.
+#
+# With '-s GPUS', only the startup time is measured instead: '-q gpus',
+# which connects to every target and does little else, is timed with each
+# of the space-separated numbers of GPUs in GPUS, and the number of times
+# NVML was initialized is reported alongside.
+#
+
+RUNS=5
+STARTUP_GPUS=
+
+usage()
+{
+    echo "usage: $0 [-r RUNS] [-s GPUS] NVIDIA_SETTINGS NVML_STUB" >&2
+    exit 2
+}
+
+while getopts "r:s:" opt; do
+    case "$opt" in
+        r) RUNS="$OPTARG" ;;
+        s) STARTUP_GPUS="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ]; then
+    usage
+fi
+
+NVIDIA_SETTINGS="$1"
+NVML_STUB="$2"
+
+if [ ! -x "$NVIDIA_SETTINGS" ]; then
+    echo "$0: '$NVIDIA_SETTINGS' is not executable; build nvidia-settings first." >&2
+    exit 1
+fi
+
+TMPDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT
+
+NO_DISPLAY=":${BENCH_NO_DISPLAY:-4095}"
+
+export NVIDIA_SETTINGS_NVML_LIBRARY="$NVML_STUB"
+
+now_ns()
+{
+    date +%s%N
+}
+
+# run_scenario NAME ARGS...
+run_scenario()
+{
+    name="$1"
+    shift
+
+    total=0
+    min=
+
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        start=$(now_ns)
+        NVML_STUB_STATS="$TMPDIR/stats" \
+            "$NVIDIA_SETTINGS" --config="$TMPDIR/rc" "$@" \
+            > /dev/null 2> "$TMPDIR/stderr"
+        status=$?
+        end=$(now_ns)
+
+        if [ $status -ne 0 ]; then
+            echo "$name: nvidia-settings exited with status $status:" >&2
+            cat "$TMPDIR/stderr" >&2
+            return 1
+        fi
+
+        elapsed=$(( (end - start) / 1000 ))
+        total=$((total + elapsed))
+        if [ -z "$min" ] || [ $elapsed -lt $min ]; then
+            min=$elapsed
+        fi
+        i=$((i + 1))
+    done
+
+    calls=$(awk '$1 == "total" { print $2 }' "$TMPDIR/stats" 2>/dev/null)
+    inits=$(awk '$1 == "nvmlInit" { print $2 }' "$TMPDIR/stats" 2>/dev/null)
+
+    printf "%-22s min %8d us  avg %8d us  nvml calls %6s  inits %4s\n" \
+        "$name" "$min" $((total / RUNS)) "${calls:-?}" "${inits:-0}"
+
+    if [ -n "$BENCH_VERBOSE" ] && [ -f "$TMPDIR/stats" ]; then
+        sed 's/^/    /' "$TMPDIR/stats"
+    fi
+}
+
+if [ -n "$STARTUP_GPUS" ]; then
+    echo "stub: ${NVML_STUB_FANS:-1} fan(s), ${NVML_STUB_SENSORS:-1}" \
+         "sensor(s) per GPU, ${NVML_STUB_LATENCY_US:-0} us/call;" \
+         "$RUNS run(s)"
+
+    for gpus in $STARTUP_GPUS; do
+        NVML_STUB_GPUS="$gpus"
+        export NVML_STUB_GPUS
+        run_scenario "startup, $gpus GPU(s)" --ctrl-display="$NO_DISPLAY" \
+            -q gpus || exit 1
+    done
+    exit 0
+fi
+
+echo "stub: ${NVML_STUB_GPUS:-1} GPU(s), ${NVML_STUB_FANS:-1} fan(s)," \
+     "${NVML_STUB_SENSORS:-1} sensor(s), ${NVML_STUB_LATENCY_US:-0} us/call;" \
+     "$RUNS run(s)"
+
+run_scenario "-q all" --ctrl-display="$NO_DISPLAY" -q all
+run_scenario "-L" --ctrl-display="$NO_DISPLAY" -L
+
+if [ -n "$BENCH_DISPLAY" ]; then
+    run_scenario "-r" --ctrl-display="$BENCH_DISPLAY" -r
+else
+    echo "-r                     skipped (set BENCH_DISPLAY to an NV-CONTROL display)"
+fi
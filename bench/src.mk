@@ -0,0 +1,20 @@
+#
+# files in the bench directory of nvidia-settings
+#
+
+BENCH_SRC +=
+
+BENCH_EXTRA_DIST += README
+BENCH_EXTRA_DIST += app-profile-bench.c
+BENCH_EXTRA_DIST += config-file-bench.c
+BENCH_EXTRA_DIST += gpu-utilization-bench.c
+BENCH_EXTRA_DIST += graph-redraw-bench.c
+BENCH_EXTRA_DIST += metrics-server-bench.c
+BENCH_EXTRA_DIST += nvctrl-batch-bench.c
+BENCH_EXTRA_DIST += nvml-stub.c
+BENCH_EXTRA_DIST += run-framelock-bench.sh
+BENCH_EXTRA_DIST += run-nvml-bench.sh
+BENCH_EXTRA_DIST += src.mk
+BENCH_EXTRA_DIST += xconfig-bench.c
+
+BENCH_DIST_FILES := $(BENCH_SRC) $(BENCH_EXTRA_DIST)
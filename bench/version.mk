@@ -0,0 +1,11 @@
+NVIDIA_VERSION = 610.43.03
+NVIDIA_NVID_VERSION = 610.43.03
+NVIDIA_NVID_EXTRA = 
+
+# This file.
+VERSION_MK_FILE := $(lastword $(MAKEFILE_LIST))
+$(OUTPUTDIR)/version.h: $(VERSION_MK_FILE)
+	@$(MKDIR) $(OUTPUTDIR)
+	@$(ECHO) '#define NVIDIA_VERSION "$(NVIDIA_VERSION)"' > $@
+
+NV_GENERATED_HEADERS += $(OUTPUTDIR)/version.h
@@ -0,0 +1,439 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * xconfig-bench.c - generate a synthetic multi-screen X configuration
+ * file in a directory, like the ones written for large display walls,
+ * and parse it with the XF86Config parser: first one file at a time,
+ * then with several scanners parsing it concurrently from different
+ * threads.  Reports the time taken and the parse throughput.
+ *
+ * Then generate a second configuration of the same size, whose screens,
+ * GPUs and monitors half overlap with those of the first and have
+ * different options, and merge it into the first the way the display
+ * configuration page merges a generated layout into an existing file.
+ *
+ * Finally, render the first configuration into a buffer, as is done for
+ * the preview of the file to be saved, and write it back to disk the way
+ * it is saved, reporting the time taken by each and the output rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common-utils.h"
+#include "XF86Config-parser/xf86Parser.h"
+
+typedef struct {
+    int screens;
+    int runs;
+    int threads;
+    const char *dir;
+} BenchOptions;
+
+typedef struct {
+    const char *filename;
+    int runs;
+    int failed;
+} ParseThread;
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+
+/*
+ * xconfigPrint() - the message callback required by the XF86Config
+ * parser; only errors and warnings are printed.
+ */
+
+void xconfigPrint(MsgType t, const char *msg)
+{
+    if (t != DebugMsg) {
+        fprintf(stderr, "%s\n", msg);
+    }
+}
+
+
+
+/*
+ * write_config_file() - write an X configuration file with 'screens'
+ * screens, numbered from 'first', each with its own GPU and monitor, laid
+ * out in a row by the server layout.  'variant' changes the values of the
+ * options.  Returns the size of the file, or -1 on error.
+ */
+
+static long write_config_file(const char *filename, int first, int screens,
+                              int variant)
+{
+    FILE *fp;
+    long size;
+    int i;
+
+    fp = fopen(filename, "w");
+    if (!fp) {
+        fprintf(stderr, "Unable to create \"%s\" (%s).\n",
+                filename, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "# xconfig-bench: %d screen(s)\n\n", screens);
+
+    fprintf(fp, "Section \"ServerLayout\"\n"
+                "    Identifier     \"Layout0\"\n");
+    for (i = first; i < first + screens; i++) {
+        if (i == first) {
+            fprintf(fp, "    Screen      0  \"Screen%d\" 0 0\n", i);
+        } else {
+            fprintf(fp, "    Screen     %2d  \"Screen%d\" RightOf "
+                        "\"Screen%d\"\n", i - first, i, i - 1);
+        }
+    }
+    fprintf(fp, "    InputDevice    \"Keyboard0\" \"CoreKeyboard\"\n"
+                "    InputDevice    \"Mouse0\" \"CorePointer\"\n"
+                "    Option         \"Xinerama\" \"%d\"\n"
+                "EndSection\n\n", variant);
+
+    fprintf(fp, "Section \"Files\"\n"
+                "EndSection\n\n"
+                "Section \"InputDevice\"\n"
+                "    Identifier     \"Mouse0\"\n"
+                "    Driver         \"mouse\"\n"
+                "    Option         \"Protocol\" \"auto\"\n"
+                "    Option         \"Device\" \"/dev/psaux\"\n"
+                "EndSection\n\n"
+                "Section \"InputDevice\"\n"
+                "    Identifier     \"Keyboard0\"\n"
+                "    Driver         \"kbd\"\n"
+                "EndSection\n\n");
+
+    for (i = first; i < first + screens; i++) {
+        fprintf(fp, "Section \"Monitor\"\n"
+                    "    # HorizSync source: edid, VertRefresh source: edid\n"
+                    "    Identifier     \"Monitor%d\"\n"
+                    "    VendorName     \"Unknown\"\n"
+                    "    ModelName      \"DELL U2723QE\"\n"
+                    "    HorizSync       30.0 - 135.0\n"
+                    "    VertRefresh     24.0 - %d.0\n"
+                    "    Option         \"DPMS\"\n"
+                    "EndSection\n\n", i, 75 + variant);
+    }
+
+    for (i = first; i < first + screens; i++) {
+        fprintf(fp, "Section \"Device\"\n"
+                    "    Identifier     \"Device%d\"\n"
+                    "    Driver         \"nvidia\"\n"
+                    "    VendorName     \"NVIDIA Corporation\"\n"
+                    "    BoardName      \"NVIDIA RTX A6000\"\n"
+                    "    BusID          \"PCI:%d:%d:0\"\n"
+                    "    Option         \"Coolbits\" \"%d\"\n"
+                    "EndSection\n\n", i, (i / 32) + 1, i % 32, 4 + variant);
+    }
+
+    for (i = first; i < first + screens; i++) {
+        fprintf(fp, "Section \"Screen\"\n"
+                    "    Identifier     \"Screen%d\"\n"
+                    "    Device         \"Device%d\"\n"
+                    "    Monitor        \"Monitor%d\"\n"
+                    "    DefaultDepth    24\n"
+                    "    Option         \"Stereo\" \"%d\"\n"
+                    "    Option         \"nvidiaXineramaInfoOrder\" "
+                    "\"DFP-0\"\n"
+                    "    Option         \"metamodes\" \"DP-0: 3840x2160_60 "
+                    "+0+0, DP-2: 3840x2160_60 +3840+0, DP-4: 3840x2160_60 "
+                    "+0+2160, DP-6: 3840x2160_60 +3840+2160\"\n"
+                    "    Option         \"SLI\" \"Off\"\n"
+                    "    Option         \"MultiGPU\" \"Off\"\n"
+                    "    Option         \"BaseMosaic\" \"off\"\n"
+                    "    SubSection     \"Display\"\n"
+                    "        Depth       24\n"
+                    "    EndSubSection\n"
+                    "EndSection\n\n", i, i, i, variant);
+    }
+
+    size = ftell(fp);
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Unable to write \"%s\" (%s).\n",
+                filename, strerror(errno));
+        return -1;
+    }
+
+    return size;
+}
+
+
+
+/*
+ * parse_config_file() - parse 'filename' with a scanner of its own.
+ * Returns the parsed configuration, or NULL on error.
+ */
+
+static XConfigPtr parse_config_file(const char *filename)
+{
+    XConfigScannerPtr scanner;
+    XConfigPtr config = NULL;
+
+    scanner = xconfigOpenConfigScanner(filename, NULL);
+    if (!scanner) {
+        fprintf(stderr, "Unable to open \"%s\".\n", filename);
+        return NULL;
+    }
+
+    if (xconfigReadConfigScanner(scanner, &config) !=
+        XCONFIG_RETURN_SUCCESS) {
+        fprintf(stderr, "Unable to parse \"%s\".\n", filename);
+        config = NULL;
+    }
+
+    xconfigCloseConfigScanner(scanner);
+
+    return config;
+}
+
+
+
+static int count_screens(XConfigPtr config)
+{
+    XConfigScreenPtr screen;
+    int n = 0;
+
+    for (screen = config->screens; screen; screen = screen->next) {
+        n++;
+    }
+
+    return n;
+}
+
+
+
+static void *parse_thread(void *data)
+{
+    ParseThread *t = data;
+    XConfigPtr config;
+    int run;
+
+    for (run = 0; run < t->runs; run++) {
+        config = parse_config_file(t->filename);
+        if (!config) {
+            t->failed = 1;
+            break;
+        }
+        xconfigFreeConfig(&config);
+    }
+
+    return NULL;
+}
+
+
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-s SCREENS] [-r RUNS] [-j THREADS] DIR\n\n"
+            "  -s SCREENS  number of screens in the configuration "
+            "(default 256)\n"
+            "  -r RUNS     number of times each thread parses it "
+            "(default 10)\n"
+            "  -j THREADS  number of threads parsing it concurrently "
+            "(default 4)\n"
+            "  DIR         directory to generate the configuration in; the "
+            "path must\n"
+            "              be absolute\n", argv0);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions op = { 256, 10, 4, NULL };
+    ParseThread *threads;
+    pthread_t *tids;
+    XConfigPtr config, src;
+    char *filename, *src_filename, *out_filename, *buf;
+    size_t len = 0;
+    long size;
+    double start, ms, mb;
+    int c, i, run, ret = 0;
+
+    while ((c = getopt(argc, argv, "s:r:j:")) != -1) {
+        switch (c) {
+        case 's': op.screens = atoi(optarg); break;
+        case 'r': op.runs = atoi(optarg); break;
+        case 'j': op.threads = atoi(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if ((optind != argc - 1) || (argv[optind][0] != '/') ||
+        (op.screens < 1) || (op.runs < 1) || (op.threads < 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+    op.dir = argv[optind];
+
+    filename = nvstrcat(op.dir, "/xorg.conf", NULL);
+
+    src_filename = nvstrcat(op.dir, "/xorg-generated.conf", NULL);
+
+    size = write_config_file(filename, 0, op.screens, 0);
+    if ((size < 0) ||
+        (write_config_file(src_filename, op.screens / 2, op.screens, 1) < 0)) {
+        nvfree(filename);
+        nvfree(src_filename);
+        return 1;
+    }
+    mb = size / (1024.0 * 1024.0);
+
+    printf("config: %d screen(s), %ld bytes\n", op.screens, size);
+
+    /* one file at a time */
+
+    start = now_ms();
+    for (run = 0; run < op.runs; run++) {
+        config = parse_config_file(filename);
+        if (!config) {
+            nvfree(filename);
+            nvfree(src_filename);
+            return 1;
+        }
+        xconfigFreeConfig(&config);
+    }
+    ms = now_ms() - start;
+
+    printf("parse, 1 thread:    %4d file(s) %10.3f ms %9.2f MB/s\n",
+           op.runs, ms, mb * op.runs * 1000.0 / ms);
+
+    /* concurrently, each thread with its own scanner */
+
+    threads = nvalloc(op.threads * sizeof(*threads));
+    tids = nvalloc(op.threads * sizeof(*tids));
+
+    start = now_ms();
+    for (i = 0; i < op.threads; i++) {
+        threads[i].filename = filename;
+        threads[i].runs = op.runs;
+        pthread_create(&tids[i], NULL, parse_thread, &threads[i]);
+    }
+    for (i = 0; i < op.threads; i++) {
+        pthread_join(tids[i], NULL);
+        ret |= threads[i].failed;
+    }
+    ms = now_ms() - start;
+
+    printf("parse, %2d thread(s): %4d file(s) %10.3f ms %9.2f MB/s\n",
+           op.threads, op.threads * op.runs, ms,
+           mb * op.threads * op.runs * 1000.0 / ms);
+
+    nvfree(threads);
+    nvfree(tids);
+
+    /* merge the second configuration into the first */
+
+    ms = 0.0;
+    for (run = 0; (run < op.runs) && !ret; run++) {
+        config = parse_config_file(filename);
+        src = parse_config_file(src_filename);
+
+        if (config && src) {
+            start = now_ms();
+            if (!xconfigMergeConfigs(config, src)) {
+                fprintf(stderr, "Unable to merge the configurations.\n");
+                ret = 1;
+            }
+            ms += now_ms() - start;
+
+            if (count_screens(config) != op.screens / 2 + op.screens) {
+                fprintf(stderr, "The merged configuration has %d "
+                        "screen(s), instead of %d.\n", count_screens(config),
+                        op.screens / 2 + op.screens);
+                ret = 1;
+            }
+        } else {
+            ret = 1;
+        }
+
+        xconfigFreeConfig(&config);
+        xconfigFreeConfig(&src);
+    }
+
+    if (!ret) {
+        printf("merge, %d + %d screen(s): %10.3f ms per merge\n",
+               op.screens, op.screens, ms / op.runs);
+    }
+
+    /* render the first configuration, and write it to a new file */
+
+    config = parse_config_file(filename);
+    out_filename = nvstrcat(op.dir, "/xorg-written.conf", NULL);
+
+    if (config && !ret) {
+        start = now_ms();
+        for (run = 0; run < op.runs; run++) {
+            buf = xconfigWriteConfigBuffer(config, &len);
+            if (!buf) {
+                ret = 1;
+                break;
+            }
+            free(buf);
+        }
+        ms = now_ms() - start;
+
+        printf("render:             %4d file(s) %10.3f ms %9.2f MB/s\n",
+               op.runs, ms, (len / (1024.0 * 1024.0)) * op.runs * 1000.0 / ms);
+
+        start = now_ms();
+        for (run = 0; (run < op.runs) && !ret; run++) {
+            if (!xconfigWriteConfigFile(out_filename, config)) {
+                fprintf(stderr, "Unable to write \"%s\".\n",
+                        out_filename);
+                ret = 1;
+            }
+        }
+        ms = now_ms() - start;
+
+        if (!ret) {
+            printf("write:              %4d file(s) %10.3f ms %9.2f MB/s "
+                   "(%zu bytes each)\n", op.runs, ms,
+                   (len / (1024.0 * 1024.0)) * op.runs * 1000.0 / ms, len);
+        }
+    } else {
+        ret = 1;
+    }
+
+    xconfigFreeConfig(&config);
+
+    nvfree(filename);
+    nvfree(src_filename);
+    nvfree(out_filename);
+
+    return ret;
+}
@@ -539,6 +539,19 @@ If there are other things you would like to see added (or better yet, would like
 .SH FILES
 .TP
 .I ~/.nvidia\-settings\-rc
+.SH ENVIRONMENT
+.TP
+.B NVIDIA_SETTINGS_NVML_LIBRARY
+The NVML library to load instead of
+.IR libnvidia\-ml.so.1 ,
+e.g. the stub implementation built in the
+.I bench
+directory of the source package, used to exercise
+.B nvidia\-settings
+on systems without NVIDIA GPUs.
+It is ignored when
+.B nvidia\-settings
+runs setuid or setgid.
 .SH EXAMPLES
 .TP
 .B nvidia\-settings
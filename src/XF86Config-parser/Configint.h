@@ -75,6 +75,64 @@ typedef struct
 }
 LexRec, *LexPtr;
 
+/* value of the token most recently returned by xconfigGetToken() */
+extern __thread LexRec val;
+
+/*
+ * Scanner state for one config file; the whole file is mapped (or read)
+ * into buf, and tokens are scanned directly out of it.
+ */
+typedef struct __xconfigscannerrec
+{
+    char *buf;      /* file contents, followed by a NUL */
+    size_t size;    /* size of the file contents */
+    size_t pos;     /* current reader's position */
+    int mapped;     /* buf is mmap(2)ed rather than malloc(3)ed */
+    char *rbuf;     /* buffer for the current token */
+    int pushToken;
+    int eolSeen;    /* private state to handle comments */
+    int lineStart;  /* the next character starts a new line */
+    int lineNo;
+    char *section;  /* name of current section being parsed */
+    char *path;     /* path to config file */
+}
+XConfigScannerRec;
+
+/*
+ * Identifier index for the sections of an XConfigRec; see
+ * xconfigBuildIndex() in Util.c.
+ */
+typedef enum
+{
+    XCONFIG_SECTION_VIDEOADAPTOR = 0,
+    XCONFIG_SECTION_MODES,
+    XCONFIG_SECTION_MONITOR,
+    XCONFIG_SECTION_DEVICE,
+    XCONFIG_SECTION_SCREEN,
+    XCONFIG_SECTION_INPUT,
+    XCONFIG_SECTION_INPUTCLASS,
+    XCONFIG_SECTION_LAYOUT,
+    XCONFIG_SECTION_VENDOR,
+    XCONFIG_SECTION_TYPE_COUNT
+}
+XConfigSectionType;
+
+typedef struct
+{
+    GenericListPtr *items;  /* open addressing hash table */
+    unsigned int size;      /* number of slots; a power of two */
+    unsigned int count;     /* number of used slots */
+    GenericListPtr tail;    /* last section in the list */
+    GenericListPtr unnamed; /* first section without an identifier */
+}
+XConfigIndexTableRec, *XConfigIndexTablePtr;
+
+typedef struct __xconfigindexrec
+{
+    XConfigIndexTableRec tables[XCONFIG_SECTION_TYPE_COUNT];
+}
+XConfigIndexRec;
+
 
 #include "configProcs.h"
 #include <stdlib.h>
@@ -61,8 +61,6 @@
 #include <math.h>
 #include "common-utils.h"
 
-extern LexRec val;
-
 static XConfigSymTabRec ServerFlagsTab[] =
 {
     {ENDSECTION, "endsection"},
@@ -60,8 +60,6 @@
 #include "Configint.h"
 #include <string.h>
 
-extern LexRec val;
-
 static XConfigSymTabRec LayoutTab[] =
 {
     {ENDSECTION, "endsection"},
@@ -454,7 +452,9 @@ xconfigValidateLayout (XConfigPtr p)
         while (adj)
         {
             /* the first one can't be "" but all others can */
-            screen = xconfigFindScreen (adj->screen_name, p->screens);
+            screen = (XConfigScreenPtr)
+                xconfigLookupSection(p, XCONFIG_SECTION_SCREEN,
+                                     adj->screen_name);
             if (!screen)
             {
                 xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_SCREEN_MSG,
@@ -478,8 +478,9 @@ xconfigValidateLayout (XConfigPtr p)
         iptr = layout->inactives;
         while (iptr)
         {
-            device = xconfigFindDevice (iptr->device_name,
-                                     p->devices);
+            device = (XConfigDevicePtr)
+                xconfigLookupSection(p, XCONFIG_SECTION_DEVICE,
+                                     iptr->device_name);
             if (!device)
             {
                 xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_DEVICE_MSG,
@@ -500,8 +501,9 @@ xconfigValidateLayout (XConfigPtr p)
         inputRef = layout->inputs;
         while (inputRef)
         {
-            input = xconfigFindInput (inputRef->input_name,
-                                   p->inputs);
+            input = (XConfigInputPtr)
+                xconfigLookupSection(p, XCONFIG_SECTION_INPUT,
+                                     inputRef->input_name);
             if (!input)
             {
                 xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_INPUT_MSG,
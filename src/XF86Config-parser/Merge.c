@@ -279,8 +279,9 @@ static int xconfigMergeAllMonitors(XConfigPtr dstConfig, XConfigPtr srcConfig)
          srcMonitor;
          srcMonitor = srcMonitor->next) {
 
-        dstMonitor =
-            xconfigFindMonitor(srcMonitor->identifier, dstConfig->monitors);
+        dstMonitor = (XConfigMonitorPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_MONITOR,
+                                 srcMonitor->identifier);
 
         /* Monitor section was not found, create a new one and add it */
         if (!dstMonitor) {
@@ -290,8 +291,8 @@ static int xconfigMergeAllMonitors(XConfigPtr dstConfig, XConfigPtr srcConfig)
 
             dstMonitor->identifier = xconfigStrdup(srcMonitor->identifier);
 
-            xconfigAddListItem((GenericListPtr *)(&dstConfig->monitors),
-                               (GenericListPtr)dstMonitor);
+            xconfigAppendSection(dstConfig, XCONFIG_SECTION_MONITOR,
+                                 (GenericListPtr)dstMonitor);
         }
 
         /* Do the merge */
@@ -369,8 +370,9 @@ static int xconfigMergeAllDevices(XConfigPtr dstConfig, XConfigPtr srcConfig)
          srcDevice;
          srcDevice = srcDevice->next) {
 
-        dstDevice =
-            xconfigFindDevice(srcDevice->identifier, dstConfig->devices);
+        dstDevice = (XConfigDevicePtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_DEVICE,
+                                 srcDevice->identifier);
         
         /* Device section was not found, create a new one and add it */
         if (!dstDevice) {
@@ -380,8 +382,8 @@ static int xconfigMergeAllDevices(XConfigPtr dstConfig, XConfigPtr srcConfig)
 
             dstDevice->identifier = xconfigStrdup(srcDevice->identifier);
 
-            xconfigAddListItem((GenericListPtr *)(&dstConfig->devices),
-                               (GenericListPtr)dstDevice);
+            xconfigAppendSection(dstConfig, XCONFIG_SECTION_DEVICE,
+                                 (GenericListPtr)dstDevice);
         }
 
         /* Do the merge */
@@ -551,16 +553,18 @@ static void xconfigMergeScreens(XConfigScreenPtr dstScreen,
     
     free(dstScreen->device_name);
     dstScreen->device_name = xconfigStrdup(srcScreen->device_name);
-    dstScreen->device =
-        xconfigFindDevice(dstScreen->device_name, dstConfig->devices);
+    dstScreen->device = (XConfigDevicePtr)
+        xconfigLookupSection(dstConfig, XCONFIG_SECTION_DEVICE,
+                             dstScreen->device_name);
     
 
     /* Use the right monitor */
     
     free(dstScreen->monitor_name);
     dstScreen->monitor_name = xconfigStrdup(srcScreen->monitor_name);
-    dstScreen->monitor =
-        xconfigFindMonitor(dstScreen->monitor_name, dstConfig->monitors);
+    dstScreen->monitor = (XConfigMonitorPtr)
+        xconfigLookupSection(dstConfig, XCONFIG_SECTION_MONITOR,
+                             dstScreen->monitor_name);
     
 
     /* Update the right default depth */
@@ -599,8 +603,9 @@ static int xconfigMergeAllScreens(XConfigPtr dstConfig, XConfigPtr srcConfig)
          srcScreen;
          srcScreen = srcScreen->next) {
 
-        dstScreen =
-            xconfigFindScreen(srcScreen->identifier, dstConfig->screens);
+        dstScreen = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 srcScreen->identifier);
 
         /* Screen section was not found, create a new one and add it */
         if (!dstScreen) {
@@ -610,8 +615,8 @@ static int xconfigMergeAllScreens(XConfigPtr dstConfig, XConfigPtr srcConfig)
 
             dstScreen->identifier = xconfigStrdup(srcScreen->identifier);
 
-            xconfigAddListItem((GenericListPtr *)(&dstConfig->screens),
-                               (GenericListPtr)dstScreen);
+            xconfigAppendSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 (GenericListPtr)dstScreen);
         }
 
         /* Do the merge */
@@ -668,16 +673,21 @@ static int xconfigMergeLayout(XConfigPtr dstConfig, XConfigPtr srcConfig)
         dstAdj->y = srcAdj->y;
         dstAdj->refscreen = xconfigStrdup(srcAdj->refscreen);
 
-        dstAdj->screen =
-            xconfigFindScreen(dstAdj->screen_name, dstConfig->screens);
-        dstAdj->top =
-            xconfigFindScreen(dstAdj->top_name, dstConfig->screens);
-        dstAdj->bottom =
-            xconfigFindScreen(dstAdj->bottom_name, dstConfig->screens);
-        dstAdj->left =
-            xconfigFindScreen(dstAdj->left_name, dstConfig->screens);
-        dstAdj->right =
-            xconfigFindScreen(dstAdj->right_name, dstConfig->screens);
+        dstAdj->screen = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 dstAdj->screen_name);
+        dstAdj->top = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 dstAdj->top_name);
+        dstAdj->bottom = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 dstAdj->bottom_name);
+        dstAdj->left = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 dstAdj->left_name);
+        dstAdj->right = (XConfigScreenPtr)
+            xconfigLookupSection(dstConfig, XCONFIG_SECTION_SCREEN,
+                                 dstAdj->right_name);
 
         /* Add adjacency at the end of the list */
         
@@ -745,7 +755,7 @@ static int  xconfigMergeExtensions(XConfigPtr dstConfig, XConfigPtr srcConfig)
 } /* xconfigMergeExtensions() */
 
 /*
- * xconfigMergeConfigs() - Merges the source X configuration with the
+ * xconfigMergeSections() - Merges the source X configuration with the
  * destination X configuration.
  *
  * NOTE: This function is currently only used for merging X config files
@@ -755,7 +765,7 @@ static int  xconfigMergeExtensions(XConfigPtr dstConfig, XConfigPtr srcConfig)
  *       copied from the source X config to the destination X config.
  *
  */
-int xconfigMergeConfigs(XConfigPtr dstConfig, XConfigPtr srcConfig)
+static int xconfigMergeSections(XConfigPtr dstConfig, XConfigPtr srcConfig)
 {
     /* Make sure the X config is valid */
     // make_xconfig_usable(dstConfig);
@@ -804,4 +814,23 @@ int xconfigMergeConfigs(XConfigPtr dstConfig, XConfigPtr srcConfig)
 
     return 1;
 
+} /* xconfigMergeSections() */
+
+
+
+/*
+ * xconfigMergeConfigs() - Merges the source X configuration with the
+ * destination X configuration; the destination's sections are indexed
+ * for the duration of the merge, so that it runs in linear time.
+ */
+int xconfigMergeConfigs(XConfigPtr dstConfig, XConfigPtr srcConfig)
+{
+    int ret;
+
+    xconfigBuildIndex(dstConfig);
+    ret = xconfigMergeSections(dstConfig, srcConfig);
+    xconfigFreeIndex(dstConfig);
+
+    return ret;
+
 } /* xconfigMergeConfigs() */
@@ -59,8 +59,6 @@
 #include "xf86tokens.h"
 #include "Configint.h"
 
-extern LexRec val;
-
 static XConfigSymTabRec MonitorTab[] =
 {
     {ENDSECTION, "endsection"},
@@ -907,7 +905,9 @@ xconfigValidateMonitor (XConfigPtr p, XConfigScreenPtr screen)
     XConfigModesPtr modes;
     while(modeslnk)
     {
-        modes = xconfigFindModes (modeslnk->modes_name, p->modes);
+        modes = (XConfigModesPtr)
+            xconfigLookupSection(p, XCONFIG_SECTION_MODES,
+                                 modeslnk->modes_name);
         if (!modes)
         {
             xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_MODES_MSG, 
@@ -57,8 +57,6 @@
 #include "xf86tokens.h"
 #include "Configint.h"
 
-extern LexRec val;
-
 static XConfigSymTabRec TopLevelTab[] =
 {
     {SECTION, "section"},
@@ -74,15 +72,14 @@ static XConfigSymTabRec TopLevelTab[] =
         return XCONFIG_RETURN_PARSE_ERROR; \
     }
 
-#define READ_HANDLE_LIST(field,func,type)                               \
+#define READ_HANDLE_LIST(type,func)                                     \
 {                                                                       \
-    type p = func();                                                    \
+    GenericListPtr p = (GenericListPtr) func();                         \
     if (p == NULL) {                                                    \
         xconfigFreeConfig(&ptr);                                        \
         return XCONFIG_RETURN_PARSE_ERROR;                              \
     } else {                                                            \
-        xconfigAddListItem((GenericListPtr *)(&ptr->field),             \
-                           (GenericListPtr) p);                         \
+        xconfigAppendSection(ptr, type, p);                             \
     }                                                                   \
 }
 
@@ -107,7 +104,15 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
 
     *configPtr = NULL;
 
+    if (!xconfigGetConfigFileName()) {
+        return XCONFIG_RETURN_PARSE_ERROR;
+    }
+
     ptr = xconfigAlloc(sizeof(XConfigRec));
+
+    /* index the sections as they are read, for validation */
+
+    xconfigBuildIndex(ptr);
     
     while ((token = xconfigGetToken(TopLevelTab)) != EOF_TOKEN) {
         
@@ -142,65 +147,64 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(inputs, xconfigParseKeyboardSection,
-                                 XConfigInputPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_INPUT,
+                                 xconfigParseKeyboardSection);
             }
             else if (xconfigNameCompare(val.str, "pointer") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(inputs, xconfigParsePointerSection,
-                                 XConfigInputPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_INPUT,
+                                 xconfigParsePointerSection);
             }
             else if (xconfigNameCompare(val.str, "videoadaptor") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(videoadaptors,
-                            xconfigParseVideoAdaptorSection,
-                                 XConfigVideoAdaptorPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_VIDEOADAPTOR,
+                                 xconfigParseVideoAdaptorSection);
             }
             else if (xconfigNameCompare(val.str, "device") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(devices, xconfigParseDeviceSection,
-                                 XConfigDevicePtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_DEVICE,
+                                 xconfigParseDeviceSection);
             }
             else if (xconfigNameCompare(val.str, "monitor") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(monitors, xconfigParseMonitorSection,
-                                 XConfigMonitorPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_MONITOR,
+                                 xconfigParseMonitorSection);
             }
             else if (xconfigNameCompare(val.str, "modes") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(modes, xconfigParseModesSection,
-                                 XConfigModesPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_MODES,
+                                 xconfigParseModesSection);
             }
             else if (xconfigNameCompare(val.str, "screen") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(screens, xconfigParseScreenSection,
-                                 XConfigScreenPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_SCREEN,
+                                 xconfigParseScreenSection);
             }
             else if (xconfigNameCompare(val.str, "inputdevice") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(inputs, xconfigParseInputSection,
-                                 XConfigInputPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_INPUT,
+                                 xconfigParseInputSection);
             }
             else if ((xconfigNameCompare(val.str, "inputclass") == 0))
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(inputclasses, xconfigParseInputClassSection,
-                                 XConfigInputClassPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_INPUTCLASS,
+                                 xconfigParseInputClassSection);
             }
             else if (xconfigNameCompare(val.str, "module") == 0)
             {
@@ -212,15 +216,15 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(layouts, xconfigParseLayoutSection,
-                                 XConfigLayoutPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_LAYOUT,
+                                 xconfigParseLayoutSection);
             }
             else if (xconfigNameCompare(val.str, "vendor") == 0)
             {
                 free(val.str);
                 val.str = NULL;
-                READ_HANDLE_LIST(vendors, xconfigParseVendorSection,
-                                 XConfigVendorPtr);
+                READ_HANDLE_LIST(XCONFIG_SECTION_VENDOR,
+                                 xconfigParseVendorSection);
             }
             else if (xconfigNameCompare(val.str, "dri") == 0)
             {
@@ -250,6 +254,7 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
     }
 
     if (xconfigValidateConfig(ptr)) {
+        xconfigFreeIndex(ptr);
         ptr->filename = strdup(xconfigGetConfigFileName());
         *configPtr = ptr;
         return XCONFIG_RETURN_SUCCESS;
@@ -262,6 +267,26 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
 #undef CLEANUP
 
 
+
+/*
+ * xconfigReadConfigScanner() - read the XConfig file opened with
+ * xconfigOpenConfigScanner(), returning the parsed data as XConfigPtr.
+ */
+
+XConfigError xconfigReadConfigScanner(XConfigScannerPtr s,
+                                      XConfigPtr *configPtr)
+{
+    XConfigScannerPtr prev;
+    XConfigError ret;
+
+    prev = xconfigSwitchScanner(s);
+    ret = xconfigReadConfigFile(configPtr);
+    xconfigSwitchScanner(prev);
+
+    return ret;
+}
+
+
 /* 
  * This function resolves name references and reports errors if the named
  * objects cannot be found.
@@ -269,16 +294,29 @@ XConfigError xconfigReadConfigFile(XConfigPtr *configPtr)
 
 int xconfigValidateConfig(XConfigPtr p)
 {
+    int ret = FALSE;
+    int indexed = (p->index != NULL);
+
+    /* use the section index for the lookups below */
+
+    xconfigBuildIndex(p);
+
     if (!xconfigValidateDevice(p))
-        return FALSE;
+        goto done;
     if (!xconfigValidateScreen(p))
-        return FALSE;
+        goto done;
     if (!xconfigValidateInput(p))
-        return FALSE;
+        goto done;
     if (!xconfigValidateLayout(p))
-        return FALSE;
-    
-    return(TRUE);
+        goto done;
+
+    ret = TRUE;
+
+ done:
+    if (!indexed) {
+        xconfigFreeIndex(p);
+    }
+    return ret;
 }
 
 
@@ -392,6 +430,7 @@ xconfigFreeConfig (XConfigPtr *p)
     xconfigFreeInputList (&((*p)->inputs));
     xconfigFreeVendorList (&((*p)->vendors));
     xconfigFreeDRI (&((*p)->dri));
+    xconfigFreeIndex (*p);
     TEST_FREE((*p)->comment);
 
     free (*p);
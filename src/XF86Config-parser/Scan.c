@@ -59,6 +59,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #if !defined(X_NOT_POSIX)
 #if defined(_POSIX_SOURCE)
@@ -84,22 +88,15 @@
 #include "Configint.h"
 #include "xf86tokens.h"
 
-#define CONFIG_BUF_LEN     1024
-
 static int StringToToken (char *, XConfigSymTabRec *);
 
-static FILE *configFile = NULL;
-static const char **builtinConfig = NULL;
-static int builtinIndex = 0;
-static int configPos = 0;            /* current readers position */
-static char *configBuf, *configRBuf; /* buffer for lines */
-static int pushToken = LOCK_TOKEN;
-static int eol_seen = 0;             /* private state to handle comments */
-LexRec val;
-
-int configLineNo = 0;         /* linenumber */
-char *configSection = NULL;   /* name of current section being parsed */
-char *configPath;             /* path to config file */
+/*
+ * The scanner of the config file currently being parsed by this thread;
+ * keeping the scanner state per thread (rather than in file-scope
+ * variables) allows several config files to be parsed concurrently.
+ */
+static __thread XConfigScannerPtr curScanner = NULL;
+__thread LexRec val;
 
 
 
@@ -177,126 +174,6 @@ static unsigned int xconfigStrToUL (char *str)
 }
 
 
-/*
- * xconfigGetNextLine --
- *
- *  read from the configFile FILE stream until we encounter a new
- *  line; this is effectively just a big wrapper for fgets(3).
- *
- *  xconfigGetToken() assumes that we will read up to the next
- *  newline; we need to grow configBuf and configRBuf as needed to
- *  support that.
- */
-
-static char *xconfigGetNextLine(void)
-{
-    static int configBufLen = CONFIG_BUF_LEN;
-    char *tmpConfigBuf, *tmpConfigRBuf;
-    int c, i, pos = 0, eolFound = 0;
-    char *ret = NULL;
-    
-    /*
-     * reallocate the string if it was grown last time (i.e., is no
-     * longer CONFIG_BUF_LEN); we malloc the new strings first, so
-     * that if either of the mallocs fail, we can fall back on the
-     * existing buffer allocations
-     */
-    
-    if (configBufLen != CONFIG_BUF_LEN) {
-                 
-        tmpConfigBuf = malloc(CONFIG_BUF_LEN);
-        tmpConfigRBuf = malloc(CONFIG_BUF_LEN);
-        
-        if (!tmpConfigBuf || !tmpConfigRBuf) {
-            
-            /*
-             * at least one of the mallocs failed; keep the old buffers
-             * and free any partial allocations
-             */
-            
-            free(tmpConfigBuf);
-            free(tmpConfigRBuf);
-            
-        } else {
-            
-            /*
-             * malloc succeeded; free the old buffers and use the new
-             * buffers
-             */
-            
-            configBufLen = CONFIG_BUF_LEN;
-            
-            free(configBuf);
-            free(configRBuf);
-            
-            configBuf = tmpConfigBuf;
-            configRBuf = tmpConfigRBuf;
-        }
-    }
-
-    /* read in another block of chars */
-    
-    do {
-        ret = fgets(configBuf + pos, configBufLen - pos - 1, configFile);
-        
-        if (!ret) break;
-        
-        /* search for EOL in the new block of chars */
-        
-        for (i = pos; i < (configBufLen - 1); i++) {
-            c = configBuf[i];
-            
-            if (c == '\0') break;
-            
-            if ((c == '\n') || (c == '\r')) {
-                eolFound = 1;
-                break;
-            }
-        }
-        
-        /*
-         * if we didn't find EOL, then grow the string and
-         * read in more
-         */
-        
-        if (!eolFound) {
-            
-            tmpConfigBuf = realloc(configBuf, configBufLen + CONFIG_BUF_LEN);
-            tmpConfigRBuf = realloc(configRBuf, configBufLen + CONFIG_BUF_LEN);
-            
-            if (!tmpConfigBuf || !tmpConfigRBuf) {
-                
-                /*
-                 * at least one of the reallocations failed; use the
-                 * new allocation that succeeded, but we have to
-                 * fallback to the previous configBufLen size and use
-                 * the string we have, even though we don't have an
-                 * EOL
-                 */
-                
-                if (tmpConfigBuf) configBuf = tmpConfigBuf;
-                if (tmpConfigRBuf) configRBuf = tmpConfigRBuf;
-                
-                break;
-                
-            } else {
-                
-                /* reallocation succeeded */
-
-                configBuf = tmpConfigBuf;
-                configRBuf = tmpConfigRBuf;
-                pos = i;
-                configBufLen += CONFIG_BUF_LEN;
-            }
-        }
-        
-    } while (!eolFound);
-    
-    return ret;
-}
-
-
-
 /* 
  * xconfigGetToken --
  *      Read next Token from the config file. Handle the global variable
@@ -305,92 +182,84 @@ static char *xconfigGetNextLine(void)
 
 int xconfigGetToken (XConfigSymTabRec * tab)
 {
+    XConfigScannerPtr s = curScanner;
     int c, i;
 
+    if (!s)
+        return (EOF_TOKEN);
+
     /* 
      * First check whether pushToken has a different value than LOCK_TOKEN.
      * In this case rBuf[] contains a valid STRING/TOKEN/NUMBER. But in the
      * oth * case the next token must be read from the input.
      */
-    if (pushToken == EOF_TOKEN)
+    if (s->pushToken == EOF_TOKEN)
         return (EOF_TOKEN);
-    else if (pushToken == LOCK_TOKEN)
+    else if (s->pushToken == LOCK_TOKEN)
     {
         /*
-         * eol_seen is only set for the first token after a newline.
+         * eolSeen is only set for the first token after a newline.
          */
-        eol_seen = 0;
-
-        c = configBuf[configPos];
+        s->eolSeen = 0;
 
         /* 
          * Get start of next Token. EOF is handled,
          * whitespaces are skipped. 
          */
 
-again:
-        if (!c)
-        {
-            char *ret;
-            if (configFile)
-                ret = xconfigGetNextLine();
-            else {
-                if (builtinConfig[builtinIndex] == NULL)
-                    ret = NULL;
-                else {
-                    ret = strncpy(configBuf, builtinConfig[builtinIndex],
-                            CONFIG_BUF_LEN);
-                    builtinIndex++;
-                }
+        i = 0;
+        for (;;) {
+            if (s->pos >= s->size)
+            {
+                return (s->pushToken = EOF_TOKEN);
             }
-            if (ret == NULL)
+            if (s->lineStart)
             {
-                return (pushToken = EOF_TOKEN);
+                s->lineNo++;
+                s->lineStart = 0;
+                s->eolSeen = 1;
             }
-            configLineNo++;
-            configPos = 0;
-            eol_seen = 1;
-        }
-
-        i = 0;
-        for (;;) {
-            c = configBuf[configPos++];
-            configRBuf[i++] = c;
+            c = s->buf[s->pos++];
+            s->rbuf[i++] = c;
             switch (c) {
                 case ' ':
                 case '\t':
                 case '\r':
+                case '\0':
                     continue;
                 case '\n':
                     i = 0;
+                    s->lineStart = 1;
                     continue;
             }
             break;
         }
-        if (c == '\0')
-            goto again;
 
         if (c == '#')
         {
             do
             {
-                configRBuf[i++] = (c = configBuf[configPos++]);
+                s->rbuf[i++] = (c = s->buf[s->pos++]);
             }
             while ((c != '\n') && (c != '\r') && (c != '\0'));
-            configRBuf[i] = '\0';
+            if (c == '\n')
+                s->lineStart = 1;
+            else if (c == '\0')
+                s->pos--;
+            s->rbuf[i] = '\0';
             /* XXX no private copy.
              * Use xconfigAddComment when setting a comment.
              */
-            val.str = configRBuf;
+            val.str = s->rbuf;
             return (COMMENT);
         }
 
         /* GJA -- handle '-' and ','  * Be careful: "-hsync" is a keyword. */
-        else if ((c == ',') && !xconfigIsAlpha(configBuf[configPos]))
+        else if ((c == ',') && !xconfigIsAlpha(s->buf[s->pos]))
         {
             return COMMA;
         }
-        else if ((c == '-') && !xconfigIsAlpha(configBuf[configPos]))
+        else if ((c == '-') && !xconfigIsAlpha(s->buf[s->pos]))
         {
             return DASH;
         }
@@ -403,26 +272,26 @@ again:
             int base;
 
             if (c == '0')
-                if ((configBuf[configPos] == 'x') ||
-                    (configBuf[configPos] == 'X'))
+                if ((s->buf[s->pos] == 'x') ||
+                    (s->buf[s->pos] == 'X'))
                     base = 16;
                 else
                     base = 8;
             else
                 base = 10;
 
-            configRBuf[0] = c;
+            s->rbuf[0] = c;
             i = 1;
-            while (xconfigIsDigit(c = configBuf[configPos++]) ||
+            while (xconfigIsDigit(c = s->buf[s->pos++]) ||
                    (c == '.') || (c == 'x') || (c == 'X') ||
                    ((base == 16) && (((c >= 'a') && (c <= 'f')) ||
                                      ((c >= 'A') && (c <= 'F')))))
-                configRBuf[i++] = c;
-            configPos--;        /* GJA -- one too far */
-            configRBuf[i] = '\0';
-            val.num = xconfigStrToUL (configRBuf);
-            val.realnum = atof (configRBuf);
-            val.str = configRBuf;
+                s->rbuf[i++] = c;
+            s->pos--;           /* GJA -- one too far */
+            s->rbuf[i] = '\0';
+            val.num = xconfigStrToUL (s->rbuf);
+            val.realnum = atof (s->rbuf);
+            val.str = s->rbuf;
             return (NUMBER);
         }
 
@@ -434,12 +303,16 @@ again:
             i = -1;
             do
             {
-                configRBuf[++i] = (c = configBuf[configPos++]);
+                s->rbuf[++i] = (c = s->buf[s->pos++]);
             }
             while ((c != '\"') && (c != '\n') && (c != '\r') && (c != '\0'));
-            configRBuf[i] = '\0';
-            val.str = malloc (strlen (configRBuf) + 1);
-            strcpy (val.str, configRBuf);    /* private copy ! */
+            if (c == '\n')
+                s->lineStart = 1;
+            else if (c == '\0')
+                s->pos--;
+            s->rbuf[i] = '\0';
+            val.str = malloc (strlen (s->rbuf) + 1);
+            strcpy (val.str, s->rbuf);    /* private copy ! */
             return (STRING);
         }
 
@@ -449,11 +322,11 @@ again:
          */
         else
         {
-            configRBuf[0] = c;
+            s->rbuf[0] = c;
             i = 0;
             do
             {
-                configRBuf[++i] = (c = configBuf[configPos++]);;
+                s->rbuf[++i] = (c = s->buf[s->pos++]);
             }
             while ((c != ' ')  &&
                    (c != '\t') &&
@@ -462,8 +335,8 @@ again:
                    (c != '\0') &&
                    (c != '#'));
             
-            --configPos;
-            configRBuf[i] = '\0';
+            --s->pos;
+            s->rbuf[i] = '\0';
             i = 0;
         }
 
@@ -475,8 +348,8 @@ again:
          * Here we deal with pushed tokens. Reinitialize pushToken again. If
          * the pushed token was NUMBER || STRING return them again ...
          */
-        int temp = pushToken;
-        pushToken = LOCK_TOKEN;
+        int temp = s->pushToken;
+        s->pushToken = LOCK_TOKEN;
 
         if (temp == COMMA || temp == DASH)
             return (temp);
@@ -491,7 +364,7 @@ again:
     {
         i = 0;
         while (tab[i].token != -1)
-            if (xconfigNameCompare (configRBuf, tab[i].name) == 0)
+            if (xconfigNameCompare (s->rbuf, tab[i].name) == 0)
                 return (tab[i].token);
             else
                 i++;
@@ -534,12 +407,13 @@ int xconfigGetSubTokenWithTab (char **comment, XConfigSymTabRec *tab)
 
 void xconfigUnGetToken (int token)
 {
-    pushToken = token;
+    if (curScanner)
+        curScanner->pushToken = token;
 }
 
 char *xconfigTokenString (void)
 {
-    return configRBuf;
+    return curScanner ? curScanner->rbuf : NULL;
 }
 
 static int pathIsAbsolute(const char *path)
@@ -640,9 +514,9 @@ static char *DoSubstitution(const char *template,
 {
     char *result;
     int i, l;
-    static const char *env = NULL;
-    static char *hostname = NULL;
-    static char majorvers[3] = "";
+    const char *env = NULL;
+    char hostname[MAXHOSTNAMELEN + 1] = "";
+    char majorvers[16] = "";
 
     if (!template)
         return NULL;
@@ -688,17 +562,14 @@ static char *DoSubstitution(const char *template,
                 APPEND_STR(XConfigFile);
                 break;
             case 'H':
-                if (!hostname) {
-                    if ((hostname = malloc(MAXHOSTNAMELEN + 1))) {
-                        if (gethostname(hostname, MAXHOSTNAMELEN) == 0) {
-                            hostname[MAXHOSTNAMELEN] = '\0';
-                        } else {
-                            free(hostname);
-                            hostname = NULL;
-                        }
+                if (!hostname[0]) {
+                    if (gethostname(hostname, MAXHOSTNAMELEN) == 0) {
+                        hostname[MAXHOSTNAMELEN] = '\0';
+                    } else {
+                        hostname[0] = '\0';
                     }
                 }
-                if (hostname)
+                if (hostname[0])
                     APPEND_STR(hostname);
                 break;
             case 'E':
@@ -826,18 +697,125 @@ static const char __user_configpath[] =
 
 
 
-const char *xconfigOpenConfigFile(const char *cmdline, const char *projroot)
+/*
+ * CreateScanner() - map (or, if that is not possible, read) the whole
+ * config file into memory and create a scanner for it; tokens are
+ * scanned directly out of that buffer.  Returns NULL if the file cannot
+ * be opened or read.
+ */
+
+static XConfigScannerPtr CreateScanner(const char *path)
 {
+    XConfigScannerPtr s;
+    struct stat st;
+    long pagesize = sysconf(_SC_PAGESIZE);
+    size_t len, maxLine = 0;
+    const char *line, *end;
+    ssize_t n;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    s = calloc(1, sizeof(XConfigScannerRec));
+    if (!s) {
+        close(fd);
+        return NULL;
+    }
+
+    /*
+     * The scanner relies on the buffer being NUL-terminated: only map
+     * files whose size is not a multiple of the page size, so that the
+     * mapping is padded with zeros past the end of the file.
+     */
+
+    if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) &&
+        (st.st_size > 0) && (pagesize > 0) && (st.st_size % pagesize)) {
+        s->buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (s->buf != MAP_FAILED) {
+            s->size = st.st_size;
+            s->mapped = 1;
+        } else {
+            s->buf = NULL;
+        }
+    }
+
+    if (!s->mapped) {
+        len = 0;
+        do {
+            if (s->size + 1 >= len) {
+                char *tmp;
+                len = len ? len * 2 : PATH_MAX;
+                tmp = realloc(s->buf, len);
+                if (!tmp) {
+                    goto fail;
+                }
+                s->buf = tmp;
+            }
+            n = read(fd, s->buf + s->size, len - s->size - 1);
+            if (n < 0) {
+                goto fail;
+            }
+            s->size += n;
+        } while (n > 0);
+        s->buf[s->size] = '\0';
+    }
+
+    close(fd);
+    fd = -1;
+
+    /* size the token buffer for the longest line */
+
+    for (line = s->buf; line < s->buf + s->size; line = end + 1) {
+        end = memchr(line, '\n', s->buf + s->size - line);
+        if (!end) {
+            end = s->buf + s->size;
+        }
+        if ((size_t)(end - line) > maxLine) {
+            maxLine = end - line;
+        }
+    }
+
+    s->rbuf = malloc(maxLine + 2);
+    s->path = strdup(path);
+    if (!s->rbuf || !s->path) {
+        goto fail;
+    }
+
+    s->rbuf[0] = '\0';
+    s->pushToken = LOCK_TOKEN;
+    s->lineStart = 1;
+
+    return s;
+
+ fail:
+    if (fd >= 0) {
+        close(fd);
+    }
+    xconfigCloseConfigScanner(s);
+    return NULL;
+}
+
+
+
+/*
+ * xconfigOpenConfigScanner() - locate the config file as described for
+ * xconfigOpenConfigFile() below, and return a scanner for it that can
+ * be passed to xconfigReadConfigScanner().  Any number of scanners may
+ * be open at once.  Returns NULL when no file is found.
+ */
+
+XConfigScannerPtr xconfigOpenConfigScanner(const char *cmdline,
+                                           const char *projroot)
+{
+    XConfigScannerPtr s = NULL;
     const char *searchpath;
-    char *pathcopy;
+    char *pathcopy, *path, *saveptr;
     const char *template;
     int cmdlineUsed = 0;
 
-    configFile = NULL;
-    configPos = 0;        /* current readers position */
-    configLineNo = 0;    /* linenumber */
-    pushToken = LOCK_TOKEN;
-
     /*
      * select the search path: XFree86 uses a slightly different path
      * depending on whether the user is root
@@ -853,95 +831,121 @@ const char *xconfigOpenConfigFile(const char *cmdline, const char *projroot)
     
     pathcopy = strdup(searchpath);
     
-    template = strtok(pathcopy, ",");
+    template = strtok_r(pathcopy, ",", &saveptr);
 
     /* First, search for a config file. */
-    while (template && !configFile) {
-        if ((configPath = DoSubstitution(template, cmdline, projroot,
-                                         &cmdlineUsed, NULL, XCONFIGFILE))) {
-            if ((configFile = fopen(configPath, "r")) != 0) {
-                if (cmdline && !cmdlineUsed) {
-                    fclose(configFile);
-                    configFile = NULL;
-                }
+    while (template && !s) {
+        if ((path = DoSubstitution(template, cmdline, projroot,
+                                   &cmdlineUsed, NULL, XCONFIGFILE))) {
+            if (!cmdline || cmdlineUsed) {
+                s = CreateScanner(path);
             }
+            free(path);
         }
-        if (configPath && !configFile) {
-            free(configPath);
-            configPath = NULL;
-        }
-        template = strtok(NULL, ",");
+        template = strtok_r(NULL, ",", &saveptr);
     }
 
     /* Then search for fallback */
-    if (!configFile) {
+    if (!s) {
         strcpy(pathcopy, searchpath);
-        template = strtok(pathcopy, ",");
+        template = strtok_r(pathcopy, ",", &saveptr);
         
-        while (template && !configFile) {
-            if ((configPath = DoSubstitution(template, cmdline, projroot,
-                                             &cmdlineUsed, NULL,
-                                             XFREE86CFGFILE))) {
-                if ((configFile = fopen(configPath, "r")) != 0) {
-                    if (cmdline && !cmdlineUsed) {
-                        fclose(configFile);
-                        configFile = NULL;
-                    }
+        while (template && !s) {
+            if ((path = DoSubstitution(template, cmdline, projroot,
+                                       &cmdlineUsed, NULL,
+                                       XFREE86CFGFILE))) {
+                if (!cmdline || cmdlineUsed) {
+                    s = CreateScanner(path);
                 }
+                free(path);
             }
-            if (configPath && !configFile) {
-                free(configPath);
-                configPath = NULL;
-            }
-            template = strtok(NULL, ",");
+            template = strtok_r(NULL, ",", &saveptr);
         }
     }
     
     free(pathcopy);
 
-    if (!configFile) {
-        return NULL;
+    return s;
+}
+
+void xconfigCloseConfigScanner(XConfigScannerPtr s)
+{
+    if (!s) {
+        return;
+    }
+
+    if (curScanner == s) {
+        curScanner = NULL;
     }
 
-    configBuf = malloc(CONFIG_BUF_LEN);
-    configRBuf = malloc(CONFIG_BUF_LEN);
-    configBuf[0] = '\0';
+    if (s->mapped) {
+        munmap(s->buf, s->size);
+    } else {
+        free(s->buf);
+    }
+    free(s->rbuf);
+    free(s->section);
+    free(s->path);
+    free(s);
+}
 
-    return configPath;
+const char *xconfigGetScannerFileName(XConfigScannerPtr s)
+{
+    return s ? s->path : NULL;
+}
+
+/*
+ * xconfigSwitchScanner() - make the given scanner the one used by this
+ * thread's calls to xconfigGetToken() and friends; returns the
+ * previously current scanner.
+ */
+
+XConfigScannerPtr xconfigSwitchScanner(XConfigScannerPtr s)
+{
+    XConfigScannerPtr prev = curScanner;
+
+    curScanner = s;
+
+    return prev;
+}
+
+const char *xconfigOpenConfigFile(const char *cmdline, const char *projroot)
+{
+    curScanner = xconfigOpenConfigScanner(cmdline, projroot);
+
+    return xconfigGetScannerFileName(curScanner);
 }
 
 void xconfigCloseConfigFile (void)
 {
-    free (configPath);
-    configPath = NULL;
-    free (configRBuf);
-    configRBuf = NULL;
-    free (configBuf);
-    configBuf = NULL;
-
-    if (configFile) {
-        fclose (configFile);
-        configFile = NULL;
-    } else {
-        builtinConfig = NULL;
-        builtinIndex = 0;
-    }
+    xconfigCloseConfigScanner(curScanner);
 }
 
 
 char *xconfigGetConfigFileName(void)
 {
-    return configPath;
+    return curScanner ? curScanner->path : NULL;
+}
+
+int xconfigGetLineNumber(void)
+{
+    return curScanner ? curScanner->lineNo : 0;
+}
+
+char *xconfigGetSection(void)
+{
+    return curScanner ? curScanner->section : NULL;
 }
 
 
 void
 xconfigSetSection (char *section)
 {
-    if (configSection)
-        free(configSection);
-    configSection = malloc(strlen (section) + 1);
-    strcpy (configSection, section);
+    if (!curScanner)
+        return;
+    free(curScanner->section);
+    curScanner->section = malloc(strlen (section) + 1);
+    strcpy (curScanner->section, section);
 }
 
 /* 
@@ -954,7 +958,7 @@ char *
 xconfigAddComment(char *cur, char *add)
 {
     char *str;
-    int len, curlen, iscomment, hasnewline = 0, endnewline;
+    int len, curlen, iscomment, hasnewline = 0, endnewline, eol_seen;
 
     if (add == NULL || add[0] == '\0')
         return (cur);
@@ -963,7 +967,8 @@ xconfigAddComment(char *cur, char *add)
         curlen = strlen(cur);
         if (curlen)
             hasnewline = cur[curlen - 1] == '\n';
-        eol_seen = 0;
+        if (curScanner)
+            curScanner->eolSeen = 0;
     }
     else
         curlen = 0;
@@ -976,6 +981,7 @@ xconfigAddComment(char *cur, char *add)
         ++str;
     }
     iscomment = (*str == '#');
+    eol_seen = curScanner ? curScanner->eolSeen : 0;
 
     len = strlen(add);
     endnewline = add[len - 1] == '\n';
@@ -59,8 +59,6 @@
 #include "xf86tokens.h"
 #include "Configint.h"
 
-extern LexRec val;
-
 static XConfigSymTabRec DisplayTab[] =
 {
     {ENDSUBSECTION, "endsubsection"},
@@ -511,10 +509,15 @@ xconfigValidateScreen (XConfigPtr p)
 
     while (screen)
     {
-        if (screen->obsolete_driver && !screen->identifier)
+        if (screen->obsolete_driver && !screen->identifier) {
             screen->identifier = screen->obsolete_driver;
+            xconfigIndexSection(p, XCONFIG_SECTION_SCREEN,
+                                (GenericListPtr) screen);
+        }
 
-        monitor = xconfigFindMonitor (screen->monitor_name, p->monitors);
+        monitor = (XConfigMonitorPtr)
+            xconfigLookupSection(p, XCONFIG_SECTION_MONITOR,
+                                 screen->monitor_name);
         if (screen->monitor_name)
         {
             if (!monitor)
@@ -531,7 +534,9 @@ xconfigValidateScreen (XConfigPtr p)
             }
         }
 
-        device = xconfigFindDevice (screen->device_name, p->devices);
+        device = (XConfigDevicePtr)
+            xconfigLookupSection(p, XCONFIG_SECTION_DEVICE,
+                                 screen->device_name);
         if (!device)
         {
             xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_DEVICE_MSG,
@@ -543,8 +548,9 @@ xconfigValidateScreen (XConfigPtr p)
 
         adaptor = screen->adaptors;
         while (adaptor) {
-            adaptor->adaptor = xconfigFindVideoAdaptor(adaptor->adaptor_name,
-                                                       p->videoadaptors);
+            adaptor->adaptor = (XConfigVideoAdaptorPtr)
+                xconfigLookupSection(p, XCONFIG_SECTION_VIDEOADAPTOR,
+                                     adaptor->adaptor_name);
             if (!adaptor->adaptor) {
                 xconfigErrorMsg(ValidationErrorMsg, UNDEFINED_ADAPTOR_MSG,
                              adaptor->adaptor_name,
@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #include "xf86Parser.h"
 #include "Configint.h"
@@ -111,10 +112,6 @@ char *xconfigStrcat(const char *str, ...)
 
 #define NV_FMT_BUF_LEN 64
 
-extern int configLineNo;
-extern char *configSection;
-extern char *configPath;
-
 void xconfigErrorMsg(MsgType t, char *fmt, ...)
 {
     va_list ap;
@@ -143,17 +140,20 @@ void xconfigErrorMsg(MsgType t, char *fmt, ...)
 
     switch (t) {
     case ParseErrorMsg:
-        sprintf(scratch, "%d", configLineNo);
+        sprintf(scratch, "%d", xconfigGetLineNumber());
         pre = xconfigStrcat("Parse error on line ", scratch, " of section ",
-                         configSection, " in file ", configPath, ".\n", NULL);
+                            xconfigGetSection(), " in file ",
+                            xconfigGetConfigFileName(), ".\n", NULL);
         break;
     case ParseWarningMsg:
-        sprintf(scratch, "%d", configLineNo);
+        sprintf(scratch, "%d", xconfigGetLineNumber());
         pre = xconfigStrcat("Parse warning on line ", scratch, " of section ",
-                         configSection, " in file ", configPath, ".\n", NULL);
+                            xconfigGetSection(), " in file ",
+                            xconfigGetConfigFileName(), ".\n", NULL);
         break;
     case ValidationErrorMsg:
-        pre = xconfigStrcat("Data incomplete in file ", configPath, ".\n", NULL);
+        pre = xconfigStrcat("Data incomplete in file ",
+                            xconfigGetConfigFileName(), ".\n", NULL);
         break;
     case InternalErrorMsg: break;
     case WriteErrorMsg: break;
@@ -178,3 +178,258 @@ void xconfigErrorMsg(MsgType t, char *fmt, ...)
     free(msg);
     if (pre) free(pre);
 }
+
+
+
+/*
+ * Section identifier index
+ *
+ * Finding a section by its identifier with xconfigFind*() walks the
+ * section list, and appending with xconfigAddListItem() walks to its
+ * end, which makes reading, validating and merging configs with many
+ * sections quadratic.  While the parser has exclusive control of an
+ * XConfigRec (while reading and validating it, and while merging into
+ * it), it keeps a hash table of each section list, keyed by identifier
+ * with the same rules as xconfigNameCompare(), along with the tail of
+ * each list.  Sections appended with xconfigAppendSection() are added to
+ * the index.  Callers outside the parser may modify the section lists
+ * directly, so the index is freed afterwards.
+ */
+
+static const struct {
+    size_t list;        /* offset of the section list in XConfigRec */
+    size_t identifier;  /* offset of the identifier in the section */
+} SectionTypes[XCONFIG_SECTION_TYPE_COUNT] = {
+    [XCONFIG_SECTION_VIDEOADAPTOR] = {
+        offsetof(XConfigRec, videoadaptors),
+        offsetof(XConfigVideoAdaptorRec, identifier) },
+    [XCONFIG_SECTION_MODES] = {
+        offsetof(XConfigRec, modes),
+        offsetof(XConfigModesRec, identifier) },
+    [XCONFIG_SECTION_MONITOR] = {
+        offsetof(XConfigRec, monitors),
+        offsetof(XConfigMonitorRec, identifier) },
+    [XCONFIG_SECTION_DEVICE] = {
+        offsetof(XConfigRec, devices),
+        offsetof(XConfigDeviceRec, identifier) },
+    [XCONFIG_SECTION_SCREEN] = {
+        offsetof(XConfigRec, screens),
+        offsetof(XConfigScreenRec, identifier) },
+    [XCONFIG_SECTION_INPUT] = {
+        offsetof(XConfigRec, inputs),
+        offsetof(XConfigInputRec, identifier) },
+    [XCONFIG_SECTION_INPUTCLASS] = {
+        offsetof(XConfigRec, inputclasses),
+        offsetof(XConfigInputClassRec, identifier) },
+    [XCONFIG_SECTION_LAYOUT] = {
+        offsetof(XConfigRec, layouts),
+        offsetof(XConfigLayoutRec, identifier) },
+    [XCONFIG_SECTION_VENDOR] = {
+        offsetof(XConfigRec, vendors),
+        offsetof(XConfigVendorRec, identifier) },
+};
+
+static GenericListPtr *SectionList(XConfigPtr p, XConfigSectionType type)
+{
+    return (GenericListPtr *)((char *)p + SectionTypes[type].list);
+}
+
+static const char *SectionIdentifier(XConfigSectionType type,
+                                     GenericListPtr item)
+{
+    return *(const char **)((char *)item + SectionTypes[type].identifier);
+}
+
+/*
+ * HashIdentifier() - FNV-1a hash of the identifier, ignoring the
+ * characters and case that xconfigNameCompare() ignores.
+ */
+
+static unsigned int HashIdentifier(const char *s)
+{
+    unsigned int hash = 2166136261u;
+    char c;
+
+    for (; *s; s++) {
+        c = *s;
+        if ((c == '_') || (c == ' ') || (c == '\t')) {
+            continue;
+        }
+        if ((c >= 'A') && (c <= 'Z')) {
+            c += 'a' - 'A';
+        }
+        hash = (hash ^ (unsigned char) c) * 16777619u;
+    }
+
+    return hash;
+}
+
+static GenericListPtr *IndexSlot(XConfigIndexTablePtr t,
+                                 XConfigSectionType type, const char *ident)
+{
+    unsigned int mask = t->size - 1;
+    unsigned int i = HashIdentifier(ident) & mask;
+
+    while (t->items[i] &&
+           xconfigNameCompare(ident, SectionIdentifier(type, t->items[i]))) {
+        i = (i + 1) & mask;
+    }
+
+    return &t->items[i];
+}
+
+static void IndexInsert(XConfigIndexTablePtr t, XConfigSectionType type,
+                        GenericListPtr item)
+{
+    const char *ident = SectionIdentifier(type, item);
+    GenericListPtr *slot;
+    GenericListPtr *old;
+    unsigned int i, oldSize;
+
+    if (!ident || !ident[0]) {
+        if (!t->unnamed) {
+            t->unnamed = item;
+        }
+        return;
+    }
+
+    /* keep the table at most half full */
+
+    if (2 * (t->count + 1) > t->size) {
+        old = t->items;
+        oldSize = t->size;
+
+        t->size = oldSize ? oldSize * 2 : 16;
+        t->items = xconfigAlloc(t->size * sizeof(GenericListPtr));
+
+        for (i = 0; i < oldSize; i++) {
+            if (old[i]) {
+                *IndexSlot(t, type, SectionIdentifier(type, old[i])) = old[i];
+            }
+        }
+        free(old);
+    }
+
+    /*
+     * like xconfigFind*(), find the first section in the list with a
+     * given identifier
+     */
+
+    slot = IndexSlot(t, type, ident);
+    if (!*slot) {
+        *slot = item;
+        t->count++;
+    }
+}
+
+/*
+ * xconfigBuildIndex() - build the identifier index of all section lists
+ * of the config.
+ */
+
+void xconfigBuildIndex(XConfigPtr p)
+{
+    XConfigIndexTablePtr t;
+    GenericListPtr item;
+    int type;
+
+    if (p->index) {
+        return;
+    }
+
+    p->index = xconfigAlloc(sizeof(XConfigIndexRec));
+
+    for (type = 0; type < XCONFIG_SECTION_TYPE_COUNT; type++) {
+        t = &p->index->tables[type];
+        for (item = *SectionList(p, type); item; item = item->next) {
+            IndexInsert(t, type, item);
+            t->tail = item;
+        }
+    }
+}
+
+void xconfigFreeIndex(XConfigPtr p)
+{
+    int type;
+
+    if (!p->index) {
+        return;
+    }
+
+    for (type = 0; type < XCONFIG_SECTION_TYPE_COUNT; type++) {
+        free(p->index->tables[type].items);
+    }
+    free(p->index);
+    p->index = NULL;
+}
+
+/*
+ * xconfigIndexSection() - add a section that is already in its list to
+ * the index; this is needed when a section's identifier is assigned
+ * after it has been added to the list.
+ */
+
+void xconfigIndexSection(XConfigPtr p, XConfigSectionType type,
+                         GenericListPtr item)
+{
+    if (p->index) {
+        IndexInsert(&p->index->tables[type], type, item);
+    }
+}
+
+/*
+ * xconfigAppendSection() - add a section to the end of its list in the
+ * config, and to the index.
+ */
+
+void xconfigAppendSection(XConfigPtr p, XConfigSectionType type,
+                          GenericListPtr item)
+{
+    XConfigIndexTablePtr t;
+
+    if (!p->index) {
+        xconfigAddListItem(SectionList(p, type), item);
+        return;
+    }
+
+    t = &p->index->tables[type];
+
+    if (t->tail) {
+        t->tail->next = item;
+    } else {
+        *SectionList(p, type) = item;
+    }
+
+    for (; item; item = item->next) {
+        IndexInsert(t, type, item);
+        t->tail = item;
+    }
+}
+
+/*
+ * xconfigLookupSection() - find the first section of the given type with
+ * the given identifier, like the xconfigFind*() functions do.
+ */
+
+GenericListPtr xconfigLookupSection(XConfigPtr p, XConfigSectionType type,
+                                    const char *ident)
+{
+    XConfigIndexTablePtr t;
+    GenericListPtr item;
+
+    if (p->index) {
+        t = &p->index->tables[type];
+        if (!ident || !ident[0]) {
+            return t->unnamed;
+        }
+        return t->size ? *IndexSlot(t, type, ident) : NULL;
+    }
+
+    for (item = *SectionList(p, type); item; item = item->next) {
+        if (xconfigNameCompare(ident, SectionIdentifier(type, item)) == 0) {
+            return item;
+        }
+    }
+
+    return NULL;
+}
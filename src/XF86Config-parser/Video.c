@@ -58,8 +58,6 @@
 #include "xf86tokens.h"
 #include "Configint.h"
 
-extern LexRec val;
-
 static XConfigSymTabRec VideoPortTab[] =
 {
     {ENDSUBSECTION, "endsubsection"},
@@ -59,40 +59,20 @@
 #include "xf86tokens.h"
 #include "Configint.h"
 
+#include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <errno.h>
 #include <locale.h>
 
 
-int xconfigWriteConfigFile (const char *filename, XConfigPtr cptr)
-{
-    FILE *cf;
-    char *locale;
-    
-    if ((cf = fopen(filename, "w")) == NULL)
-    {
-        xconfigErrorMsg(WriteErrorMsg, "Unable to open the file \"%s\" for "
-                     "writing (%s).\n", filename, strerror(errno));
-        return FALSE;
-    }
-
-    /*
-     * read the current locale and then set the standard "C" locale,
-     * so that the X configuration writer does not use locale-specific
-     * formatting.  After writing the configuration file, we restore
-     * the original locale.
-     */
 
-    locale = setlocale(LC_ALL, NULL);
-    
-    if (locale) locale = strdup(locale);
-
-    setlocale(LC_ALL, "C");
-    
-    
+static void PrintConfig (FILE *cf, XConfigPtr cptr)
+{
     if (cptr->comment)
         fprintf (cf, "%s\n", cptr->comment);
 
@@ -131,8 +111,45 @@ int xconfigWriteConfigFile (const char *filename, XConfigPtr cptr)
     xconfigPrintDRISection (cf, cptr->dri);
 
     xconfigPrintExtensionsSection (cf, cptr->extensions);
+}
+
+
 
-    fclose(cf);
+/*
+ * xconfigWriteConfigBuffer() - render the config into a newly allocated,
+ * NUL-terminated buffer in a single pass; the length of the text is
+ * returned in len.  The caller should free the buffer with free().
+ * Returns NULL on failure.
+ */
+
+char *xconfigWriteConfigBuffer (XConfigPtr cptr, size_t *len)
+{
+    FILE *cf;
+    char *buf = NULL;
+    size_t size = 0;
+    char *locale;
+
+    if ((cf = open_memstream(&buf, &size)) == NULL)
+    {
+        xconfigErrorMsg(WriteErrorMsg, "Unable to allocate a buffer for "
+                     "the X configuration (%s).\n", strerror(errno));
+        return NULL;
+    }
+
+    /*
+     * read the current locale and then set the standard "C" locale,
+     * so that the X configuration writer does not use locale-specific
+     * formatting.  After writing the configuration file, we restore
+     * the original locale.
+     */
+
+    locale = setlocale(LC_ALL, NULL);
+    
+    if (locale) locale = strdup(locale);
+
+    setlocale(LC_ALL, "C");
+    
+    PrintConfig (cf, cptr);
 
     /* restore the original locale */
 
@@ -141,5 +158,161 @@ int xconfigWriteConfigFile (const char *filename, XConfigPtr cptr)
         free(locale);
     }
 
+    if (fclose(cf) != 0)
+    {
+        xconfigErrorMsg(WriteErrorMsg, "Unable to write the X configuration "
+                     "to a buffer (%s).\n", strerror(errno));
+        free(buf);
+        return NULL;
+    }
+
+    if (len) *len = size;
+
+    return buf;
+}
+
+
+
+static int WriteAll (int fd, const char *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        buf += written;
+        len -= written;
+    }
+
     return TRUE;
 }
+
+/*
+ * xconfigWriteBufferToFile() - replace the contents of the file with
+ * the given buffer.  The buffer is written to a temporary file in the
+ * same directory, flushed to disk and renamed over the file, so that
+ * the file is never left partially written.  An existing file keeps its
+ * owner, group and permissions; if the file is a symbolic link, its
+ * target is replaced.  If no temporary file can be created in the
+ * directory, or it cannot be given the owner and group of the file, the
+ * file is overwritten in place.
+ */
+
+int xconfigWriteBufferToFile (const char *filename, const char *buf,
+                              size_t len)
+{
+    struct stat st;
+    char *target, *tmp = NULL, *slash;
+    mode_t mode, mask;
+    int fd, dirfd, have_stat, ret = FALSE;
+
+    if ((target = realpath(filename, NULL)) == NULL)
+        target = strdup(filename);
+    if (!target)
+        return FALSE;
+
+    have_stat = (stat(target, &st) == 0);
+
+    if (have_stat) {
+        mode = st.st_mode & 07777;
+    } else {
+        mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+
+    tmp = xconfigStrcat(target, ".XXXXXX", NULL);
+    fd = mkstemp(tmp);
+
+    if (fd >= 0 && have_stat && fchown(fd, st.st_uid, st.st_gid) != 0) {
+
+        /* replacing the file would change its owner or group */
+
+        close(fd);
+        unlink(tmp);
+        fd = -1;
+    }
+
+    if (fd < 0) {
+
+        /* fall back to writing the file in place */
+
+        free(tmp);
+        tmp = NULL;
+        fd = open(target, O_WRONLY | O_CREAT | O_TRUNC, mode);
+        if (fd < 0) {
+            xconfigErrorMsg(WriteErrorMsg, "Unable to open the file \"%s\" "
+                         "for writing (%s).\n", filename, strerror(errno));
+            goto done;
+        }
+    }
+
+    if (!WriteAll(fd, buf, len) ||
+        (tmp && (fchmod(fd, mode) != 0 || fsync(fd) != 0))) {
+        xconfigErrorMsg(WriteErrorMsg, "Unable to write the file \"%s\" "
+                     "(%s).\n", tmp ? tmp : filename, strerror(errno));
+        close(fd);
+        goto done;
+    }
+
+    if (close(fd) != 0) {
+        xconfigErrorMsg(WriteErrorMsg, "Unable to write the file \"%s\" "
+                     "(%s).\n", tmp ? tmp : filename, strerror(errno));
+        goto done;
+    }
+
+    if (tmp) {
+        if (rename(tmp, target) != 0) {
+            xconfigErrorMsg(WriteErrorMsg, "Unable to rename \"%s\" to "
+                         "\"%s\" (%s).\n", tmp, target, strerror(errno));
+            goto done;
+        }
+        free(tmp);
+        tmp = NULL;
+
+        /* make the rename itself durable */
+
+        slash = strrchr(target, '/');
+        if (slash) {
+            *slash = '\0';
+            dirfd = open(slash == target ? "/" : target, O_RDONLY);
+        } else {
+            dirfd = open(".", O_RDONLY);
+        }
+        if (dirfd >= 0) {
+            fsync(dirfd);
+            close(dirfd);
+        }
+    }
+
+    ret = TRUE;
+
+ done:
+    if (tmp) {
+        unlink(tmp);
+        free(tmp);
+    }
+    free(target);
+    return ret;
+}
+
+
+
+int xconfigWriteConfigFile (const char *filename, XConfigPtr cptr)
+{
+    char *buf;
+    size_t len;
+    int ret;
+
+    if ((buf = xconfigWriteConfigBuffer(cptr, &len)) == NULL)
+        return FALSE;
+
+    ret = xconfigWriteBufferToFile(filename, buf, len);
+
+    free(buf);
+
+    return ret;
+}
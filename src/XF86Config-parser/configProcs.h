@@ -106,6 +106,9 @@ char *xconfigTokenString(void);
 void xconfigSetSection(char *section);
 int xconfigGetStringToken(XConfigSymTabRec *tab);
 char *xconfigGetConfigFileName(void);
+int xconfigGetLineNumber(void);
+char *xconfigGetSection(void);
+XConfigScannerPtr xconfigSwitchScanner(XConfigScannerPtr s);
 
 /* Write.c */
 
@@ -117,6 +120,14 @@ void xconfigPrintDRISection (FILE * cf, XConfigDRIPtr ptr);
 /* Util.c */
 void *xconfigAlloc(size_t size);
 void xconfigErrorMsg(MsgType, char *fmt, ...);
+void xconfigBuildIndex(XConfigPtr p);
+void xconfigFreeIndex(XConfigPtr p);
+void xconfigIndexSection(XConfigPtr p, XConfigSectionType type,
+                         GenericListPtr item);
+void xconfigAppendSection(XConfigPtr p, XConfigSectionType type,
+                          GenericListPtr item);
+GenericListPtr xconfigLookupSection(XConfigPtr p, XConfigSectionType type,
+                                    const char *ident);
 
 /* Extensions.c */
 XConfigExtensionsPtr xconfigParseExtensionsSection (void);
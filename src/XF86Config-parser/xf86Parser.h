@@ -600,6 +600,7 @@ typedef struct {
     XConfigExtensionsPtr   extensions;
     char                  *comment;
     char                  *filename;
+    struct __xconfigindexrec *index;  /* private; see xconfigBuildIndex() */
 } XConfigRec, *XConfigPtr;
 
 typedef struct {
@@ -636,6 +637,22 @@ int xconfigSanitizeConfig(XConfigPtr p, const char *screenName,
                           GenerateOptions *gop);
 void xconfigCloseConfigFile(void);
 int xconfigWriteConfigFile(const char *, XConfigPtr);
+char *xconfigWriteConfigBuffer(XConfigPtr, size_t *);
+int xconfigWriteBufferToFile(const char *, const char *, size_t);
+
+/*
+ * Reentrant versions of the above: each scanner holds the state for one
+ * config file, so several files may be open and parsed (from different
+ * threads) at the same time.
+ */
+typedef struct __xconfigscannerrec *XConfigScannerPtr;
+
+XConfigScannerPtr xconfigOpenConfigScanner(const char *cmdline,
+                                           const char *projroot);
+const char *xconfigGetScannerFileName(XConfigScannerPtr s);
+XConfigError xconfigReadConfigScanner(XConfigScannerPtr s,
+                                      XConfigPtr *configPtr);
+void xconfigCloseConfigScanner(XConfigScannerPtr s);
 
 void xconfigFreeConfig(XConfigPtr *p);
 
@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <dirent.h>
 #include <ctype.h>
@@ -58,52 +59,106 @@
 # define NV_JSON_OBJECT_FOREACH(object, key, value) json_object_foreach(object, key, value)
 #endif
 
+/*
+ * slurp() - read the contents of the given file into a single string,
+ * skipping empty lines; each remaining line is preceded by a newline.  The
+ * file is read in chunks into a geometrically growing buffer, and the lines
+ * are then compacted in place, so that this is linear in the size of the
+ * file.
+ */
+
 static char *slurp(FILE *fp)
 {
-    int eof = FALSE;
-    char *text = strdup("");
-    char *new_text;
+    size_t len, size, n;
+    char *text, *line, *end, *limit, *out;
+
+    /* leave room for the newline inserted in front of the first line */
 
-    while (text && !eof) {
-        char *line = fget_next_line(fp, &eof);
+    size = 4096;
+    len = 1;
+    text = nvalloc(size);
 
-        if (line && *line != '\0' && *line != '\n') {
-            new_text = nvstrcat(text, "\n", line, NULL);
-            free(text);
-            text = new_text;
+    while ((n = fread(text + len, 1, size - len - 1, fp)) > 0) {
+        len += n;
+        if (len + 1 == size) {
+            size *= 2;
+            text = nvrealloc(text, size);
         }
-        free(line);
     }
 
+    /*
+     * lines are terminated by newlines or NUL characters; the output never
+     * overtakes the input, since every line copied after the first one
+     * replaces the terminator of the line before it with a newline
+     */
+
+    out = text;
+    line = text + 1;
+    limit = text + len;
+
+    while (line < limit) {
+        end = line;
+        while ((end < limit) && (*end != '\n') && (*end != '\0')) {
+            end++;
+        }
+
+        if (end > line) {
+            *out++ = '\n';
+            memmove(out, line, end - line);
+            out += end - line;
+        }
+
+        line = end + 1;
+    }
+
+    *out = '\0';
+
     return text;
 }
 
-static void splice_string(char **s, size_t b, size_t e, const char *replace)
+/*
+ * append_text() - append the first 'n' characters of 'text' to the
+ * NUL-terminated string '*s' of length '*len', in a buffer of '*size' bytes
+ * that is grown geometrically as needed.
+ */
+
+static void append_text(char **s, size_t *len, size_t *size,
+                        const char *text, size_t n)
 {
-    char *tail = strdup(*s + e);
-    *s = realloc(*s, b + strlen(replace) + strlen(tail) + 1);
-    if (!*s) {
-        return;
+    if (*len + n + 1 > *size) {
+        *size = NV_MAX(*size * 2, *len + n + 1);
+        *s = nvrealloc(*s, *size);
     }
-    sprintf(*s + b, "%s%s", replace, tail);
-    free(tail);
+
+    memcpy(*s + *len, text, n);
+    *len += n;
+    (*s)[*len] = '\0';
 }
 
 #define HEX_DIGITS "0123456789abcdefABCDEF"
 
+/*
+ * nv_app_profile_file_syntax_to_json() - translate the application profile
+ * file syntax, which allows comments as well as hexadecimal and octal
+ * integers, into JSON.  The input is scanned once; the text between
+ * comments and non-decimal integers is copied to the output unchanged.
+ */
+
 char *nv_app_profile_file_syntax_to_json(const char *orig_s)
 {
-    char *s = strdup(orig_s);
+    size_t len = 0, size, n;
+    char *s;
 
     int quoted = FALSE;
-    char *tok;
-    size_t start, end, size;
+    const char *tok, *copied;
     unsigned long long val;
-    char *old_substr = NULL;
     char *endptr;
-    char *new_substr = NULL;
+    char new_substr[32];
+
+    size = strlen(orig_s) + 1;
+    s = nvalloc(size);
 
-    tok = s;
+    tok = copied = orig_s;
     while ((tok = strpbrk(tok, "\\\"#" HEX_DIGITS))) {
         switch (*tok) {
         case '\"':
@@ -121,14 +176,8 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
         case '#':
             // Comment
             if (!quoted) {
-                char *end_tok = nvstrchrnul(tok, '\n');
-                start = tok - s;
-                end = end_tok - s;
-                splice_string(&s, start, end, "");
-                if (!s) {
-                    goto fail;
-                }
-                tok = s + start;
+                append_text(&s, &len, &size, copied, tok - copied);
+                tok = copied = tok + strcspn(tok, "\n");
             } else {
                 tok++;
             }
@@ -138,37 +187,27 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
         case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
         case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
             // Numeric value
-            size = strspn(tok, "Xx." HEX_DIGITS);
+            n = strspn(tok, "Xx." HEX_DIGITS);
             if ((tok[0] == '0') &&
                 (tok[1] == 'x' || tok[1] == 'X' || isdigit(tok[1])) &&
                 !quoted) {
-                old_substr = nvstrndup(tok, size);
-                if (!old_substr) {
-                    goto fail;
-                }
+                /*
+                 * strtoull() cannot consume any characters past the
+                 * literal, as they are not in the set counted above
+                 */
                 errno = 0;
-                val = strtoull(old_substr, &endptr, 0);
-                if (errno || (endptr - old_substr != strlen(old_substr))) {
-                    // Invalid conversion, skip this string
-                    tok += size;
-                    free(old_substr); old_substr = NULL;
-                } else {
-                    new_substr = nvasprintf("%llu", val);
-                    if (!new_substr) {
-                        goto fail;
-                    } else {
-                        start = tok - s;
-                        end = tok - s + size;
-                        splice_string(&s, start, end, new_substr);
-                        free(new_substr); new_substr = NULL;
-                        free(old_substr); old_substr = NULL;
-                        tok = s + start;
-                    }
+                val = strtoull(tok, &endptr, 0);
+                if (!errno && (endptr == tok + n)) {
+                    append_text(&s, &len, &size, copied, tok - copied);
+                    snprintf(new_substr, sizeof(new_substr), "%llu", val);
+                    append_text(&s, &len, &size, new_substr,
+                                strlen(new_substr));
+                    copied = tok + n;
                 }
-            } else {
-                // Not hex or octal; let the JSON parser deal with it
-                tok += size;
+                // Otherwise, the conversion is invalid; skip this string
             }
+            // If not hex or octal, let the JSON parser deal with it
+            tok += n;
             break;
         default:
             assert(!"Unhandled character");
@@ -176,15 +215,9 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
         }
     }
 
-    assert(!new_substr);
-    assert(!old_substr);
-    return s;
+    append_text(&s, &len, &size, copied, strlen(copied));
 
-fail:
-    free(old_substr);
-    free(new_substr);
-    free(s);
-    return NULL;
+    return s;
 }
 
 static int open_and_stat(const char *filename, const char *perms, FILE **fp, struct stat *stat_buf)
@@ -206,6 +239,73 @@ static int open_and_stat(const char *filename, const char *perms, FILE **fp, str
     return ret;
 }
 
+static char *rule_id_to_key_string(int id)
+{
+    char *key;
+    key = nvasprintf("%d", id);
+    return key;
+}
+
+/*
+ * Drops the rule index; this must be called whenever rules are added to,
+ * removed from or moved within the rules arrays of the parsed files.
+ */
+static void app_profile_config_invalidate_rule_index(AppProfileConfig *config)
+{
+    json_decref(config->rule_index);
+    config->rule_index = NULL;
+}
+
+/*
+ * Records in the change journal that the rules or profiles of the given file
+ * have been changed.
+ */
+static void app_profile_config_journal_file(AppProfileConfig *config,
+                                            const char *filename)
+{
+    json_object_set_new(config->changed_files, filename, json_true());
+}
+
+/*
+ * Returns the index entry of the rule with the given id, building the rule
+ * index first if needed, or NULL if there is no such rule.
+ */
+static json_t *app_profile_config_lookup_rule_entry(AppProfileConfig *config,
+                                                    int id)
+{
+    size_t i, j, num_files, num_rules;
+    size_t pri = 0;
+    json_t *file, *rules, *rule, *entry;
+    char *key;
+
+    if (!config->rule_index) {
+        config->rule_index = json_object();
+
+        for (i = 0, num_files = json_array_size(config->parsed_files); i < num_files; i++) {
+            file = json_array_get(config->parsed_files, i);
+            rules = json_object_get(file, "rules");
+            for (j = 0, num_rules = json_array_size(rules); j < num_rules; j++) {
+                rule = json_array_get(rules, j);
+
+                entry = json_object();
+                json_object_set(entry, "rule", rule);
+                json_object_set_new(entry, "index", json_integer(j));
+                json_object_set_new(entry, "priority", json_integer(pri++));
+
+                key = rule_id_to_key_string(json_integer_value(json_object_get(rule, "id")));
+                json_object_set_new(config->rule_index, key, entry);
+                free(key);
+            }
+        }
+    }
+
+    key = rule_id_to_key_string(id);
+    entry = json_object_get(config->rule_index, key);
+    free(key);
+
+    return entry;
+}
+
 static json_t *app_profile_config_insert_file_object(AppProfileConfig *config, json_t *new_file)
 {
     json_t *json_filename, *json_new_filename;
@@ -275,6 +375,7 @@ static json_t *app_profile_config_insert_file_object(AppProfileConfig *config, j
 
     // Add the new file
     json_array_insert(config->parsed_files, i, new_file);
+    app_profile_config_invalidate_rule_index(config);
 
     // Bump up minor for files after this one with the same major
     num_files = json_array_size(config->parsed_files);
@@ -314,13 +415,6 @@ static json_t *app_profile_config_new_file(AppProfileConfig *config,
     return new_file;
 }
 
-static char *rule_id_to_key_string(int id)
-{
-    char *key;
-    key = nvasprintf("%d", id);
-    return key;
-}
-
 /*
  * Constructs a profile name that is guaranteed to be unique to this
  * configuration. This is used to handle the case where there are multiple
@@ -935,6 +1029,9 @@ AppProfileConfig *nv_app_profile_config_load(const char *global_config_file,
     config->parsed_files = json_array();
     config->profile_locations = json_object();
     config->rule_locations = json_object();
+    config->rule_index = NULL;
+    config->changed_files = json_object();
+    config->bytes_written = 0;
 
     if (global_config_file) {
         config->global_config_file = nvstrdup(global_config_file);
@@ -1044,6 +1141,89 @@ char *nv_app_profile_config_get_backup_filename(AppProfileConfig *config, const
     return backup_name;
 }
 
+static int write_all(int fd, const char *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+/*
+ * Return the file that writing to filename actually modifies: the target of
+ * filename if it is a symbolic link, or filename itself otherwise.
+ */
+static char *resolve_filename(const char *filename)
+{
+    char *resolved = realpath(filename, NULL);
+
+    return resolved ? resolved : strdup(filename);
+}
+
+/*
+ * Copy the contents of the file src to a new file dst.
+ */
+static int copy_file(const char *src, const char *dst)
+{
+    char buf[4096];
+    ssize_t len;
+    struct stat stat_buf;
+    int src_fd, dst_fd = -1;
+    int created = FALSE;
+    int ret = -1;
+
+    src_fd = open(src, O_RDONLY);
+    if (src_fd < 0) {
+        return -1;
+    }
+
+    if (fstat(src_fd, &stat_buf) < 0) {
+        goto done;
+    }
+
+    dst_fd = open(dst, O_WRONLY | O_CREAT | O_EXCL, stat_buf.st_mode & 07777);
+    if (dst_fd < 0) {
+        goto done;
+    }
+    created = TRUE;
+
+    while ((len = read(src_fd, buf, sizeof(buf))) != 0) {
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            goto done;
+        }
+        if (write_all(dst_fd, buf, len) < 0) {
+            goto done;
+        }
+    }
+
+    ret = close(dst_fd);
+    dst_fd = -1;
+
+done:
+    if (dst_fd >= 0) {
+        close(dst_fd);
+    }
+    if ((ret < 0) && created) {
+        unlink(dst);
+    }
+    close(src_fd);
+    return ret;
+}
+
 static int app_profile_config_backup_file(AppProfileConfig *config,
                                           const char *filename,
                                           char **error_str)
@@ -1051,6 +1231,14 @@ static int app_profile_config_backup_file(AppProfileConfig *config,
     int ret;
     char *backup_name = nv_app_profile_config_get_backup_filename(config, filename);
     char *backup_dirname = nv_dirname(backup_name);
+    char *resolved_name = resolve_filename(filename);
+    struct stat stat_buf;
+
+    if (stat(resolved_name, &stat_buf) < 0) {
+        // Nothing to back up
+        ret = 0;
+        goto done;
+    }
 
     ret = nv_mkdirp(backup_dirname, error_str);
     if (ret < 0) {
@@ -1059,36 +1247,205 @@ static int app_profile_config_backup_file(AppProfileConfig *config,
         goto done;
     }
 
-    ret = rename(filename, backup_name);
+    if ((unlink(backup_name) < 0) && (errno != ENOENT)) {
+        ret = -1;
+        LOG_ERROR(error_str, "Could not remove the old backup file \"%s\" (%s)",
+                  backup_name, strerror(errno));
+        goto done;
+    }
+
+    // Link rather than rename the file, so that it stays in place until it
+    // is atomically replaced. Link the file a symbolic link points to rather
+    // than the link itself, as that is the file which will be replaced. Fall
+    // back to copying the file on file systems which do not support hard
+    // links, or if the file is on a different file system.
+    ret = link(resolved_name, backup_name);
     if (ret < 0) {
-        if (errno == ENOENT) {
-            // Clear the error; the file does not exist
-            ret = 0;
-        } else {
-            LOG_ERROR(error_str, "Could not rename file \"%s\" to \"%s\" for backup (%s)",
-                      filename, backup_name, strerror(errno));
-        }
+        ret = copy_file(resolved_name, backup_name);
+    }
+    if (ret < 0) {
+        LOG_ERROR(error_str, "Could not copy file \"%s\" to \"%s\" for backup (%s)",
+                  resolved_name, backup_name, strerror(errno));
+        goto done;
     }
 
     nv_info_msg("", "Backing up configuration file \"%s\" as \"%s\"\n", filename, backup_name);
 
 done:
+    free(resolved_name);
     free(backup_dirname);
     free(backup_name);
     return ret;
 }
 
+/*
+ * Rewrite the file in place with text (followed by a newline). This is used
+ * when the file cannot be replaced without changing its owner or group.
+ */
+static int app_profile_config_write_file_in_place(const char *filename,
+                                                  const char *text,
+                                                  size_t *bytes_written,
+                                                  char **error_str)
+{
+    size_t len = strlen(text);
+    int fd, ret;
+
+    fd = open(filename, O_WRONLY | O_TRUNC);
+    if (fd < 0) {
+        LOG_ERROR(error_str, "Could not open the file \"%s\" for writing (%s)",
+                  filename, strerror(errno));
+        return -1;
+    }
+
+    if ((write_all(fd, text, len) < 0) ||
+        (write_all(fd, "\n", 1) < 0) ||
+        (fsync(fd) < 0)) {
+        LOG_ERROR(error_str, "Could not write to the file \"%s\" (%s)",
+                  filename, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    ret = close(fd);
+    if (ret < 0) {
+        LOG_ERROR(error_str, "Could not write to the file \"%s\" (%s)",
+                  filename, strerror(errno));
+        return -1;
+    }
+
+    *bytes_written += len + 1;
+
+    return 0;
+}
+
+/*
+ * Replace the contents of the given file with text (followed by a newline).
+ * If the file is a symbolic link, the file it points to is replaced, and the
+ * link is left alone. The text is written to a temporary file in a private
+ * directory next to the file, so that it is not picked up as part of the
+ * configuration if the file is in a search path directory, flushed to disk,
+ * and renamed over the file; readers thus see either the old or the new
+ * contents, even if the system crashes while saving. The temporary file takes
+ * the permissions, owner and group of the file it replaces, if any; if the
+ * owner or group cannot be kept, the file is rewritten in place instead.
+ * The number of bytes written is added to *bytes_written.
+ */
+static int app_profile_config_write_file_atomic(const char *filename,
+                                                const char *text,
+                                                size_t *bytes_written,
+                                                char **error_str)
+{
+    char *resolved_name = resolve_filename(filename);
+    char *dirname = nv_dirname(resolved_name);
+    char *basename = nv_basename(resolved_name);
+    char *tmp_dirname = nvstrcat(dirname, "/.nvidia-settings-XXXXXX", NULL);
+    char *tmp_name = NULL;
+    size_t len = strlen(text);
+    struct stat stat_buf;
+    int have_stat;
+    mode_t mode, mask;
+    int fd = -1, dir_fd;
+    int ret = -1;
+
+    have_stat = (stat(resolved_name, &stat_buf) == 0);
+
+    if (!mkdtemp(tmp_dirname)) {
+        LOG_ERROR(error_str, "Could not create a temporary directory for \"%s\" (%s)",
+                  filename, strerror(errno));
+        free(tmp_dirname);
+        tmp_dirname = NULL;
+        goto done;
+    }
+
+    tmp_name = nvstrcat(tmp_dirname, "/", basename, NULL);
+
+    if (have_stat) {
+        mode = stat_buf.st_mode & 07777;
+    } else {
+        mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+
+    fd = open(tmp_name, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        LOG_ERROR(error_str, "Could not create a temporary file for \"%s\" (%s)",
+                  filename, strerror(errno));
+        goto done;
+    }
+
+    if (have_stat && (fchown(fd, stat_buf.st_uid, stat_buf.st_gid) < 0)) {
+        // Replacing the file would change its owner or group
+        close(fd);
+        fd = -1;
+        unlink(tmp_name);
+        ret = app_profile_config_write_file_in_place(resolved_name, text,
+                                                     bytes_written, error_str);
+        goto done;
+    }
+
+    if ((fchmod(fd, mode) < 0) ||
+        (write_all(fd, text, len) < 0) ||
+        (write_all(fd, "\n", 1) < 0) ||
+        (fsync(fd) < 0)) {
+        LOG_ERROR(error_str, "Could not write to the file \"%s\" (%s)",
+                  tmp_name, strerror(errno));
+        goto done;
+    }
+
+    ret = close(fd);
+    fd = -1;
+    if (ret < 0) {
+        LOG_ERROR(error_str, "Could not write to the file \"%s\" (%s)",
+                  tmp_name, strerror(errno));
+        goto done;
+    }
+
+    ret = rename(tmp_name, resolved_name);
+    if (ret < 0) {
+        LOG_ERROR(error_str, "Could not rename file \"%s\" to \"%s\" (%s)",
+                  tmp_name, resolved_name, strerror(errno));
+        goto done;
+    }
+
+    *bytes_written += len + 1;
+
+    // Make the rename itself durable
+    dir_fd = open(dirname, O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+done:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (tmp_name && (ret < 0)) {
+        unlink(tmp_name);
+    }
+    if (tmp_dirname) {
+        rmdir(tmp_dirname);
+    }
+    free(tmp_name);
+    free(tmp_dirname);
+    free(basename);
+    free(dirname);
+    free(resolved_name);
+    return ret;
+}
 
 static int app_profile_config_save_updates_to_file(AppProfileConfig *config,
                                                    const char *filename,
                                                    const char *update_text,
                                                    int backup,
+                                                   size_t *bytes_written,
                                                    char **error_str)
 {
     int file_is_new = FALSE;
+    size_t file_bytes = 0;
     struct stat stat_buf;
     char *dirname = NULL;
-    FILE *fp;
     int ret;
 
     ret = stat(filename, &stat_buf);
@@ -1162,15 +1519,13 @@ static int app_profile_config_save_updates_to_file(AppProfileConfig *config,
             goto done;
         }
     }
-    ret = open_and_stat(filename, "w", &fp, &stat_buf);
-    if (ret < 0) {
-        LOG_ERROR(error_str, "Could not write to the file \"%s\" (%s)",
-                  filename, strerror(errno));
-        goto done;
+    ret = app_profile_config_write_file_atomic(filename, update_text,
+                                               &file_bytes, error_str);
+    if (ret == 0) {
+        nv_info_msg("", "Wrote %zu bytes to configuration file \"%s\"\n",
+                    file_bytes, filename);
+        *bytes_written += file_bytes;
     }
-    nv_info_msg("", "Writing to configuration file \"%s\"\n", filename);
-    fprintf(fp, "%s\n", update_text);
-    fclose(fp);
 
 done:
     free(dirname);
@@ -1186,6 +1541,7 @@ int nv_app_profile_config_save_updates(AppProfileConfig *config,
     const char *filename;
     const char *update_text;
     size_t i, size;
+    size_t bytes_written = 0;
     int ret = 0;
     int all_ret = 0;
 
@@ -1201,12 +1557,20 @@ int nv_app_profile_config_save_updates(AppProfileConfig *config,
                                                       filename,
                                                       update_text,
                                                       backup,
+                                                      &bytes_written,
                                                       error_str);
         if (ret < 0) {
             all_ret = -1;
         }
     }
 
+    config->bytes_written += bytes_written;
+
+    if (size > 0) {
+        nv_info_msg("", "Wrote %zu bytes to %zu configuration file%s\n",
+                    bytes_written, size, (size == 1) ? "" : "s");
+    }
+
     assert(all_ret <= 0);
 
     // This asserts an error string is set iff we are returning an error
@@ -1227,6 +1591,9 @@ AppProfileConfig *nv_app_profile_config_dup(AppProfileConfig *config)
     new_config->profile_locations = json_deep_copy(config->profile_locations);
     new_config->rule_locations = json_deep_copy(config->rule_locations);
     new_config->next_free_rule_id = config->next_free_rule_id;
+    new_config->rule_index = NULL;
+    new_config->changed_files = json_object();
+    new_config->bytes_written = config->bytes_written;
 
     new_config->global_config_file =
         config->global_config_file ? strdup(config->global_config_file) : NULL;
@@ -1269,6 +1636,8 @@ void nv_app_profile_config_free(AppProfileConfig *config)
     json_decref(config->parsed_files);
     json_decref(config->profile_locations);
     json_decref(config->rule_locations);
+    json_decref(config->rule_index);
+    json_decref(config->changed_files);
 
     for (i = 0; i < config->search_path_count; i++) {
         free(config->search_path[i]);
@@ -1310,6 +1679,7 @@ static void app_profile_config_delete_file(AppProfileConfig *config, const char
         json_filename = json_object_get(json_file, "filename");
         if (!strcmp(json_string_value(json_filename), filename)) {
             json_array_remove(config->parsed_files, i);
+            app_profile_config_invalidate_rule_index(config);
             return;
         }
     }
@@ -1405,18 +1775,21 @@ fail:
     return output;
 }
 
-static void add_files_from_config(AppProfileConfig *config, json_t *all_files, json_t *changed_files)
+static void add_files_from_config(AppProfileConfig *config, json_t *journaled_files, json_t *changed_files)
 {
-    json_t *file, *filename;
+    json_t *file, *filename, *unused;
+    const char *journaled_filename;
     size_t i, size;
     for (i = 0, size = json_array_size(config->parsed_files); i < size; i++) {
         file = json_array_get(config->parsed_files, i);
         filename = json_object_get(file, "filename");
-        json_object_set_new(all_files, json_string_value(filename), json_true());
         if (json_is_true(json_object_get(file, "dirty"))) {
             json_object_set_new(changed_files, json_string_value(filename), json_true());
         }
     }
+    NV_JSON_OBJECT_FOREACH(config->changed_files, journaled_filename, unused) {
+        json_object_set_new(journaled_files, journaled_filename, json_true());
+    }
 }
 
 static json_t *app_profile_config_validate_global_options(AppProfileConfig *new_config,
@@ -1443,7 +1816,7 @@ static json_t *app_profile_config_validate_global_options(AppProfileConfig *new_
 json_t *nv_app_profile_config_validate(AppProfileConfig *new_config,
                                        AppProfileConfig *old_config)
 {
-    json_t *all_files, *changed_files;
+    json_t *journaled_files, *changed_files;
     json_t *new_file, *new_rules, *old_rules;
     json_t *old_file, *new_profiles, *old_profiles;
     json_t *updates, *update;
@@ -1459,15 +1832,17 @@ json_t *nv_app_profile_config_validate(AppProfileConfig *new_config,
         json_array_append_new(updates, update);
     }
 
-    // Build a set of files to examine: this is the union of files specified
-    // by the old configuration and the new.
-    all_files = json_object();
+    // Build a set of files to examine: this is the union of the files
+    // recorded in the change journals of the old configuration and the new.
+    // Files which were not changed by any edit need not be compared.
+    journaled_files = json_object();
     changed_files = json_object();
-    add_files_from_config(new_config, all_files, changed_files);
-    add_files_from_config(old_config, all_files, changed_files);
+    add_files_from_config(new_config, journaled_files, changed_files);
+    add_files_from_config(old_config, journaled_files, changed_files);
 
-    // For each file in the set, determine if it needs to be updated
-    NV_JSON_OBJECT_FOREACH(all_files, filename, unused) {
+    // For each file in the set, determine if it needs to be updated; an edit
+    // may have been undone by a later one
+    NV_JSON_OBJECT_FOREACH(journaled_files, filename, unused) {
         app_profile_config_get_per_file_config(new_config, filename, &new_file, &new_rules, &new_profiles);
         app_profile_config_get_per_file_config(old_config, filename, &old_file, &old_rules, &old_profiles);
 
@@ -1491,7 +1866,7 @@ json_t *nv_app_profile_config_validate(AppProfileConfig *new_config,
         free(update_text);
     }
 
-    json_decref(all_files);
+    json_decref(journaled_files);
     json_decref(changed_files);
 
     return updates;
@@ -1543,6 +1918,7 @@ int nv_app_profile_config_update_profile(AppProfileConfig *config,
 
     // If there is an existing profile with a differing filename, delete it first
     if (old_filename && (strcmp(filename, old_filename) != 0)) {
+        app_profile_config_journal_file(config, old_filename);
         file = app_profile_config_lookup_file(config, old_filename);
         file_profiles = json_object_get(file, "profiles");
         if (file) {
@@ -1557,6 +1933,7 @@ int nv_app_profile_config_update_profile(AppProfileConfig *config,
 
     file_profiles = json_object_get(file, "profiles");
     json_object_set(file_profiles, profile_name, new_profile);
+    app_profile_config_journal_file(config, filename);
     json_object_set(config->profile_locations, profile_name, json_string(filename));
 
     if (old_file) {
@@ -1576,6 +1953,7 @@ void nv_app_profile_config_delete_profile(AppProfileConfig *config,
         file = app_profile_config_lookup_file(config, filename);
         if (file) {
             json_object_del(json_object_get(file, "profiles"), profile_name);
+            app_profile_config_journal_file(config, filename);
         }
     }
 
@@ -1609,6 +1987,9 @@ int nv_app_profile_config_create_rule(AppProfileConfig *config,
     new_id = config->next_free_rule_id++;
     json_object_set_new(new_rule_copy, "id", json_integer(new_id));
 
+    app_profile_config_invalidate_rule_index(config);
+    app_profile_config_journal_file(config, filename);
+
     key = rule_id_to_key_string(new_id);
     json_object_set(config->rule_locations, key, json_string(filename));
     free(key);
@@ -1616,19 +1997,19 @@ int nv_app_profile_config_create_rule(AppProfileConfig *config,
     return new_id;
 }
 
-static int lookup_rule_index_in_array(json_t *rules, int id)
+/*
+ * Returns the index of the rule with the given id in its file's rules array,
+ * or -1 if there is no such rule.
+ */
+static int lookup_rule_index_in_array(AppProfileConfig *config, int id)
 {
-    json_t *rule, *rule_id;
-    size_t i, size;
-    for (i = 0, size = json_array_size(rules); i < size; i++) {
-        rule = json_array_get(rules, i);
-        rule_id = json_object_get(rule, "id");
-        if (json_integer_value(rule_id) == id) {
-            return i;
-        }
+    json_t *entry = app_profile_config_lookup_rule_entry(config, id);
+
+    if (!entry) {
+        return -1;
     }
 
-    return -1;
+    return json_integer_value(json_object_get(entry, "index"));
 }
 
 int nv_app_profile_config_update_rule(AppProfileConfig *config,
@@ -1653,7 +2034,11 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
 
     old_file_rules = json_object_get(old_file, "rules");
 
+    app_profile_config_journal_file(config, old_filename);
+
     if (filename && (strcmp(filename, old_filename) != 0)) {
+        app_profile_config_journal_file(config, filename);
+
         // If the rule has a new file, delete the rule and re-add it
         new_file = app_profile_config_lookup_file(config, filename);
         rule_moved = TRUE;
@@ -1663,7 +2048,7 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
 
         new_file_rules = json_object_get(new_file, "rules");
 
-        idx = lookup_rule_index_in_array(old_file_rules, id);
+        idx = lookup_rule_index_in_array(config, id);
         if (idx != -1) {
             json_array_remove(old_file_rules, idx);
         }
@@ -1675,7 +2060,7 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
     } else {
         // Otherwise, just edit the existing rule
         rule_moved = FALSE;
-        idx = lookup_rule_index_in_array(old_file_rules, id);
+        idx = lookup_rule_index_in_array(config, id);
         if (idx != -1) {
             json_array_set(old_file_rules, idx, new_rule);
             new_rule_copy = json_array_get(old_file_rules, idx);
@@ -1685,6 +2070,8 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
 
     free(key);
 
+    app_profile_config_invalidate_rule_index(config);
+
     app_profile_config_prune_empty_file(config, old_file);
 
     return rule_moved;
@@ -1708,10 +2095,13 @@ void nv_app_profile_config_delete_rule(AppProfileConfig *config, int id)
 
     file_rules = json_object_get(file, "rules");
 
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = lookup_rule_index_in_array(config, id);
     if (idx != -1) {
         json_array_remove(file_rules, idx);
     }
+    app_profile_config_journal_file(config, filename);
+
+    app_profile_config_invalidate_rule_index(config);
 
     json_object_del(config->rule_locations, key);
     free(key);
@@ -1722,24 +2112,6 @@ size_t nv_app_profile_config_count_rules(AppProfileConfig *config)
     return json_object_size(config->rule_locations);
 }
 
-static size_t app_profile_config_count_rules_before(AppProfileConfig *config, const char *filename)
-{
-    size_t i, size;
-    size_t num_rules = 0;
-    json_t *cur_file, *cur_filename;
-
-    for (i = 0, size = json_array_size(config->parsed_files); i < size; i++) {
-        cur_file = json_array_get(config->parsed_files, i);
-        cur_filename = json_object_get(cur_file, "filename");
-        if (!strcmp(filename, json_string_value(cur_filename))) {
-            break;
-        }
-        num_rules += json_array_size(json_object_get(cur_file, "rules"));
-    }
-
-    return num_rules;
-}
-
 static void app_profile_config_insert_rule(AppProfileConfig *config,
                                            json_t *rule,
                                            size_t new_pri,
@@ -1781,36 +2153,22 @@ static void app_profile_config_insert_rule(AppProfileConfig *config,
 
     file_rules = json_object_get(target[i], "rules");
     json_array_insert_new(file_rules, new_pri - rules_before_target[i], rule);
+    app_profile_config_invalidate_rule_index(config);
     // Update the hashtable to point to the new file
     key = rule_id_to_key_string(json_integer_value(json_object_get(rule, "id")));
     filename = json_string_value(json_object_get(target[i], "filename"));
     json_object_set_new(config->rule_locations, key, json_string(filename));
+    app_profile_config_journal_file(config, filename);
     free(key);
 }
 
 size_t nv_app_profile_config_get_rule_priority(AppProfileConfig *config,
                                                int id)
 {
-    json_t *file, *file_rules;
-    const char *filename;
-    int idx;
-    char *key;
-
-    key = rule_id_to_key_string(id);
-
-    filename = json_string_value(json_object_get(config->rule_locations, key));
-    assert(filename);
-
-    file = app_profile_config_lookup_file(config, filename);
-    assert(file);
+    json_t *entry = app_profile_config_lookup_rule_entry(config, id);
+    assert(entry);
 
-    file_rules = json_object_get(file, "rules");
-
-    idx = lookup_rule_index_in_array(file_rules, id);
-
-    free(key);
-
-    return app_profile_config_count_rules_before(config, filename) + idx;
+    return json_integer_value(json_object_get(entry, "priority"));
 }
 
 static void app_profile_config_set_abs_rule_priority_internal(AppProfileConfig *config,
@@ -1840,12 +2198,14 @@ static void app_profile_config_set_abs_rule_priority_internal(AppProfileConfig *
     assert(file);
 
     file_rules = json_object_get(file, "rules");
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = lookup_rule_index_in_array(config, id);
     assert(idx >= 0);
     rule = json_array_get(file_rules, idx);
 
     rule_copy = json_deep_copy(rule);
     json_array_remove(file_rules, idx);
+    app_profile_config_invalidate_rule_index(config);
+    app_profile_config_journal_file(config, filename);
 
     app_profile_config_insert_rule(config, rule_copy, new_pri, filename);
 
@@ -1897,31 +2257,13 @@ const json_t *nv_app_profile_config_get_profile(AppProfileConfig *config,
 const json_t *nv_app_profile_config_get_rule(AppProfileConfig *config,
                                              int id)
 {
-    char *key = rule_id_to_key_string(id);
-    json_t *file, *rule, *filename;
-    json_t *file_rules;
-    int idx;
-
-    filename = json_object_get(config->rule_locations, key);
+    json_t *entry = app_profile_config_lookup_rule_entry(config, id);
 
-    if (!filename) {
-        free(key);
+    if (!entry) {
         return NULL;
     }
 
-    file = app_profile_config_lookup_file(config, json_string_value(filename));
-    file_rules = json_object_get(file, "rules");
-
-    idx = lookup_rule_index_in_array(file_rules, id);
-    if (idx != -1) {
-        rule = json_array_get(file_rules, idx);
-    } else {
-        assert(0);
-        rule = NULL;
-    }
-
-    free(key);
-    return rule;
+    return json_object_get(entry, "rule");
 }
 
 struct AppProfileConfigProfileIterRec {
@@ -2306,6 +2648,8 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
             rule_profile_str = json_string_value(rule_profile);
             if (!strcmp(rule_profile_str, orig_name)) {
                 json_object_set_new(rule, "profile", json_string(new_name));
+                app_profile_config_journal_file(config,
+                    json_string_value(json_object_get(file, "filename")));
                 fixed_up = TRUE;
             }
         }
@@ -2313,3 +2657,370 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
 
     return fixed_up;
 }
+
+#define SEARCH_PATH_NUM_FILES 4
+
+char **nv_app_profile_config_get_default_search_path(size_t *num_files)
+{
+    size_t i = 0;
+    char **filenames = malloc(SEARCH_PATH_NUM_FILES * sizeof(char *));
+    const char *homeStr = getenv("HOME");
+
+    if (homeStr) {
+        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc", NULL);
+        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc.d", NULL);
+    }
+    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc");
+    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc.d");
+
+    *num_files = i;
+    assert(i <= SEARCH_PATH_NUM_FILES);
+
+    return filenames;
+}
+
+void nv_app_profile_config_free_search_path(char **search_path,
+                                            size_t search_path_size)
+{
+    while (search_path_size--) {
+        free(search_path[search_path_size]);
+    }
+    free(search_path);
+}
+
+struct AppProfileMatcherRec {
+    /*
+     * JSON object mapping each indexed feature name to a hashtable (JSON
+     * object) which maps the strings matched by rules using that feature to
+     * arrays of the priorities of those rules, in increasing order.
+     */
+    json_t *tables;
+
+    /*
+     * Priorities of the rules which always apply, in increasing order.
+     */
+    json_t *always;
+
+    /*
+     * The rules in priority order, annotated with their priority and
+     * filename.
+     */
+    json_t *rules;
+};
+
+static const char *matcher_indexed_features[] = {
+    "procname",
+    "cmdline",
+    "dso",
+};
+
+/*
+ * Returns the given path with leading directory components removed; the
+ * cmdline feature also treats backslashes as directory separators.
+ */
+static const char *matcher_basename(const char *path, int backslashes)
+{
+    const char *base = path;
+    const char *c;
+
+    for (c = path; *c; c++) {
+        if ((*c == '/') || (backslashes && (*c == '\\'))) {
+            base = c + 1;
+        }
+    }
+
+    return base;
+}
+
+AppProfileMatcher *nv_app_profile_matcher_new(AppProfileConfig *config)
+{
+    AppProfileMatcher *matcher = nvalloc(sizeof(AppProfileMatcher));
+    AppProfileConfigRuleIter *iter;
+    json_t *rule, *pattern, *table, *bucket;
+    const char *feature, *matches;
+    size_t i, pri;
+
+    matcher->tables = json_object();
+    matcher->always = json_array();
+    matcher->rules = json_array();
+
+    for (i = 0; i < ARRAY_LEN(matcher_indexed_features); i++) {
+        json_object_set_new(matcher->tables, matcher_indexed_features[i],
+                            json_object());
+    }
+
+    for (iter = nv_app_profile_config_rule_iter(config), pri = 0;
+         iter;
+         iter = nv_app_profile_config_rule_iter_next(iter), pri++) {
+        rule = json_deep_copy(nv_app_profile_config_rule_iter_val(iter));
+        json_object_set_new(rule, "priority", json_integer(pri));
+        json_object_set_new(rule, "filename",
+                            json_string(nv_app_profile_config_rule_iter_filename(iter)));
+        json_array_append_new(matcher->rules, rule);
+
+        pattern = json_object_get(rule, "pattern");
+        feature = json_string_value(json_object_get(pattern, "feature"));
+        matches = json_string_value(json_object_get(pattern, "matches"));
+
+        if (!feature) {
+            continue;
+        }
+
+        if (!strcmp(feature, "true")) {
+            json_array_append_new(matcher->always, json_integer(pri));
+            continue;
+        }
+
+        // Rules using features that are not indexed never match
+        table = json_object_get(matcher->tables, feature);
+        if (!table || !matches) {
+            continue;
+        }
+
+        bucket = json_object_get(table, matches);
+        if (!bucket) {
+            bucket = json_array();
+            json_object_set_new(table, matches, bucket);
+        }
+        json_array_append_new(bucket, json_integer(pri));
+    }
+
+    return matcher;
+}
+
+void nv_app_profile_matcher_free(AppProfileMatcher *matcher)
+{
+    if (!matcher) {
+        return;
+    }
+
+    json_decref(matcher->tables);
+    json_decref(matcher->always);
+    json_decref(matcher->rules);
+    free(matcher);
+}
+
+/*
+ * Appends the priorities in the given array to the priority list.
+ */
+static void matcher_collect(const json_t *bucket, size_t **pris,
+                            size_t *num_pris, size_t *size)
+{
+    size_t i, num;
+
+    for (i = 0, num = json_array_size(bucket); i < num; i++) {
+        if (*num_pris == *size) {
+            *size = *size ? *size * 2 : 16;
+            *pris = nvrealloc(*pris, *size * sizeof(size_t));
+        }
+        (*pris)[(*num_pris)++] = json_integer_value(json_array_get(bucket, i));
+    }
+}
+
+static int compare_priorities(const void *a, const void *b)
+{
+    size_t pri_a = *(const size_t *)a;
+    size_t pri_b = *(const size_t *)b;
+
+    return (pri_a > pri_b) - (pri_a < pri_b);
+}
+
+json_t *nv_app_profile_matcher_match(AppProfileMatcher *matcher,
+                                     const char *process,
+                                     const char * const *dsos,
+                                     size_t num_dsos)
+{
+    json_t *matched = json_array();
+    json_t *table;
+    size_t *pris = NULL;
+    size_t num_pris = 0, size = 0;
+    size_t i;
+
+    matcher_collect(matcher->always, &pris, &num_pris, &size);
+
+    if (process) {
+        table = json_object_get(matcher->tables, "procname");
+        matcher_collect(json_object_get(table, matcher_basename(process, FALSE)),
+                        &pris, &num_pris, &size);
+
+        table = json_object_get(matcher->tables, "cmdline");
+        matcher_collect(json_object_get(table, matcher_basename(process, TRUE)),
+                        &pris, &num_pris, &size);
+    }
+
+    table = json_object_get(matcher->tables, "dso");
+    for (i = 0; i < num_dsos; i++) {
+        matcher_collect(json_object_get(table, matcher_basename(dsos[i], FALSE)),
+                        &pris, &num_pris, &size);
+    }
+
+    // A rule may match more than one feature of the process; list it once
+    qsort(pris, num_pris, sizeof(size_t), compare_priorities);
+
+    for (i = 0; i < num_pris; i++) {
+        if ((i > 0) && (pris[i] == pris[i - 1])) {
+            continue;
+        }
+        json_array_append(matched, json_array_get(matcher->rules, pris[i]));
+    }
+
+    free(pris);
+
+    return matched;
+}
+
+/*
+ * Determines the settings which result from applying the profiles of the
+ * given rules: when more than one profile sets a key, the value from the
+ * profile of the rule with the highest priority is used. Returns a JSON
+ * array of objects containing the key, value and profile of each setting.
+ */
+static json_t *matcher_resulting_settings(AppProfileConfig *config,
+                                          const json_t *rules)
+{
+    json_t *settings = json_array();
+    json_t *seen_keys = json_object();
+    const json_t *rule, *profile, *profile_settings, *setting;
+    const char *profile_name, *key;
+    json_t *new_setting;
+    size_t i, j, num_rules, num_settings;
+
+    for (i = 0, num_rules = json_array_size(rules); i < num_rules; i++) {
+        rule = json_array_get(rules, i);
+        profile_name = json_string_value(json_object_get(rule, "profile"));
+        profile = profile_name ?
+            nv_app_profile_config_get_profile(config, profile_name) : NULL;
+
+        if (!profile) {
+            nv_warning_msg("Rule %" JSON_INTEGER_FORMAT " in the file %s "
+                           "refers to the undefined profile \"%s\".",
+                           json_integer_value(json_object_get(rule, "id")),
+                           json_string_value(json_object_get(rule, "filename")),
+                           profile_name ? profile_name : "");
+            continue;
+        }
+
+        profile_settings = json_object_get(profile, "settings");
+        for (j = 0, num_settings = json_array_size(profile_settings); j < num_settings; j++) {
+            setting = json_array_get(profile_settings, j);
+            key = json_string_value(json_object_get(setting, "key"));
+            if (!key || json_object_get(seen_keys, key)) {
+                continue;
+            }
+            json_object_set_new(seen_keys, key, json_true());
+
+            new_setting = json_object();
+            json_object_set_new(new_setting, "key", json_string(key));
+            json_object_set(new_setting, "value", json_object_get(setting, "value"));
+            json_object_set_new(new_setting, "profile", json_string(profile_name));
+            json_array_append_new(settings, new_setting);
+        }
+    }
+
+    json_decref(seen_keys);
+
+    return settings;
+}
+
+int nv_app_profile_print_matching_rules(const char *spec, int json_output,
+                                        int compact)
+{
+    AppProfileConfig *config;
+    AppProfileMatcher *matcher;
+    char **search_path, **dsos = NULL;
+    char *process, *c;
+    size_t search_path_count, num_dsos = 0;
+    json_t *rules, *settings, *rule, *pattern, *setting, *output, *json_dsos;
+    char *value_str;
+    size_t i;
+
+    process = nvstrdup(spec);
+
+    for (c = strchr(process, ','); c; c = strchr(c, ',')) {
+        *c++ = '\0';
+        dsos = nvrealloc(dsos, sizeof(char *) * (num_dsos + 1));
+        dsos[num_dsos++] = c;
+    }
+
+    search_path = nv_app_profile_config_get_default_search_path(&search_path_count);
+    config = nv_app_profile_config_load(NULL, search_path, search_path_count);
+    nv_app_profile_config_free_search_path(search_path, search_path_count);
+
+    if (!config) {
+        nv_error_msg("Unable to load the application profile configuration.");
+        free(dsos);
+        free(process);
+        return FALSE;
+    }
+
+    matcher = nv_app_profile_matcher_new(config);
+    rules = nv_app_profile_matcher_match(matcher, process,
+                                         (const char * const *)dsos,
+                                         num_dsos);
+    settings = matcher_resulting_settings(config, rules);
+
+    if (json_output) {
+        output = json_object();
+        json_dsos = json_array();
+        for (i = 0; i < num_dsos; i++) {
+            json_array_append_new(json_dsos, json_string(dsos[i]));
+        }
+        json_object_set_new(output, "process", json_string(process));
+        json_object_set_new(output, "dsos", json_dsos);
+        json_object_set_new(output, "rule_count",
+                            json_integer(nv_app_profile_config_count_rules(config)));
+        json_object_set(output, "rules", rules);
+        json_object_set(output, "settings", settings);
+        json_dumpf(output, stdout, JSON_PRESERVE_ORDER |
+                   (compact ? JSON_COMPACT : JSON_INDENT(2)));
+        fputs("\n", stdout);
+        fflush(stdout);
+        json_decref(output);
+    } else {
+        nv_msg(NULL, "");
+        nv_msg(NULL, "%zu of %zu application profile rules apply to '%s':",
+               json_array_size(rules), nv_app_profile_config_count_rules(config),
+               process);
+        nv_msg(NULL, "");
+
+        for (i = 0; i < json_array_size(rules); i++) {
+            rule = json_array_get(rules, i);
+            pattern = json_object_get(rule, "pattern");
+            nv_msg("  ", "Rule %" JSON_INTEGER_FORMAT " (priority %"
+                   JSON_INTEGER_FORMAT ", %s): %s \"%s\" -> profile \"%s\"",
+                   json_integer_value(json_object_get(rule, "id")),
+                   json_integer_value(json_object_get(rule, "priority")),
+                   json_string_value(json_object_get(rule, "filename")),
+                   json_string_value(json_object_get(pattern, "feature")),
+                   json_string_value(json_object_get(pattern, "matches")),
+                   json_string_value(json_object_get(rule, "profile")));
+        }
+
+        if (json_array_size(settings)) {
+            nv_msg(NULL, "");
+            nv_msg(NULL, "Resulting settings:");
+            nv_msg(NULL, "");
+        }
+
+        for (i = 0; i < json_array_size(settings); i++) {
+            setting = json_array_get(settings, i);
+            value_str = json_dumps(json_object_get(setting, "value"),
+                                   JSON_ENCODE_ANY);
+            nv_msg("  ", "%s = %s (profile \"%s\")",
+                   json_string_value(json_object_get(setting, "key")),
+                   value_str ? value_str : "",
+                   json_string_value(json_object_get(setting, "profile")));
+            free(value_str);
+        }
+        nv_msg(NULL, "");
+    }
+
+    json_decref(settings);
+    json_decref(rules);
+    nv_app_profile_matcher_free(matcher);
+    nv_app_profile_config_free(config);
+    free(dsos);
+    free(process);
+
+    return TRUE;
+}
@@ -103,6 +103,29 @@ typedef struct AppProfileConfigRec {
     json_t *rule_locations;
     size_t next_free_rule_id;
 
+    /*
+     * Index of the rules by id, built on demand and dropped whenever rules
+     * are added, removed or reordered. This maps the same keys as
+     * rule_locations to objects containing the rule itself, its index in its
+     * file's rules array and its priority, so that looking up a rule by id
+     * does not require scanning the rules arrays.
+     */
+    json_t *rule_index;
+
+    /*
+     * Journal of the files whose rules or profiles have been changed since
+     * the configuration was loaded or duplicated, stored as a JSON object
+     * used as a set of filenames. Only these files need to be compared
+     * against the original configuration when validating.
+     */
+    json_t *changed_files;
+
+    /*
+     * Number of bytes written to disk by nv_app_profile_config_save_updates()
+     * with this configuration (or the configuration it was duplicated from).
+     */
+    size_t bytes_written;
+
     /*
      * Copy of the global configuration filename
      */
@@ -120,7 +143,11 @@ typedef struct AppProfileConfigRec {
  * Save configuration specified by the JSON array updates to disk. See
  * nv_app_profile_config_validate() below for the format of this array.
  * backup indicates whether this should also make backups of the original files
- * before saving.
+ * before saving. Each file is written to a temporary file which is flushed to
+ * disk and then renamed over the original, so that the file is replaced
+ * atomically; symbolic links are written through, and the owner and group
+ * of the original are kept. The number of bytes written is added to
+ * config->bytes_written.
  * Returns 0 if successful, or a negative integer if an error was encountered.
  * If error_str is non-NULL, *error_str is set to NULL on success, or a
  * dynamically-allocated string if an error occurred.
@@ -161,7 +188,8 @@ void nv_app_profile_config_free(AppProfileConfig *config);
 /*
  * Validate the configuration specified by new_config against the pristine copy
  * specified by old_config, and generate a list of changes needed in order to
- * achieve the new configuration.
+ * achieve the new configuration. Only the files recorded in the change journals
+ * of either configuration, or marked dirty, are compared and written.
  *
  * This returns a JSON array which must be freed via json_decref(), containing
  * a list of update objects. Each update object contains the following
@@ -320,4 +348,48 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
                                                     const char *orig_name,
                                                     const char *new_name);
 
+/*
+ * Returns a newly allocated copy of the default search path, and its length
+ * in *num_files. The search path should be freed with
+ * nv_app_profile_config_free_search_path().
+ */
+char **nv_app_profile_config_get_default_search_path(size_t *num_files);
+void nv_app_profile_config_free_search_path(char **search_path,
+                                            size_t search_path_size);
+
+/*
+ * A compiled rule matcher answers which rules of a configuration apply to
+ * a given process without scanning the rules: rules matching on procname,
+ * cmdline and dso are indexed in hashtables keyed by the string they match.
+ * The matcher is a snapshot of the configuration at the time it was created
+ * and is not affected by later changes to the configuration.
+ */
+typedef struct AppProfileMatcherRec AppProfileMatcher;
+
+AppProfileMatcher *nv_app_profile_matcher_new(AppProfileConfig *config);
+void nv_app_profile_matcher_free(AppProfileMatcher *matcher);
+
+/*
+ * Returns a JSON array of the rules that apply to the process with the
+ * executable path given by process, which has loaded the shared objects
+ * given in dsos, in order of decreasing priority. Each rule is annotated
+ * with its "priority" and the "filename" it was loaded from. The array
+ * should be freed via json_decref().
+ */
+json_t *nv_app_profile_matcher_match(AppProfileMatcher *matcher,
+                                     const char *process,
+                                     const char * const *dsos,
+                                     size_t num_dsos);
+
+/*
+ * Loads the configuration from the default search path, and prints which
+ * rules apply to the process described by spec (the path of the process,
+ * optionally followed by a comma-separated list of the shared objects it
+ * loads), along with the resulting settings. The output is a JSON object
+ * if json_output is TRUE, written on a single line if compact is also TRUE.
+ * Returns TRUE on success.
+ */
+int nv_app_profile_print_matching_rules(const char *spec, int json_output,
+                                        int compact);
+
 #endif // __APP_PROFILES_H__
@@ -215,7 +215,8 @@ Options *parse_command_line(int argc, char *argv[],
     Options *op;
     int n, c;
     char *strval;
-    int boolval;
+    int boolval, intval;
+    double doubleval;
 
     op = nvalloc(sizeof(Options));
     op->config = DEFAULT_RC_FILE;
@@ -229,8 +230,8 @@ Options *parse_command_line(int argc, char *argv[],
     while (1) {
         c = nvgetopt(argc, argv, __options, &strval,
                      &boolval,  /* boolval */
-                     NULL,  /* intval */
-                     NULL,  /* doubleval */
+                     &intval,   /* intval */
+                     &doubleval, /* doubleval */
                      NULL); /* disable_val */
 
         if (c == -1)
@@ -300,6 +301,39 @@ Options *parse_command_line(int argc, char *argv[],
         case 'w': op->write_config = boolval; break;
         case 'i': op->use_gtk2 = NV_TRUE; break;
         case 'I': op->gtk_lib_path = strval; break;
+        case 'j': op->jobs = intval; break;
+        case OUTPUT_FORMAT_OPTION:
+            if (nv_strcasecmp(strval, "text") == NV_TRUE) {
+                op->output_format = OUTPUT_FORMAT_TEXT;
+            } else if (nv_strcasecmp(strval, "json") == NV_TRUE) {
+                op->output_format = OUTPUT_FORMAT_JSON;
+            } else if (nv_strcasecmp(strval, "ndjson") == NV_TRUE) {
+                op->output_format = OUTPUT_FORMAT_NDJSON;
+            } else if (nv_strcasecmp(strval, "csv") == NV_TRUE) {
+                op->output_format = OUTPUT_FORMAT_CSV;
+            } else {
+                nv_error_msg("Invalid output format '%s'.  Please run "
+                             "`%s --help` for usage information.\n",
+                             strval, argv[0]);
+                exit(0);
+            }
+            break;
+        case ATTRIBUTE_CACHE_OPTION:
+            NvCtrlSetAttributeCache(NV_TRUE, intval);
+            break;
+        case WATCH_OPTION:
+            if (doubleval <= 0.0) {
+                nv_error_msg("Invalid watch interval '%g'.  Please run "
+                             "`%s --help` for usage information.\n",
+                             doubleval, argv[0]);
+                exit(0);
+            }
+            op->watch_interval = doubleval;
+            break;
+        case WATCH_CHANGES_OPTION: op->watch_changes = boolval; break;
+        case APP_PROFILE_MATCH_OPTION: op->app_profile_match = strval; break;
+        case SERVE_OPTION: op->serve_address = strval; break;
+        case FRAMELOCK_STATUS_OPTION: op->framelock_status = strval; break;
         default:
             nv_error_msg("Invalid commandline, please run `%s --help` "
                          "for usage information.\n", argv[0]);
@@ -307,6 +341,15 @@ Options *parse_command_line(int argc, char *argv[],
         }
     }
 
+    if ((op->output_format == OUTPUT_FORMAT_CSV) &&
+        (op->watch_interval <= 0.0) && !op->framelock_status) {
+        nv_error_msg("The 'csv' output format can only be used together "
+                     "with the '--watch' or '--framelock-status' options.  "
+                     "Please run `%s --help` for usage information.\n",
+                     argv[0]);
+        exit(0);
+    }
+
     /* do tilde expansion on the config file path */
 
     op->config = tilde_expansion(op->config);
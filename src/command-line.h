@@ -30,12 +30,28 @@ struct _CtrlSystemList;
 #define DEFAULT_RC_FILE "~/.nvidia-settings-rc"
 #define CONFIG_FILE_OPTION 1
 #define DISPLAY_OPTION 2
+#define ATTRIBUTE_CACHE_OPTION 3
+#define OUTPUT_FORMAT_OPTION 4
+#define WATCH_OPTION 5
+#define WATCH_CHANGES_OPTION 6
+#define APP_PROFILE_MATCH_OPTION 7
+#define SERVE_OPTION 8
+#define FRAMELOCK_STATUS_OPTION 9
 
 /*
  * Options structure -- stores the parameters specified on the
  * commandline.
  */
 
+/* Format of the results printed for queries */
+
+typedef enum {
+    OUTPUT_FORMAT_TEXT = 0,
+    OUTPUT_FORMAT_JSON,   /* a single JSON array of records */
+    OUTPUT_FORMAT_NDJSON, /* one JSON record per line */
+    OUTPUT_FORMAT_CSV,    /* one comma separated row per value (--watch) */
+} OutputFormat;
+
 typedef struct {
     
     char *ctrl_display;  /*
@@ -122,6 +138,47 @@ typedef struct {
                           * ignored.
                           */
 
+    int jobs;            /*
+                          * Number of threads to use when querying
+                          * NVML-backed targets; 0 or 1 queries them
+                          * sequentially.
+                          */
+
+    OutputFormat output_format; /*
+                                 * Format of the query results.
+                                 */
+
+    double watch_interval; /*
+                            * If greater than zero, re-query the attributes
+                            * given with --query every watch_interval
+                            * seconds until interrupted.
+                            */
+
+    int watch_changes;   /*
+                          * If true, only print the values that changed
+                          * since the previous sample in watch mode.
+                          */
+
+    char *app_profile_match; /*
+                              * If set, print the application profile rules
+                              * that apply to the given process
+                              * ("PROCESS[,DSO...]") and exit.
+                              */
+
+    char *serve_address; /*
+                          * If set, sample the attributes given with --query
+                          * (or a default set) every watch_interval seconds
+                          * and serve them in the Prometheus text format on
+                          * this address ("unix:PATH" or "[HOST:]PORT").
+                          */
+
+    char *framelock_status; /*
+                             * If set, print the frame lock status of this
+                             * comma separated list of X servers, sampled
+                             * concurrently, and exit (or, with --watch,
+                             * repeat every watch_interval seconds).
+                             */
+
 } Options;
 
 
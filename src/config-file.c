@@ -84,6 +84,10 @@ static void write_config_properties(FILE *stream, const ConfigProperties *conf,
 static char *create_display_device_target_string(CtrlTarget *t,
                                                  const ConfigProperties *conf);
 
+static CtrlAttributeQuery *query_config_int_attributes(CtrlTarget *t,
+                                                       CtrlTargetType type,
+                                                       int skip_display_attrs);
+
 /*
  * set_dynamic_verbosity() - Sets the __dynamic_verbosity variable which
  * allows temporary toggling of the verbosity level to hide some output
@@ -163,9 +167,12 @@ int nv_read_config_file(const Options *op, const char *file,
         goto done;
     }
 
-    /* map the file into memory */
+    /*
+     * map the file into memory; the mapping is private and writable so
+     * that parse_config_file() can terminate lines in place
+     */
 
-    buf = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    buf = mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
     if (buf == (void *) -1) {
         nv_error_msg("Unable to mmap file '%s' for reading (%s).",
                      file, strerror(errno));
@@ -235,7 +242,7 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
     FILE *stream;
     time_t now;
     ReturnStatus status;
-    CtrlAttributePerms perms;
+    CtrlAttributeQuery *values;
     CtrlTargetNode *node;
     CtrlTarget *t;
     char *prefix, scratch[4];
@@ -316,6 +323,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
             prefix = scratch;
         }
 
+        values = query_config_int_attributes(t, X_SCREEN_TARGET, NV_TRUE);
+
         /* loop over all the entries in the table */
 
         for (entry = 0; entry < attributeTableLen; entry++) {
@@ -367,17 +376,11 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
              * write attributes that can be written for an X screen target
              */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(X_SCREEN_TARGET)) ||
-                (perms.valid_targets & CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
+            if (values[entry].status != NvCtrlSuccess) {
                 continue;
             }
 
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status != NvCtrlSuccess) {
-                continue;
-            }
+            val = values[entry].val;
 
             if (a->f.int_flags.is_display_id) {
                 const char *name = NvCtrlGetDisplayConfigName(system, val);
@@ -393,6 +396,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 
         } /* entry */
 
+        nvfree(values);
+
     } /* screen */
 
     /*
@@ -423,6 +428,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 
         prefix = create_display_device_target_string(t, conf);
 
+        values = query_config_int_attributes(t, DISPLAY_TARGET, NV_FALSE);
+
         /* loop over all the entries in the table */
 
         for (entry = 0; entry < attributeTableLen; entry++) {
@@ -464,19 +471,14 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 
             /* Make sure this is a display and writable attribute */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
-                continue;
-            }
-
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status == NvCtrlSuccess) {
+            if (values[entry].status == NvCtrlSuccess) {
                 fprintf(stream, "%s%c%s=%d\n", prefix,
-                        DISPLAY_NAME_SEPARATOR, a->name, val);
+                        DISPLAY_NAME_SEPARATOR, a->name,
+                        (int) values[entry].val);
             }
         }
 
+        nvfree(values);
         free(prefix);
     }
 
@@ -503,6 +505,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
         target_str = nvasprintf("[gpu:%d]", NvCtrlGetTargetId(t));
         nvstrtoupper(target_str);
 
+        values = query_config_int_attributes(t, GPU_TARGET, NV_FALSE);
+
         /* loop over all the entries in the table */
 
         for (entry = 0; entry < attributeTableLen; entry++) {
@@ -528,21 +532,15 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
              * Only write attributes that can be written for a GPU target
              */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(GPU_TARGET)))  {
-                continue;
-            }
-
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status != NvCtrlSuccess) {
+            if (values[entry].status != NvCtrlSuccess) {
                 continue;
             }
 
             fprintf(stream, "%s%c%s=%d\n", target_str,
-                    DISPLAY_NAME_SEPARATOR, a->name, val);
+                    DISPLAY_NAME_SEPARATOR, a->name, (int) values[entry].val);
         }
 
+        nvfree(values);
         free(target_str);
     }
 
@@ -620,6 +618,12 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
  * lines.  Non-comment lines with non-whitespace characters are passed
  * on to nv_parse_attribute_string for parsing.
  *
+ * Lines are parsed in place: the buffer must be writable (the caller
+ * maps the file privately), and the character following the data on each
+ * line (the comment character or newline) is overwritten with a NUL.
+ * Only a final line that is not terminated within the buffer is copied.
+ * The array of parsed attributes is grown geometrically.
+ *
  * If an error occurs, an error message is printed and NULL is
  * returned.  If successful, a malloced array of
  * ParsedAttributeWrapper structs is returned.  The last
@@ -631,22 +635,22 @@ static ParsedAttributeWrapper *parse_config_file(char *buf, const char *file,
                                                  const int length,
                                                  ConfigProperties *conf)
 {
-    int line, has_data, current_tmp_len, len, n, ret;
-    char *cur, *c, *comment, *tmp;
+    int line, has_data, last, n, size, ret;
+    char *cur, *c, *comment, *str, *tmp;
     ParsedAttributeWrapper *w;
-    
+
     cur = buf;
     line = 1;
-    current_tmp_len = 0;
     n = 0;
+    size = 0;
     w = NULL;
     tmp = NULL;
 
     while (cur) {
         c = cur;
         comment = NULL;
-        has_data = NV_FALSE;;
-        
+        has_data = NV_FALSE;
+
         while (((c - buf) < length) &&
                (*c != '\n') &&
                (*c != '\0')) {
@@ -655,56 +659,67 @@ static ParsedAttributeWrapper *parse_config_file(char *buf, const char *file,
             if (!isspace(*c)) has_data = NV_TRUE;
             c++;
         }
-        
+
+        /* check this before the line terminator is overwritten below */
+
+        last = ((c - buf) >= length) || (*c == '\0');
+
         if (has_data) {
             if (!comment) comment = c;
-            len = comment - cur;
-            
-            /* grow the tmp buffer if it's too small */
-            
-            if (len >= current_tmp_len) {
-                current_tmp_len = len + 1;
-                if (tmp) {
-                    free(tmp);
-                }
-                tmp = nvalloc(sizeof(char) * current_tmp_len);
-            }
 
-            strncpy (tmp, cur, len);
-            tmp[len] = '\0';
+            /*
+             * terminate the line in place; only when the data runs up to
+             * the end of the buffer is there no character to overwrite
+             */
+
+            if ((comment - buf) < length) {
+                *comment = '\0';
+                str = cur;
+            } else {
+                tmp = nvstrndup(cur, comment - cur);
+                str = tmp;
+            }
 
             /* first, see if this line is a config property */
 
-            if (!parse_config_property(file, tmp, conf)) {
-                
-                w = nvrealloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
-            
-                ret = nv_parse_attribute_string(tmp,
+            if (!parse_config_property(file, str, conf)) {
+
+                /* keep room for the terminating entry */
+
+                if (n + 1 >= size) {
+                    size = size ? size * 2 : 64;
+                    w = nvrealloc(w, sizeof(ParsedAttributeWrapper) * size);
+                }
+
+                ret = nv_parse_attribute_string(str,
                                                 NV_PARSER_ASSIGNMENT,
                                                 &w[n].a);
                 if (ret != NV_PARSER_STATUS_SUCCESS) {
                     nv_error_msg("Error parsing configuration file '%s' on "
                                  "line %d: '%s' (%s).",
-                                 file, line, tmp, nv_parse_strerror(ret));
+                                 file, line, str, nv_parse_strerror(ret));
                     goto failed;
                 }
-            
+
                 w[n].line = line;
                 n++;
             }
         }
 
-        if (((c - buf) >= length) || (*c == '\0')) cur = NULL;
+        if (last) cur = NULL;
         else cur = c + 1;
 
         line++;
     }
     free(tmp);
+
     /* mark the end of the array */
 
-    w = nvrealloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
+    if (!w) {
+        w = nvalloc(sizeof(ParsedAttributeWrapper));
+    }
     w[n].line = -1;
-    
+
     return w;
 
  failed:
@@ -842,6 +857,7 @@ ConfigPropertiesTableEntry configPropertyTable[] = {
       CONFIG_PROPERTIES_INCLUDE_DISPLAY_NAME_IN_CONFIG_FILE },
     { "UpdateRulesOnProfileNameChange",
       CONFIG_PROPERTIES_UPDATE_RULES_ON_PROFILE_NAME_CHANGE },
+    { "ShowLayoutFrameTimes", CONFIG_PROPERTIES_SHOW_LAYOUT_FRAME_TIMES },
     { NULL, 0 }
 };
 
@@ -1018,6 +1034,69 @@ void init_config_properties(ConfigProperties *conf)
 } /* init_config_properties() */
 
 
+/*
+ * query_config_int_attributes() - query the current value of each integer
+ * attribute that nv_write_config_file() should save for the given target:
+ * attributes that are writable, valid for targets of the given type and, if
+ * skip_display_attrs is set, not valid for display targets.  The values are
+ * fetched with a single batched query.  The returned array is indexed like
+ * attributeTable[]; entries that were not queried have a status of
+ * NvCtrlNoAttribute.  The caller is responsible for freeing the array.
+ */
+
+static CtrlAttributeQuery *query_config_int_attributes(CtrlTarget *t,
+                                                       CtrlTargetType type,
+                                                       int skip_display_attrs)
+{
+    CtrlAttributeQuery *values;
+    CtrlAttributeQuery *batch;
+    CtrlAttributePerms perms;
+    ReturnStatus status;
+    int *indices;
+    int entry, n = 0;
+
+    values = nvalloc(sizeof(*values) * attributeTableLen);
+    batch = nvalloc(sizeof(*batch) * attributeTableLen);
+    indices = nvalloc(sizeof(*indices) * attributeTableLen);
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        const AttributeTableEntry *a = &attributeTable[entry];
+
+        values[entry].status = NvCtrlNoAttribute;
+
+        if (a->flags.no_config_write ||
+            (a->type != CTRL_ATTRIBUTE_TYPE_INTEGER)) {
+            continue;
+        }
+
+        status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
+        if (status != NvCtrlSuccess || !(perms.write) ||
+            !(perms.valid_targets & CTRL_TARGET_PERM_BIT(type)) ||
+            (skip_display_attrs &&
+             (perms.valid_targets & CTRL_TARGET_PERM_BIT(DISPLAY_TARGET)))) {
+            continue;
+        }
+
+        batch[n].display_mask = 0;
+        batch[n].attr = a->attr;
+        indices[n++] = entry;
+    }
+
+    NvCtrlGetDisplayAttributes(t, batch, n);
+
+    while (n--) {
+        values[indices[n]] = batch[n];
+    }
+
+    nvfree(indices);
+    nvfree(batch);
+
+    return values;
+
+} /* query_config_int_attributes() */
+
+
+
 /*
  * create_display_device_target_string() - create the string
  * to specify the display device target in the config file.
@@ -0,0 +1,1445 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * framelock-monitor.c - samples the frame lock status of several X servers
+ * concurrently.
+ *
+ * Each monitored X server gets its own thread and its own connection, so
+ * that a slow or unreachable server only delays its own samples.  After
+ * each sample, the thread publishes the status of all of the server's
+ * frame lock boards and of the GPUs tied to them; readers only ever take
+ * a reference to the last published status, and never wait for a query.
+ *
+ * A display name of the form "stub:NAME[@MS]" is not connected to;
+ * instead, its thread simulates a server with one frame lock board and
+ * two GPUs, taking MS milliseconds per sample.  This allows exercising
+ * the monitor and its users without a frame lock cluster.
+ *
+ * Xlib's default handling of a lost connection exits the process.  The
+ * connections of host threads instead get an IO error exit handler that
+ * marks them as lost, so that the host is reported as unreachable and
+ * reconnected to.  XSetIOErrorExitHandler() was added in libX11 1.7; when
+ * building against an older libX11 (HAVE_XSETIOERROREXITHANDLER is not
+ * defined), X servers are not sampled on host threads but synchronously,
+ * when their status is read, as the frame lock page used to do.
+ *
+ * nv_print_framelock_status() implements --framelock-status on top of the
+ * monitor, printing the samples as a sync matrix.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+
+#include <X11/Xlib.h>
+
+#include "framelock-monitor.h"
+#include "query-assign.h"
+#include "msg.h"
+#include "common-utils.h"
+
+#define FRAMELOCK_MONITOR_STUB_PREFIX "stub:"
+
+/*
+ * Connection attempts to an unreachable X server are retried at most this
+ * often, however short the sampling interval.
+ */
+#define FRAMELOCK_MONITOR_RETRY_MS 5000
+
+
+static const int boardStatusAttributes[FRAMELOCK_STATUS_COUNT] = {
+    NV_CTRL_FRAMELOCK_SYNC_DELAY,               /* SYNC_DELAY */
+    NV_CTRL_FRAMELOCK_HOUSE_STATUS,             /* HOUSE */
+    NV_CTRL_FRAMELOCK_PORT0_STATUS,             /* PORT0 */
+    NV_CTRL_FRAMELOCK_PORT1_STATUS,             /* PORT1 */
+    NV_CTRL_FRAMELOCK_SYNC_READY,               /* SYNC_READY */
+    NV_CTRL_FRAMELOCK_SYNC_RATE_4,              /* SYNC_RATE_4 */
+    NV_CTRL_FRAMELOCK_SYNC_RATE,                /* SYNC_RATE */
+    NV_CTRL_FRAMELOCK_INCOMING_HOUSE_SYNC_RATE, /* HOUSE_SYNC_RATE */
+    NV_CTRL_FRAMELOCK_ETHERNET_DETECTED,        /* ETHERNET */
+};
+
+static const int gpuStatusAttributes[GPU_STATUS_COUNT] = {
+    NV_CTRL_FRAMELOCK_SYNC,        /* SYNC */
+    NV_CTRL_FRAMELOCK_TIMING,      /* TIMING */
+    NV_CTRL_FRAMELOCK_STEREO_SYNC, /* STEREO_SYNC */
+};
+
+
+/*
+ * The connection to the X server of a host; owned by the host's thread,
+ * or by the host when it is sampled synchronously.
+ */
+
+typedef struct {
+    CtrlSystemList systems;
+    CtrlSystem *system;   /* NULL while not connected */
+    int lost;             /* set when the connection is lost */
+    struct timespec retry; /* earliest time of the next connection attempt */
+} HostConnection;
+
+typedef struct _FrameLockHost FrameLockHost;
+
+struct _FrameLockHost {
+    FrameLockHost *next;
+    FrameLockMonitor *monitor;
+
+    char *display;
+    int stub_latency_ms; /* -1 unless this is a stub host */
+
+    int stop; /* set when the host is removed; the thread then frees it */
+    FrameLockHostStatus *status; /* last published status */
+
+    /* hosts sampled synchronously only; see sample_host_sync() */
+    HostConnection conn;
+    unsigned int sample;
+    struct timespec next_sample;
+};
+
+struct _FrameLockMonitor {
+    int interval_ms;
+
+    pthread_mutex_t lock; /* protects everything below, and the status
+                           * reference counts */
+    pthread_cond_t cond;  /* signaled when a status is published or a
+                           * host is removed */
+
+    FrameLockHost *hosts;
+    int refs; /* one for the owner, and one per running host thread */
+};
+
+
+
+#ifdef HAVE_XSETIOERROREXITHANDLER
+
+/*
+ * Xlib calls the process-wide IO error handler before the exit handler of
+ * the display.  io_error_handler() defers to the handler it replaced
+ * (e.g., the one installed by GDK, which exits), except on host threads,
+ * which are marked with io_error_key.
+ */
+
+static pthread_once_t io_error_once = PTHREAD_ONCE_INIT;
+static pthread_key_t io_error_key;
+static XIOErrorHandler io_error_previous_handler;
+
+static int io_error_handler(Display *dpy)
+{
+    if (pthread_getspecific(io_error_key)) {
+        return 0;
+    }
+
+    return io_error_previous_handler(dpy);
+}
+
+static void io_error_init(void)
+{
+    pthread_key_create(&io_error_key, NULL);
+    io_error_previous_handler = XSetIOErrorHandler(io_error_handler);
+}
+
+
+
+/*
+ * io_error_exit() - the IO error exit handler of the connections of host
+ * threads: rather than exiting, mark the connection as lost.  Xlib then
+ * fails any further request on it without blocking.
+ */
+
+static void io_error_exit(Display *dpy, void *data)
+{
+    int *lost = data;
+
+    *lost = NV_TRUE;
+}
+
+#endif /* HAVE_XSETIOERROREXITHANDLER */
+
+
+
+/*
+ * sampled_on_thread() - whether 'host' is sampled by a thread of its own;
+ * without XSetIOErrorExitHandler(), only stub hosts are.
+ */
+
+static int sampled_on_thread(const FrameLockHost *host)
+{
+#ifdef HAVE_XSETIOERROREXITHANDLER
+    return NV_TRUE;
+#else
+    return host->stub_latency_ms >= 0;
+#endif
+}
+
+
+
+/*
+ * query_status() - query the attributes 'attrs' of 'target' into 'status'
+ * with a single batch, so that they cost one round trip.
+ */
+
+static void query_status(const CtrlTarget *target, const int *attrs,
+                         CtrlAttributeQuery *status, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        status[i].display_mask = 0;
+        status[i].attr = attrs[i];
+        status[i].val = 0;
+        status[i].status = NvCtrlError;
+    }
+
+    NvCtrlGetDisplayAttributes(target, status, count);
+}
+
+
+
+/*
+ * nv_framelock_query_board_status() - query the FRAMELOCK_STATUS_COUNT
+ * status attributes of the frame lock board 'board' into 'status'.
+ */
+
+void nv_framelock_query_board_status(const CtrlTarget *board,
+                                     CtrlAttributeQuery *status)
+{
+    query_status(board, boardStatusAttributes, status,
+                 FRAMELOCK_STATUS_COUNT);
+}
+
+
+
+/*
+ * nv_framelock_query_gpu_status() - query the GPU_STATUS_COUNT frame lock
+ * status attributes of 'gpu' into 'status'.
+ */
+
+void nv_framelock_query_gpu_status(const CtrlTarget *gpu,
+                                   CtrlAttributeQuery *status)
+{
+    query_status(gpu, gpuStatusAttributes, status, GPU_STATUS_COUNT);
+}
+
+
+
+static FrameLockHostStatus *status_new(FrameLockHostState state)
+{
+    FrameLockHostStatus *status = nvalloc(sizeof(*status));
+
+    status->refs = 1;
+    status->state = state;
+    clock_gettime(CLOCK_REALTIME, &status->when);
+
+    return status;
+}
+
+
+
+/*
+ * status_unref() - drop a reference to 'status', freeing it when the last
+ * reference is gone.  Must be called with the monitor lock held.
+ */
+
+static void status_unref(FrameLockHostStatus *status)
+{
+    int i;
+
+    if (!status || --status->refs > 0) {
+        return;
+    }
+
+    for (i = 0; i < status->num_boards; i++) {
+        nvfree(status->boards[i].gpus);
+    }
+    nvfree(status->boards);
+    nvfree(status);
+}
+
+
+
+/*
+ * sample_system() - query the status of all frame lock boards of 'system',
+ * and of the GPUs tied to them.
+ */
+
+static FrameLockHostStatus *sample_system(const CtrlSystem *system)
+{
+    FrameLockHostStatus *status = status_new(FRAMELOCK_HOST_CONNECTED);
+    const CtrlTargetNode *node, *rel;
+    int n = 0;
+
+    for (node = system->targets[FRAMELOCK_TARGET]; node; node = node->next) {
+        n++;
+    }
+
+    status->boards = nvalloc(sizeof(FrameLockBoardStatus) * NV_MAX(n, 1));
+
+    for (node = system->targets[FRAMELOCK_TARGET]; node; node = node->next) {
+        FrameLockBoardStatus *board = &status->boards[status->num_boards++];
+
+        board->id = NvCtrlGetTargetId(node->t);
+        nv_framelock_query_board_status(node->t, board->status);
+
+        n = 0;
+        for (rel = node->t->relations; rel; rel = rel->next) {
+            n += (NvCtrlGetTargetType(rel->t) == GPU_TARGET);
+        }
+
+        board->gpus = nvalloc(sizeof(FrameLockGpuStatus) * NV_MAX(n, 1));
+
+        for (rel = node->t->relations; rel; rel = rel->next) {
+            FrameLockGpuStatus *gpu;
+
+            if (NvCtrlGetTargetType(rel->t) != GPU_TARGET) {
+                continue;
+            }
+
+            gpu = &board->gpus[board->num_gpus++];
+            gpu->id = NvCtrlGetTargetId(rel->t);
+            nv_framelock_query_gpu_status(rel->t, gpu->status);
+        }
+    }
+
+    /* the clock was read when the status was created; update it */
+
+    clock_gettime(CLOCK_REALTIME, &status->when);
+
+    return status;
+}
+
+
+
+/*
+ * sample_stub() - simulate sample number 'sample' of a stub host: one
+ * synced frame lock board receiving a 60 Hz house sync signal, tied to
+ * two GPUs.  To give users something to react to, GPU 1 loses
+ * timing on every tenth sample (offset by a hash of the host's name).
+ */
+
+static FrameLockHostStatus *sample_stub(const FrameLockHost *host,
+                                        unsigned int sample)
+{
+    FrameLockHostStatus *status;
+    FrameLockBoardStatus *board;
+    struct timespec latency;
+    unsigned int hash = 5381;
+    const char *c;
+    int i;
+
+    if (host->stub_latency_ms > 0) {
+        latency.tv_sec = host->stub_latency_ms / 1000;
+        latency.tv_nsec = (host->stub_latency_ms % 1000) * 1000000;
+        while (nanosleep(&latency, &latency) < 0 && errno == EINTR) {
+        }
+    }
+
+    for (c = host->display; *c; c++) {
+        hash = hash * 33 + (unsigned char) *c;
+    }
+
+    status = status_new(FRAMELOCK_HOST_CONNECTED);
+    status->boards = nvalloc(sizeof(FrameLockBoardStatus));
+    status->num_boards = 1;
+
+    board = &status->boards[0];
+    board->id = 0;
+
+    for (i = 0; i < FRAMELOCK_STATUS_COUNT; i++) {
+        board->status[i].attr = boardStatusAttributes[i];
+        board->status[i].status = NvCtrlSuccess;
+    }
+
+    board->status[FRAMELOCK_STATUS_HOUSE].val =
+        NV_CTRL_FRAMELOCK_HOUSE_STATUS_DETECTED;
+    board->status[FRAMELOCK_STATUS_PORT0].val =
+        NV_CTRL_FRAMELOCK_PORT0_STATUS_INPUT;
+    board->status[FRAMELOCK_STATUS_PORT1].val =
+        NV_CTRL_FRAMELOCK_PORT1_STATUS_OUTPUT;
+    board->status[FRAMELOCK_STATUS_SYNC_READY].val =
+        NV_CTRL_FRAMELOCK_SYNC_READY_TRUE;
+    board->status[FRAMELOCK_STATUS_SYNC_RATE_4].val = 600000;
+    board->status[FRAMELOCK_STATUS_SYNC_RATE].val = 60000;
+    board->status[FRAMELOCK_STATUS_HOUSE_SYNC_RATE].val = 600000;
+    board->status[FRAMELOCK_STATUS_ETHERNET].val =
+        NV_CTRL_FRAMELOCK_ETHERNET_DETECTED_NONE;
+
+    board->gpus = nvalloc(sizeof(FrameLockGpuStatus) * 2);
+    board->num_gpus = 2;
+
+    for (i = 0; i < board->num_gpus; i++) {
+        FrameLockGpuStatus *gpu = &board->gpus[i];
+        int j;
+
+        gpu->id = i;
+        for (j = 0; j < GPU_STATUS_COUNT; j++) {
+            gpu->status[j].attr = gpuStatusAttributes[j];
+            gpu->status[j].status = NvCtrlSuccess;
+        }
+
+        gpu->status[GPU_STATUS_SYNC].val = NV_CTRL_FRAMELOCK_SYNC_ENABLE;
+        gpu->status[GPU_STATUS_TIMING].val =
+            (i == 1 && (sample + hash) % 10 == 9) ?
+            NV_CTRL_FRAMELOCK_TIMING_FALSE : NV_CTRL_FRAMELOCK_TIMING_TRUE;
+        gpu->status[GPU_STATUS_STEREO_SYNC].val =
+            NV_CTRL_FRAMELOCK_STEREO_SYNC_FALSE;
+    }
+
+    return status;
+}
+
+
+
+/*
+ * connect_host() - connect to the X server of 'host'.  Returns NULL if it
+ * cannot be reached.  '*lost' is set if the connection is lost later on.
+ */
+
+static CtrlSystem *connect_host(const FrameLockHost *host,
+                                CtrlSystemList *systems, int *lost)
+{
+    CtrlSystem *system;
+    Display *dpy;
+
+    /*
+     * Probe the X server first: if it cannot be reached, connecting to
+     * the CtrlSystem would fall back to the local GPUs through NVML, and
+     * report errors on every retry.
+     */
+
+    dpy = XOpenDisplay(host->display);
+    if (!dpy) {
+        return NULL;
+    }
+    XCloseDisplay(dpy);
+
+    system = NvCtrlConnectToLimitedSystem(host->display, systems, NV_TRUE);
+    if (!system || !system->dpy) {
+        NvCtrlFreeAllSystems(systems);
+        return NULL;
+    }
+
+    *lost = NV_FALSE;
+#ifdef HAVE_XSETIOERROREXITHANDLER
+    XSetIOErrorExitHandler(system->dpy, io_error_exit, lost);
+#endif
+
+    return system;
+}
+
+
+
+/*
+ * monitor_unref() - drop a reference to 'monitor', which must be locked,
+ * and unlock it; the monitor is freed when the last reference is gone.
+ */
+
+static void monitor_unref(FrameLockMonitor *monitor)
+{
+    int refs = --monitor->refs;
+
+    pthread_mutex_unlock(&monitor->lock);
+
+    if (refs == 0) {
+        pthread_cond_destroy(&monitor->cond);
+        pthread_mutex_destroy(&monitor->lock);
+        nvfree(monitor);
+    }
+}
+
+
+
+/*
+ * timespec_add_ms() - return '*ts' advanced by 'ms' milliseconds.
+ */
+
+static struct timespec timespec_add_ms(const struct timespec *ts, int64_t ms)
+{
+    struct timespec ret;
+    int64_t nsec = ts->tv_nsec + (ms % 1000) * 1000000;
+
+    ret.tv_sec = ts->tv_sec + ms / 1000 + nsec / 1000000000;
+    ret.tv_nsec = nsec % 1000000000;
+
+    return ret;
+}
+
+static int timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    return (a->tv_sec < b->tv_sec) ||
+           (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+
+
+/*
+ * sample_connection() - sample the X server of 'host' through 'conn',
+ * connecting to it first if needed (at most every
+ * FRAMELOCK_MONITOR_RETRY_MS).  A sample during which the connection was
+ * lost is discarded, and the host reported as unreachable until it is
+ * reconnected to.  Must be called without the monitor lock held.
+ */
+
+static FrameLockHostStatus *sample_connection(const FrameLockHost *host,
+                                              HostConnection *conn)
+{
+    FrameLockHostStatus *status;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!conn->system && !timespec_before(&now, &conn->retry)) {
+        conn->system = connect_host(host, &conn->systems, &conn->lost);
+        conn->retry = timespec_add_ms(&now, FRAMELOCK_MONITOR_RETRY_MS);
+    }
+    status = conn->system ? sample_system(conn->system) : NULL;
+
+    if (conn->lost) {
+        pthread_mutex_lock(&host->monitor->lock);
+        status_unref(status);
+        pthread_mutex_unlock(&host->monitor->lock);
+        status = NULL;
+
+        NvCtrlFreeAllSystems(&conn->systems);
+        conn->system = NULL;
+        conn->lost = NV_FALSE;
+    }
+
+    return status ? status : status_new(FRAMELOCK_HOST_UNREACHABLE);
+}
+
+
+
+/*
+ * host_thread() - sample the status of one host every interval_ms
+ * milliseconds and publish it, until the host is removed.
+ *
+ * As in --watch mode, samples are taken at fixed points in time since the
+ * thread started, and samples that could not be taken in time are
+ * skipped.
+ */
+
+static void *host_thread(void *data)
+{
+    FrameLockHost *host = data;
+    FrameLockMonitor *monitor = host->monitor;
+    HostConnection conn;
+    FrameLockHostStatus *status;
+    struct timespec start, now, next;
+    unsigned int sample = 0;
+    int64_t tick = 0;
+
+    memset(&conn, 0, sizeof(conn));
+
+#ifdef HAVE_XSETIOERROREXITHANDLER
+    pthread_setspecific(io_error_key, host);
+#endif
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&monitor->lock);
+
+    while (!host->stop) {
+
+        pthread_mutex_unlock(&monitor->lock);
+
+        if (host->stub_latency_ms >= 0) {
+            status = sample_stub(host, sample);
+        } else {
+            status = sample_connection(host, &conn);
+        }
+        status->sample = sample++;
+
+        pthread_mutex_lock(&monitor->lock);
+
+        status_unref(host->status);
+        host->status = status;
+        pthread_cond_broadcast(&monitor->cond);
+
+        /* wait for the next sample time that has not passed yet */
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        do {
+            next = timespec_add_ms(&start, ++tick * monitor->interval_ms);
+        } while (timespec_before(&next, &now));
+
+        while (!host->stop &&
+               pthread_cond_timedwait(&monitor->cond, &monitor->lock,
+                                      &next) != ETIMEDOUT) {
+        }
+    }
+
+    status_unref(host->status);
+    nvfree(host->display);
+    nvfree(host);
+
+    monitor_unref(monitor);
+
+    NvCtrlFreeAllSystems(&conn.systems);
+
+    return NULL;
+}
+
+
+
+/*
+ * sample_host_sync() - sample the X server of 'host', which has no thread
+ * of its own, on the calling thread, and publish the status.  Called with
+ * the monitor locked; the lock is released while sampling.
+ */
+
+static void sample_host_sync(FrameLockMonitor *monitor, FrameLockHost *host)
+{
+    FrameLockHostStatus *status;
+    struct timespec now;
+
+    pthread_mutex_unlock(&monitor->lock);
+    status = sample_connection(host, &host->conn);
+    pthread_mutex_lock(&monitor->lock);
+
+    status->sample = host->sample++;
+    status_unref(host->status);
+    host->status = status;
+    pthread_cond_broadcast(&monitor->cond);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    host->next_sample = timespec_add_ms(&now, monitor->interval_ms);
+}
+
+
+
+/*
+ * free_host_sync() - free 'host', which has no thread of its own and has
+ * been removed from the monitor.  Called with the monitor locked.
+ */
+
+static void free_host_sync(FrameLockHost *host)
+{
+    status_unref(host->status);
+    NvCtrlFreeAllSystems(&host->conn.systems);
+    nvfree(host->display);
+    nvfree(host);
+}
+
+
+
+/*
+ * nv_framelock_monitor_new() - create a monitor that samples each of its
+ * hosts every 'interval_ms' milliseconds.  Hosts are added with
+ * nv_framelock_monitor_add_host().
+ */
+
+FrameLockMonitor *nv_framelock_monitor_new(int interval_ms)
+{
+    FrameLockMonitor *monitor = nvalloc(sizeof(*monitor));
+    pthread_condattr_t attr;
+
+#ifdef HAVE_XSETIOERROREXITHANDLER
+    pthread_once(&io_error_once, io_error_init);
+#endif
+
+    monitor->interval_ms = NV_MAX(interval_ms, 1);
+    monitor->refs = 1;
+
+    pthread_mutex_init(&monitor->lock, NULL);
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&monitor->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return monitor;
+}
+
+
+
+/*
+ * nv_framelock_monitor_free() - stop monitoring all hosts and free
+ * 'monitor'.  This does not wait for the host threads: a thread that is
+ * still connecting or sampling exits once that completes, and the monitor
+ * is only freed after the last thread exits.
+ */
+
+void nv_framelock_monitor_free(FrameLockMonitor *monitor)
+{
+    FrameLockHost *host, *next;
+
+    if (!monitor) {
+        return;
+    }
+
+    pthread_mutex_lock(&monitor->lock);
+
+    for (host = monitor->hosts; host; host = next) {
+        next = host->next;
+        if (sampled_on_thread(host)) {
+            host->stop = NV_TRUE;
+        } else {
+            free_host_sync(host);
+        }
+    }
+    monitor->hosts = NULL;
+    pthread_cond_broadcast(&monitor->cond);
+
+    monitor_unref(monitor);
+}
+
+
+
+static FrameLockHost *find_host(const FrameLockMonitor *monitor,
+                                const char *display)
+{
+    FrameLockHost *host;
+
+    for (host = monitor->hosts; host; host = host->next) {
+        if (strcmp(host->display, display) == 0) {
+            return host;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * nv_framelock_monitor_add_host() - start monitoring the X server
+ * 'display' (or, if it is of the form "stub:NAME[@MS]", a simulated
+ * server).  Adding a host that is already monitored does nothing.
+ *
+ * Returns NV_FALSE and prints an error message if the host's thread
+ * cannot be created; otherwise, returns NV_TRUE.
+ */
+
+int nv_framelock_monitor_add_host(FrameLockMonitor *monitor,
+                                  const char *display)
+{
+    FrameLockHost *host;
+    pthread_t thread;
+    pthread_attr_t attr;
+    sigset_t all, old;
+    const char *latency;
+    int ret;
+
+    pthread_mutex_lock(&monitor->lock);
+
+    if (find_host(monitor, display)) {
+        pthread_mutex_unlock(&monitor->lock);
+        return NV_TRUE;
+    }
+
+    host = nvalloc(sizeof(*host));
+    host->monitor = monitor;
+    host->display = nvstrdup(display);
+    host->stub_latency_ms = -1;
+    host->status = status_new(FRAMELOCK_HOST_CONNECTING);
+
+    if (strncmp(display, FRAMELOCK_MONITOR_STUB_PREFIX,
+                strlen(FRAMELOCK_MONITOR_STUB_PREFIX)) == 0) {
+        latency = strchr(display, '@');
+        host->stub_latency_ms = latency ? NV_MAX(atoi(latency + 1), 0) : 0;
+    }
+
+    if (!sampled_on_thread(host)) {
+        host->next = monitor->hosts;
+        monitor->hosts = host;
+        pthread_mutex_unlock(&monitor->lock);
+        return NV_TRUE;
+    }
+
+    /*
+     * block all signals in the host thread, so that SIGINT and SIGTERM
+     * are delivered to the thread that owns the monitor
+     */
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    ret = pthread_create(&thread, &attr, host_thread, host);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        pthread_mutex_unlock(&monitor->lock);
+        nv_error_msg("Unable to create the frame lock monitor thread for "
+                     "'%s' (%s).", display, strerror(ret));
+        status_unref(host->status);
+        nvfree(host->display);
+        nvfree(host);
+        return NV_FALSE;
+    }
+
+    host->next = monitor->hosts;
+    monitor->hosts = host;
+    monitor->refs++;
+
+    pthread_mutex_unlock(&monitor->lock);
+
+    return NV_TRUE;
+}
+
+
+
+/*
+ * nv_framelock_monitor_remove_host() - stop monitoring 'display'.  This
+ * does not wait for the host's thread, which exits (and frees the host)
+ * once any connection or sample in progress completes.
+ */
+
+void nv_framelock_monitor_remove_host(FrameLockMonitor *monitor,
+                                      const char *display)
+{
+    FrameLockHost **prev, *host;
+
+    pthread_mutex_lock(&monitor->lock);
+
+    for (prev = &monitor->hosts; (host = *prev); prev = &host->next) {
+        if (strcmp(host->display, display) == 0) {
+            *prev = host->next;
+            if (sampled_on_thread(host)) {
+                host->stop = NV_TRUE;
+                pthread_cond_broadcast(&monitor->cond);
+            } else {
+                free_host_sync(host);
+            }
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+
+
+/*
+ * nv_framelock_monitor_wait() - wait up to 'timeout_ms' milliseconds for
+ * every host to have been sampled at least once.  Returns NV_TRUE if they
+ * all have, or NV_FALSE on timeout.
+ */
+
+int nv_framelock_monitor_wait(FrameLockMonitor *monitor, int timeout_ms)
+{
+    FrameLockHost *host;
+    struct timespec now, deadline;
+    int ret = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = timespec_add_ms(&now, timeout_ms);
+
+    pthread_mutex_lock(&monitor->lock);
+
+    for (host = monitor->hosts; host; host = host->next) {
+        if (!sampled_on_thread(host) &&
+            host->status->state == FRAMELOCK_HOST_CONNECTING) {
+            sample_host_sync(monitor, host);
+        }
+    }
+
+    while (1) {
+        for (host = monitor->hosts; host; host = host->next) {
+            if (host->status->state == FRAMELOCK_HOST_CONNECTING) {
+                break;
+            }
+        }
+        if (!host || ret == ETIMEDOUT) {
+            break;
+        }
+        ret = pthread_cond_timedwait(&monitor->cond, &monitor->lock,
+                                     &deadline);
+    }
+
+    pthread_mutex_unlock(&monitor->lock);
+
+    return host == NULL;
+}
+
+
+
+/*
+ * nv_framelock_monitor_get_status() - return a reference to the last
+ * published status of 'display', or NULL if it is not monitored.  The
+ * status must be released with nv_framelock_monitor_release_status().
+ * This never waits for a sample, except for hosts sampled synchronously
+ * (see sampled_on_thread()), which are sampled here if their last sample
+ * is older than the monitor's interval.
+ */
+
+FrameLockHostStatus *nv_framelock_monitor_get_status(FrameLockMonitor *monitor,
+                                                     const char *display)
+{
+    FrameLockHostStatus *status = NULL;
+    FrameLockHost *host;
+    struct timespec now;
+
+    pthread_mutex_lock(&monitor->lock);
+
+    host = find_host(monitor, display);
+    if (host && !sampled_on_thread(host)) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (!timespec_before(&now, &host->next_sample)) {
+            sample_host_sync(monitor, host);
+        }
+    }
+    if (host) {
+        status = host->status;
+        status->refs++;
+    }
+
+    pthread_mutex_unlock(&monitor->lock);
+
+    return status;
+}
+
+
+
+void nv_framelock_monitor_release_status(FrameLockMonitor *monitor,
+                                         FrameLockHostStatus *status)
+{
+    pthread_mutex_lock(&monitor->lock);
+    status_unref(status);
+    pthread_mutex_unlock(&monitor->lock);
+}
+
+
+
+/*
+ * nv_framelock_find_board_status() - return the status of the frame lock
+ * board with target id 'id' in 'status', or NULL if there is none.
+ */
+
+const FrameLockBoardStatus *
+nv_framelock_find_board_status(const FrameLockHostStatus *status, int id)
+{
+    int i;
+
+    for (i = 0; status && i < status->num_boards; i++) {
+        if (status->boards[i].id == id) {
+            return &status->boards[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * nv_framelock_find_gpu_status() - return the status of the GPU with
+ * target id 'id' in 'status', or NULL if it is not tied to any of the
+ * frame lock boards.
+ */
+
+const FrameLockGpuStatus *
+nv_framelock_find_gpu_status(const FrameLockHostStatus *status, int id)
+{
+    int i, j;
+
+    for (i = 0; status && i < status->num_boards; i++) {
+        const FrameLockBoardStatus *board = &status->boards[i];
+
+        for (j = 0; j < board->num_gpus; j++) {
+            if (board->gpus[j].id == id) {
+                return &board->gpus[j];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * Frame lock status (--framelock-status): the frame lock boards of several
+ * X servers are sampled concurrently by a FrameLockMonitor, with one
+ * thread per X server, and printed as the sync matrix of the cluster: one
+ * row per GPU tied to a frame lock board, along with that board's status.
+ * An X server that cannot be reached only delays its own row.
+ */
+
+#define FRAMELOCK_STATUS_DEFAULT_INTERVAL 1.0
+#define FRAMELOCK_STATUS_CONNECT_TIMEOUT_MS 10000
+
+typedef struct {
+    const char *host;
+    const FrameLockHostStatus *status;
+    const FrameLockBoardStatus *board; /* NULL if unreachable */
+    const FrameLockGpuStatus *gpu;     /* NULL if the board has no GPUs */
+} FrameLockStatusRow;
+
+static const char *framelock_host_state_names[] = {
+    "connecting",  /* FRAMELOCK_HOST_CONNECTING */
+    "connected",   /* FRAMELOCK_HOST_CONNECTED */
+    "unreachable", /* FRAMELOCK_HOST_UNREACHABLE */
+};
+
+
+
+/*
+ * framelock_status_host_name() - return the X server name for the host
+ * 'name' given with --framelock-status, as the frame lock page builds it:
+ * without a screen number, and with display number 0 if none is given.
+ * Stub hosts are returned unchanged.
+ */
+
+static char *framelock_status_host_name(const char *name)
+{
+    char *colon;
+
+    if (strncmp(name, "stub:", 5) == 0) {
+        return nvstrdup(name);
+    }
+
+    colon = strchr(name, ':');
+    if (!colon) {
+        return nvstrcat(name, ":0", NULL);
+    }
+
+    return nvstrndup(name, strcspn(colon, ".") + (colon - name));
+}
+
+
+
+/*
+ * framelock_status_value() - return NV_TRUE, and the value in 'val', if
+ * the status attribute 'q' was queried successfully.
+ */
+
+static Bool framelock_status_value(const CtrlAttributeQuery *q, int *val)
+{
+    if (q->status != NvCtrlSuccess) {
+        return NV_FALSE;
+    }
+
+    *val = (int) q->val;
+
+    return NV_TRUE;
+}
+
+/*
+ * framelock_status_rate() - return NV_TRUE, and the sync rate of 'board'
+ * in Hz in 'hz', if it could be queried.
+ */
+
+static Bool framelock_status_rate(const FrameLockBoardStatus *board,
+                                  double *hz)
+{
+    int val;
+
+    if (framelock_status_value(&board->status[FRAMELOCK_STATUS_SYNC_RATE_4],
+                               &val)) {
+        *hz = val / 10000.0;
+        return NV_TRUE;
+    }
+    if (framelock_status_value(&board->status[FRAMELOCK_STATUS_SYNC_RATE],
+                               &val)) {
+        *hz = val / 1000.0;
+        return NV_TRUE;
+    }
+
+    return NV_FALSE;
+}
+
+/*
+ * framelock_status_port() - return a description of the state of port
+ * 'port' of 'board': its direction, or "LAN" if an Ethernet cable is
+ * connected to it; NULL if it could not be queried.
+ */
+
+static const char *framelock_status_port(const FrameLockBoardStatus *board,
+                                         int port)
+{
+    int val, ethernet;
+
+    if (framelock_status_value(&board->status[FRAMELOCK_STATUS_ETHERNET],
+                               &ethernet) &&
+        (ethernet & (port ? NV_CTRL_FRAMELOCK_ETHERNET_DETECTED_PORT1 :
+                            NV_CTRL_FRAMELOCK_ETHERNET_DETECTED_PORT0))) {
+        return "LAN";
+    }
+
+    if (!framelock_status_value(&board->status[port ?
+                                               FRAMELOCK_STATUS_PORT1 :
+                                               FRAMELOCK_STATUS_PORT0],
+                                &val)) {
+        return NULL;
+    }
+
+    /* the PORT0 and PORT1 values are the same */
+
+    return (val == NV_CTRL_FRAMELOCK_PORT0_STATUS_INPUT) ? "input" : "output";
+}
+
+
+
+static void framelock_status_print_text_bool(const CtrlAttributeQuery *q,
+                                             int width)
+{
+    int val;
+
+    printf(" %-*s", width,
+           framelock_status_value(q, &val) ? (val ? "yes" : "no") : "-");
+}
+
+static void framelock_status_print_text_rate(Bool valid, double hz)
+{
+    if (valid) {
+        printf(" %10.4f", hz);
+    } else {
+        printf(" %10s", "-");
+    }
+}
+
+static void framelock_status_print_csv_int(const CtrlAttributeQuery *q)
+{
+    int val;
+
+    fputc(',', stdout);
+    if (framelock_status_value(q, &val)) {
+        printf("%d", val);
+    }
+}
+
+static void framelock_status_set_json_bool(json_t *record, const char *key,
+                                           const CtrlAttributeQuery *q)
+{
+    int val;
+
+    if (framelock_status_value(q, &val)) {
+        json_object_set_new(record, key, json_boolean(val));
+    }
+}
+
+
+
+/*
+ * framelock_status_print_row() - print one row of the sync matrix in the
+ * requested output format.
+ */
+
+static void framelock_status_print_row(const Options *op,
+                                       const FrameLockStatusRow *row)
+{
+    const FrameLockBoardStatus *board = row->board;
+    const FrameLockGpuStatus *gpu = row->gpu;
+    const char *state = framelock_host_state_names[row->status->state];
+    const char *port0 = NULL, *port1 = NULL;
+    Bool have_rate = NV_FALSE, have_house_rate = NV_FALSE;
+    double rate = 0.0, house_rate = 0.0;
+    json_t *record;
+    int val, i;
+
+    if (board) {
+        have_rate = framelock_status_rate(board, &rate);
+        have_house_rate = framelock_status_value(
+            &board->status[FRAMELOCK_STATUS_HOUSE_SYNC_RATE], &val);
+        house_rate = have_house_rate ? val / 10000.0 : 0.0;
+        port0 = framelock_status_port(board, 0);
+        port1 = framelock_status_port(board, 1);
+    }
+
+    switch (op->output_format) {
+
+    case OUTPUT_FORMAT_JSON:
+    case OUTPUT_FORMAT_NDJSON:
+        record = json_object();
+        json_object_set_new(record, "time",
+                            json_real(row->status->when.tv_sec +
+                                      row->status->when.tv_nsec /
+                                      1000000000.0));
+        json_object_set_new(record, "host", json_string(row->host));
+        json_object_set_new(record, "state", json_string(state));
+
+        if (board) {
+            json_object_set_new(record, "board", json_integer(board->id));
+            framelock_status_set_json_bool(record, "sync_ready",
+                &board->status[FRAMELOCK_STATUS_SYNC_READY]);
+            framelock_status_set_json_bool(record, "house_sync",
+                &board->status[FRAMELOCK_STATUS_HOUSE]);
+            if (have_house_rate) {
+                json_object_set_new(record, "house_sync_rate",
+                                    json_real(house_rate));
+            }
+            if (have_rate) {
+                json_object_set_new(record, "sync_rate", json_real(rate));
+            }
+            if (port0) {
+                json_object_set_new(record, "port0", json_string(port0));
+            }
+            if (port1) {
+                json_object_set_new(record, "port1", json_string(port1));
+            }
+        }
+
+        if (gpu) {
+            json_object_set_new(record, "gpu", json_integer(gpu->id));
+            framelock_status_set_json_bool(record, "sync",
+                &gpu->status[GPU_STATUS_SYNC]);
+            framelock_status_set_json_bool(record, "timing",
+                &gpu->status[GPU_STATUS_TIMING]);
+            framelock_status_set_json_bool(record, "stereo_sync",
+                &gpu->status[GPU_STATUS_STEREO_SYNC]);
+        }
+
+        nv_json_output_record(op, record);
+        break;
+
+    case OUTPUT_FORMAT_CSV:
+        printf("%lld.%03ld,", (long long) row->status->when.tv_sec,
+               row->status->when.tv_nsec / 1000000);
+        nv_print_csv_string(row->host);
+        printf(",%s", state);
+
+        if (board) {
+            printf(",%d", board->id);
+            framelock_status_print_csv_int(
+                &board->status[FRAMELOCK_STATUS_SYNC_READY]);
+            framelock_status_print_csv_int(
+                &board->status[FRAMELOCK_STATUS_HOUSE]);
+            fputc(',', stdout);
+            if (have_house_rate) {
+                printf("%.4f", house_rate);
+            }
+            fputc(',', stdout);
+            if (have_rate) {
+                printf("%.4f", rate);
+            }
+            printf(",%s,%s", port0 ? port0 : "", port1 ? port1 : "");
+        } else {
+            printf(",,,,,,,");
+        }
+
+        if (gpu) {
+            printf(",%d", gpu->id);
+            for (i = 0; i < GPU_STATUS_COUNT; i++) {
+                framelock_status_print_csv_int(&gpu->status[i]);
+            }
+        } else {
+            printf(",,,,");
+        }
+
+        fputc('\n', stdout);
+        break;
+
+    case OUTPUT_FORMAT_TEXT:
+        printf("%-24s", row->host);
+
+        if (!board) {
+            printf(" %s\n", state);
+            break;
+        }
+
+        printf(" %5d", board->id);
+        framelock_status_print_text_bool(
+            &board->status[FRAMELOCK_STATUS_SYNC_READY], 5);
+        framelock_status_print_text_bool(
+            &board->status[FRAMELOCK_STATUS_HOUSE], 5);
+        framelock_status_print_text_rate(have_house_rate, house_rate);
+        framelock_status_print_text_rate(have_rate, rate);
+        printf(" %-6s %-6s", port0 ? port0 : "-", port1 ? port1 : "-");
+
+        if (gpu) {
+            printf(" %3d", gpu->id);
+            framelock_status_print_text_bool(
+                &gpu->status[GPU_STATUS_SYNC], 4);
+            framelock_status_print_text_bool(
+                &gpu->status[GPU_STATUS_TIMING], 6);
+            framelock_status_print_text_bool(
+                &gpu->status[GPU_STATUS_STEREO_SYNC], 0);
+        }
+        fputc('\n', stdout);
+        break;
+    }
+}
+
+
+
+/*
+ * framelock_status_print() - print the sync matrix of the last published
+ * status of each of the 'num_hosts' hosts.
+ */
+
+static void framelock_status_print(const Options *op,
+                                   FrameLockMonitor *monitor,
+                                   char **hosts, int num_hosts)
+{
+    FrameLockHostStatus *status;
+    FrameLockStatusRow row;
+    struct timespec now;
+    char time_str[32];
+    struct tm tm;
+    int i, j, k;
+
+    if (op->output_format == OUTPUT_FORMAT_TEXT && !op->terse) {
+        if (op->watch_interval > 0.0) {
+            clock_gettime(CLOCK_REALTIME, &now);
+            localtime_r(&now.tv_sec, &tm);
+            strftime(time_str, sizeof(time_str), "%H:%M:%S", &tm);
+            printf("%s.%03ld\n", time_str, now.tv_nsec / 1000000);
+        }
+        printf("%-24s %5s %-5s %-5s %10s %10s %-6s %-6s %3s %-4s %-6s %s\n",
+               "Host", "Board", "Ready", "House", "House Hz", "Sync Hz",
+               "Port 0", "Port 1", "GPU", "Sync", "Timing", "Stereo");
+    }
+
+    for (i = 0; i < num_hosts; i++) {
+        status = nv_framelock_monitor_get_status(monitor, hosts[i]);
+        if (!status) {
+            continue;
+        }
+
+        memset(&row, 0, sizeof(row));
+        row.host = hosts[i];
+        row.status = status;
+
+        if (status->state != FRAMELOCK_HOST_CONNECTED) {
+            framelock_status_print_row(op, &row);
+        }
+
+        for (j = 0; j < status->num_boards; j++) {
+            row.board = &status->boards[j];
+            row.gpu = NULL;
+
+            if (row.board->num_gpus == 0) {
+                framelock_status_print_row(op, &row);
+            }
+            for (k = 0; k < row.board->num_gpus; k++) {
+                row.gpu = &row.board->gpus[k];
+                framelock_status_print_row(op, &row);
+            }
+        }
+
+        nv_framelock_monitor_release_status(monitor, status);
+    }
+
+    if (op->output_format == OUTPUT_FORMAT_TEXT && op->watch_interval > 0.0) {
+        fputc('\n', stdout);
+    }
+}
+
+
+
+/*
+ * nv_print_framelock_status() - sample the frame lock status of the
+ * comma separated list of X servers op->framelock_status, each in its own
+ * thread, and print it as a sync matrix.  Hosts named "stub:NAME[@MS]"
+ * are simulated, for testing without a frame lock cluster.
+ *
+ * Without --watch, the matrix is printed once every host has been sampled
+ * or found unreachable (waiting at most
+ * FRAMELOCK_STATUS_CONNECT_TIMEOUT_MS), and NV_FALSE is returned if any
+ * host could not be sampled.  With --watch, the matrix is printed every
+ * op->watch_interval seconds until SIGINT or SIGTERM is received; each
+ * print shows the last sample of each host, so that a slow host does not
+ * delay the others.
+ */
+
+int nv_print_framelock_status(const Options *op)
+{
+    FrameLockMonitor *monitor;
+    FrameLockHostStatus *status;
+    WatchTimer timer;
+    char *list, **toks, **hosts = NULL;
+    int num_toks, num_hosts = 0, i, val = NV_TRUE;
+    double interval;
+
+    list = nvstrdup(op->framelock_status);
+    toks = nv_strtok(list, ',', &num_toks);
+    nvfree(list);
+
+    for (i = 0; i < num_toks; i++) {
+        if (toks[i][0] != '\0') {
+            hosts = nvrealloc(hosts, sizeof(char *) * (num_hosts + 1));
+            hosts[num_hosts++] = framelock_status_host_name(toks[i]);
+        }
+    }
+    nv_free_strtoks(toks, num_toks);
+
+    if (num_hosts == 0) {
+        nv_error_msg("No X servers given to query the frame lock status of.");
+        return NV_FALSE;
+    }
+
+    interval = (op->watch_interval > 0.0) ?
+               op->watch_interval : FRAMELOCK_STATUS_DEFAULT_INTERVAL;
+
+    monitor = nv_framelock_monitor_new((int) (interval * 1000.0));
+
+    for (i = 0; i < num_hosts; i++) {
+        if (!nv_framelock_monitor_add_host(monitor, hosts[i])) {
+            val = NV_FALSE;
+            goto done;
+        }
+    }
+
+    nv_framelock_monitor_wait(monitor, FRAMELOCK_STATUS_CONNECT_TIMEOUT_MS);
+
+    if (op->output_format == OUTPUT_FORMAT_CSV) {
+        printf("time,host,state,board,sync_ready,house_sync,house_sync_rate,"
+               "sync_rate,port0,port1,gpu,sync,timing,stereo_sync\n");
+    } else if (op->output_format != OUTPUT_FORMAT_TEXT) {
+        nv_json_output_begin(op);
+    }
+
+    if (op->watch_interval <= 0.0) {
+        framelock_status_print(op, monitor, hosts, num_hosts);
+        fflush(stdout);
+
+        for (i = 0; i < num_hosts; i++) {
+            status = nv_framelock_monitor_get_status(monitor, hosts[i]);
+            if (status->state != FRAMELOCK_HOST_CONNECTED) {
+                nv_error_msg("Unable to query the frame lock status of "
+                             "'%s'.", hosts[i]);
+                val = NV_FALSE;
+            }
+            nv_framelock_monitor_release_status(monitor, status);
+        }
+    } else {
+        nv_watch_timer_start(&timer, interval);
+
+        do {
+            framelock_status_print(op, monitor, hosts, num_hosts);
+            fflush(stdout);
+        } while (nv_watch_timer_wait(&timer));
+
+        nv_watch_timer_stop(&timer);
+    }
+
+    if (op->output_format == OUTPUT_FORMAT_JSON ||
+        op->output_format == OUTPUT_FORMAT_NDJSON) {
+        nv_json_output_end(op);
+    }
+
+ done:
+    nv_framelock_monitor_free(monitor);
+
+    for (i = 0; i < num_hosts; i++) {
+        nvfree(hosts[i]);
+    }
+    nvfree(hosts);
+
+    return val;
+
+} /* nv_print_framelock_status() */
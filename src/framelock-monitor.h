@@ -0,0 +1,124 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * framelock-monitor.h - prototypes for the frame lock monitor, which
+ * samples the frame lock status of several X servers in the background
+ * (--framelock-status, and the remote X servers of the frame lock page).
+ */
+
+#ifndef __FRAMELOCK_MONITOR_H__
+#define __FRAMELOCK_MONITOR_H__
+
+#include <time.h>
+
+#include "NvCtrlAttributes.h"
+#include "command-line.h"
+
+/*
+ * Dynamic status attributes of a frame lock board and of the GPUs tied
+ * to it; these index the arrays filled in by
+ * nv_framelock_query_board_status() and nv_framelock_query_gpu_status().
+ */
+
+enum {
+    FRAMELOCK_STATUS_SYNC_DELAY = 0,
+    FRAMELOCK_STATUS_HOUSE,
+    FRAMELOCK_STATUS_PORT0,
+    FRAMELOCK_STATUS_PORT1,
+    FRAMELOCK_STATUS_SYNC_READY,
+    FRAMELOCK_STATUS_SYNC_RATE_4,
+    FRAMELOCK_STATUS_SYNC_RATE,
+    FRAMELOCK_STATUS_HOUSE_SYNC_RATE,
+    FRAMELOCK_STATUS_ETHERNET,
+    FRAMELOCK_STATUS_COUNT
+};
+
+enum {
+    GPU_STATUS_SYNC = 0,
+    GPU_STATUS_TIMING,
+    GPU_STATUS_STEREO_SYNC,
+    GPU_STATUS_COUNT
+};
+
+void nv_framelock_query_board_status(const CtrlTarget *board,
+                                     CtrlAttributeQuery *status);
+void nv_framelock_query_gpu_status(const CtrlTarget *gpu,
+                                   CtrlAttributeQuery *status);
+
+
+/*
+ * The status of one X server, as last sampled by its monitor thread.
+ * Published statuses are never modified; they are reference counted so
+ * that readers can keep using one while a newer one is published.
+ */
+
+typedef enum {
+    FRAMELOCK_HOST_CONNECTING = 0, /* not sampled yet */
+    FRAMELOCK_HOST_CONNECTED,
+    FRAMELOCK_HOST_UNREACHABLE,
+} FrameLockHostState;
+
+typedef struct {
+    int id; /* GPU target id */
+    CtrlAttributeQuery status[GPU_STATUS_COUNT];
+} FrameLockGpuStatus;
+
+typedef struct {
+    int id; /* frame lock target id */
+    CtrlAttributeQuery status[FRAMELOCK_STATUS_COUNT];
+
+    int num_gpus;
+    FrameLockGpuStatus *gpus;
+} FrameLockBoardStatus;
+
+typedef struct {
+    int refs;
+    FrameLockHostState state;
+    unsigned int sample;  /* number of samples taken so far */
+    struct timespec when; /* wall clock time of the sample */
+
+    int num_boards;
+    FrameLockBoardStatus *boards;
+} FrameLockHostStatus;
+
+typedef struct _FrameLockMonitor FrameLockMonitor;
+
+FrameLockMonitor *nv_framelock_monitor_new(int interval_ms);
+void nv_framelock_monitor_free(FrameLockMonitor *monitor);
+
+int nv_framelock_monitor_add_host(FrameLockMonitor *monitor,
+                                  const char *display);
+void nv_framelock_monitor_remove_host(FrameLockMonitor *monitor,
+                                      const char *display);
+int nv_framelock_monitor_wait(FrameLockMonitor *monitor, int timeout_ms);
+
+FrameLockHostStatus *nv_framelock_monitor_get_status(FrameLockMonitor *monitor,
+                                                     const char *display);
+void nv_framelock_monitor_release_status(FrameLockMonitor *monitor,
+                                         FrameLockHostStatus *status);
+
+const FrameLockBoardStatus *
+nv_framelock_find_board_status(const FrameLockHostStatus *status, int id);
+const FrameLockGpuStatus *
+nv_framelock_find_gpu_status(const FrameLockHostStatus *status, int id);
+
+int nv_print_framelock_status(const Options *op);
+
+#endif /* __FRAMELOCK_MONITOR_H__ */
@@ -3874,35 +3874,6 @@ static char *get_default_keys_file(const char *driver_version)
     }
 }
 
-#define SEARCH_PATH_NUM_FILES 4
-
-static char **get_default_search_path(size_t *num_files)
-{
-    size_t i = 0;
-    char **filenames = malloc(SEARCH_PATH_NUM_FILES * sizeof(char *));
-    const char *homeStr = getenv("HOME");
-
-    if (homeStr) {
-        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc", NULL);
-        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc.d", NULL);
-    }
-    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc");
-    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc.d");
-
-    *num_files = i;
-    assert(i <= SEARCH_PATH_NUM_FILES);
-
-    return filenames;
-}
-
-static void free_search_path(char **search_path, size_t search_path_size)
-{
-    while (search_path_size--) {
-        free(search_path[search_path_size]);
-    }
-    free(search_path);
-}
-
 static void app_profile_load_global_settings(CtkAppProfile *ctk_app_profile,
                                              AppProfileConfig *config)
 {
@@ -3928,13 +3899,13 @@ static void app_profile_reload(CtkAppProfile *ctk_app_profile)
     nv_app_profile_config_free(ctk_app_profile->cur_config);
     nv_app_profile_config_free(ctk_app_profile->gold_config);
 
-    search_path = get_default_search_path(&search_path_size);
+    search_path = nv_app_profile_config_get_default_search_path(&search_path_size);
     global_config_file = get_default_global_config_file();
     ctk_app_profile->gold_config = nv_app_profile_config_load(global_config_file,
                                                               search_path,
                                                               search_path_size);
     ctk_app_profile->cur_config = nv_app_profile_config_dup(ctk_app_profile->gold_config);
-    free_search_path(search_path, search_path_size);
+    nv_app_profile_config_free_search_path(search_path, search_path_size);
     free(global_config_file);
 
     ctk_apc_profile_model_attach(ctk_app_profile->apc_profile_model, ctk_app_profile->cur_config);
@@ -4631,13 +4602,13 @@ GtkWidget* ctk_app_profile_new(CtrlTarget *ctrl_target,
 
     /* Load app profile settings */
     // TODO only load this if the page is exposed
-    search_path = get_default_search_path(&search_path_size);
+    search_path = nv_app_profile_config_get_default_search_path(&search_path_size);
     global_config_file = get_default_global_config_file();
     ctk_app_profile->gold_config = nv_app_profile_config_load(global_config_file,
                                                               search_path,
                                                               search_path_size);
     ctk_app_profile->cur_config = nv_app_profile_config_dup(ctk_app_profile->gold_config);
-    free_search_path(search_path, search_path_size);
+    nv_app_profile_config_free_search_path(search_path, search_path_size);
     free(global_config_file);
 
     ctk_app_profile->apc_profile_model = ctk_apc_profile_model_new(ctk_app_profile->cur_config);
@@ -23,7 +23,6 @@
 #include <errno.h>
 
 #include <fcntl.h>
-#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <pwd.h>
@@ -4058,19 +4057,54 @@ static void update_banner(XConfigPtr config)
 
 
 
+/** copy_xconfig_file() **********************************************
+ *
+ * Copies the contents and permissions of the file src to the file dst.
+ * Returns TRUE on success.
+ *
+ **/
+
+static gboolean copy_xconfig_file(const char *src, const char *dst)
+{
+    gchar *contents = NULL;
+    gsize len;
+    struct stat st;
+    gboolean ret = FALSE;
+
+    if (stat(src, &st) != 0 ||
+        !g_file_get_contents(src, &contents, &len, NULL)) {
+        goto done;
+    }
+
+    if (!g_file_set_contents(dst, contents, len, NULL)) {
+        goto done;
+    }
+
+    ret = (chmod(dst, st.st_mode & 07777) == 0);
+
+ done:
+    g_free(contents);
+    return ret;
+
+} /* copy_xconfig_file() */
+
+
+
 /** save_xconfig_file() **********************************************
  *
  * Saves the X config file text from buf into a file called
  * filename.  If filename already exists, a backup file named
- * 'filename.backup' is created.
+ * 'filename.backup' is created.  The new contents are written to a
+ * temporary file that then replaces filename, so an interrupted save
+ * never leaves a truncated X config file behind.
  *
  **/
 
 static int save_xconfig_file(SaveXConfDlg *dlg,
                              gchar *filename, char *buf, mode_t mode)
 {
+    char *resolved_filename = NULL;
     gchar *backup_filename = NULL;
-    FILE *fp = NULL;
     gchar *err_msg = NULL;
     struct stat st;
 
@@ -4116,8 +4150,19 @@ static int save_xconfig_file(SaveXConfDlg *dlg,
             }
         }
 
-        /* Make the current x config file the backup */
-        if (rename(filename, backup_filename)) {
+        /*
+         * Make the current x config file the backup.  The file is
+         * replaced through any symbolic link, so back up the file the
+         * link points to rather than the link itself.  Linking keeps the
+         * current file in place until the new one replaces it; fall back
+         * to copying it on file systems without hard links, or if the
+         * link points to a different file system.
+         */
+        resolved_filename = realpath(filename, NULL);
+
+        if (!resolved_filename ||
+            (link(resolved_filename, backup_filename) &&
+             !copy_xconfig_file(resolved_filename, backup_filename))) {
                 err_msg =
                     g_strdup_printf("Unable to create new X config backup "
                                     "file '%s'.",
@@ -4127,14 +4172,12 @@ static int save_xconfig_file(SaveXConfDlg *dlg,
     }
 
     /* Write out the X config file */
-    fp = fopen(filename, "w");
-    if (!fp) {
+    if (!xconfigWriteBufferToFile(filename, buf, strlen(buf))) {
         err_msg =
-            g_strdup_printf("Unable to open X config file '%s' for writing.",
+            g_strdup_printf("Unable to write X config file '%s'.",
                             filename);
         goto done;
     }
-    fprintf(fp, "%s", buf);
 
     ret = 1;
 
@@ -4146,7 +4189,7 @@ static int save_xconfig_file(SaveXConfDlg *dlg,
         g_free(err_msg);
     }
 
-    if (fp) fclose(fp);
+    free(resolved_filename);
     g_free(backup_filename);
     return ret;
 
@@ -4201,10 +4244,8 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
     XConfigPtr xconfGen = NULL;
     XConfigError xconfErr;
 
-    char *tmp_filename = NULL;
-    int tmp_fd;
-    struct stat st;
-    void *buf;
+    char *buf;
+    size_t len;
     GtkTextIter buf_start, buf_end;
 
     gboolean merge;
@@ -4232,6 +4273,7 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
     if (filename && (stat(filename, &st) == 0)) {
         const char *non_regular_file_type_description =
             get_non_regular_file_type_description(st.st_mode);
+        XConfigScannerPtr scanner;
         const char *test_filename;
 
         /* Make sure this is a regular file */
@@ -4248,16 +4290,17 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
         }
 
         /* Must be able to open the file */
-        test_filename = xconfigOpenConfigFile(filename, NULL);
+        scanner = xconfigOpenConfigScanner(filename, NULL);
+        test_filename = xconfigGetScannerFileName(scanner);
         if (!test_filename || strcmp(test_filename, filename)) {
-            xconfigCloseConfigFile();
+            xconfigCloseConfigScanner(scanner);
 
         } else {
             GenerateOptions gop;
 
             /* Must be able to parse the file as an X config file */
-            xconfErr = xconfigReadConfigFile(&xconfCur);
-            xconfigCloseConfigFile();
+            xconfErr = xconfigReadConfigScanner(scanner, &xconfCur);
+            xconfigCloseConfigScanner(scanner);
             if ((xconfErr != XCONFIG_RETURN_SUCCESS) || !xconfCur) {
                 /* If we failed to parse the config file, we should not
                  * allow a merge.
@@ -4350,35 +4393,12 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
     update_banner(xconfGen);
 
 
-    /* Setup the X config file preview buffer by writing to a temp file */
-    tmp_filename = g_strdup_printf("/tmp/.xconfig.tmp.XXXXXX");
-    tmp_fd = mkstemp(tmp_filename);
-    if (!tmp_fd) {
-        err_msg = g_strdup_printf("Failed to create temp X config file '%s' "
-                                  "for preview.",
-                                  tmp_filename);
-        goto fail;
-    }
-    xconfigWriteConfigFile(tmp_filename, xconfGen);
+    /* Setup the X config file preview buffer */
+    buf = xconfigWriteConfigBuffer(xconfGen, &len);
     xconfigFreeConfig(&xconfGen);
-
-    if (lseek(tmp_fd, 0, SEEK_SET) == (off_t)-1) {
-        err_msg = g_strdup_printf("Failed lseek() on temp X config file '%s' "
-                                  "for preview.",
-                                  tmp_filename);
-        goto fail;
-    }
-    if (fstat(tmp_fd, &st) == -1) {
-        err_msg = g_strdup_printf("Failed fstat() on temp X config file '%s' "
-                                  "for preview.",
-                                  tmp_filename);
-        goto fail;
-    }
-    buf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, tmp_fd, 0);
-    if (buf == MAP_FAILED) {
-        err_msg = g_strdup_printf("Failed mmap() on temp X config file '%s' "
-                                  "for preview.",
-                                  tmp_filename);
+    if (!buf) {
+        err_msg = g_strdup_printf("Failed to generate the X config file "
+                                  "for preview.");
         goto fail;
     }
 
@@ -4392,11 +4412,8 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
 
     /* Set the new GTK buffer contents */
     gtk_text_buffer_set_text(GTK_TEXT_BUFFER(dlg->buf_xconfig_save),
-                             buf, st.st_size);
-    munmap(buf, st.st_size);
-    close(tmp_fd);
-    remove(tmp_filename);
-    g_free(tmp_filename);
+                             buf, len);
+    free(buf);
 
     return;
 
@@ -4424,8 +4441,6 @@ static void update_xconfig_save_buffer(SaveXConfDlg *dlg)
         xconfigFreeConfig(&xconfCur);
     }
 
-    g_free(tmp_filename);
-
     return;
 
 } /* update_xconfig_save_buffer() */
@@ -44,6 +44,7 @@
 
 #define LAYOUT_IMG_OFFSET           2 /* Border + White trimming */
 #define LAYOUT_IMG_BORDER_PADDING   8
+#define LAYOUT_DAMAGE_PADDING       3 /* Border and selection lines */
 
 #define LAYOUT_IMG_FG_COLOR         "black"
 #define LAYOUT_IMG_BG_COLOR         "#AAAAAA"
@@ -178,6 +179,8 @@ static void calc_metamode(nvScreenPtr screen, nvMetaModePtr metamode);
 
 static Bool sync_layout(CtkDisplayLayout *ctk_object);
 
+static void update_zorder_areas(CtkDisplayLayout *ctk_object);
+
 
 
 
@@ -198,6 +201,14 @@ static void queue_layout_redraw(CtkDisplayLayout *ctk_object)
     GtkAllocation allocation;
     GdkRectangle rect;
 
+    /* Whatever changed may have moved or reordered the items under the
+     * mouse.
+     */
+    ctk_object->hit_index.valid = FALSE;
+
+    /* Later damage is relative to what is drawn now */
+    update_zorder_areas(ctk_object);
+
     if (!window) {
         return;
     }
@@ -216,6 +227,37 @@ static void queue_layout_redraw(CtkDisplayLayout *ctk_object)
 
 
 
+/** layout_text_free() ***********************************************
+ *
+ * Frees cached label text.
+ *
+ **/
+
+static void layout_text_free(LayoutText *text)
+{
+    if (!text) {
+        return;
+    }
+
+    g_free(text->str_1);
+    g_free(text->str_2);
+
+    if (text->layout_1) {
+        g_object_unref(text->layout_1);
+    }
+    if (text->layout_2) {
+        g_object_unref(text->layout_2);
+    }
+    if (text->layout_12) {
+        g_object_unref(text->layout_12);
+    }
+
+    free(text);
+
+} /* layout_text_free() */
+
+
+
 /** zorder_layout() **************************************************
  *
  * In order to draw and allow selecting display devices, we need to
@@ -236,11 +278,18 @@ static void zorder_layout(CtkDisplayLayout *ctk_object)
 
     /* Clean up */
     if (ctk_object->Zorder) {
+        for (z = 0; z < ctk_object->Zcount; z++) {
+            layout_text_free(ctk_object->Zorder[z].text);
+        }
         free(ctk_object->Zorder);
         ctk_object->Zorder = NULL;
     }
     ctk_object->Zcount = 0;
 
+    ctk_object->snap_index.valid = FALSE;
+    ctk_object->hit_index.valid = FALSE;
+    ctk_object->resolve_order.valid = FALSE;
+
 
     /* Count the number of Z-orderable elements in the layout */
     ctk_object->Zcount = layout->num_screens;
@@ -528,6 +577,9 @@ static Bool get_modify_info(CtkDisplayLayout *ctk_object)
     if (info->modify_dirty) {
         info->modify_dim = info->orig_dim;
         info->modify_dirty = 0;
+
+        /* Look up what may be snapped to anew */
+        ctk_object->snap_index.valid = FALSE;
     }
 
     return TRUE;
@@ -597,6 +649,343 @@ static int point_in_screen(nvScreenPtr screen, int x, int y)
     return point_in_rect(&screen_rect, x, y);
 }
 
+static int point_in_zorder_node(const ZNode *node, int x, int y)
+{
+    switch (node->type) {
+    case ZNODE_TYPE_DISPLAY:
+        return point_in_display(node->u.display, x, y);
+    case ZNODE_TYPE_SCREEN:
+        return point_in_screen(node->u.screen, x, y);
+    case ZNODE_TYPE_PRIME:
+        return point_in_rect(&(node->u.prime_display->rect), x, y);
+    }
+
+    return 0;
+}
+
+
+
+/** get_zorder_node_rect() ******************************************
+ *
+ * Gets the rectangle in which the given Z-order item can be clicked.
+ * Returns FALSE if the item cannot be clicked.
+ *
+ **/
+
+static Bool get_zorder_node_rect(const ZNode *node, GdkRectangle *rect)
+{
+    switch (node->type) {
+    case ZNODE_TYPE_DISPLAY:
+        if (!node->u.display || !node->u.display->cur_mode) {
+            return FALSE;
+        }
+        *rect = node->u.display->cur_mode->pan;
+        return TRUE;
+
+    case ZNODE_TYPE_SCREEN:
+        if (!node->u.screen) {
+            return FALSE;
+        }
+        get_screen_rect_with_prime(node->u.screen, 1, rect);
+        return TRUE;
+
+    case ZNODE_TYPE_PRIME:
+        *rect = node->u.prime_display->rect;
+        return TRUE;
+    }
+
+    return FALSE;
+
+} /* get_zorder_node_rect() */
+
+
+
+/** get_hit_index_span() ********************************************
+ *
+ * Gets the range of hit index cells that the given rectangle overlaps.
+ *
+ **/
+
+static void get_hit_index_span(const HitIndex *index, const GdkRectangle *rect,
+                               int *first_col, int *last_col,
+                               int *first_row, int *last_row)
+{
+    *first_col = (rect->x - index->dim.x) / index->cell_width;
+    *last_col = (rect->x + rect->width - index->dim.x) / index->cell_width;
+    *last_col = NV_MIN(*last_col, index->cols - 1);
+
+    *first_row = (rect->y - index->dim.y) / index->cell_height;
+    *last_row = (rect->y + rect->height - index->dim.y) / index->cell_height;
+    *last_row = NV_MIN(*last_row, index->rows - 1);
+
+} /* get_hit_index_span() */
+
+
+
+/** hit_index_build() ***********************************************
+ *
+ * Builds the grid of Z-order items by location.  The grid has about as
+ * many cells as there are items, and each cell lists the items that
+ * overlap it in Z-order.
+ *
+ **/
+
+static void hit_index_build(CtkDisplayLayout *ctk_object)
+{
+    HitIndex *index = &(ctk_object->hit_index);
+    GdkRectangle rect;
+    int num_cells;
+    int col, row, first_col, last_col, first_row, last_row;
+    int *fill;
+    int i, init = 1;
+
+
+    free(index->cells);
+    free(index->nodes);
+    memset(index, 0, sizeof(*index));
+
+    /* Find the area covered by the items */
+    for (i = 0; i < ctk_object->Zcount; i++) {
+        if (!get_zorder_node_rect(&(ctk_object->Zorder[i]), &rect)) continue;
+        if (init) {
+            index->dim = rect;
+            init = 0;
+        } else {
+            gdk_rectangle_union(&(index->dim), &rect, &(index->dim));
+        }
+    }
+
+    index->cols = 1;
+    while (index->cols * index->cols < ctk_object->Zcount) {
+        index->cols++;
+    }
+    index->rows = index->cols;
+    index->cell_width = NV_MAX(1, (index->dim.width + index->cols - 1) /
+                               index->cols);
+    index->cell_height = NV_MAX(1, (index->dim.height + index->rows - 1) /
+                                index->rows);
+
+    num_cells = index->cols * index->rows;
+    index->cells = calloc(num_cells + 1, sizeof(int));
+    fill = calloc(num_cells, sizeof(int));
+    if (!index->cells || !fill) {
+        goto fail;
+    }
+
+    /* Count the items overlapping each cell, then list them, in Z-order */
+    for (i = 0; i < ctk_object->Zcount; i++) {
+        if (!get_zorder_node_rect(&(ctk_object->Zorder[i]), &rect)) continue;
+
+        get_hit_index_span(index, &rect, &first_col, &last_col,
+                           &first_row, &last_row);
+
+        for (row = first_row; row <= last_row; row++) {
+            for (col = first_col; col <= last_col; col++) {
+                index->cells[row * index->cols + col + 1]++;
+            }
+        }
+    }
+
+    for (i = 0; i < num_cells; i++) {
+        index->cells[i + 1] += index->cells[i];
+        fill[i] = index->cells[i];
+    }
+
+    index->nodes = calloc(NV_MAX(1, index->cells[num_cells]), sizeof(int));
+    if (!index->nodes) {
+        goto fail;
+    }
+
+    for (i = 0; i < ctk_object->Zcount; i++) {
+        if (!get_zorder_node_rect(&(ctk_object->Zorder[i]), &rect)) continue;
+
+        get_hit_index_span(index, &rect, &first_col, &last_col,
+                           &first_row, &last_row);
+
+        for (row = first_row; row <= last_row; row++) {
+            for (col = first_col; col <= last_col; col++) {
+                index->nodes[fill[row * index->cols + col]++] = i;
+            }
+        }
+    }
+
+    free(fill);
+    index->valid = TRUE;
+    return;
+
+ fail:
+    free(fill);
+    free(index->cells);
+    free(index->nodes);
+    memset(index, 0, sizeof(*index));
+
+} /* hit_index_build() */
+
+
+
+/** get_zorder_node_at() ********************************************
+ *
+ * Returns the Z-order index of the top-most display, X screen or PRIME
+ * display under the point (x, y), or -1 if there is none.  Only the
+ * items that overlap the point's cell of the hit index are tested.
+ *
+ **/
+
+static int get_zorder_node_at(CtkDisplayLayout *ctk_object, int x, int y)
+{
+    HitIndex *index = &(ctk_object->hit_index);
+    int col, row, cell;
+    int i;
+
+
+    if (!index->valid) {
+        hit_index_build(ctk_object);
+        if (!index->valid) {
+            return -1;
+        }
+    }
+
+    if (x < index->dim.x || x >= index->dim.x + index->dim.width ||
+        y < index->dim.y || y >= index->dim.y + index->dim.height) {
+        return -1;
+    }
+
+    col = NV_MIN((x - index->dim.x) / index->cell_width, index->cols - 1);
+    row = NV_MIN((y - index->dim.y) / index->cell_height, index->rows - 1);
+    cell = row * index->cols + col;
+
+    for (i = index->cells[cell]; i < index->cells[cell + 1]; i++) {
+        if (point_in_zorder_node(&(ctk_object->Zorder[index->nodes[i]]),
+                                 x, y)) {
+            return index->nodes[i];
+        }
+    }
+
+    return -1;
+
+} /* get_zorder_node_at() */
+
+
+
+/** get_zorder_node_area() ******************************************
+ *
+ * Gets the part of the drawing area that the given Z-order item is
+ * drawn in, including its border and selection hilite.  Returns FALSE
+ * if the item is not drawn.
+ *
+ **/
+
+static Bool get_zorder_node_area(CtkDisplayLayout *ctk_object,
+                                 const ZNode *node, GdkRectangle *area)
+{
+    GdkRectangle rect;
+    int x2, y2;
+
+
+    if (!get_zorder_node_rect(node, &rect)) {
+        return FALSE;
+    }
+
+    /* Displays are drawn as both their panning domain and ViewPortIn */
+    if (node->type == ZNODE_TYPE_DISPLAY) {
+        GdkRectangle vpi;
+        get_viewportin_rect(node->u.display->cur_mode, &vpi);
+        gdk_rectangle_union(&rect, &vpi, &rect);
+    }
+
+    area->x = ctk_object->img_dim.x + (int)(ctk_object->scale * rect.x);
+    area->y = ctk_object->img_dim.y + (int)(ctk_object->scale * rect.y);
+    x2 = ctk_object->img_dim.x +
+        (int)(ctk_object->scale * (rect.x + rect.width)) + 1;
+    y2 = ctk_object->img_dim.y +
+        (int)(ctk_object->scale * (rect.y + rect.height)) + 1;
+
+    area->x -= LAYOUT_DAMAGE_PADDING;
+    area->y -= LAYOUT_DAMAGE_PADDING;
+    area->width = x2 + LAYOUT_DAMAGE_PADDING - area->x;
+    area->height = y2 + LAYOUT_DAMAGE_PADDING - area->y;
+
+    return TRUE;
+
+} /* get_zorder_node_area() */
+
+
+
+/** update_zorder_areas() *******************************************
+ *
+ * Records where each item of the Z-order is drawn, as a reference for
+ * later calls to queue_layout_damage().
+ *
+ **/
+
+static void update_zorder_areas(CtkDisplayLayout *ctk_object)
+{
+    ZNode *node;
+    int i;
+
+    for (i = 0; i < ctk_object->Zcount; i++) {
+        node = &(ctk_object->Zorder[i]);
+        if (!get_zorder_node_area(ctk_object, node, &(node->area))) {
+            memset(&(node->area), 0, sizeof(node->area));
+        }
+    }
+
+} /* update_zorder_areas() */
+
+
+
+/** queue_layout_damage() *******************************************
+ *
+ * Queues a redraw of only the parts of the layout image that changed
+ * since the last redraw was queued: the old and new areas of each item
+ * that was moved or resized.  This is used while the user drags items
+ * around; anything else that changes the layout (or the Z-order)
+ * should use queue_layout_redraw().
+ *
+ **/
+
+static void queue_layout_damage(CtkDisplayLayout *ctk_object)
+{
+    GdkWindow *window = ctk_widget_get_window(ctk_object->drawing_area);
+    GdkRectangle *overlay = &(ctk_object->frame_stats.area);
+    GdkRectangle area;
+    ZNode *node;
+    int i;
+
+
+    ctk_object->hit_index.valid = FALSE;
+
+    for (i = 0; i < ctk_object->Zcount; i++) {
+        node = &(ctk_object->Zorder[i]);
+
+        if (!get_zorder_node_area(ctk_object, node, &area)) {
+            memset(&area, 0, sizeof(area));
+        }
+
+        if (area.x == node->area.x &&
+            area.y == node->area.y &&
+            area.width == node->area.width &&
+            area.height == node->area.height) {
+            continue;
+        }
+
+        if (window && node->area.width > 0 && node->area.height > 0) {
+            gdk_window_invalidate_rect(window, &(node->area), TRUE);
+        }
+        if (window && area.width > 0 && area.height > 0) {
+            gdk_window_invalidate_rect(window, &area, TRUE);
+        }
+
+        node->area = area;
+    }
+
+    /* Keep the frame times up to date */
+    if (window && overlay->width > 0 && overlay->height > 0) {
+        gdk_window_invalidate_rect(window, overlay, TRUE);
+    }
+
+} /* queue_layout_damage() */
+
 
 
 /** get_point_relative_position() ************************************
@@ -744,64 +1133,41 @@ static void offset_layout(nvLayoutPtr layout, int x, int y)
 
 
 
-/** resolve_display() ************************************************
+/** place_relative() *************************************************
  *
- * Figures out where the current mode of the given display should be
- * placed in relation to the layout.
- *
- * XXX This function assumes there are no relationship loops
+ * Sets the position of 'rect' (keeping its size) such that it is
+ * placed as given by 'position_type' relative to 'relative_pos'.
+ * Returns 0 if 'position_type' is not a relative position.
  *
  **/
 
-static int resolve_display(nvDisplayPtr display, int mode_idx,
-                           GdkRectangle *pos)
+static int place_relative(int position_type, const GdkRectangle *relative_pos,
+                          GdkRectangle *rect)
 {
-    nvModePtr mode = get_mode(display, mode_idx);
-    GdkRectangle relative_pos;
-
-    if (!mode) return 0;
-
-
-    /* Set the dimensions */
-    pos->width  = mode->pan.width;
-    pos->height = mode->pan.height;
-
-
-    /* Find the position */
-    switch (mode->position_type) {
-    case CONF_ADJ_ABSOLUTE:
-        pos->x = mode->pan.x;
-        pos->y = mode->pan.y;
-        break;
-
+    switch (position_type) {
     case CONF_ADJ_RIGHTOF:
-        resolve_display(mode->relative_to, mode_idx, &relative_pos);
-        pos->x = relative_pos.x + relative_pos.width;
-        pos->y = relative_pos.y;
+        rect->x = relative_pos->x + relative_pos->width;
+        rect->y = relative_pos->y;
         break;
 
     case CONF_ADJ_LEFTOF:
-        resolve_display(mode->relative_to, mode_idx, &relative_pos);
-        pos->x = relative_pos.x - pos->width;
-        pos->y = relative_pos.y;
+        rect->x = relative_pos->x - rect->width;
+        rect->y = relative_pos->y;
         break;
 
     case CONF_ADJ_BELOW:
-        resolve_display(mode->relative_to, mode_idx, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y + relative_pos.height;
+        rect->x = relative_pos->x;
+        rect->y = relative_pos->y + relative_pos->height;
         break;
 
     case CONF_ADJ_ABOVE:
-        resolve_display(mode->relative_to, mode_idx, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y - pos->height;
+        rect->x = relative_pos->x;
+        rect->y = relative_pos->y - rect->height;
         break;
 
     case CONF_ADJ_RELATIVE: /* Inside */
-        resolve_display(mode->relative_to, mode_idx, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y;
+        rect->x = relative_pos->x;
+        rect->y = relative_pos->y;
         break;
 
     default:
@@ -810,7 +1176,121 @@ static int resolve_display(nvDisplayPtr display, int mode_idx,
 
     return 1;
 
-} /* resolve_display() */
+} /* place_relative() */
+
+
+
+/** order_relative_positions() ***************************************
+ *
+ * Orders 'num' items, each of which may be positioned relative to one
+ * other item (parent[i] is its index, or -1), such that every item comes
+ * after the item it is positioned relative to.  The order is stored in
+ * 'order'.
+ *
+ * Loops of relative positions are broken by treating the items in the
+ * loop as absolutely positioned: their parent is set to -1 and they are
+ * flagged in 'in_loop'.
+ *
+ * Returns FALSE if memory could not be allocated.
+ *
+ **/
+
+static Bool order_relative_positions(int num, int *parent, Bool *in_loop,
+                                     int *order)
+{
+    int *state; /* 0: not visited, 1: on the current path, 2: done */
+    int *path;
+    int i, j, k, next;
+    int num_ordered = 0;
+    int len;
+
+
+    if (num <= 0) {
+        return TRUE;
+    }
+
+    state = calloc(num, sizeof(int));
+    path = calloc(num, sizeof(int));
+    if (!state || !path) {
+        free(state);
+        free(path);
+        return FALSE;
+    }
+
+    /* Follow each item's chain of relative positions until reaching an
+     * item that is done, or one that is on the chain itself (a loop).
+     */
+    for (i = 0; i < num; i++) {
+        for (j = i; j >= 0 && state[j] == 0; j = parent[j]) {
+            state[j] = 1;
+        }
+
+        if (j >= 0 && state[j] == 1) {
+            k = j;
+            do {
+                next = parent[k];
+                parent[k] = -1;
+                in_loop[k] = TRUE;
+                state[k] = 2;
+                k = next;
+            } while (k != j);
+        }
+
+        for (j = i; j >= 0 && state[j] == 1; j = parent[j]) {
+            state[j] = 2;
+        }
+    }
+
+    /* Order each item after the items it is (indirectly) relative to */
+    memset(state, 0, num * sizeof(int));
+
+    for (i = 0; i < num; i++) {
+        len = 0;
+        for (j = i; j >= 0 && !state[j]; j = parent[j]) {
+            path[len++] = j;
+        }
+        while (len > 0) {
+            j = path[--len];
+            state[j] = 1;
+            order[num_ordered++] = j;
+        }
+    }
+
+    free(state);
+    free(path);
+
+    return TRUE;
+
+} /* order_relative_positions() */
+
+
+
+/** resolve_mode() ***************************************************
+ *
+ * Places the given mode of the display where its relative position
+ * says it should be, based on the current position of the display it
+ * is relative to.
+ *
+ **/
+
+static void resolve_mode(nvDisplayPtr display, int mode_idx)
+{
+    nvModePtr mode = get_mode(display, mode_idx);
+    nvModePtr relative_mode;
+
+    if (!mode || mode->position_type == CONF_ADJ_ABSOLUTE ||
+        !mode->relative_to) {
+        return;
+    }
+
+    relative_mode = get_mode(mode->relative_to, mode_idx);
+    if (!relative_mode) {
+        return;
+    }
+
+    place_relative(mode->position_type, &(relative_mode->pan), &(mode->pan));
+
+} /* resolve_mode() */
 
 
 
@@ -825,10 +1305,16 @@ static void resolve_displays_in_screen(nvScreenPtr screen,
                                        int resolve_all_modes)
 {
     nvDisplayPtr display;
-    GdkRectangle rect;
+    nvDisplayPtr *displays = NULL;
+    nvModePtr mode;
+    int *parent = NULL;
+    int *order = NULL;
+    Bool *in_loop = NULL;
+    int num_displays = 0;
     int first_idx;
     int last_idx;
     int mode_idx;
+    int i, j;
 
     if (resolve_all_modes) {
         first_idx = 0;
@@ -838,147 +1324,463 @@ static void resolve_displays_in_screen(nvScreenPtr screen,
         last_idx = first_idx;
     }
 
-    /* Resolve the current mode of each display in the screen */
     for (display = screen->displays;
          display;
          display = display->next_in_screen) {
+        num_displays++;
+    }
 
-        for (mode_idx = first_idx; mode_idx <= last_idx; mode_idx++) {
-            if (resolve_display(display, mode_idx, &rect)) {
-                nvModePtr mode = get_mode(display, mode_idx);
-                mode->pan.x = rect.x;
-                mode->pan.y = rect.y;
-            }
+    if (num_displays) {
+        displays = calloc(num_displays, sizeof(nvDisplayPtr));
+        parent = calloc(num_displays, sizeof(int));
+        order = calloc(num_displays, sizeof(int));
+        in_loop = calloc(num_displays, sizeof(Bool));
+        if (!displays || !parent || !order || !in_loop) {
+            goto done;
         }
     }
 
-    /* Get the new position of the metamode(s) */
-    for (mode_idx = first_idx; mode_idx <= last_idx; mode_idx++) {
-        calc_metamode(screen, get_metamode(screen, mode_idx));
+    for (display = screen->displays, i = 0;
+         display;
+         display = display->next_in_screen, i++) {
+        displays[i] = display;
     }
 
-} /* resolve_displays_in_screen() */
+    /* Resolve the mode(s) of each display in the screen, after the mode
+     * of the display it is relative to.
+     */
+    for (mode_idx = first_idx; mode_idx <= last_idx; mode_idx++) {
+
+        for (i = 0; i < num_displays; i++) {
+            mode = get_mode(displays[i], mode_idx);
+
+            parent[i] = -1;
+            in_loop[i] = FALSE;
+            if (!mode || mode->position_type == CONF_ADJ_ABSOLUTE) {
+                continue;
+            }
+            for (j = 0; j < num_displays; j++) {
+                if (displays[j] == mode->relative_to) {
+                    parent[i] = j;
+                    break;
+                }
+            }
+        }
+
+        if (!order_relative_positions(num_displays, parent, in_loop,
+                                      order)) {
+            goto done;
+        }
+
+        for (i = 0; i < num_displays; i++) {
+            if (!in_loop[order[i]]) {
+                resolve_mode(displays[order[i]], mode_idx);
+            }
+        }
+    }
+
+    /* Get the new position of the metamode(s) */
+    for (mode_idx = first_idx; mode_idx <= last_idx; mode_idx++) {
+        calc_metamode(screen, get_metamode(screen, mode_idx));
+    }
+
+ done:
+    free(displays);
+    free(parent);
+    free(order);
+    free(in_loop);
+
+} /* resolve_displays_in_screen() */
 
 
 
 /** resolve_screen() *************************************************
  *
- * Figures out where the current metamode of the given screen should be
- * placed in relation to the layout.
- *
- * XXX This function assumes there are no relationship loops
+ * Moves the given screen (and its displays) to where its relative
+ * position says it should be, based on the current position of the
+ * screen it is relative to.
  *
  **/
 
-static int resolve_screen(nvScreenPtr screen, GdkRectangle *pos)
+static void resolve_screen(nvScreenPtr screen)
 {
     GdkRectangle *screen_rect = get_screen_rect(screen, 0);
-    GdkRectangle relative_pos;
-
-    if (!screen_rect) return 0;
+    GdkRectangle pos;
 
+    if (!screen_rect || screen->position_type == CONF_ADJ_ABSOLUTE ||
+        !screen->relative_to) {
+        return;
+    }
 
-    /* Set the dimensions */
-    pos->width  = screen_rect->width;
-    pos->height = screen_rect->height;
+    pos = *screen_rect;
 
+    if (place_relative(screen->position_type,
+                       get_screen_rect(screen->relative_to, 0), &pos)) {
 
-    /* Find the position */
-    switch (screen->position_type) {
-    case CONF_ADJ_ABSOLUTE:
-        pos->x = screen_rect->x;
-        pos->y = screen_rect->y;
-        break;
+        /* Move the screen and the displays by offsetting */
+        offset_screen(screen, pos.x - screen_rect->x, pos.y - screen_rect->y);
+    }
 
-    case CONF_ADJ_RIGHTOF:
-        resolve_screen(screen->relative_to, &relative_pos);
-        pos->x = relative_pos.x + relative_pos.width;
-        pos->y = relative_pos.y;
-        break;
+} /* resolve_screen() */
 
-    case CONF_ADJ_LEFTOF:
-        resolve_screen(screen->relative_to, &relative_pos);
-        pos->x = relative_pos.x - pos->width;
-        pos->y = relative_pos.y;
-        break;
 
-    case CONF_ADJ_BELOW:
-        resolve_screen(screen->relative_to, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y + relative_pos.height;
-        break;
 
-    case CONF_ADJ_ABOVE:
-        resolve_screen(screen->relative_to, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y - pos->height;
-        break;
+/** get_node_relative_to() *******************************************
+ *
+ * Returns what the given resolve node is currently positioned relative
+ * to, or NULL if it is absolutely positioned.
+ *
+ **/
 
-    case CONF_ADJ_RELATIVE: /* Inside */
-        resolve_screen(screen->relative_to, &relative_pos);
-        pos->x = relative_pos.x;
-        pos->y = relative_pos.y;
-        break;
+static void *get_node_relative_to(const ResolveNode *node)
+{
+    nvModePtr mode;
 
-    default:
-        return 0;
+    if (node->display) {
+        mode = node->display->cur_mode;
+        if (!mode || mode->position_type == CONF_ADJ_ABSOLUTE) {
+            return NULL;
+        }
+        return mode->relative_to;
     }
 
-    return 1;
+    if (node->screen->position_type == CONF_ADJ_ABSOLUTE) {
+        return NULL;
+    }
+    return node->screen->relative_to;
 
-} /* resolve_screen() */
+} /* get_node_relative_to() */
 
 
 
-/* resolve_screen_in_layout() ***************************************
+/** resolve_order_matches_layout() ***********************************
  *
- * Resolves relative screen positions into absolute positions for
- * the currently selected metamode of the screen.
+ * Returns TRUE if the resolve order is still valid for the layout: the
+ * layout has the same X screens and displays, in the same modes, with
+ * the same relative positions as when the order was built.
  *
  **/
 
-static void resolve_screen_in_layout(nvScreenPtr screen)
+static Bool resolve_order_matches_layout(CtkDisplayLayout *ctk_object)
 {
-    GdkRectangle pos;
-    int x, y;
-    GdkRectangle *screen_rect;
+    ResolveOrder *ro = &(ctk_object->resolve_order);
+    nvScreenPtr screen;
+    nvDisplayPtr display;
+    ResolveNode *node;
+    int num_nodes = 0;
+    int i;
 
 
-    /* Resolve the current screen location */
-    if (resolve_screen(screen, &pos)) {
+    if (!ro->valid) {
+        return FALSE;
+    }
 
-        /* Move the screen and the displays by offsetting */
-        screen_rect = get_screen_rect(screen, 0);
+    for (screen = ctk_object->layout->screens;
+         screen;
+         screen = screen->next_in_layout) {
+        num_nodes++;
+        for (display = screen->displays;
+             display;
+             display = display->next_in_screen) {
+            num_nodes++;
+        }
+    }
 
-        x = pos.x - screen_rect->x;
-        y = pos.y - screen_rect->y;
+    if (num_nodes != ro->num_nodes) {
+        return FALSE;
+    }
 
-        offset_screen(screen, x, y);
+    for (i = 0; i < ro->num_nodes; i++) {
+        node = &(ro->nodes[i]);
+
+        if (node->display &&
+            (node->display->screen != node->screen ||
+             node->display->cur_mode != node->mode)) {
+            return FALSE;
+        }
+        if (get_node_relative_to(node) != node->relative_to) {
+            return FALSE;
+        }
     }
 
-} /* resolve_screen_in_layout() */
+    return TRUE;
 
+} /* resolve_order_matches_layout() */
 
 
-/** resolve_layout() *************************************************
+
+/** build_resolve_order() ********************************************
  *
- * Resolves relative positions into absolute positions for the
- * the *current* layout.
+ * Orders the X screens of the layout, and the displays within each X
+ * screen, such that each comes after what it is positioned relative to.
  *
  **/
 
-static void resolve_layout(nvLayoutPtr layout)
+static void build_resolve_order(CtkDisplayLayout *ctk_object)
 {
+    ResolveOrder *ro = &(ctk_object->resolve_order);
+    nvLayoutPtr layout = ctk_object->layout;
     nvScreenPtr screen;
+    nvDisplayPtr display;
+    ResolveNode *node;
+    nvScreenPtr *screens = NULL;
+    nvDisplayPtr *displays = NULL;
+    int *s_parent = NULL, *s_order = NULL, *s_node = NULL;
+    int *d_parent = NULL, *d_order = NULL, *d_node = NULL;
+    Bool *s_loop = NULL, *d_loop = NULL;
+    int num_screens = 0;
+    int num_displays = 0;
+    int nd;
+    int i, j, k, m;
+
+
+    free(ro->nodes);
+    memset(ro, 0, sizeof(*ro));
 
-    /* First, resolve TwinView relationships */
     for (screen = layout->screens; screen; screen = screen->next_in_layout) {
-        resolve_displays_in_screen(screen, 0);
+        num_screens++;
+        for (display = screen->displays;
+             display;
+             display = display->next_in_screen) {
+            num_displays++;
+        }
     }
 
-    /* Next, resolve X screen relationships */
-    for (screen = layout->screens; screen; screen = screen->next_in_layout) {
-        resolve_screen_in_layout(screen);
+    if (!num_screens) {
+        ro->valid = TRUE;
+        return;
+    }
+
+    ro->nodes = calloc(num_screens + num_displays, sizeof(ResolveNode));
+    screens = calloc(num_screens, sizeof(nvScreenPtr));
+    s_parent = calloc(num_screens, sizeof(int));
+    s_order = calloc(num_screens, sizeof(int));
+    s_node = calloc(num_screens, sizeof(int));
+    s_loop = calloc(num_screens, sizeof(Bool));
+    displays = calloc(num_displays + 1, sizeof(nvDisplayPtr));
+    d_parent = calloc(num_displays + 1, sizeof(int));
+    d_order = calloc(num_displays + 1, sizeof(int));
+    d_node = calloc(num_displays + 1, sizeof(int));
+    d_loop = calloc(num_displays + 1, sizeof(Bool));
+    if (!ro->nodes || !screens || !s_parent || !s_order || !s_node ||
+        !s_loop || !displays || !d_parent || !d_order || !d_node ||
+        !d_loop) {
+        goto fail;
+    }
+
+
+    /* Order the X screens */
+    for (screen = layout->screens, i = 0;
+         screen;
+         screen = screen->next_in_layout, i++) {
+        screens[i] = screen;
+    }
+    for (i = 0; i < num_screens; i++) {
+        s_parent[i] = -1;
+        if (screens[i]->position_type == CONF_ADJ_ABSOLUTE) continue;
+        for (j = 0; j < num_screens; j++) {
+            if (screens[j] == screens[i]->relative_to) {
+                s_parent[i] = j;
+                break;
+            }
+        }
+    }
+    if (!order_relative_positions(num_screens, s_parent, s_loop, s_order)) {
+        goto fail;
+    }
+
+
+    /* Add the displays of each X screen in order, then the X screen */
+    for (k = 0; k < num_screens; k++) {
+        i = s_order[k];
+        screen = screens[i];
+
+        nd = 0;
+        for (display = screen->displays;
+             display;
+             display = display->next_in_screen) {
+            displays[nd++] = display;
+        }
+        for (j = 0; j < nd; j++) {
+            nvModePtr mode = displays[j]->cur_mode;
+
+            d_parent[j] = -1;
+            d_loop[j] = FALSE;
+            if (!mode || mode->position_type == CONF_ADJ_ABSOLUTE) continue;
+            for (m = 0; m < nd; m++) {
+                if (displays[m] == mode->relative_to) {
+                    d_parent[j] = m;
+                    break;
+                }
+            }
+        }
+        if (!order_relative_positions(nd, d_parent, d_loop, d_order)) {
+            goto fail;
+        }
+
+        for (m = 0; m < nd; m++) {
+            d_node[d_order[m]] = ro->num_nodes + m;
+        }
+        for (m = 0; m < nd; m++) {
+            j = d_order[m];
+            node = &(ro->nodes[ro->num_nodes++]);
+            node->screen = screen;
+            node->display = displays[j];
+            node->mode = displays[j]->cur_mode;
+            node->relative_to = get_node_relative_to(node);
+            node->parent = (d_parent[j] >= 0) ? d_node[d_parent[j]] : -1;
+            node->in_loop = d_loop[j];
+        }
+
+        s_node[i] = ro->num_nodes;
+        node = &(ro->nodes[ro->num_nodes++]);
+        node->screen = screen;
+        node->relative_to = get_node_relative_to(node);
+        node->parent = (s_parent[i] >= 0) ? s_node[s_parent[i]] : -1;
+        node->in_loop = s_loop[i];
+    }
+
+    ro->valid = TRUE;
+    goto done;
+
+ fail:
+    free(ro->nodes);
+    memset(ro, 0, sizeof(*ro));
+
+ done:
+    free(screens);
+    free(s_parent);
+    free(s_order);
+    free(s_node);
+    free(s_loop);
+    free(displays);
+    free(d_parent);
+    free(d_order);
+    free(d_node);
+    free(d_loop);
+
+} /* build_resolve_order() */
+
+
+
+/** mark_resolve_dirty() *********************************************
+ *
+ * Notes that only the given display (or, if display is NULL, the given
+ * X screen) was modified, so that the next sync_layout() only needs to
+ * resolve it and what is positioned relative to it.
+ *
+ **/
+
+static void mark_resolve_dirty(CtkDisplayLayout *ctk_object,
+                               nvScreenPtr screen, nvDisplayPtr display)
+{
+    ResolveOrder *ro = &(ctk_object->resolve_order);
+    int i;
+
+
+    if (!resolve_order_matches_layout(ctk_object)) {
+        build_resolve_order(ctk_object);
+    }
+
+    for (i = 0; i < ro->num_nodes; i++) {
+        if (ro->nodes[i].screen == screen &&
+            ro->nodes[i].display == display) {
+            ro->nodes[i].dirty = TRUE;
+            ro->partial = TRUE;
+            return;
+        }
+    }
+
+} /* mark_resolve_dirty() */
+
+
+
+/** update_resolve_order() *******************************************
+ *
+ * Makes sure the resolve order is up to date with the layout, and marks
+ * the nodes that need to be resolved: all of them, or if only some were
+ * marked dirty with mark_resolve_dirty(), those and the nodes that
+ * depend on them.
+ *
+ **/
+
+static void update_resolve_order(CtkDisplayLayout *ctk_object)
+{
+    ResolveOrder *ro = &(ctk_object->resolve_order);
+    ResolveNode *node;
+    Bool displays_dirty = FALSE;
+    int i;
+
+
+    if (!resolve_order_matches_layout(ctk_object)) {
+        build_resolve_order(ctk_object);
+    }
+
+    for (i = 0; i < ro->num_nodes; i++) {
+        node = &(ro->nodes[i]);
+
+        if (!ro->partial) {
+            node->dirty = TRUE;
+            continue;
+        }
+
+        /* Nodes depend on what they are positioned relative to.  Nodes
+         * positioned relative to something outside of the order (or in
+         * a loop) are always resolved.
+         */
+        if ((node->parent >= 0 && ro->nodes[node->parent].dirty) ||
+            (node->parent < 0 && node->relative_to && !node->in_loop)) {
+            node->dirty = TRUE;
+        }
+
+        /* X screens also depend on the size of their displays */
+        if (node->display) {
+            displays_dirty |= node->dirty;
+        } else {
+            node->dirty |= displays_dirty;
+            displays_dirty = FALSE;
+        }
+    }
+
+} /* update_resolve_order() */
+
+
+
+/** resolve_layout() *************************************************
+ *
+ * Resolves relative positions into absolute positions for the
+ * the *current* layout, for the nodes of the resolve order that are
+ * marked dirty (see update_resolve_order()).
+ *
+ **/
+
+static void resolve_layout(CtkDisplayLayout *ctk_object)
+{
+    ResolveOrder *ro = &(ctk_object->resolve_order);
+    ResolveNode *node;
+    int i;
+
+    for (i = 0; i < ro->num_nodes; i++) {
+        node = &(ro->nodes[i]);
+
+        if (!node->dirty) continue;
+
+        if (node->display) {
+            /* Resolve TwinView relationships */
+            if (!node->in_loop) {
+                resolve_mode(node->display, node->screen->cur_metamode_idx);
+            }
+        } else {
+            /* Get the new position of the metamode, then resolve X
+             * screen relationships.
+             */
+            calc_metamode(node->screen,
+                          get_metamode(node->screen,
+                                       node->screen->cur_metamode_idx));
+            if (!node->in_loop) {
+                resolve_screen(node->screen);
+            }
+        }
     }
 
 } /* resolve_layout() */
@@ -1091,13 +1893,15 @@ static void calc_screen(nvScreenPtr screen)
  * the smallest bounding box that holds all the metamodes of all X
  * screens as well as dummy modes for disabled displays.
 
- * As a side effect, the dimensions of all metamodes for all X
- * screens are (re)calculated.
+ * As a side effect, the dimensions of all metamodes for the X screens
+ * that were resolved (see update_resolve_order()) are (re)calculated.
  *
  **/
 
-static void calc_layout(nvLayoutPtr layout)
+static void calc_layout(CtkDisplayLayout *ctk_object)
 {
+    nvLayoutPtr layout = ctk_object->layout;
+    ResolveOrder *ro = &(ctk_object->resolve_order);
     nvGpuPtr gpu;
     nvScreenPtr screen;
     nvDisplayPtr display;
@@ -1105,11 +1909,18 @@ static void calc_layout(nvLayoutPtr layout)
     int init = 1;
     GdkRectangle *dim;
     int x, y;
+    int i;
 
 
     if (!layout) return;
 
-    resolve_layout(layout);
+    resolve_layout(ctk_object);
+
+    for (i = 0; i < ro->num_nodes; i++) {
+        if (!ro->nodes[i].display && ro->nodes[i].dirty) {
+            calc_screen(ro->nodes[i].screen);
+        }
+    }
 
     dim = &(layout->dim);
     memset(dim, 0, sizeof(*dim));
@@ -1117,7 +1928,6 @@ static void calc_layout(nvLayoutPtr layout)
     for (screen = layout->screens; screen; screen = screen->next_in_layout) {
         GdkRectangle *screen_rect;
 
-        calc_screen(screen);
         screen_rect = get_screen_rect(screen, 0);
 
         if (init) {
@@ -1279,6 +2089,333 @@ static void switch_screen_to_absolute(nvScreenPtr screen)
 
 
 
+/** screen_moves_with() **********************************************
+ *
+ * Returns TRUE if the position of the given X screen depends on that of
+ * the 'base' X screen, such that moving 'base' may move it as well.
+ *
+ **/
+
+static Bool screen_moves_with(nvScreenPtr screen, nvScreenPtr base,
+                              int max_depth)
+{
+    int depth;
+
+    for (depth = 0; screen && depth <= max_depth; depth++) {
+        if (screen == base) {
+            return TRUE;
+        }
+        if (screen->position_type == CONF_ADJ_ABSOLUTE) {
+            break;
+        }
+        screen = screen->relative_to;
+    }
+
+    return FALSE;
+
+} /* screen_moves_with() */
+
+
+
+/** snap_index_clear() **********************************************
+ *
+ * Frees the snap index.
+ *
+ **/
+
+static void snap_index_clear(SnapIndex *index)
+{
+    int i;
+
+    free(index->targets);
+    free(index->moving);
+    free(index->candidates);
+    free(index->stamps);
+    for (i = 0; i < SNAP_NUM_EDGE_LISTS; i++) {
+        free(index->edges[i]);
+    }
+
+    memset(index, 0, sizeof(*index));
+
+} /* snap_index_clear() */
+
+
+
+/** snap_index_add_rect() *******************************************
+ *
+ * Adds the edges and midlines of a rectangle of the given target to
+ * the snap index.
+ *
+ **/
+
+static void snap_index_add_rect(SnapIndex *index, int target,
+                                const GdkRectangle *rect)
+{
+    SnapEdge *edge;
+
+    edge = index->edges[SNAP_EDGES_H] + index->num_edges[SNAP_EDGES_H];
+    edge[0].pos = rect->x;
+    edge[1].pos = rect->x + rect->width;
+    edge[0].target = edge[1].target = target;
+    index->num_edges[SNAP_EDGES_H] += 2;
+
+    edge = index->edges[SNAP_MIDLINES_H] + index->num_edges[SNAP_MIDLINES_H];
+    edge->pos = rect->x + rect->width/2;
+    edge->target = target;
+    index->num_edges[SNAP_MIDLINES_H]++;
+
+    edge = index->edges[SNAP_EDGES_V] + index->num_edges[SNAP_EDGES_V];
+    edge[0].pos = rect->y;
+    edge[1].pos = rect->y + rect->height;
+    edge[0].target = edge[1].target = target;
+    index->num_edges[SNAP_EDGES_V] += 2;
+
+    edge = index->edges[SNAP_MIDLINES_V] + index->num_edges[SNAP_MIDLINES_V];
+    edge->pos = rect->y + rect->height/2;
+    edge->target = target;
+    index->num_edges[SNAP_MIDLINES_V]++;
+
+} /* snap_index_add_rect() */
+
+
+
+static int compare_snap_edges(const void *a, const void *b)
+{
+    const SnapEdge *ea = a;
+    const SnapEdge *eb = b;
+
+    return (ea->pos > eb->pos) - (ea->pos < eb->pos);
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+
+    return (ia > ib) - (ia < ib);
+}
+
+
+
+/** snap_index_build() **********************************************
+ *
+ * Builds the snap index for modifying the given X screen (or one of its
+ * displays).  The targets are listed in the order in which snap_move()
+ * and snap_pan() used to test them: displays in Z-order, then X screens,
+ * then PRIME displays, so that ties between equally close edges are
+ * broken as before.
+ *
+ * The displays of the modified X screen, and the X screens positioned
+ * relative to it (along with their displays), may move along with what
+ * is being modified and so are not indexed.
+ *
+ **/
+
+static void snap_index_build(CtkDisplayLayout *ctk_object,
+                             nvScreenPtr modified_screen)
+{
+    SnapIndex *index = &(ctk_object->snap_index);
+    nvLayoutPtr layout = ctk_object->layout;
+    nvScreenPtr screen;
+    nvDisplayPtr display;
+    nvPrimeDisplayPtr prime;
+    GdkRectangle rect;
+    int max_targets;
+    int i, n;
+
+
+    snap_index_clear(index);
+
+    max_targets = ctk_object->Zcount + layout->num_screens +
+        layout->num_prime_displays;
+    if (!max_targets) {
+        max_targets = 1;
+    }
+
+    index->targets = calloc(max_targets, sizeof(ZNode));
+    index->moving = calloc(max_targets, sizeof(int));
+    index->candidates = calloc(max_targets, sizeof(int));
+    index->stamps = calloc(max_targets, sizeof(unsigned int));
+    for (i = 0; i < SNAP_NUM_EDGE_LISTS; i++) {
+        /* Displays contribute two rectangles with two edges each */
+        index->edges[i] = calloc(4 * max_targets, sizeof(SnapEdge));
+        if (!index->edges[i]) {
+            goto fail;
+        }
+    }
+    if (!index->targets || !index->moving || !index->candidates ||
+        !index->stamps) {
+        goto fail;
+    }
+
+
+    /* Displays, in Z-order */
+    for (i = 0; i < ctk_object->Zcount; i++) {
+
+        if (ctk_object->Zorder[i].type != ZNODE_TYPE_DISPLAY) continue;
+
+        display = ctk_object->Zorder[i].u.display;
+        if (!display || !display->cur_mode || !display->screen) continue;
+
+        n = index->num_targets++;
+        index->targets[n] = ctk_object->Zorder[i];
+
+        if (screen_moves_with(display->screen, modified_screen,
+                              layout->num_screens)) {
+            index->moving[index->num_moving++] = n;
+            continue;
+        }
+
+        snap_index_add_rect(index, n, &(display->cur_mode->pan));
+        get_viewportin_rect(display->cur_mode, &rect);
+        snap_index_add_rect(index, n, &rect);
+    }
+
+    /* X screens */
+    for (screen = layout->screens; screen; screen = screen->next_in_layout) {
+
+        if (screen == modified_screen) continue;
+
+        n = index->num_targets++;
+        index->targets[n].type = ZNODE_TYPE_SCREEN;
+        index->targets[n].u.screen = screen;
+
+        if (screen_moves_with(screen, modified_screen, layout->num_screens)) {
+            index->moving[index->num_moving++] = n;
+            continue;
+        }
+
+        snap_index_add_rect(index, n, get_screen_rect(screen, 0));
+    }
+
+    /* PRIME displays */
+    for (prime = layout->prime_displays; prime; prime = prime->next_in_layout) {
+        n = index->num_targets++;
+        index->targets[n].type = ZNODE_TYPE_PRIME;
+        index->targets[n].u.prime_display = prime;
+
+        snap_index_add_rect(index, n, &(prime->rect));
+    }
+
+    for (i = 0; i < SNAP_NUM_EDGE_LISTS; i++) {
+        qsort(index->edges[i], index->num_edges[i], sizeof(SnapEdge),
+              compare_snap_edges);
+    }
+
+    index->screen = modified_screen;
+    index->valid = TRUE;
+    return;
+
+ fail:
+    snap_index_clear(index);
+
+} /* snap_index_build() */
+
+
+
+/** snap_index_find_edges() *****************************************
+ *
+ * Adds the targets that have an edge in the given sorted list within
+ * 'dist' of 'pos' to the snap index's candidates.
+ *
+ **/
+
+static void snap_index_find_edges(SnapIndex *index, int list, int pos,
+                                  int dist, int *num_candidates)
+{
+    const SnapEdge *edges = index->edges[list];
+    int lo = 0;
+    int hi = index->num_edges[list];
+    int mid;
+
+    /* Find the first edge at or after pos - dist */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (edges[mid].pos < pos - dist) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (; lo < index->num_edges[list] && edges[lo].pos <= pos + dist; lo++) {
+        int target = edges[lo].target;
+
+        if (index->stamps[target] != index->stamp) {
+            index->stamps[target] = index->stamp;
+            index->candidates[(*num_candidates)++] = target;
+        }
+    }
+
+} /* snap_index_find_edges() */
+
+
+
+/** snap_index_lookup() *********************************************
+ *
+ * Finds the items that the modify info's source dimensions (src_dim)
+ * may snap to: the indexed items with an edge (or midline) within snap
+ * strength of an edge (or the midline) of src_dim, plus the items that
+ * are not indexed.  The candidates are left in snap_index.candidates,
+ * in snapping order.
+ *
+ * The snap index is (re)built first if it is out of date.
+ *
+ * Returns the number of candidates.
+ *
+ **/
+
+static int snap_index_lookup(CtkDisplayLayout *ctk_object)
+{
+    ModifyInfo *info = &(ctk_object->modify_info);
+    SnapIndex *index = &(ctk_object->snap_index);
+    GdkRectangle *src = &(info->src_dim);
+    int dist = ctk_object->snap_strength;
+    int num = 0;
+    int x, y;
+    int i;
+
+
+    if (!index->valid || index->screen != info->screen) {
+        snap_index_build(ctk_object, info->screen);
+        if (!index->valid) {
+            return 0;
+        }
+    }
+
+    /* Start a new lookup, resetting the stamps if they wrap around */
+    if (++index->stamp == 0) {
+        memset(index->stamps, 0, index->num_targets * sizeof(unsigned int));
+        index->stamp = 1;
+    }
+
+    for (i = 0; i < index->num_moving; i++) {
+        index->stamps[index->moving[i]] = index->stamp;
+        index->candidates[num++] = index->moving[i];
+    }
+
+    /* Look up in the coordinates the index was built in */
+    x = src->x - index->dx;
+    y = src->y - index->dy;
+
+    snap_index_find_edges(index, SNAP_EDGES_H, x, dist, &num);
+    snap_index_find_edges(index, SNAP_EDGES_H, x + src->width, dist, &num);
+    snap_index_find_edges(index, SNAP_MIDLINES_H, x + src->width/2, dist,
+                          &num);
+
+    snap_index_find_edges(index, SNAP_EDGES_V, y, dist, &num);
+    snap_index_find_edges(index, SNAP_EDGES_V, y + src->height, dist, &num);
+    snap_index_find_edges(index, SNAP_MIDLINES_V, y + src->height/2, dist,
+                          &num);
+
+    qsort(index->candidates, num, sizeof(int), compare_ints);
+
+    return num;
+
+} /* snap_index_lookup() */
+
+
+
 /** snap_dim_to_dim() ***********************************************
  *
  * Snaps the sides of two rectangles together.
@@ -1454,6 +2591,166 @@ static void snap_side_to_dim(GdkRectangle *dst, GdkRectangle *src,
 
 
 
+/** snap_move_to_display() ******************************************
+ *
+ * Snaps the modify info's source dimensions (src_dim) to the panning
+ * domain and ViewPortIn of the given other display (see snap_move()).
+ *
+ **/
+
+static void snap_move_to_display(CtkDisplayLayout *ctk_object,
+                                 nvDisplayPtr other)
+{
+    ModifyInfo *info = &(ctk_object->modify_info);
+    int *bv;
+    int *bh;
+
+
+    /* Other display must have a mode */
+    if (!other || !other->cur_mode || !other->screen ||
+        other == info->display) return;
+
+    /* Don't snap to displays that are somehow related.
+     * XXX Check for nested relations.
+     */
+    if (((other->cur_mode->position_type != CONF_ADJ_ABSOLUTE) &&
+         (other->cur_mode->relative_to == info->display)) ||
+        ((info->display->cur_mode->position_type != CONF_ADJ_ABSOLUTE) &&
+         (info->display->cur_mode->relative_to == other))) {
+        return;
+    }
+
+    /* NOTE: When the display devices' screens are relative to each
+     *       other, we may still want to allow snapping of the non-
+     *       related edges.  This is useful, for example, when two
+     *       screens have a right of/left of relationship and
+     *       one of them is taller.
+     */
+    bv = &info->best_snap_v;
+    bh = &info->best_snap_h;
+
+    if (((other->screen->position_type == CONF_ADJ_RIGHTOF) ||
+         (other->screen->position_type == CONF_ADJ_LEFTOF)) &&
+        (other->screen->relative_to == info->screen)) {
+        bh = NULL;
+    }
+    if (((info->screen->position_type == CONF_ADJ_RIGHTOF) ||
+         (info->screen->position_type == CONF_ADJ_LEFTOF)) &&
+        (info->screen->relative_to == other->screen)) {
+        bh = NULL;
+    }
+
+    if (((other->screen->position_type == CONF_ADJ_ABOVE) ||
+         (other->screen->position_type == CONF_ADJ_BELOW)) &&
+        (other->screen->relative_to == info->screen)) {
+        bv = NULL;
+    }
+    if (((info->screen->position_type == CONF_ADJ_ABOVE) ||
+         (info->screen->position_type == CONF_ADJ_BELOW)) &&
+        (info->screen->relative_to == other->screen)) {
+        bv = NULL;
+    }
+
+    /* Snap to other display's panning dimensions */
+    snap_dim_to_dim(&(info->dst_dim),
+                    &(info->src_dim),
+                    &(other->cur_mode->pan),
+                    ctk_object->snap_strength, bv, bh);
+
+    /* Snap to other display's dimensions */
+    {
+        GdkRectangle rect;
+        get_viewportin_rect(other->cur_mode, &rect);
+        snap_dim_to_dim(&(info->dst_dim),
+                        &(info->src_dim),
+                        &rect,
+                        ctk_object->snap_strength, bv, bh);
+    }
+
+} /* snap_move_to_display() */
+
+
+
+/** snap_move_to_screen() *******************************************
+ *
+ * Snaps the modify info's source dimensions (src_dim) to the dimensions
+ * of the given other X screen (see snap_move()).
+ *
+ **/
+
+static void snap_move_to_screen(CtkDisplayLayout *ctk_object,
+                                nvScreenPtr screen)
+{
+    ModifyInfo *info = &(ctk_object->modify_info);
+    int *bv;
+    int *bh;
+    GdkRectangle *screen_rect;
+
+
+    if (screen == info->screen) return;
+
+    /* NOTE: When the (display devices') screens are relative to
+     *       each other, we may still want to allow snapping of the
+     *       non-related edges.  This is useful, for example, when
+     *       two screens have a right of/left of relationship and
+     *       one of them is taller.
+     */
+
+    bv = &info->best_snap_v;
+    bh = &info->best_snap_h;
+
+    if (((screen->position_type == CONF_ADJ_RIGHTOF) ||
+         (screen->position_type == CONF_ADJ_LEFTOF)) &&
+        (screen->relative_to == info->screen)) {
+        bh = NULL;
+    }
+    if (((info->screen->position_type == CONF_ADJ_RIGHTOF) ||
+         (info->screen->position_type == CONF_ADJ_LEFTOF)) &&
+        (info->screen->relative_to == screen)) {
+        bh = NULL;
+    }
+
+    /* If we aren't snapping horizontally with the other screen,
+     * we shouldn't snap vertically either if we are moving the
+     * top-most display in the screen.
+     */
+    if (!bh &&
+        info->display &&
+        info->display->cur_mode->pan.y == info->screen->dim.y) {
+        bv = NULL;
+    }
+
+    if (((screen->position_type == CONF_ADJ_ABOVE) ||
+         (screen->position_type == CONF_ADJ_BELOW)) &&
+        (screen->relative_to == info->screen)) {
+        bv = NULL;
+    }
+    if (((info->screen->position_type == CONF_ADJ_ABOVE) ||
+         (info->screen->position_type == CONF_ADJ_BELOW)) &&
+        (info->screen->relative_to == screen)) {
+        bv = NULL;
+    }
+
+    /* If we aren't snapping vertically with the other screen,
+     * we shouldn't snap horizontally either if this is the
+     * left-most display in the screen.
+     */
+    if (!bv &&
+        info->display &&
+        info->display->cur_mode->pan.x == info->screen->dim.x) {
+        bh = NULL;
+    }
+
+    screen_rect = get_screen_rect(screen, 0);
+    snap_dim_to_dim(&(info->dst_dim),
+                    &(info->src_dim),
+                    screen_rect,
+                    ctk_object->snap_strength, bv, bh);
+
+} /* snap_move_to_screen() */
+
+
+
 /** snap_move() *****************************************************
  *
  * Snaps the modify info's source dimensions (src_dim) to other
@@ -1462,193 +2759,226 @@ static void snap_side_to_dim(GdkRectangle *dst, GdkRectangle *src,
  * with the closest other screen/display's dimensions.  The results
  * of the snap are placed into the destination dimensions (dst_dim).
  *
+ * Only the displays/screens found close enough to snap to by the
+ * snap index are considered.
+ *
  **/
 
 static void snap_move(CtkDisplayLayout *ctk_object)
 {
     ModifyInfo *info = &(ctk_object->modify_info);
+    SnapIndex *index = &(ctk_object->snap_index);
     int *bv;
     int *bh;
     int i;
+    int num_candidates;
     int dist;
-    nvLayoutPtr layout = ctk_object->layout;
-    nvScreenPtr screen;
-    nvDisplayPtr other;
-    nvPrimeDisplayPtr prime;
-    GdkRectangle *screen_rect;
-
-
-    /* Snap to other display's modes */
-    if (info->display) {
-        for (i = 0; i < ctk_object->Zcount; i++) {
-
-            if (ctk_object->Zorder[i].type != ZNODE_TYPE_DISPLAY) continue;
-
-            other = ctk_object->Zorder[i].u.display;
+    ZNode *target;
 
-            /* Other display must have a mode */
-            if (!other || !other->cur_mode || !other->screen ||
-                other == info->display) continue;
 
-            /* Don't snap to displays that are somehow related.
-             * XXX Check for nested relations.
-             */
-            if (((other->cur_mode->position_type != CONF_ADJ_ABSOLUTE) &&
-                 (other->cur_mode->relative_to == info->display)) ||
-                ((info->display->cur_mode->position_type != CONF_ADJ_ABSOLUTE) &&
-                 (info->display->cur_mode->relative_to == other))) {
-                continue;
-            }
+    num_candidates = snap_index_lookup(ctk_object);
 
-            /* NOTE: When the display devices' screens are relative to each
-             *       other, we may still want to allow snapping of the non-
-             *       related edges.  This is useful, for example, when two
-             *       screens have a right of/left of relationship and
-             *       one of them is taller.
-             */
-            bv = &info->best_snap_v;
-            bh = &info->best_snap_h;
+    for (i = 0; i < num_candidates; i++) {
+        target = &(index->targets[index->candidates[i]]);
 
-            if (((other->screen->position_type == CONF_ADJ_RIGHTOF) ||
-                 (other->screen->position_type == CONF_ADJ_LEFTOF)) &&
-                (other->screen->relative_to == info->screen)) {
-                bh = NULL;
-            }
-            if (((info->screen->position_type == CONF_ADJ_RIGHTOF) ||
-                 (info->screen->position_type == CONF_ADJ_LEFTOF)) &&
-                (info->screen->relative_to == other->screen)) {
-                bh = NULL;
+        switch (target->type) {
+        case ZNODE_TYPE_DISPLAY:
+            /* Snap to other display's modes */
+            if (info->display) {
+                snap_move_to_display(ctk_object, target->u.display);
             }
+            break;
 
-            if (((other->screen->position_type == CONF_ADJ_ABOVE) ||
-                 (other->screen->position_type == CONF_ADJ_BELOW)) &&
-                (other->screen->relative_to == info->screen)) {
-                bv = NULL;
-            }
-            if (((info->screen->position_type == CONF_ADJ_ABOVE) ||
-                 (info->screen->position_type == CONF_ADJ_BELOW)) &&
-                (info->screen->relative_to == other->screen)) {
-                bv = NULL;
-            }
+        case ZNODE_TYPE_SCREEN:
+            /* Snap to dimensions of other X screens */
+            snap_move_to_screen(ctk_object, target->u.screen);
+            break;
 
-            /* Snap to other display's panning dimensions */
+        case ZNODE_TYPE_PRIME:
+            /* Snap to PRIME displays if available */
             snap_dim_to_dim(&(info->dst_dim),
                             &(info->src_dim),
-                            &(other->cur_mode->pan),
-                            ctk_object->snap_strength, bv, bh);
-
-            /* Snap to other display's dimensions */
-            {
-                GdkRectangle rect;
-                get_viewportin_rect(other->cur_mode, &rect);
-                snap_dim_to_dim(&(info->dst_dim),
-                                &(info->src_dim),
-                                &rect,
-                                ctk_object->snap_strength, bv, bh);
-            }
+                            &(target->u.prime_display->rect),
+                            ctk_object->snap_strength,
+                            &info->best_snap_v, &info->best_snap_h);
+            break;
         }
+    }
 
-    } /* Done snapping to other displays */
+    /* Snap to the maximum screen dimensions */
+    bv = &info->best_snap_v;
+    bh = &info->best_snap_h;
 
+    if (info->display) {
+        dist = abs( (info->screen->dim.x + info->screen->max_width)
+                   -(info->src_dim.x + info->src_dim.width));
+        if (dist < *bh) {
+            info->dst_dim.x = info->screen->dim.x + info->screen->max_width -
+                info->src_dim.width;
+            *bh = dist;
+        }
+        dist = abs( (info->screen->dim.y + info->screen->max_height)
+                   -(info->src_dim.y + info->src_dim.height));
+        if (dist < *bv) {
+            info->dst_dim.y = info->screen->dim.y + info->screen->max_height -
+                info->src_dim.height;
+            *bv = dist;
+        }
+    }
 
-    /* Snap to dimensions of other X screens */
-    for (screen = layout->screens; screen; screen = screen->next_in_layout) {
+} /* snap_move() */
 
-        if (screen == info->screen) continue;
 
-        /* NOTE: When the (display devices') screens are relative to
-         *       each other, we may still want to allow snapping of the
-         *       non-related edges.  This is useful, for example, when
-         *       two screens have a right of/left of relationship and
-         *       one of them is taller.
-         */
 
-        bv = &info->best_snap_v;
-        bh = &info->best_snap_h;
+/** snap_pan_to_display() *******************************************
+ *
+ * Snaps the bottom right edge(s) of the modify info's source dimensions
+ * (src_dim) to the panning domain and ViewPortIn of the given other
+ * display (see snap_pan()).
+ *
+ **/
+
+static void snap_pan_to_display(CtkDisplayLayout *ctk_object,
+                                nvDisplayPtr other)
+{
+    ModifyInfo *info = &(ctk_object->modify_info);
+    int *bv;
+    int *bh;
+
+
+    /* Other display must have a mode */
+    if (!other || !other->cur_mode || !other->screen ||
+        other == info->display) return;
+
+
+    /* NOTE: When display devices are relative to each other,
+     *       we may still want to allow snapping of the non-related
+     *       edges.  This is useful, for example, when two
+     *       displays have a right of/left of relationship and
+     *       one of the displays is taller.
+     */
+    bv = &info->best_snap_v;
+    bh = &info->best_snap_h;
 
-        if (((screen->position_type == CONF_ADJ_RIGHTOF) ||
-             (screen->position_type == CONF_ADJ_LEFTOF)) &&
-            (screen->relative_to == info->screen)) {
+    /* Don't snap horizontally to other displays that are somehow
+     * related on the right edge of the display being panned.
+     */
+    if (info->display) {
+        if ((other->cur_mode->position_type == CONF_ADJ_RIGHTOF) &&
+            other->cur_mode->relative_to == info->display) {
             bh = NULL;
         }
-        if (((info->screen->position_type == CONF_ADJ_RIGHTOF) ||
-             (info->screen->position_type == CONF_ADJ_LEFTOF)) &&
-            (info->screen->relative_to == screen)) {
+        if ((info->display->cur_mode->position_type == CONF_ADJ_LEFTOF) &&
+            info->display->cur_mode->relative_to == other) {
             bh = NULL;
         }
+    }
+    if ((other->screen->position_type == CONF_ADJ_RIGHTOF) &&
+        other->screen->relative_to == info->screen) {
+        bh = NULL;
+    }
+    if ((info->screen->position_type == CONF_ADJ_LEFTOF) &&
+        info->screen->relative_to == other->screen) {
+        bh = NULL;
+    }
 
-        /* If we aren't snapping horizontally with the other screen,
-         * we shouldn't snap vertically either if we are moving the
-         * top-most display in the screen.
-         */
-        if (!bh &&
-            info->display &&
-            info->display->cur_mode->pan.y == info->screen->dim.y) {
-            bv = NULL;
-        }
-
-        if (((screen->position_type == CONF_ADJ_ABOVE) ||
-             (screen->position_type == CONF_ADJ_BELOW)) &&
-            (screen->relative_to == info->screen)) {
+    /* Don't snap vertically to other displays that are somehow
+     * related on the bottom edge of the display being panned.
+     */
+    if (info->display) {
+        if ((other->cur_mode->position_type == CONF_ADJ_BELOW) &&
+            other->cur_mode->relative_to == info->display) {
             bv = NULL;
         }
-        if (((info->screen->position_type == CONF_ADJ_ABOVE) ||
-             (info->screen->position_type == CONF_ADJ_BELOW)) &&
-            (info->screen->relative_to == screen)) {
+        if ((info->display->cur_mode->position_type == CONF_ADJ_ABOVE) &&
+            info->display->cur_mode->relative_to == other) {
             bv = NULL;
         }
+    }
+    if ((other->screen->position_type == CONF_ADJ_BELOW) &&
+        other->screen->relative_to == info->screen) {
+        bv = NULL;
+    }
+    if ((info->screen->position_type == CONF_ADJ_ABOVE) &&
+        info->screen->relative_to == other->screen) {
+        bv = NULL;
+    }
 
-        /* If we aren't snapping vertically with the other screen,
-         * we shouldn't snap horizontally either if this is the
-         * left-most display in the screen.
-         */
-        if (!bv &&
-            info->display &&
-            info->display->cur_mode->pan.x == info->screen->dim.x) {
-            bh = NULL;
-        }
+    /* Snap to other display panning dimensions */
+    snap_side_to_dim(&(info->dst_dim),
+                     &(info->src_dim),
+                     &(other->cur_mode->pan),
+                     bv, bh);
 
-        screen_rect = get_screen_rect(screen, 0);
-        snap_dim_to_dim(&(info->dst_dim),
-                        &(info->src_dim),
-                        screen_rect,
-                        ctk_object->snap_strength, bv, bh);
+    /* Snap to other display dimensions */
+    {
+        GdkRectangle rect;
+        get_viewportin_rect(other->cur_mode, &rect);
+        snap_side_to_dim(&(info->dst_dim),
+                         &(info->src_dim),
+                         &rect,
+                         bv, bh);
     }
 
-    /* Snap to PRIME displays if available */
-    for (prime = layout->prime_displays; prime; prime = prime->next_in_layout) {
+} /* snap_pan_to_display() */
 
-        bv = &info->best_snap_v;
-        bh = &info->best_snap_h;
 
-        snap_dim_to_dim(&(info->dst_dim),
-                        &(info->src_dim),
-                        &prime->rect,
-                        ctk_object->snap_strength, bv, bh);
-    }
 
-    /* Snap to the maximum screen dimensions */
+/** snap_pan_to_screen() ********************************************
+ *
+ * Snaps the bottom right edge(s) of the modify info's source dimensions
+ * (src_dim) to the dimensions of the given other X screen (see
+ * snap_pan()).
+ *
+ **/
+
+static void snap_pan_to_screen(CtkDisplayLayout *ctk_object,
+                               nvScreenPtr screen)
+{
+    ModifyInfo *info = &(ctk_object->modify_info);
+    int *bv;
+    int *bh;
+    GdkRectangle *screen_rect;
+
+
+    if (screen == info->screen) return;
+
     bv = &info->best_snap_v;
     bh = &info->best_snap_h;
 
-    if (info->display) {
-        dist = abs( (info->screen->dim.x + info->screen->max_width)
-                   -(info->src_dim.x + info->src_dim.width));
-        if (dist < *bh) {
-            info->dst_dim.x = info->screen->dim.x + info->screen->max_width -
-                info->src_dim.width;
-            *bh = dist;
-        }
-        dist = abs( (info->screen->dim.y + info->screen->max_height)
-                   -(info->src_dim.y + info->src_dim.height));
-        if (dist < *bv) {
-            info->dst_dim.y = info->screen->dim.y + info->screen->max_height -
-                info->src_dim.height;
-            *bv = dist;
-        }
+    /* Don't snap horizontally to other screens that are somehow
+     * related on the right edge of the (display's) screen being
+     * panned.
+     */
+    if ((screen->position_type == CONF_ADJ_RIGHTOF) &&
+        (screen->relative_to == info->screen)) {
+        bh = NULL;
+    }
+    if ((info->screen->position_type == CONF_ADJ_LEFTOF) &&
+        (info->screen->relative_to == screen)) {
+        bh = NULL;
+    }
+
+    /* Don't snap vertically to other screens that are somehow
+     * related on the bottom edge of the (display's) screen being
+     * panned.
+     */
+    if ((screen->position_type == CONF_ADJ_BELOW) &&
+        (screen->relative_to == info->screen)) {
+        bv = NULL;
+    }
+    if ((info->screen->position_type == CONF_ADJ_ABOVE) &&
+        (info->screen->relative_to == screen)) {
+        bv = NULL;
     }
 
-} /* snap_move() */
+    screen_rect = get_screen_rect(screen, 0);
+    snap_side_to_dim(&(info->dst_dim),
+                     &(info->src_dim),
+                     screen_rect,
+                     bv, bh);
+
+} /* snap_pan_to_screen() */
 
 
 
@@ -1668,14 +2998,13 @@ static void snap_move(CtkDisplayLayout *ctk_object)
 static void snap_pan(CtkDisplayLayout *ctk_object)
 {
     ModifyInfo *info = &(ctk_object->modify_info);
+    SnapIndex *index = &(ctk_object->snap_index);
     int *bv;
     int *bh;
     int i;
+    int num_candidates;
     int dist;
-    nvLayoutPtr layout = ctk_object->layout;
-    nvScreenPtr screen;
-    nvDisplayPtr other;
-    GdkRectangle *screen_rect;
+    ZNode *target;
 
 
     if (info->display) {
@@ -1714,128 +3043,25 @@ static void snap_pan(CtkDisplayLayout *ctk_object)
     }
 
 
-    /* Snap to other display's modes */
-    for (i = 0; i < ctk_object->Zcount; i++) {
-
-        if (ctk_object->Zorder[i].type != ZNODE_TYPE_DISPLAY) continue;
-
-        other = ctk_object->Zorder[i].u.display;
-
-        /* Other display must have a mode */
-        if (!other || !other->cur_mode || !other->screen ||
-            other == info->display) continue;
-
-
-        /* NOTE: When display devices are relative to each other,
-         *       we may still want to allow snapping of the non-related
-         *       edges.  This is useful, for example, when two
-         *       displays have a right of/left of relationship and
-         *       one of the displays is taller.
-         */
-        bv = &info->best_snap_v;
-        bh = &info->best_snap_h;
-
-        /* Don't snap horizontally to other displays that are somehow
-         * related on the right edge of the display being panned.
-         */
-        if (info->display) {
-            if ((other->cur_mode->position_type == CONF_ADJ_RIGHTOF) &&
-                other->cur_mode->relative_to == info->display) {
-                bh = NULL;
-            }
-            if ((info->display->cur_mode->position_type == CONF_ADJ_LEFTOF) &&
-                info->display->cur_mode->relative_to == other) {
-                bh = NULL;
-            }
-        }
-        if ((other->screen->position_type == CONF_ADJ_RIGHTOF) &&
-            other->screen->relative_to == info->screen) {
-            bh = NULL;
-        }
-        if ((info->screen->position_type == CONF_ADJ_LEFTOF) &&
-            info->screen->relative_to == other->screen) {
-            bh = NULL;
-        }
-
-        /* Don't snap vertically to other displays that are somehow
-         * related on the bottom edge of the display being panned.
-         */
-        if (info->display) {
-            if ((other->cur_mode->position_type == CONF_ADJ_BELOW) &&
-                other->cur_mode->relative_to == info->display) {
-                bv = NULL;
-            }
-            if ((info->display->cur_mode->position_type == CONF_ADJ_ABOVE) &&
-                info->display->cur_mode->relative_to == other) {
-                bv = NULL;
-            }
-        }
-        if ((other->screen->position_type == CONF_ADJ_BELOW) &&
-            other->screen->relative_to == info->screen) {
-            bv = NULL;
-        }
-        if ((info->screen->position_type == CONF_ADJ_ABOVE) &&
-            info->screen->relative_to == other->screen) {
-            bv = NULL;
-        }
-
-        /* Snap to other display panning dimensions */
-        snap_side_to_dim(&(info->dst_dim),
-                         &(info->src_dim),
-                         &(other->cur_mode->pan),
-                         bv, bh);
-
-        /* Snap to other display dimensions */
-        {
-            GdkRectangle rect;
-            get_viewportin_rect(other->cur_mode, &rect);
-            snap_side_to_dim(&(info->dst_dim),
-                             &(info->src_dim),
-                             &rect,
-                             bv, bh);
-        }
-    }
-
-
-    /* Snap to dimensions of other X screens */
-    for (screen = layout->screens; screen; screen = screen->next_in_layout) {
+    /* Snap to other displays and X screens */
+    num_candidates = snap_index_lookup(ctk_object);
 
-        if (screen == info->screen) continue;
+    for (i = 0; i < num_candidates; i++) {
+        target = &(index->targets[index->candidates[i]]);
 
-        bv = &info->best_snap_v;
-        bh = &info->best_snap_h;
+        switch (target->type) {
+        case ZNODE_TYPE_DISPLAY:
+            snap_pan_to_display(ctk_object, target->u.display);
+            break;
 
-        /* Don't snap horizontally to other screens that are somehow
-         * related on the right edge of the (display's) screen being
-         * panned.
-         */
-        if ((screen->position_type == CONF_ADJ_RIGHTOF) &&
-            (screen->relative_to == info->screen)) {
-            bh = NULL;
-        }
-        if ((info->screen->position_type == CONF_ADJ_LEFTOF) &&
-            (info->screen->relative_to == screen)) {
-            bh = NULL;
-        }
+        case ZNODE_TYPE_SCREEN:
+            snap_pan_to_screen(ctk_object, target->u.screen);
+            break;
 
-        /* Don't snap vertically to other screens that are somehow
-         * related on the bottom edge of the (display's) screen being
-         * panned.
-         */
-        if ((screen->position_type == CONF_ADJ_BELOW) &&
-            (screen->relative_to == info->screen)) {
-            bv = NULL;
-        }
-        if ((info->screen->position_type == CONF_ADJ_ABOVE) &&
-            (info->screen->relative_to == screen)) {
-            bv = NULL;
+        case ZNODE_TYPE_PRIME:
+            /* Panning does not snap to PRIME displays */
+            break;
         }
-
-        screen_rect = get_screen_rect(screen, 0);
-        snap_side_to_dim(&(info->dst_dim),
-                         &(info->src_dim),
-                         screen_rect,
-                         bv, bh);
     }
 
     bh = &(info->best_snap_h);
@@ -2094,6 +3320,11 @@ static int move_selected(CtkDisplayLayout *ctk_object, int x, int y, int snap)
         }
     }
 
+    /* Only what was modified, and what is positioned relative to it,
+     * needs to be resolved again.
+     */
+    mark_resolve_dirty(ctk_object, info->screen, info->display);
+
     /* Recalculate layout dimensions and scaling */
     if (sync_layout(ctk_object)) {
         modified = 1;
@@ -2217,6 +3448,11 @@ static int pan_selected(CtkDisplayLayout *ctk_object, int x, int y, int snap)
     info->target_dim->height = info->dst_dim.height;
 
 
+    /* Only what was modified, and what is positioned relative to it,
+     * needs to be resolved again.
+     */
+    mark_resolve_dirty(ctk_object, info->screen, info->display);
+
     /* Recalculate layout dimensions and scaling */
     if (sync_layout(ctk_object)) {
         modified = 1;
@@ -2363,12 +3599,13 @@ static void select_display(CtkDisplayLayout *ctk_object, nvDisplayPtr display)
 
             /* Move all nodes above this one down by one location */
             if (i > 0) {
+                ZNode node = ctk_object->Zorder[i];
+
                 memmove(ctk_object->Zorder + 1, ctk_object->Zorder,
                         i*sizeof(ZNode));
 
                 /* Place the display at the top */
-                ctk_object->Zorder[0].type = ZNODE_TYPE_DISPLAY;
-                ctk_object->Zorder[0].u.display = display;
+                ctk_object->Zorder[0] = node;
             }
             break;
         }
@@ -2411,12 +3648,13 @@ static void select_prime_display(CtkDisplayLayout *ctk_object, nvPrimeDisplayPtr
 
             /* Move all nodes above this one down by one location */
             if (i > 0) {
+                ZNode node = ctk_object->Zorder[i];
+
                 memmove(ctk_object->Zorder + 1, ctk_object->Zorder,
                         i*sizeof(ZNode));
 
                 /* Place the display at the top */
-                ctk_object->Zorder[0].type = ZNODE_TYPE_PRIME;
-                ctk_object->Zorder[0].u.prime_display = prime;
+                ctk_object->Zorder[0] = node;
             }
             break;
         }
@@ -2672,47 +3910,38 @@ static char *get_tooltip_under_mouse(CtkDisplayLayout *ctk_object,
     y = (y -ctk_object->img_dim.y) / ctk_object->scale;
 
 
-    /* Go through the Z-order looking for what we are under */
-    for (i = 0; i < ctk_object->Zcount; i++) {
+    /* Look up what we are under in the Z-order */
+    i = get_zorder_node_at(ctk_object, x, y);
+
+    if (i >= 0) {
 
         if (ctk_object->Zorder[i].type == ZNODE_TYPE_DISPLAY) {
             display = ctk_object->Zorder[i].u.display;
-            if (point_in_display(display, x, y)) {
-                screen = NULL;
-                prime = NULL;
-                if (display == last_display) {
-                    goto found;
-                }
-                tip = get_display_tooltip(display, ctk_object->advanced_mode);
+            if (display == last_display) {
                 goto found;
             }
+            tip = get_display_tooltip(display, ctk_object->advanced_mode);
+            goto found;
 
         } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_SCREEN) {
             screen = ctk_object->Zorder[i].u.screen;
-            if (point_in_screen(screen, x, y)) {
-                display = NULL;
-                prime = NULL;
-                if (screen == last_screen) {
-                    goto found;
-                }
-                tip = get_screen_tooltip(screen);
+            if (screen == last_screen) {
                 goto found;
             }
+            tip = get_screen_tooltip(screen);
+            goto found;
+
         } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_PRIME) {
             prime = ctk_object->Zorder[i].u.prime_display;
-            if (point_in_rect(&prime->rect, x, y)) {
-                display = NULL;
-                screen = NULL;
-                if (prime == last_prime) {
-                    goto found;
-                }
-                if (prime->label) {
-                    tip = g_strdup_printf("PRIME display: %s", prime->label);
-                } else {
-                    tip = g_strdup("PRIME display");
-                }
+            if (prime == last_prime) {
                 goto found;
             }
+            if (prime->label) {
+                tip = g_strdup_printf("PRIME display: %s", prime->label);
+            } else {
+                tip = g_strdup("PRIME display");
+            }
+            goto found;
         }
     }
 
@@ -2773,30 +4002,24 @@ static int click_layout(CtkDisplayLayout *ctk_object,
          NULL, NULL, &state);
 #endif
 
-    /* Look through the Z-order for the next element */
-    for (i = 0; i < ctk_object->Zcount; i++) {
+    /* Look up the top-most element under the click in the Z-order */
+    i = get_zorder_node_at(ctk_object, x, y);
+
+    if (i >= 0) {
         if (ctk_object->Zorder[i].type == ZNODE_TYPE_DISPLAY) {
             display = ctk_object->Zorder[i].u.display;
-            if (point_in_display(display, x, y)) {
-                select_display(ctk_object, display);
-                ctk_object->clicked_outside = 0;
-                break;
-            }
+            select_display(ctk_object, display);
         } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_SCREEN) {
             screen = ctk_object->Zorder[i].u.screen;
-            if (point_in_screen(screen, x, y)) {
-                select_screen(ctk_object, screen);
-                ctk_object->clicked_outside = 0;
-                break;
-            }
+            select_screen(ctk_object, screen);
         } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_PRIME) {
             prime = ctk_object->Zorder[i].u.prime_display;
-            if (point_in_rect(&prime->rect, x, y)) {
-                select_prime_display(ctk_object, prime);
-                ctk_object->clicked_outside = 0;
-                break;
-            }
+            select_prime_display(ctk_object, prime);
         }
+        ctk_object->clicked_outside = 0;
+
+        /* Selecting reorders the Z-order */
+        ctk_object->hit_index.valid = FALSE;
     }
 
     /* Select display's X screen when CTRL is held down on click */
@@ -3217,16 +4440,111 @@ static void draw_hatching(CtkDisplayLayout *ctk_object,
 
 
 
+/** strings_match() ************************************************
+ *
+ * Returns TRUE if both strings are NULL or have the same contents.
+ *
+ **/
+
+static Bool strings_match(const char *str_1, const char *str_2)
+{
+    if (!str_1 || !str_2) {
+        return str_1 == str_2;
+    }
+
+    return strcmp(str_1, str_2) == 0;
+}
+
+
+
+/** new_text_layout() ***********************************************
+ *
+ * Lays out the given text for drawing in the layout image, and returns
+ * its size in pixels.
+ *
+ **/
+
+static PangoLayout *new_text_layout(CtkDisplayLayout *ctk_object,
+                                    const char *str, int *w, int *h)
+{
+    PangoLayout *layout = pango_layout_copy(ctk_object->pango_layout);
+
+    pango_layout_set_text(layout, str, -1);
+    pango_layout_get_pixel_size(layout, w, h);
+
+    return layout;
+
+} /* new_text_layout() */
+
+
+
+/** get_layout_text() ***********************************************
+ *
+ * Returns the cached layout of the given label text, laying the text
+ * out (again) if there is no cache or if the text changed since it was
+ * cached (for example, when the display's mode or name changes).
+ *
+ **/
+
+static LayoutText *get_layout_text(CtkDisplayLayout *ctk_object,
+                                   LayoutText **cache,
+                                   const char *str_1,
+                                   const char *str_2)
+{
+    LayoutText *text = *cache;
+    char *str;
+
+
+    if (text &&
+        strings_match(text->str_1, str_1) &&
+        strings_match(text->str_2, str_2)) {
+        return text;
+    }
+
+    layout_text_free(text);
+
+    text = calloc(1, sizeof(LayoutText));
+    *cache = text;
+    if (!text) {
+        return NULL;
+    }
+
+    text->str_1 = g_strdup(str_1);
+    text->str_2 = g_strdup(str_2);
+
+    if (str_1) {
+        text->layout_1 = new_text_layout(ctk_object, str_1,
+                                         &text->w_1, &text->h_1);
+    }
+
+    if (str_2) {
+        text->layout_2 = new_text_layout(ctk_object, str_2,
+                                         &text->w_2, &text->h_2);
+
+        str = g_strconcat(str_1, "\n", str_2, NULL);
+        text->layout_12 = new_text_layout(ctk_object, str,
+                                          &text->w_12, &text->h_12);
+        g_free(str);
+    }
+
+    return text;
+
+} /* get_layout_text() */
+
+
+
 /** draw_rect_strs() *************************************************
  *
  * Draws possibly 2 rows of text in the middle of a bounding,
  * scaled rectangle.  If the text does not fit, it is not drawn.
+ * The text is laid out once and kept in the given cache.
  *
  **/
 
 static void draw_rect_strs(CtkDisplayLayout *ctk_object,
                            GdkRectangle *rect,
                            GdkColor *color,
+                           LayoutText **cache,
                            const char *str_1,
                            const char *str_2)
 {
@@ -3235,126 +4553,80 @@ static void draw_rect_strs(CtkDisplayLayout *ctk_object,
 #else
     GdkGC *fg_gc;
 #endif
-    char *str;
+    LayoutText *text;
+    PangoLayout *layout;
 
     int txt_w;
     int txt_h;
-    int txt_x, txt_x1, txt_x2;
-    int txt_y, txt_y1, txt_y2;
+    int txt_x;
+    int txt_y;
 
     int draw_1 = 0;
     int draw_2 = 0;
 
     fg_gc = get_drawing_context(ctk_object);
 
-    if (str_1) {
-        pango_layout_set_text(ctk_object->pango_layout, str_1, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
+    text = get_layout_text(ctk_object, cache, str_1, str_2);
+    if (!text) {
+        return;
+    }
 
-        if (txt_w +8 <= ctk_object->scale * rect->width &&
-            txt_h +8 <= ctk_object->scale * rect->height) {
+    if (str_1) {
+        if (text->w_1 +8 <= ctk_object->scale * rect->width &&
+            text->h_1 +8 <= ctk_object->scale * rect->height) {
             draw_1 = 1;
         }
     }
 
     if (str_2) {
-        pango_layout_set_text(ctk_object->pango_layout, str_2, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
-
-        if (txt_w +8 <= ctk_object->scale * rect->width &&
-            txt_h +8 <= ctk_object->scale * rect->height) {
+        if (text->w_2 +8 <= ctk_object->scale * rect->width &&
+            text->h_2 +8 <= ctk_object->scale * rect->height) {
             draw_2 = 1;
         }
 
-        str = g_strconcat(str_1, "\n", str_2, NULL);
-
-        pango_layout_set_text(ctk_object->pango_layout, str, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
-
         if (draw_1 && draw_2 &&
-            txt_h +8 > ctk_object->scale * rect->height) {
+            text->h_12 +8 > ctk_object->scale * rect->height) {
             draw_2 = 0;
         }
-
-        g_free(str);
     }
 
-    if (draw_1 && !draw_2) {
-        pango_layout_set_text(ctk_object->pango_layout, str_1, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
-
-        txt_x1 = ctk_object->scale*(rect->x + rect->width / 2) - (txt_w / 2);
-        txt_y1 = ctk_object->scale*(rect->y + rect->height / 2) - (txt_h / 2);
-
+    if (draw_1 && draw_2) {
+        /* Write both */
+        layout = text->layout_12;
+        txt_w = text->w_12;
+        txt_h = text->h_12;
+    } else if (draw_1) {
         /* Write name */
-        set_drawing_color(fg_gc, color);
-
-#ifdef CTK_GTK3
-        cairo_move_to(fg_gc,
-                      ctk_object->img_dim.x + txt_x1,
-                      ctk_object->img_dim.y + txt_y1);
-        pango_cairo_show_layout(fg_gc, ctk_object->pango_layout);
-#else
-        gdk_draw_layout(ctk_object->pixmap,
-                        fg_gc,
-                        ctk_object->img_dim.x + txt_x1,
-                        ctk_object->img_dim.y + txt_y1,
-                        ctk_object->pango_layout);
-#endif
-    }
-
-    else if (!draw_1 && draw_2) {
-        pango_layout_set_text(ctk_object->pango_layout, str_2, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
-
-        txt_x2 = ctk_object->scale*(rect->x + rect->width / 2) - (txt_w / 2);
-        txt_y2 = ctk_object->scale*(rect->y + rect->height / 2) - (txt_h / 2);
-
+        layout = text->layout_1;
+        txt_w = text->w_1;
+        txt_h = text->h_1;
+    } else if (draw_2) {
         /* Write dimensions */
-        set_drawing_color(fg_gc, color);
-
-#ifdef CTK_GTK3
-        cairo_move_to(fg_gc,
-                      ctk_object->img_dim.x + txt_x2,
-                      ctk_object->img_dim.y + txt_y2);
-        pango_cairo_show_layout(fg_gc, ctk_object->pango_layout);
-#else
-        gdk_draw_layout(ctk_object->pixmap,
-                        fg_gc,
-                        ctk_object->img_dim.x + txt_x2,
-                        ctk_object->img_dim.y + txt_y2,
-                        ctk_object->pango_layout);
-#endif
+        layout = text->layout_2;
+        txt_w = text->w_2;
+        txt_h = text->h_2;
+    } else {
+        return;
     }
 
-    else if (draw_1 && draw_2) {
-        str = g_strconcat(str_1, "\n", str_2, NULL);
-
-        pango_layout_set_text(ctk_object->pango_layout, str, -1);
-        pango_layout_get_pixel_size(ctk_object->pango_layout, &txt_w, &txt_h);
-
-        txt_x = ctk_object->scale*(rect->x + rect->width / 2) - (txt_w / 2);
-        txt_y = ctk_object->scale*(rect->y + rect->height / 2) - (txt_h / 2);
+    txt_x = ctk_object->scale*(rect->x + rect->width / 2) - (txt_w / 2);
+    txt_y = ctk_object->scale*(rect->y + rect->height / 2) - (txt_h / 2);
 
-        /* Write both */
-        set_drawing_color(fg_gc, color);
+    set_drawing_color(fg_gc, color);
 
 #ifdef CTK_GTK3
-        cairo_move_to(fg_gc,
-                      ctk_object->img_dim.x + txt_x,
-                      ctk_object->img_dim.y + txt_y);
-        pango_cairo_show_layout(fg_gc, ctk_object->pango_layout);
+    cairo_move_to(fg_gc,
+                  ctk_object->img_dim.x + txt_x,
+                  ctk_object->img_dim.y + txt_y);
+    pango_cairo_show_layout(fg_gc, layout);
 #else
-        gdk_draw_layout(ctk_object->pixmap,
-                        fg_gc,
-                        ctk_object->img_dim.x + txt_x,
-                        ctk_object->img_dim.y + txt_y,
-                        ctk_object->pango_layout);
+    gdk_draw_layout(ctk_object->pixmap,
+                    fg_gc,
+                    ctk_object->img_dim.x + txt_x,
+                    ctk_object->img_dim.y + txt_y,
+                    layout);
 #endif
 
-        g_free(str);
-    }
-
 } /* draw_rect_strs() */
 
 
@@ -3366,7 +4638,8 @@ static void draw_rect_strs(CtkDisplayLayout *ctk_object,
  **/
 
 static void draw_prime_display(CtkDisplayLayout *ctk_object,
-                       nvPrimeDisplayPtr prime_display)
+                       nvPrimeDisplayPtr prime_display,
+                       LayoutText **text)
 {
     int base_color_idx;
     int color_idx;
@@ -3399,6 +4672,7 @@ static void draw_prime_display(CtkDisplayLayout *ctk_object,
     draw_rect_strs(ctk_object,
                    rect,
                    &(ctk_object->fg_color),
+                   text,
                    tmp_str_name,
                    tmp_str_data);
 
@@ -3415,7 +4689,8 @@ static void draw_prime_display(CtkDisplayLayout *ctk_object,
  **/
 
 static void draw_display(CtkDisplayLayout *ctk_object,
-                         nvDisplayPtr display)
+                         nvDisplayPtr display,
+                         LayoutText **text)
 {
     nvModePtr mode;
     int base_color_idx;
@@ -3473,6 +4748,7 @@ static void draw_display(CtkDisplayLayout *ctk_object,
     draw_rect_strs(ctk_object,
                    &rect,
                    &(ctk_object->fg_color),
+                   text,
                    display->logName,
                    tmp_str);
     g_free(tmp_str);
@@ -3488,7 +4764,8 @@ static void draw_display(CtkDisplayLayout *ctk_object,
  **/
 
 static void draw_screen(CtkDisplayLayout *ctk_object,
-                        nvScreenPtr screen)
+                        nvScreenPtr screen,
+                        LayoutText **text)
 {
 #ifdef CTK_GTK3
     cairo_t *fg_gc;
@@ -3544,6 +4821,7 @@ static void draw_screen(CtkDisplayLayout *ctk_object,
         draw_rect_strs(ctk_object,
                        &(screen->dim),
                        &(ctk_object->fg_color),
+                       text,
                        tmp_str,
                        "(No Scanout)");
         g_free(tmp_str);
@@ -3569,6 +4847,8 @@ static void draw_layout(CtkDisplayLayout *ctk_object)
 
     GdkColor bg_color; /* Background color */
     GdkColor bd_color; /* Border color */
+    GdkRectangle area;
+    ZNode *node;
     int i;
 
     fg_gc = get_drawing_context(ctk_object);
@@ -3576,15 +4856,25 @@ static void draw_layout(CtkDisplayLayout *ctk_object)
     gdk_color_parse("#888888", &bg_color);
     gdk_color_parse("#777777", &bd_color);
 
-    /* Draw the Z-order back to front */
+    /* Draw the Z-order back to front, skipping the items that are
+     * entirely outside of the part of the image being drawn.
+     */
     for (i = ctk_object->Zcount - 1; i >= 0; i--) {
-        if (ctk_object->Zorder[i].type == ZNODE_TYPE_DISPLAY) {
-            draw_display(ctk_object, ctk_object->Zorder[i].u.display);
-        } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_SCREEN) {
-            draw_screen(ctk_object, ctk_object->Zorder[i].u.screen);
-        } else if (ctk_object->Zorder[i].type == ZNODE_TYPE_PRIME) {
-            draw_prime_display(ctk_object,
-                               ctk_object->Zorder[i].u.prime_display);
+        node = &(ctk_object->Zorder[i]);
+
+        if (!get_zorder_node_area(ctk_object, node, &area) ||
+            !gdk_rectangle_intersect(&area, &(ctk_object->paint_area),
+                                     &area)) {
+            continue;
+        }
+
+        if (node->type == ZNODE_TYPE_DISPLAY) {
+            draw_display(ctk_object, node->u.display, &(node->text));
+        } else if (node->type == ZNODE_TYPE_SCREEN) {
+            draw_screen(ctk_object, node->u.screen, &(node->text));
+        } else if (node->type == ZNODE_TYPE_PRIME) {
+            draw_prime_display(ctk_object, node->u.prime_display,
+                               &(node->text));
         }
     }
 
@@ -3801,6 +5091,99 @@ static void clear_layout(CtkDisplayLayout *ctk_object)
 
 
 
+/** draw_frame_times() **********************************************
+ *
+ * Records the time taken to draw the latest frame of the layout image.
+ * If the ShowLayoutFrameTimes config property is set, also draws the
+ * latest, average and worst times of the recent frames, along with the
+ * size of the area that was drawn, in the top left corner of the image.
+ *
+ **/
+
+static void draw_frame_times(CtkDisplayLayout *ctk_object, gint64 frame_time)
+{
+    FrameStats *stats = &(ctk_object->frame_stats);
+#ifdef CTK_GTK3
+    cairo_t *fg_gc;
+#else
+    GdkGC *fg_gc;
+#endif
+    gint64 total = 0;
+    gint64 worst = 0;
+    char *str;
+    int w, h;
+    int i;
+
+
+    stats->times[stats->next] = frame_time;
+    stats->next = (stats->next + 1) % FRAME_STATS_NUM_FRAMES;
+    if (stats->num_frames < FRAME_STATS_NUM_FRAMES) {
+        stats->num_frames++;
+    }
+
+    if (!(ctk_object->ctk_config->conf->booleans &
+          CONFIG_PROPERTIES_SHOW_LAYOUT_FRAME_TIMES)) {
+        memset(&(stats->area), 0, sizeof(stats->area));
+        return;
+    }
+
+    for (i = 0; i < stats->num_frames; i++) {
+        total += stats->times[i];
+        worst = NV_MAX(worst, stats->times[i]);
+    }
+
+    str = g_strdup_printf("Frame: %.2f ms (avg %.2f, max %.2f)\n"
+                          "Drawn: %dx%d",
+                          frame_time / 1000.0,
+                          total / 1000.0 / stats->num_frames,
+                          worst / 1000.0,
+                          ctk_object->paint_area.width,
+                          ctk_object->paint_area.height);
+
+    pango_layout_set_text(ctk_object->pango_layout, str, -1);
+    pango_layout_get_pixel_size(ctk_object->pango_layout, &w, &h);
+    g_free(str);
+
+    stats->area.x = ctk_object->img_dim.x;
+    stats->area.y = ctk_object->img_dim.y;
+    stats->area.width = w + 4;
+    stats->area.height = h + 4;
+
+    fg_gc = get_drawing_context(ctk_object);
+
+    /* Draw the text on the background color so it stays readable */
+    set_drawing_color(fg_gc, &(ctk_object->bg_color));
+
+#ifdef CTK_GTK3
+    cairo_rectangle(fg_gc,
+                    stats->area.x, stats->area.y,
+                    stats->area.width, stats->area.height);
+    cairo_fill(fg_gc);
+#else
+    gdk_draw_rectangle(ctk_object->pixmap,
+                       fg_gc,
+                       TRUE,
+                       stats->area.x, stats->area.y,
+                       stats->area.width, stats->area.height);
+#endif
+
+    set_drawing_color(fg_gc, &(ctk_object->fg_color));
+
+#ifdef CTK_GTK3
+    cairo_move_to(fg_gc, stats->area.x + 2, stats->area.y + 2);
+    pango_cairo_show_layout(fg_gc, ctk_object->pango_layout);
+#else
+    gdk_draw_layout(ctk_object->pixmap,
+                    fg_gc,
+                    stats->area.x + 2,
+                    stats->area.y + 2,
+                    ctk_object->pango_layout);
+#endif
+
+} /* draw_frame_times() */
+
+
+
 /** sync_layout() ****************************************************
  *
  * Recalculates the X screen positions in the layout such that the
@@ -3811,22 +5194,34 @@ static void clear_layout(CtkDisplayLayout *ctk_object)
 static Bool sync_layout(CtkDisplayLayout *ctk_object)
 {
     nvLayoutPtr layout = ctk_object->layout;
-    nvScreenPtr screen;
+    ResolveOrder *ro = &(ctk_object->resolve_order);
     Bool modified = FALSE;
+    int i;
+
 
+    /* Find what needs to be resolved */
+    update_resolve_order(ctk_object);
 
     /* Align all metamodes of each screen */
-    for (screen = layout->screens; screen; screen = screen->next_in_layout) {
-        if (realign_screen(screen)) {
+    for (i = 0; i < ro->num_nodes; i++) {
+        if (!ro->nodes[i].display && ro->nodes[i].dirty &&
+            realign_screen(ro->nodes[i].screen)) {
             modified = TRUE;
         }
     }
 
     /* Resolve final screen positions */
-    calc_layout(layout);
+    calc_layout(ctk_object);
+
+    for (i = 0; i < ro->num_nodes; i++) {
+        ro->nodes[i].dirty = FALSE;
+    }
+    ro->partial = FALSE;
 
     /* Offset layout back to (0,0) */
     if ((layout->dim.x || layout->dim.y) && layout->num_prime_displays == 0) {
+        ctk_object->snap_index.dx -= layout->dim.x;
+        ctk_object->snap_index.dy -= layout->dim.y;
         offset_layout(layout, -layout->dim.x, -layout->dim.y);
         modified = TRUE;
     }
@@ -4866,10 +6261,23 @@ static gboolean
 draw_event_callback(GtkWidget *widget, cairo_t *cr, gpointer data)
 {
     CtkDisplayLayout *ctk_object = CTK_DISPLAY_LAYOUT(data);
+    gint64 start = g_get_monotonic_time();
+
+    /* Only draw what GTK asked to have redrawn */
+    if (!gdk_cairo_get_clip_rectangle(cr, &(ctk_object->paint_area))) {
+        GtkAllocation allocation;
+
+        ctk_widget_get_allocation(widget, &allocation);
+        ctk_object->paint_area.x = 0;
+        ctk_object->paint_area.y = 0;
+        ctk_object->paint_area.width = allocation.width;
+        ctk_object->paint_area.height = allocation.height;
+    }
 
     ctk_object->c_context = cr;
     clear_layout(ctk_object);
     draw_layout(ctk_object);
+    draw_frame_times(ctk_object, g_get_monotonic_time() - start);
     ctk_object->c_context = NULL;
 
     return TRUE;
@@ -4889,21 +6297,31 @@ expose_event_callback(GtkWidget *widget, GdkEventExpose *event, gpointer data)
     CtkDisplayLayout *ctk_object = CTK_DISPLAY_LAYOUT(data);
     GdkGC *fg_gc = get_drawing_context(ctk_object);
     GdkGCValues old_gc_values;
+    gint64 start;
 
 
     if (event->count || !ctk_widget_get_window(widget) || !fg_gc) {
         return TRUE;
     }
 
-    /* Redraw the layout */
+    /* Redraw the exposed part of the layout; the rest of the pixmap
+     * still holds what was drawn before.
+     */
+    start = g_get_monotonic_time();
+
     gdk_window_begin_paint_rect(ctk_widget_get_window(widget), &event->area);
 
     gdk_gc_get_values(fg_gc, &old_gc_values);
+    gdk_gc_set_clip_rectangle(fg_gc, &event->area);
+    ctk_object->paint_area = event->area;
 
     clear_layout(ctk_object);
 
     draw_layout(ctk_object);
 
+    draw_frame_times(ctk_object, g_get_monotonic_time() - start);
+
+    gdk_gc_set_clip_rectangle(fg_gc, NULL);
     gdk_gc_set_values(fg_gc, &old_gc_values, GDK_GC_FOREGROUND);
 
     gdk_draw_drawable(widget->window,
@@ -5030,8 +6448,10 @@ motion_event_callback(GtkWidget *widget, GdkEventMotion *event, gpointer data)
                                               ctk_object->modified_callback_data);
             }
 
-            /* Queue and process expose event so we redraw ASAP */
-            queue_layout_redraw(ctk_object);
+            /* Queue and process expose event so we redraw ASAP, only
+             * repainting what moved.
+             */
+            queue_layout_damage(ctk_object);
             gdk_window_process_updates(ctk_widget_get_window(drawing_area), TRUE);
         }
 
@@ -473,6 +473,26 @@ typedef struct ModifyInfoRec {
 
 
 
+/* Label text of a display, X screen or PRIME display, laid out once and
+ * reused for drawing until the text changes.
+ */
+typedef struct _LayoutText
+{
+    char *str_1;
+    char *str_2;
+
+    PangoLayout *layout_1;  /* str_1 alone */
+    PangoLayout *layout_2;  /* str_2 alone */
+    PangoLayout *layout_12; /* str_1 and str_2 on two lines */
+
+    int w_1, h_1;
+    int w_2, h_2;
+    int w_12, h_12;
+
+} LayoutText;
+
+
+
 // Something selectable/visible.
 typedef struct _ZNode
 {
@@ -488,9 +508,119 @@ typedef struct _ZNode
         nvPrimeDisplayPtr prime_display;
     } u;
 
+    GdkRectangle area;  /* Drawing area last queued for redraw */
+    LayoutText *text;   /* Cached label text */
+
 } ZNode;
 
 
+/* The X screens and displays (in their current modes) of the layout, in
+ * the order in which their relative positions are resolved: the displays
+ * of each X screen after the display they are positioned relative to,
+ * followed by the X screen, after the X screen it is positioned relative
+ * to.  The order is checked against the layout before each use and
+ * rebuilt when a relative position changes.  Items whose relative
+ * positions form a loop are left where they are.
+ */
+typedef struct _ResolveNode
+{
+    nvScreenPtr  screen;   /* X screen (of the display) */
+    nvDisplayPtr display;  /* Display, or NULL for the X screen node */
+    nvModePtr    mode;     /* Display's current mode when ordered */
+    void *relative_to;     /* Position dependency when ordered, if any */
+    int   parent;          /* Node positioned relative to, or -1 */
+    Bool  in_loop;         /* Part of a loop of relative positions */
+    Bool  dirty;           /* Needs to be resolved */
+
+} ResolveNode;
+
+typedef struct _ResolveOrder
+{
+    Bool valid;
+    Bool partial; /* Only resolve the dirty nodes and their dependants */
+
+    ResolveNode *nodes; /* In resolving order */
+    int num_nodes;
+
+} ResolveOrder;
+
+
+
+/* Times taken to draw the most recent frames of the layout image */
+#define FRAME_STATS_NUM_FRAMES 64
+
+typedef struct _FrameStats
+{
+    gint64 times[FRAME_STATS_NUM_FRAMES]; /* In microseconds */
+    int next;
+    int num_frames;
+
+    GdkRectangle area; /* Where the overlay was last drawn */
+
+} FrameStats;
+
+
+
+/* Index of the edges and midlines of the displays, X screens and PRIME
+ * displays that the item being moved or panned may snap to, so that
+ * snapping does not need to test every item in the layout.  The index is
+ * built at the start of each move/pan of an X screen (or one of its
+ * displays); items that may move along with it are not indexed, but are
+ * always tested.
+ */
+typedef struct _SnapEdge
+{
+    int pos;    /* Coordinate of the edge or midline */
+    int target; /* Index of the item in SnapIndex.targets */
+
+} SnapEdge;
+
+enum {
+    SNAP_EDGES_H = 0,   /* Left and right edges */
+    SNAP_MIDLINES_H,    /* Vertical midlines */
+    SNAP_EDGES_V,       /* Top and bottom edges */
+    SNAP_MIDLINES_V,    /* Horizontal midlines */
+    SNAP_NUM_EDGE_LISTS
+};
+
+typedef struct _SnapIndex
+{
+    Bool valid;
+    nvScreenPtr screen; /* X screen being modified when the index was built */
+    int dx, dy;         /* Offset applied to the layout since then */
+
+    ZNode *targets;     /* Items that may be snapped to, in snapping order */
+    int    num_targets;
+    int   *moving;      /* Targets that are not indexed */
+    int    num_moving;
+
+    SnapEdge *edges[SNAP_NUM_EDGE_LISTS]; /* Sorted by position */
+    int       num_edges[SNAP_NUM_EDGE_LISTS];
+
+    int          *candidates; /* Targets found by the last lookup */
+    unsigned int *stamps;     /* Lookup in which a target was last found */
+    unsigned int  stamp;
+
+} SnapIndex;
+
+
+/* Grid over the layout listing, for each cell, the (Z-order indices of
+ * the) items that overlap it, in Z-order.  Used to find the item under the
+ * mouse without testing every item in the layout.
+ */
+typedef struct _HitIndex
+{
+    Bool valid;
+    GdkRectangle dim;   /* Area covered by the grid */
+    int cols, rows;
+    int cell_width, cell_height;
+
+    int *cells;         /* Start of each cell's list in nodes, plus the end */
+    int *nodes;
+
+} HitIndex;
+
+
 typedef struct _CtkDisplayLayout
 {
     GtkVBox parent;
@@ -516,6 +646,7 @@ typedef struct _CtkDisplayLayout
     /* Image information */
     GdkRectangle img_dim;
     float scale;
+    GdkRectangle paint_area; /* Part of the image being drawn */
 
     /* Colors */
     GdkColor  *color_palettes;  /* Colors to use to display screens */
@@ -531,6 +662,14 @@ typedef struct _CtkDisplayLayout
     ZNode *Zorder; /* Z ordering of visible elements in layout */
     int    Zcount; /* Count of visible elements in the z order */
 
+    SnapIndex snap_index; /* Edges of what the modified item may snap to */
+    HitIndex  hit_index;  /* Items of the Z-order by location */
+
+    ResolveOrder resolve_order; /* Order of relative position resolution */
+
+    /* Frame times, for the debug overlay */
+    FrameStats frame_stats;
+
     nvDisplayPtr  selected_display; /* Currently selected display */
     nvScreenPtr   selected_screen;  /* Selected screen */
     nvPrimeDisplayPtr selected_prime_display;  /* Selected Prime display */
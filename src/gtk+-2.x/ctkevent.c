@@ -28,6 +28,7 @@
  *   NV-CONTROL -> event -> glib -> CtkEvent -> signal -> GUI
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <gtk/gtk.h>
@@ -68,6 +69,41 @@ static guint binary_signals[NV_CTRL_BINARY_DATA_LAST_ATTRIBUTE + 1];
 static guint string_signals[NV_CTRL_STRING_LAST_ATTRIBUTE + 1];
 static guint signals[NV_CTRL_LAST_ATTRIBUTE + 1];
 static guint signal_RRScreenChangeNotify;
+static guint signal_SampleNotify;
+static guint signal_HistoryNotify;
+
+/*
+ * Attribute sampled periodically on behalf of the pages of a GPU; see
+ * ctk_event_sample()
+ */
+struct _CtkEventSample {
+    CtrlTarget *ctrl_target;
+    int attribute;
+    CtrlAttributeType type;
+    int refcount;
+
+    gboolean sampled;
+    ReturnStatus status;
+    int value;
+    unsigned char *data;   /* string or binary data */
+    int len;
+
+    struct _CtkEventSample *next;
+};
+
+/*
+ * History of an integer attribute, or of an integer field of a binary
+ * data attribute, recorded on every tick of ctk_event_sample(); see
+ * ctk_event_add_history()
+ */
+struct _CtkEventHistory {
+    CtkEventSample *sample;
+    size_t offset;
+
+    gint *values;   /* CTK_EVENT_HISTORY_LENGTH entries, indexed by tick */
+
+    struct _CtkEventHistory *next;
+};
 
 /* List of event sources to track (one per dpy) */
 CtkEventSource *event_sources = NULL;
@@ -400,6 +436,22 @@ static void ctk_event_class_init(CtkEventClass *ctk_event_class,
                      g_cclosure_marshal_VOID__POINTER,
                      G_TYPE_NONE, 1, G_TYPE_POINTER);
 
+    /* Make the signal emitted when sampled attributes change */
+    signal_SampleNotify =
+        g_signal_new("CTK_EVENT_SampleNotify",
+                     G_OBJECT_CLASS_TYPE(ctk_event_class),
+                     G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                     g_cclosure_marshal_VOID__POINTER,
+                     G_TYPE_NONE, 1, G_TYPE_POINTER);
+
+    /* Make the signal emitted when histories are recorded */
+    signal_HistoryNotify =
+        g_signal_new("CTK_EVENT_HistoryNotify",
+                     G_OBJECT_CLASS_TYPE(ctk_event_class),
+                     G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                     g_cclosure_marshal_VOID__POINTER,
+                     G_TYPE_NONE, 1, G_TYPE_POINTER);
+
 
 } /* ctk_event_class_init */
 
@@ -600,6 +652,8 @@ GObject *ctk_event_new(CtrlTarget *ctrl_target)
 void ctk_event_destroy(GObject *object)
 {
     CtkEvent *ctk_event;
+    CtkEventSample *sample;
+    CtkEventHistory *history;
 
     if (object == NULL || !CTK_IS_EVENT(object)) {
         return;
@@ -607,6 +661,22 @@ void ctk_event_destroy(GObject *object)
 
     ctk_event = CTK_EVENT(object);
 
+    /* Free the histories, and the sampled attributes */
+
+    while (ctk_event->histories) {
+        history = ctk_event->histories;
+        ctk_event->histories = history->next;
+        g_free(history->values);
+        g_free(history);
+    }
+
+    while (ctk_event->samples) {
+        sample = ctk_event->samples;
+        ctk_event->samples = sample->next;
+        free(sample->data);
+        g_free(sample);
+    }
+
     /* Unregister to stop receiving (dpy) events */
 
     ctk_event_unregister_source(ctk_event);
@@ -851,7 +921,361 @@ void ctk_event_emit_string(CtkEvent *ctk_event,
 
     event.str_attr.attribute = attrib;
 
-    CTK_EVENT_BROADCAST(source, signals[attrib], &event);
+    CTK_EVENT_BROADCAST(source, string_signals[attrib], &event);
 
 } /* ctk_event_emit_string() */
 
+
+
+/*
+ * Attribute sampling
+ *
+ * Pages that monitor changing values (temperatures, fan speeds, clocks,
+ * utilization) register the attributes they display with the CtkEvent
+ * of their GPU while they are visible, and unregister them when hidden.
+ * ctk_event_sample(), run from the GPU's monitor timer, then queries
+ * each registered attribute once per tick, no matter how many pages
+ * display it, and emits the "CTK_EVENT_SampleNotify" signal when any of
+ * the values changed.  The pages read the values back with
+ * ctk_event_get_sample(), ctk_event_get_string_sample() and
+ * ctk_event_get_binary_sample().
+ *
+ * Values that are graphed over time are also recorded into fixed size
+ * histories on every tick, whether or not any page displays them, so that
+ * a graph is complete when its page is shown; see ctk_event_add_history().
+ */
+
+static CtkEventSample *find_sample(CtkEvent *ctk_event,
+                                   CtrlTarget *ctrl_target,
+                                   int attrib, CtrlAttributeType type)
+{
+    CtkEventSample *sample;
+
+    for (sample = ctk_event->samples; sample; sample = sample->next) {
+        if (sample->ctrl_target == ctrl_target &&
+            sample->attribute == attrib &&
+            sample->type == type) {
+            return sample;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/* ctk_event_add_sample() - Adds the attribute of the given target (the
+ * GPU of the ctk_event, or one of its coolers or thermal sensors) to the
+ * attributes sampled by ctk_event_sample().  Registrations are counted;
+ * each call should be paired with a call to ctk_event_remove_sample().
+ */
+void ctk_event_add_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                          int attrib, CtrlAttributeType type)
+{
+    CtkEventSample *sample;
+
+    sample = find_sample(ctk_event, ctrl_target, attrib, type);
+    if (sample) {
+        sample->refcount++;
+        return;
+    }
+
+    sample = g_malloc0(sizeof(CtkEventSample));
+    sample->ctrl_target = ctrl_target;
+    sample->attribute = attrib;
+    sample->type = type;
+    sample->refcount = 1;
+
+    sample->next = ctk_event->samples;
+    ctk_event->samples = sample;
+
+} /* ctk_event_add_sample() */
+
+
+
+void ctk_event_remove_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                             int attrib, CtrlAttributeType type)
+{
+    CtkEventSample **prev;
+    CtkEventSample *sample;
+
+    for (prev = &ctk_event->samples; *prev; prev = &(*prev)->next) {
+        sample = *prev;
+        if (sample->ctrl_target == ctrl_target &&
+            sample->attribute == attrib &&
+            sample->type == type) {
+
+            if (--sample->refcount == 0) {
+                *prev = sample->next;
+                free(sample->data);
+                g_free(sample);
+            }
+            return;
+        }
+    }
+
+} /* ctk_event_remove_sample() */
+
+
+
+/* ctk_event_get_sample() - Returns the last sampled value of an integer
+ * attribute.  Attributes that are not sampled (or not sampled yet) are
+ * queried directly, so callers can use this in place of
+ * NvCtrlGetAttribute() whether or not their page is visible.
+ */
+ReturnStatus ctk_event_get_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                                  int attrib, int *value)
+{
+    CtkEventSample *sample;
+
+    sample = find_sample(ctk_event, ctrl_target, attrib,
+                         CTRL_ATTRIBUTE_TYPE_INTEGER);
+    if (!sample || !sample->sampled) {
+        return NvCtrlGetAttribute(ctrl_target, attrib, value);
+    }
+
+    if (sample->status == NvCtrlSuccess) {
+        *value = sample->value;
+    }
+
+    return sample->status;
+
+} /* ctk_event_get_sample() */
+
+
+
+/* ctk_event_get_string_sample() - Like ctk_event_get_sample(), for string
+ * attributes.  On success, str is set to a copy of the value that the
+ * caller should free().
+ */
+ReturnStatus ctk_event_get_string_sample(CtkEvent *ctk_event,
+                                         CtrlTarget *ctrl_target,
+                                         int attrib, char **str)
+{
+    CtkEventSample *sample;
+
+    sample = find_sample(ctk_event, ctrl_target, attrib,
+                         CTRL_ATTRIBUTE_TYPE_STRING);
+    if (!sample || !sample->sampled) {
+        return NvCtrlGetStringAttribute(ctrl_target, attrib, str);
+    }
+
+    if (sample->status == NvCtrlSuccess) {
+        *str = sample->data ? strdup((const char *) sample->data) : NULL;
+        if (!*str) {
+            return NvCtrlError;
+        }
+    }
+
+    return sample->status;
+
+} /* ctk_event_get_string_sample() */
+
+
+
+/* ctk_event_get_binary_sample() - Like ctk_event_get_sample(), for binary
+ * data attributes.  On success, data is set to a copy of the value that
+ * the caller should free().
+ */
+ReturnStatus ctk_event_get_binary_sample(CtkEvent *ctk_event,
+                                         CtrlTarget *ctrl_target,
+                                         int attrib,
+                                         unsigned char **data, int *len)
+{
+    CtkEventSample *sample;
+
+    sample = find_sample(ctk_event, ctrl_target, attrib,
+                         CTRL_ATTRIBUTE_TYPE_BINARY_DATA);
+    if (!sample || !sample->sampled) {
+        return NvCtrlGetBinaryAttribute(ctrl_target, 0, attrib, data, len);
+    }
+
+    if (sample->status == NvCtrlSuccess) {
+        *data = sample->data ? malloc(sample->len) : NULL;
+        if (!*data) {
+            return NvCtrlError;
+        }
+        memcpy(*data, sample->data, sample->len);
+        if (len) {
+            *len = sample->len;
+        }
+    }
+
+    return sample->status;
+
+} /* ctk_event_get_binary_sample() */
+
+
+
+/*
+ * record_histories() - Store the current value of each history at the
+ * index of the current tick.
+ */
+static void record_histories(CtkEvent *ctk_event)
+{
+    CtkEventHistory *history;
+    CtkEventSample *sample;
+    guint index = ctk_event->history_serial % CTK_EVENT_HISTORY_LENGTH;
+    gint value;
+
+    for (history = ctk_event->histories; history; history = history->next) {
+        sample = history->sample;
+        value = CTK_EVENT_HISTORY_NO_DATA;
+
+        if (sample->sampled && sample->status == NvCtrlSuccess) {
+            if (sample->type == CTRL_ATTRIBUTE_TYPE_INTEGER) {
+                value = sample->value;
+            } else if (sample->data && history->offset + sizeof(gint) <=
+                                       (size_t) sample->len) {
+                memcpy(&value, sample->data + history->offset, sizeof(gint));
+            }
+        }
+
+        history->values[index] = value;
+    }
+
+    ctk_event->history_serial++;
+}
+
+
+
+/* ctk_event_sample() - Timer callback that queries all sampled attributes
+ * of the ctk_event once, and notifies the pages when any value changed.
+ */
+gboolean ctk_event_sample(gpointer user_data)
+{
+    CtkEvent *ctk_event = CTK_EVENT(user_data);
+    CtkEventSample *sample;
+    ReturnStatus status;
+    gboolean changed = FALSE;
+    unsigned char *data;
+    int value, len;
+
+    for (sample = ctk_event->samples; sample; sample = sample->next) {
+
+        if (sample->type == CTRL_ATTRIBUTE_TYPE_INTEGER) {
+            status = NvCtrlGetAttribute(sample->ctrl_target,
+                                        sample->attribute, &value);
+            if (sample->sampled && sample->status == status &&
+                (status != NvCtrlSuccess || sample->value == value)) {
+                continue;
+            }
+            sample->value = value;
+        } else {
+            data = NULL;
+            len = 0;
+            if (sample->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+                status = NvCtrlGetStringAttribute(sample->ctrl_target,
+                                                  sample->attribute,
+                                                  (char **) &data);
+                if (status == NvCtrlSuccess && data) {
+                    len = strlen((const char *) data) + 1;
+                }
+            } else {
+                status = NvCtrlGetBinaryAttribute(sample->ctrl_target, 0,
+                                                  sample->attribute,
+                                                  &data, &len);
+            }
+            if (status == NvCtrlSuccess && sample->sampled &&
+                sample->status == NvCtrlSuccess && data && sample->data &&
+                len == sample->len && memcmp(data, sample->data, len) == 0) {
+                free(data);
+                continue;
+            }
+            if (status != NvCtrlSuccess && sample->sampled &&
+                sample->status == status) {
+                continue;
+            }
+            free(sample->data);
+            if (status == NvCtrlSuccess) {
+                sample->data = data;
+                sample->len = len;
+            } else {
+                sample->data = NULL;
+                sample->len = 0;
+            }
+        }
+
+        sample->status = status;
+        sample->sampled = TRUE;
+        changed = TRUE;
+    }
+
+    if (changed) {
+        g_signal_emit(ctk_event, signal_SampleNotify, 0, NULL);
+    }
+
+    if (ctk_event->histories) {
+        record_histories(ctk_event);
+        g_signal_emit(ctk_event, signal_HistoryNotify, 0, NULL);
+    }
+
+    return TRUE;
+
+} /* ctk_event_sample() */
+
+
+
+/* ctk_event_add_history() - Records the value of an integer attribute of
+ * the given target (or, for binary data attributes, the integer at the
+ * given offset of the data) on every tick of ctk_event_sample(), for as
+ * long as the ctk_event exists.  Histories are kept in fixed size ring
+ * buffers of CTK_EVENT_HISTORY_LENGTH ticks, allocated here; adding the
+ * same history again returns the existing one.
+ */
+CtkEventHistory *ctk_event_add_history(CtkEvent *ctk_event,
+                                       CtrlTarget *ctrl_target,
+                                       int attrib, CtrlAttributeType type,
+                                       size_t offset)
+{
+    CtkEventHistory *history;
+    CtkEventSample *sample;
+    int i;
+
+    sample = find_sample(ctk_event, ctrl_target, attrib, type);
+
+    for (history = ctk_event->histories; history; history = history->next) {
+        if (sample && history->sample == sample &&
+            history->offset == offset) {
+            return history;
+        }
+    }
+
+    /* The history keeps its attribute sampled */
+
+    ctk_event_add_sample(ctk_event, ctrl_target, attrib, type);
+
+    history = g_malloc0(sizeof(CtkEventHistory));
+    history->sample = find_sample(ctk_event, ctrl_target, attrib, type);
+    history->offset = offset;
+    history->values = g_malloc(CTK_EVENT_HISTORY_LENGTH * sizeof(gint));
+    for (i = 0; i < CTK_EVENT_HISTORY_LENGTH; i++) {
+        history->values[i] = CTK_EVENT_HISTORY_NO_DATA;
+    }
+
+    history->next = ctk_event->histories;
+    ctk_event->histories = history;
+
+    return history;
+
+} /* ctk_event_add_history() */
+
+
+
+/* ctk_event_get_history_value() - Returns the value of the history that
+ * was recorded on the given tick, or CTK_EVENT_HISTORY_NO_DATA if the
+ * value could not be queried then or the tick is no longer (or not yet)
+ * in the history.  Ticks are numbered from 0; ctk_event->history_serial
+ * is the number of ticks recorded so far.
+ */
+gint ctk_event_get_history_value(CtkEvent *ctk_event,
+                                 CtkEventHistory *history, guint64 tick)
+{
+    if (tick >= ctk_event->history_serial ||
+        ctk_event->history_serial - tick > CTK_EVENT_HISTORY_LENGTH) {
+        return CTK_EVENT_HISTORY_NO_DATA;
+    }
+
+    return history->values[tick % CTK_EVENT_HISTORY_LENGTH];
+
+} /* ctk_event_get_history_value() */
@@ -46,11 +46,23 @@ G_BEGIN_DECLS
 
 typedef struct _CtkEvent       CtkEvent;
 typedef struct _CtkEventClass  CtkEventClass;
+typedef struct _CtkEventSample CtkEventSample;
+typedef struct _CtkEventHistory CtkEventHistory;
+
+/* Number of ticks of the GPU monitor kept in each history */
+#define CTK_EVENT_HISTORY_LENGTH 300
+
+#define CTK_EVENT_HISTORY_NO_DATA G_MININT
 
 struct _CtkEvent
 {
     GObject     parent;
     CtrlTarget *ctrl_target;
+
+    CtkEventSample *samples;
+
+    CtkEventHistory *histories;
+    guint64 history_serial;   /* number of ticks recorded in the histories */
 };
 
 struct _CtkEventClass
@@ -67,6 +79,28 @@ void ctk_event_emit(CtkEvent *ctk_event,
 void ctk_event_emit_string(CtkEvent *ctk_event,
                     unsigned int mask, int attrib);
 
+void ctk_event_add_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                          int attrib, CtrlAttributeType type);
+void ctk_event_remove_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                             int attrib, CtrlAttributeType type);
+ReturnStatus ctk_event_get_sample(CtkEvent *ctk_event, CtrlTarget *ctrl_target,
+                                  int attrib, int *value);
+ReturnStatus ctk_event_get_string_sample(CtkEvent *ctk_event,
+                                         CtrlTarget *ctrl_target,
+                                         int attrib, char **str);
+ReturnStatus ctk_event_get_binary_sample(CtkEvent *ctk_event,
+                                         CtrlTarget *ctrl_target,
+                                         int attrib,
+                                         unsigned char **data, int *len);
+gboolean ctk_event_sample(gpointer user_data);
+
+CtkEventHistory *ctk_event_add_history(CtkEvent *ctk_event,
+                                       CtrlTarget *ctrl_target,
+                                       int attrib, CtrlAttributeType type,
+                                       size_t offset);
+gint ctk_event_get_history_value(CtkEvent *ctk_event,
+                                 CtkEventHistory *history, guint64 tick);
+
 #define CTK_EVENT_NAME(x) ("CTK_EVENT_" #x)
 
 
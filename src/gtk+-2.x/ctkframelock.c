@@ -46,6 +46,7 @@
 #include "parse.h"
 #include "msg.h"
 #include "common-utils.h"
+#include "framelock-monitor.h"
 
 
 #define DEFAULT_UPDATE_STATUS_TIME_INTERVAL       1000
@@ -209,6 +210,8 @@ struct _nvGPUDataRec {
     GtkWidget *timing_hbox; /* LED */
 
     GtkWidget *label;
+
+    CtrlAttributeQuery status[GPU_STATUS_COUNT];
 };
 
 struct _nvFrameLockDataRec {
@@ -247,6 +250,8 @@ struct _nvFrameLockDataRec {
     const char *board_name;
 
     GtkWidget  *extra_info_hbox;
+
+    CtrlAttributeQuery status[FRAMELOCK_STATUS_COUNT];
 };
 
 
@@ -436,6 +441,15 @@ static void label_set_text(
     const char *text
 )
 {
+    const gchar *current = g_object_get_data(G_OBJECT(label), "ctk-text");
+
+    /* Avoid relayouts of labels whose text did not change */
+    if (current && !strcmp(current, text)) {
+        return;
+    }
+    g_object_set_data_full(G_OBJECT(label), "ctk-text", g_strdup(text),
+                           g_free);
+
 #ifdef CTK_GTK3
     GtkStyleContext *context;
     GdkRGBA text_color = {0};
@@ -874,10 +888,16 @@ static GtkWidget *my_toggle_button_new_with_label(const gchar *txt,
 /** update_image() ***************************************************
  *
  * Updates the container to hold a duplicate of the given image.
+ * Nothing is done if the container already shows that image.
  *
  */
 static void update_image(GtkWidget *container, GdkPixbuf *new_pixbuf)
 {
+    if (g_object_get_data(G_OBJECT(container), "ctk-pixbuf") == new_pixbuf) {
+        return;
+    }
+    g_object_set_data(G_OBJECT(container), "ctk-pixbuf", new_pixbuf);
+
     ctk_empty_container(container);
 
     gtk_box_pack_start(GTK_BOX(container),
@@ -3670,6 +3690,122 @@ static void toggle_detect_video_mode(GtkToggleButton *button,
 
 
 
+/** is_remote_target() ***********************************************
+ *
+ * Returns whether the target lives on an X Server other than the one
+ * this page was created for.  The status of remote targets is sampled
+ * in the background by the frame lock monitor, so that a slow or
+ * unreachable X Server cannot stall the GUI.
+ *
+ */
+static gboolean is_remote_target(CtkFramelock *ctk_framelock,
+                                 const CtrlTarget *ctrl_target)
+{
+    return ctrl_target->system != ctk_framelock->ctrl_target->system;
+}
+
+
+
+/** copy_monitor_status() ********************************************
+ *
+ * Copies status attributes sampled by the frame lock monitor.  A NULL
+ * source (the X Server is unreachable, or the target went away) marks
+ * every attribute as unavailable.
+ *
+ */
+static void copy_monitor_status(CtrlAttributeQuery *status,
+                                const CtrlAttributeQuery *sampled,
+                                int count)
+{
+    int i;
+
+    if (sampled) {
+        memcpy(status, sampled, count * sizeof(*status));
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        status[i].val = 0;
+        status[i].status = NvCtrlError;
+    }
+}
+
+
+
+/** query_framelock_status() *****************************************
+ *
+ * Refreshes the cached dynamic status attributes of a frame lock
+ * board.  Local boards are queried as a single batch, so the whole
+ * board costs one round trip to the X Server; remote boards are read
+ * from the last sample taken by the frame lock monitor.  Until the
+ * first sample of a remote X Server is in, the previous values are
+ * kept.
+ *
+ */
+static void query_framelock_status(CtkFramelock *ctk_framelock,
+                                   nvFrameLockDataPtr data)
+{
+    FrameLockHostStatus *host;
+
+    if (!is_remote_target(ctk_framelock, data->ctrl_target)) {
+        nv_framelock_query_board_status(data->ctrl_target, data->status);
+        return;
+    }
+
+    if (!ctk_framelock->monitor) return;
+
+    host = nv_framelock_monitor_get_status(ctk_framelock->monitor,
+                                           data->ctrl_target->system->display);
+    if (!host) return;
+
+    if (host->state != FRAMELOCK_HOST_CONNECTING) {
+        int id = NvCtrlGetTargetId(data->ctrl_target);
+        const FrameLockBoardStatus *board =
+            nv_framelock_find_board_status(host, id);
+
+        copy_monitor_status(data->status, board ? board->status : NULL,
+                            FRAMELOCK_STATUS_COUNT);
+    }
+
+    nv_framelock_monitor_release_status(ctk_framelock->monitor, host);
+}
+
+
+
+/** query_gpu_status() ***********************************************
+ *
+ * Refreshes the cached dynamic status attributes of a GPU, the same
+ * way query_framelock_status() does for frame lock boards.
+ *
+ */
+static void query_gpu_status(CtkFramelock *ctk_framelock, nvGPUDataPtr data)
+{
+    FrameLockHostStatus *host;
+
+    if (!is_remote_target(ctk_framelock, data->ctrl_target)) {
+        nv_framelock_query_gpu_status(data->ctrl_target, data->status);
+        return;
+    }
+
+    if (!ctk_framelock->monitor) return;
+
+    host = nv_framelock_monitor_get_status(ctk_framelock->monitor,
+                                           data->ctrl_target->system->display);
+    if (!host) return;
+
+    if (host->state != FRAMELOCK_HOST_CONNECTING) {
+        int id = NvCtrlGetTargetId(data->ctrl_target);
+        const FrameLockGpuStatus *gpu = nv_framelock_find_gpu_status(host, id);
+
+        copy_monitor_status(data->status, gpu ? gpu->status : NULL,
+                            GPU_STATUS_COUNT);
+    }
+
+    nv_framelock_monitor_release_status(ctk_framelock->monitor, host);
+}
+
+
+
 /** list_entry_update_framelock_status() *****************************
  *
  * Updates the dynamic state of the GUI for a frame lock list entry by
@@ -3680,7 +3816,6 @@ static void list_entry_update_framelock_status(CtkFramelock *ctk_framelock,
                                                nvListEntryPtr entry)
 {
     nvFrameLockDataPtr data = (nvFrameLockDataPtr)(entry->data);
-    CtrlTarget *ctrl_target = data->ctrl_target;
     gint rate, delay, house, port0, port1;
     gchar str[32];
     gfloat fvalue;
@@ -3689,13 +3824,14 @@ static void list_entry_update_framelock_status(CtkFramelock *ctk_framelock,
     gboolean use_house_sync_input;
     gboolean framelock_enabled;
     gboolean is_server;
-    ReturnStatus ret;
-    
     
-    NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_SYNC_DELAY, &delay);
-    NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_HOUSE_STATUS, &house);
-    NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_PORT0_STATUS, &port0);
-    NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_PORT1_STATUS, &port1);
+
+    query_framelock_status(ctk_framelock, data);
+
+    delay = data->status[FRAMELOCK_STATUS_SYNC_DELAY].val;
+    house = data->status[FRAMELOCK_STATUS_HOUSE].val;
+    port0 = data->status[FRAMELOCK_STATUS_PORT0].val;
+    port1 = data->status[FRAMELOCK_STATUS_PORT1].val;
 
     use_house_sync_input = gtk_combo_box_get_active
         (GTK_COMBO_BOX(ctk_framelock->house_sync_mode_combo)) ==
@@ -3712,9 +3848,7 @@ static void list_entry_update_framelock_status(CtkFramelock *ctk_framelock,
         gtk_widget_set_sensitive(data->receiving_label, FALSE);
         update_image(data->receiving_hbox, ctk_framelock->led_grey_pixbuf);
     } else {
-        gint receiving;
-        NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_SYNC_READY,
-                           &receiving);
+        gint receiving = data->status[FRAMELOCK_STATUS_SYNC_READY].val;
         gtk_widget_set_sensitive(data->receiving_label, TRUE);
         update_image(data->receiving_hbox,
                      (receiving ? ctk_framelock->led_green_pixbuf :
@@ -3725,12 +3859,11 @@ static void list_entry_update_framelock_status(CtkFramelock *ctk_framelock,
     gtk_widget_set_sensitive(data->rate_label, framelock_enabled);
     gtk_widget_set_sensitive(data->rate_text, framelock_enabled);
 
-    ret =
-        NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_SYNC_RATE_4, &rate);
-    if (ret == NvCtrlSuccess) {
+    if (data->status[FRAMELOCK_STATUS_SYNC_RATE_4].status == NvCtrlSuccess) {
+        rate = data->status[FRAMELOCK_STATUS_SYNC_RATE_4].val;
         snprintf(str, 32, "%d.%.4d Hz", (rate / 10000), (rate % 10000));
     } else {
-        NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_SYNC_RATE, &rate);
+        rate = data->status[FRAMELOCK_STATUS_SYNC_RATE].val;
         snprintf(str, 32, "%d.%.3d Hz", (rate / 1000), (rate % 1000));
     }
     label_set_text(data->rate_text, str);
@@ -3747,10 +3880,9 @@ static void list_entry_update_framelock_status(CtkFramelock *ctk_framelock,
     gtk_widget_set_sensitive(data->house_sync_rate_label, framelock_enabled);
     gtk_widget_set_sensitive(data->house_sync_rate_text, framelock_enabled);
 
-    ret = NvCtrlGetAttribute(ctrl_target,
-                             NV_CTRL_FRAMELOCK_INCOMING_HOUSE_SYNC_RATE,
-                             &rate);
-    if (ret == NvCtrlSuccess) {
+    if (data->status[FRAMELOCK_STATUS_HOUSE_SYNC_RATE].status ==
+        NvCtrlSuccess) {
+        rate = data->status[FRAMELOCK_STATUS_HOUSE_SYNC_RATE].val;
         snprintf(str, 32, "%d.%.4d Hz", (rate / 10000), (rate % 10000));
     } else {
         snprintf(str, 32, "Unknown");
@@ -3803,13 +3935,14 @@ static void list_entry_update_gpu_status(CtkFramelock *ctk_framelock,
         (GTK_COMBO_BOX(ctk_framelock->house_sync_mode_combo)) ==
         NV_CTRL_USE_HOUSE_SYNC_INPUT;
 
+    query_gpu_status(ctk_framelock, data);
+
+    /* The parent board's status was refreshed before its children's */
     if (entry->parent && entry->parent->data) {
         nvFrameLockDataPtr framelock_data =
             (nvFrameLockDataPtr)(entry->parent->data);
 
-        NvCtrlGetAttribute(framelock_data->ctrl_target,
-                           NV_CTRL_FRAMELOCK_HOUSE_STATUS,
-                           &house);
+        house = framelock_data->status[FRAMELOCK_STATUS_HOUSE].val;
     }
 
     /*
@@ -3835,8 +3968,7 @@ static void list_entry_update_gpu_status(CtkFramelock *ctk_framelock,
         gtk_widget_set_sensitive(data->timing_label, FALSE);
         update_image(data->timing_hbox, ctk_framelock->led_grey_pixbuf);
     } else {
-        gint timing;
-        NvCtrlGetAttribute(data->ctrl_target, NV_CTRL_FRAMELOCK_TIMING, &timing);
+        gint timing = data->status[GPU_STATUS_TIMING].val;
         gtk_widget_set_sensitive(data->timing_label, TRUE);
         update_image(data->timing_hbox,
                      (timing ? ctk_framelock->led_green_pixbuf :
@@ -3848,25 +3980,22 @@ static void list_entry_update_gpu_status(CtkFramelock *ctk_framelock,
 
 /** list_entry_update_display_status() *******************************
  *
- * Updates the dynamic state of the GUI for a display list entry by
- * querying the current state of the X Server.
+ * Updates the dynamic state of the GUI for a display list entry from
+ * the status last queried for the GPU driving it.
  *
  */
 static void list_entry_update_display_status(CtkFramelock *ctk_framelock,
-                                             nvListEntryPtr entry)
+                                             nvListEntryPtr entry,
+                                             gboolean stereo_enabled)
 {
-    CtrlTarget *ctrl_target = ctk_framelock->ctrl_target;
     nvDisplayDataPtr data = (nvDisplayDataPtr)(entry->data);
     gboolean framelock_enabled;
-    gboolean stereo_enabled = FALSE;
     gboolean is_server;
     gboolean is_client;
     gboolean gpu_is_server;
     gboolean use_house_sync_input;
     nvListTreePtr tree = (nvListTreePtr)(ctk_framelock->tree);
     nvListEntryPtr gpu_server_entry = get_gpu_server_entry(tree);
-    ReturnStatus ret;
-    int val;
 
     framelock_enabled = ctk_framelock->framelock_enabled;
 
@@ -3882,12 +4011,6 @@ static void list_entry_update_display_status(CtkFramelock *ctk_framelock,
 
     gpu_is_server = (gpu_server_entry && (gpu_server_entry == entry->parent));
 
-    ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_STEREO, &val);
-    if ((ret == NvCtrlSuccess) &&
-        (val != NV_CTRL_STEREO_OFF)) {
-        stereo_enabled = TRUE;
-    }
-
     /* Check Stereo Sync.  If stereo or frame lock is disabled or this display
      * device is neither a client/server or the display device is a server and
      * the GPU driving it is not using the house sync signal, gray out the LED.
@@ -3906,19 +4029,18 @@ static void list_entry_update_display_status(CtkFramelock *ctk_framelock,
         if (entry->parent) {
             GdkPixbuf *pixbuf = ctk_framelock->led_grey_pixbuf;
             nvGPUDataPtr gpu_data = (nvGPUDataPtr)(entry->parent->data);
-            CtrlTarget *ctrl_target = gpu_data->ctrl_target;
-
-            ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_FRAMELOCK_TIMING,
-                                     &val);
-            if ((ret == NvCtrlSuccess) &&
-                (val == NV_CTRL_FRAMELOCK_TIMING_TRUE)) {
-                ret = NvCtrlGetAttribute(ctrl_target,
-                                         NV_CTRL_FRAMELOCK_STEREO_SYNC, &val);
-                if (ret == NvCtrlSuccess) {
-                    pixbuf = (val == NV_CTRL_FRAMELOCK_STEREO_SYNC_TRUE) ?
-                        ctk_framelock->led_green_pixbuf :
-                        ctk_framelock->led_red_pixbuf;
-                }
+            const CtrlAttributeQuery *timing =
+                &gpu_data->status[GPU_STATUS_TIMING];
+            const CtrlAttributeQuery *stereo_sync =
+                &gpu_data->status[GPU_STATUS_STEREO_SYNC];
+
+            if ((timing->status == NvCtrlSuccess) &&
+                (timing->val == NV_CTRL_FRAMELOCK_TIMING_TRUE) &&
+                (stereo_sync->status == NvCtrlSuccess)) {
+                pixbuf =
+                    (stereo_sync->val == NV_CTRL_FRAMELOCK_STEREO_SYNC_TRUE) ?
+                    ctk_framelock->led_green_pixbuf :
+                    ctk_framelock->led_red_pixbuf;
             }
             update_image(data->stereo_hbox, pixbuf);
         }
@@ -3932,27 +4054,57 @@ static void list_entry_update_display_status(CtkFramelock *ctk_framelock,
  * Updates the (GUI) state of a list entry, its children and siblings
  * by querying the X Server.
  *
+ * The entries are visited in pre-order without recursion, so that each
+ * frame lock board and GPU refreshes its batched status before any of
+ * its children look at it.
+ *
  */
 static void list_entry_update_status(CtkFramelock *ctk_framelock,
                                      nvListEntryPtr entry)
 {
-    if (!entry) return;
+    nvListEntryPtr top;
+    gboolean stereo_enabled = FALSE;
+    ReturnStatus ret;
+    int val;
 
-    list_entry_update_status(ctk_framelock, entry->children);
+    if (!entry) return;
 
-    switch (entry->data_type) {
-    case ENTRY_DATA_FRAMELOCK:
-        list_entry_update_framelock_status(ctk_framelock, entry);
-        break;
-    case ENTRY_DATA_GPU:
-        list_entry_update_gpu_status(ctk_framelock, entry);
-        break;
-    case ENTRY_DATA_DISPLAY:
-        list_entry_update_display_status(ctk_framelock, entry);
-        break;
+    /* Stereo is queried on the X screen, the same for every display */
+    ret = NvCtrlGetAttribute(ctk_framelock->ctrl_target, NV_CTRL_STEREO,
+                             &val);
+    if ((ret == NvCtrlSuccess) &&
+        (val != NV_CTRL_STEREO_OFF)) {
+        stereo_enabled = TRUE;
     }
 
-    list_entry_update_status(ctk_framelock, entry->next_sibling);
+    top = entry->parent;
+
+    while (entry) {
+
+        switch (entry->data_type) {
+        case ENTRY_DATA_FRAMELOCK:
+            list_entry_update_framelock_status(ctk_framelock, entry);
+            break;
+        case ENTRY_DATA_GPU:
+            list_entry_update_gpu_status(ctk_framelock, entry);
+            break;
+        case ENTRY_DATA_DISPLAY:
+            list_entry_update_display_status(ctk_framelock, entry,
+                                             stereo_enabled);
+            break;
+        }
+
+        if (entry->children) {
+            entry = entry->children;
+            continue;
+        }
+
+        /* Climb back up until an entry with a next sibling is found */
+        while (!entry->next_sibling && (entry->parent != top)) {
+            entry = entry->parent;
+        }
+        entry = entry->next_sibling;
+    }
 }
 
 
@@ -4001,9 +4153,14 @@ static gboolean check_for_ethernet(gpointer user_data)
             nvFrameLockDataPtr data = (nvFrameLockDataPtr)(entry->data);
             gint val;
 
-            NvCtrlGetAttribute(data->ctrl_target,
-                               NV_CTRL_FRAMELOCK_ETHERNET_DETECTED,
-                               &val);
+            if (is_remote_target(ctk_framelock, data->ctrl_target)) {
+                query_framelock_status(ctk_framelock, data);
+                val = data->status[FRAMELOCK_STATUS_ETHERNET].val;
+            } else {
+                NvCtrlGetAttribute(data->ctrl_target,
+                                   NV_CTRL_FRAMELOCK_ETHERNET_DETECTED,
+                                   &val);
+            }
 
             if (val & NV_CTRL_FRAMELOCK_ETHERNET_DETECTED_PORT0) {
                 data->port0_ethernet_error = TRUE;
@@ -5571,6 +5728,39 @@ static void add_devices_response(GtkWidget *button, gint response,
 
 
 
+/** release_monitor_host() ******************************************
+ *
+ * Stops sampling a remote X Server in the background once none of its
+ * frame lock devices are left in the frame lock group.
+ *
+ */
+static void release_monitor_host(CtkFramelock *ctk_framelock,
+                                 CtrlSystem *system)
+{
+    nvListEntryPtr entry;
+
+    if (!ctk_framelock->monitor ||
+        system == ctk_framelock->ctrl_target->system) {
+        return;
+    }
+
+    entry = ((nvListTreePtr)(ctk_framelock->tree))->entries;
+    while (entry) {
+        if (entry->data_type == ENTRY_DATA_FRAMELOCK) {
+            nvFrameLockDataPtr data = (nvFrameLockDataPtr)(entry->data);
+
+            if (data->ctrl_target->system == system) {
+                return;
+            }
+        }
+        entry = entry->next_sibling;
+    }
+
+    nv_framelock_monitor_remove_host(ctk_framelock->monitor, system->display);
+}
+
+
+
 /** remove_devices_response() ****************************************
  *
  * Callback function for the "response" event of the "Remove Devices"
@@ -5583,6 +5773,8 @@ static void remove_devices_response(GtkWidget *button, gint response,
     CtkFramelock *ctk_framelock = CTK_FRAMELOCK(user_data);
     nvListTreePtr tree = (nvListTreePtr)(ctk_framelock->tree);
     nvListEntryPtr entry = tree->selected_entry;
+    nvListEntryPtr top;
+    CtrlSystem *system;
     gchar *name;
 
     gtk_widget_hide(ctk_framelock->remove_devices_dialog);
@@ -5593,8 +5785,13 @@ static void remove_devices_response(GtkWidget *button, gint response,
 
     name = list_entry_get_name(entry, 0);
 
+    /* Top-level entries are frame lock devices */
+    for (top = entry; top->parent; top = top->parent);
+    system = ((nvFrameLockDataPtr)(top->data))->ctrl_target->system;
+
     /* Remove entry from list */
     list_tree_remove_entry(tree, entry);
+    release_monitor_host(ctk_framelock, system);
 
     /* If there are no entries left, Update the frame lock GUI */
     if (!tree->nentries) {
@@ -5840,6 +6037,9 @@ static void add_gpu_devices(CtkFramelock *ctk_framelock,
         gpu_data->ctrl_target = ctrl_target;
         gpu_data->label = gtk_label_new(NULL);
 
+        /* Remote GPUs only get their status refreshed once sampled */
+        nv_framelock_query_gpu_status(ctrl_target, gpu_data->status);
+
         gpu_data->timing_label = gtk_label_new(NULL);
         label_set_text(gpu_data->timing_label, "Timing");
         gpu_data->timing_hbox = gtk_hbox_new(FALSE, 0);
@@ -5923,6 +6123,9 @@ static void add_framelock_devices(CtkFramelock *ctk_framelock,
         /* Get the frame lock target */
         framelock_data->ctrl_target = ctrl_target;
 
+        /* Remote boards only get their status refreshed once sampled */
+        nv_framelock_query_board_status(ctrl_target, framelock_data->status);
+
         /* Gather framelock device information */
         ret = NvCtrlGetAttribute(ctrl_target,
                                  NV_CTRL_FRAMELOCK_SYNC_DELAY_RESOLUTION,
@@ -6161,9 +6364,23 @@ static void add_devices(CtkFramelock *ctk_framelock,
         goto done;
     }
 
+    /* Sample the status of remote X servers in the background */
+
+    if (system != ctk_framelock->ctrl_target->system) {
+        if (!ctk_framelock->monitor) {
+            ctk_framelock->monitor =
+                nv_framelock_monitor_new(DEFAULT_UPDATE_STATUS_TIME_INTERVAL);
+        }
+        if (ctk_framelock->monitor) {
+            nv_framelock_monitor_add_host(ctk_framelock->monitor,
+                                          system->display);
+        }
+    }
+
     /* Add frame lock devices found on server */
 
     add_framelock_devices(ctk_framelock, system, server_id);
+    release_monitor_host(ctk_framelock, system);
     if (!ctk_framelock->tree ||
         !((nvListTreePtr)(ctk_framelock->tree))->nentries) {
         if (error_dialog) {
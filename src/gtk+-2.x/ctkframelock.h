@@ -64,6 +64,7 @@ struct _CtkFramelock
 
     /* Device tree & buttons */
     gpointer               tree;
+    gpointer               monitor; /* Samples remote X Servers */
     GtkWidget             *add_devices_button;
     GtkWidget             *remove_devices_button;
     GtkWidget             *short_labels_button;
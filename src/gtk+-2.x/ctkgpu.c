@@ -20,6 +20,7 @@
 #include <gtk/gtk.h>
 #include "NvCtrlAttributes.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,6 +31,7 @@
 #include "ctkbanner.h"
 
 #include "ctkgpu.h"
+#include "ctkgraph.h"
 #include "ctkhelp.h"
 #include "ctkutils.h"
 
@@ -37,21 +39,11 @@
 
 static void probe_displays_received(GObject *object, CtrlEvent *event,
                                     gpointer user_data);
-static gboolean update_gpu_usage(gpointer);
+static void gpu_usage_sampled(GObject *object, gpointer arg1,
+                              gpointer user_data);
+static void update_gpu_usage(CtkGpu *ctk_gpu);
 
 #define ARRAY_ELEMENTS 16
-#define DEFAULT_UPDATE_GPU_INFO_TIME_INTERVAL 3000
-
-typedef struct {
-    gint graphics;
-    gboolean graphics_specified;
-
-    gint video;
-    gboolean video_specified;
-
-    gint pcie;
-    gboolean pcie_specified;
-} utilizationEntry, * utilizationEntryPtr;
 
 GType ctk_gpu_get_type(
     void
@@ -188,24 +180,6 @@ gchar *get_bus_id_str(CtrlTarget *ctrl_target)
 }
 
 
-static void apply_gpu_utilization_token(char *token, char *value, void *data)
-{
-    utilizationEntryPtr pEntry = (utilizationEntryPtr) data;
-
-    if (!strcasecmp("graphics", token)) {
-        pEntry->graphics = atoi(value);
-        pEntry->graphics_specified = TRUE;
-    } else if (!strcasecmp("video", token)) {
-        pEntry->video = atoi(value);
-        pEntry->video_specified = TRUE;
-    } else if (!strcasecmp("pcie", token)) {
-        pEntry->pcie = atoi(value);
-        pEntry->pcie_specified = TRUE;
-    }
-}
-
-
-
 GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
                        CtkEvent *ctk_event,
                        CtkConfig *ctk_config)
@@ -244,9 +218,11 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
     int len;
     int i;
     int row = 0;
-    int total_rows = 21;
+    int total_rows = 22;
     int gpu_memory;
-    utilizationEntry entry;
+    CtrlGpuUtilization *util = NULL;
+    unsigned int util_valid = 0;
+    CtkEventHistory *history;
     gboolean resizable_bar;
 
 
@@ -354,16 +330,14 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
         irq = g_strdup_printf("%d", tmp);
     }
 
-    /* NV_CTRL_STRING_GPU_UTILIZATION */
+    /* NV_CTRL_BINARY_DATA_GPU_UTILIZATION */
 
-    memset(&entry, 0, sizeof(entry));
-
-    ret = NvCtrlGetStringAttribute(ctrl_target,
-                                   NV_CTRL_STRING_GPU_UTILIZATION,
-                                   &tmp_str);
-    if (ret == NvCtrlSuccess) {
-        parse_token_value_pairs(tmp_str, apply_gpu_utilization_token, &entry);
-        free(tmp_str);
+    ret = NvCtrlGetBinaryAttribute(ctrl_target, 0,
+                                   NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                                   (unsigned char **) &util, &len);
+    if (ret == NvCtrlSuccess && util) {
+        util_valid = util->valid;
+        free(util);
     }
 
 
@@ -538,13 +512,22 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
 
     /* GPU utilization */
 
-    if (entry.graphics_specified) {
+    if (util_valid & CTRL_GPU_UTILIZATION_GRAPHICS) {
         ctk_gpu->gpu_utilization_label =
             add_table_row(table, row++,
                           0, 0.5, "GPU Utilization:",
                           0, 0.5, NULL);
+
+        history = ctk_event_add_history(ctk_event, ctrl_target,
+                                        NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                                        CTRL_ATTRIBUTE_TYPE_BINARY_DATA,
+                                        offsetof(CtrlGpuUtilization,
+                                                 graphics));
+        add_table_widget_row(table, NULL, NULL,
+                             row++, "GPU Utilization History:",
+                             ctk_graph_new(ctk_event, history, 0, 100));
     }
-    if (entry.video_specified) {
+    if (util_valid & CTRL_GPU_UTILIZATION_VIDEO) {
         ctk_gpu->video_utilization_label =
             add_table_row(table, row++,
                           0, 0.5, "Video Engine Utilization:",
@@ -599,7 +582,7 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
                           0, 0.5, "Maximum PCIe Link Speed:",
                           0, 0.5, link_speed_str);
         }
-        if (entry.pcie_specified) {
+        if (util_valid & CTRL_GPU_UTILIZATION_PCIE) {
             ctk_gpu->pcie_utilization_label =
                 add_table_row(table, row++,
                               0, 0.5, "PCIe Bandwidth Utilization:",
@@ -631,9 +614,12 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
     }
 
     ctk_gpu->video_ram_available = (video_ram != NULL);
-    ctk_gpu->graphics_util_available = entry.graphics_specified;
-    ctk_gpu->video_util_available = entry.video_specified;
-    ctk_gpu->pcie_util_available = entry.pcie_specified;
+    ctk_gpu->graphics_util_available =
+        !!(util_valid & CTRL_GPU_UTILIZATION_GRAPHICS);
+    ctk_gpu->video_util_available =
+        !!(util_valid & CTRL_GPU_UTILIZATION_VIDEO);
+    ctk_gpu->pcie_util_available =
+        !!(util_valid & CTRL_GPU_UTILIZATION_PCIE);
 
     free(product_name);
     free(vbios_version);
@@ -656,16 +642,6 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
                      G_CALLBACK(probe_displays_received),
                      (gpointer) ctk_gpu);
 
-    tmp_str = g_strdup_printf("Memory Used (GPU %d)",
-                              NvCtrlGetTargetId(ctrl_target));
-
-    ctk_config_add_timer(ctk_gpu->ctk_config,
-                         DEFAULT_UPDATE_GPU_INFO_TIME_INTERVAL,
-                         tmp_str,
-                         (GSourceFunc) update_gpu_usage,
-                         (gpointer) ctk_gpu);
-    g_free(tmp_str);
-
     return GTK_WIDGET(object);
 }
 
@@ -739,6 +715,10 @@ GtkTextBuffer *ctk_gpu_create_help(GtkTextTagTable *table,
     if (ctk_gpu->graphics_util_available) {
         ctk_help_heading(b, &i, "GPU Utilization");
         ctk_help_para(b, &i, "This is the percentage usage of graphics engine.");
+        ctk_help_heading(b, &i, "GPU Utilization History");
+        ctk_help_para(b, &i, "This graph shows the percentage usage of the "
+                      "graphics engine over the last minutes; the current "
+                      "usage is at the right.");
     }
 
     if (ctk_gpu->video_util_available) {
@@ -843,22 +823,18 @@ static void probe_displays_received(GObject *object,
 
 
 
-static gboolean update_gpu_usage(gpointer user_data)
+static void update_gpu_usage(CtkGpu *ctk_gpu)
 {
-    CtkGpu *ctk_gpu;
     gchar *memory_text;
     gchar *utilization_text = NULL;
     ReturnStatus ret;
-    gchar *utilizationStr = NULL;
     gint value = 0;
-    utilizationEntry entry;
-    CtrlTarget *ctrl_target;
-
-    ctk_gpu = CTK_GPU(user_data);
-    ctrl_target = ctk_gpu->ctrl_target;
+    CtrlGpuUtilization *util = NULL;
+    int len;
+    CtrlTarget *ctrl_target = ctk_gpu->ctrl_target;
 
-    ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_USED_DEDICATED_GPU_MEMORY,
-                             &value);
+    ret = ctk_event_get_sample(ctk_gpu->ctk_event, ctrl_target,
+                               NV_CTRL_USED_DEDICATED_GPU_MEMORY, &value);
     if (ret != NvCtrlSuccess || value > ctk_gpu->gpu_memory || value < 0) {
         gtk_label_set_text(GTK_LABEL(ctk_gpu->gpu_memory_used_label), "Unknown");
     } else {
@@ -876,10 +852,10 @@ static gboolean update_gpu_usage(gpointer user_data)
     }
 
     /* GPU utilization */
-    ret = NvCtrlGetStringAttribute(ctrl_target,
-                                   NV_CTRL_STRING_GPU_UTILIZATION,
-                                   &utilizationStr);
-    if (ret != NvCtrlSuccess) {
+    ret = ctk_event_get_binary_sample(ctk_gpu->ctk_event, ctrl_target,
+                                      NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                                      (unsigned char **) &util, &len);
+    if (ret != NvCtrlSuccess || !util) {
         if (ctk_gpu->gpu_utilization_label) {
             gtk_label_set_text(GTK_LABEL(ctk_gpu->gpu_utilization_label),
                                "Unknown");
@@ -892,43 +868,45 @@ static gboolean update_gpu_usage(gpointer user_data)
             gtk_label_set_text(GTK_LABEL(ctk_gpu->pcie_utilization_label),
                                "Unknown");
         }
-        return FALSE;
+        return;
     }
 
-    memset(&entry, 0, sizeof(entry));
-    parse_token_value_pairs(utilizationStr, apply_gpu_utilization_token,
-                            &entry);
-    if ((entry.graphics_specified) &&
+    if ((util->valid & CTRL_GPU_UTILIZATION_GRAPHICS) &&
         (ctk_gpu->gpu_utilization_label)) {
         utilization_text = g_strdup_printf("%d %%",
-                                           entry.graphics);
+                                           util->graphics);
 
         gtk_label_set_text(GTK_LABEL(ctk_gpu->gpu_utilization_label),
                            utilization_text);
         g_free(utilization_text);
     }
-    if ((entry.video_specified) &&
+    if ((util->valid & CTRL_GPU_UTILIZATION_VIDEO) &&
         (ctk_gpu->video_utilization_label)) {
         utilization_text = g_strdup_printf("%d %%",
-                                           entry.video);
+                                           util->video);
 
         gtk_label_set_text(GTK_LABEL(ctk_gpu->video_utilization_label),
                            utilization_text);
         g_free(utilization_text);
     }
-    if ((entry.pcie_specified) &&
+    if ((util->valid & CTRL_GPU_UTILIZATION_PCIE) &&
         (ctk_gpu->pcie_utilization_label)) {
         utilization_text = g_strdup_printf("%d %%",
-                                           entry.pcie);
+                                           util->pcie);
 
         gtk_label_set_text(GTK_LABEL(ctk_gpu->pcie_utilization_label),
                            utilization_text);
         g_free(utilization_text);
     }
 
-    free(utilizationStr);
+    free(util);
+}
 
-    return TRUE;
+static void gpu_usage_sampled(GObject *object,
+                              gpointer arg1,
+                              gpointer user_data)
+{
+    update_gpu_usage(CTK_GPU(user_data));
 }
 
 void ctk_gpu_page_select(GtkWidget *widget)
@@ -939,21 +917,35 @@ void ctk_gpu_page_select(GtkWidget *widget)
 
     update_gpu_usage(ctk_gpu);
 
-    /* Start the gpu timer */
+    /* Have the GPU monitor sample the GPU usage */
+
+    ctk_event_add_sample(ctk_gpu->ctk_event, ctk_gpu->ctrl_target,
+                         NV_CTRL_USED_DEDICATED_GPU_MEMORY,
+                         CTRL_ATTRIBUTE_TYPE_INTEGER);
+    ctk_event_add_sample(ctk_gpu->ctk_event, ctk_gpu->ctrl_target,
+                         NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                         CTRL_ATTRIBUTE_TYPE_BINARY_DATA);
 
-    ctk_config_start_timer(ctk_gpu->ctk_config,
-                           (GSourceFunc) update_gpu_usage,
-                           (gpointer) ctk_gpu);
+    g_signal_connect(G_OBJECT(ctk_gpu->ctk_event), "CTK_EVENT_SampleNotify",
+                     G_CALLBACK(gpu_usage_sampled),
+                     (gpointer) ctk_gpu);
 }
 
 void ctk_gpu_page_unselect(GtkWidget *widget)
 {
     CtkGpu *ctk_gpu = CTK_GPU(widget);
 
-    /* Stop the gpu timer */
+    /* Stop sampling the GPU usage */
+
+    g_signal_handlers_disconnect_by_func(G_OBJECT(ctk_gpu->ctk_event),
+                                         G_CALLBACK(gpu_usage_sampled),
+                                         (gpointer) ctk_gpu);
 
-    ctk_config_stop_timer(ctk_gpu->ctk_config,
-                          (GSourceFunc) update_gpu_usage,
-                          (gpointer) ctk_gpu);
+    ctk_event_remove_sample(ctk_gpu->ctk_event, ctk_gpu->ctrl_target,
+                            NV_CTRL_USED_DEDICATED_GPU_MEMORY,
+                            CTRL_ATTRIBUTE_TYPE_INTEGER);
+    ctk_event_remove_sample(ctk_gpu->ctk_event, ctk_gpu->ctrl_target,
+                            NV_CTRL_BINARY_DATA_GPU_UTILIZATION,
+                            CTRL_ATTRIBUTE_TYPE_BINARY_DATA);
 }
 
@@ -0,0 +1,445 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * CtkGraph - a sparkline of a history recorded by the GPU monitor (see
+ * ctk_event_add_history()).  The newest value is at the right edge; on
+ * every tick the plot is scrolled to the left within the backing surface
+ * and only the new values are plotted.  The history is recorded while the
+ * GPU monitor runs, but only graphs that are shown are redrawn; hidden
+ * graphs catch up when they are next exposed.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "ctkgraph.h"
+#include "ctkutils.h"
+
+#define REQUESTED_WIDTH  240
+#define REQUESTED_HEIGHT 64
+
+/* Horizontal distance between ticks, in pixels */
+#define STEP 2
+
+static void
+ctk_graph_class_init    (CtkGraphClass *, gpointer);
+
+static void
+ctk_graph_finalize      (GObject *);
+
+#ifdef CTK_GTK3
+static gboolean
+ctk_graph_draw_event    (GtkWidget *, cairo_t *);
+
+static void
+ctk_graph_get_preferred_width(GtkWidget *, gint *, gint *);
+
+static void
+ctk_graph_get_preferred_height(GtkWidget *, gint *, gint *);
+#else
+
+static gboolean
+ctk_graph_expose_event  (GtkWidget *, GdkEventExpose *);
+
+static void
+ctk_graph_size_request  (GtkWidget *, GtkRequisition *);
+
+#endif
+
+static gboolean
+ctk_graph_configure_event  (GtkWidget *, GdkEventConfigure *);
+
+static void update      (CtkGraph *);
+
+static GObjectClass *parent_class;
+
+
+GType ctk_graph_get_type(
+    void
+)
+{
+    static GType ctk_graph_type = 0;
+
+    if (!ctk_graph_type) {
+        static const GTypeInfo ctk_graph_info = {
+            sizeof (CtkGraphClass),
+            NULL, /* base_init */
+            NULL, /* base_finalize */
+            (GClassInitFunc) ctk_graph_class_init,
+            NULL, /* class_finalize */
+            NULL, /* class_data */
+            sizeof (CtkGraph),
+            0, /* n_preallocs */
+            NULL, /* instance_init */
+            NULL  /* value_table */
+        };
+
+        ctk_graph_type = g_type_register_static(GTK_TYPE_DRAWING_AREA,
+                        "CtkGraph", &ctk_graph_info, 0);
+    }
+
+    return ctk_graph_type;
+}
+
+static void ctk_graph_class_init(
+    CtkGraphClass *ctk_graph_class,
+    gpointer class_data
+)
+{
+    GObjectClass *gobject_class;
+    GtkWidgetClass *widget_class;
+
+    widget_class = (GtkWidgetClass *) ctk_graph_class;
+    gobject_class = (GObjectClass *) ctk_graph_class;
+
+    parent_class = g_type_class_peek_parent(ctk_graph_class);
+
+    gobject_class->finalize = ctk_graph_finalize;
+
+#ifdef CTK_GTK3
+    widget_class->draw = ctk_graph_draw_event;
+    widget_class->get_preferred_width  = ctk_graph_get_preferred_width;
+    widget_class->get_preferred_height = ctk_graph_get_preferred_height;
+#else
+    widget_class->expose_event = ctk_graph_expose_event;
+    widget_class->size_request = ctk_graph_size_request;
+#endif
+    widget_class->configure_event = ctk_graph_configure_event;
+}
+
+static void ctk_graph_finalize(
+    GObject *object
+)
+{
+    CtkGraph *ctk_graph = CTK_GRAPH(object);
+
+    if (ctk_graph->c_surface) {
+        cairo_surface_destroy(ctk_graph->c_surface);
+    }
+
+    G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+#ifdef CTK_GTK3
+static gboolean ctk_graph_draw_event(
+    GtkWidget *widget,
+    cairo_t *cr
+)
+#else
+static gboolean ctk_graph_expose_event(
+    GtkWidget *widget,
+    GdkEventExpose *event
+)
+#endif
+{
+    CtkGraph *ctk_graph = CTK_GRAPH(widget);
+#ifndef CTK_GTK3
+    cairo_t *cr;
+#endif
+
+    if (!ctk_graph->c_surface) {
+        return FALSE;
+    }
+
+    /* catch up with the ticks recorded while the graph was hidden */
+
+    update(ctk_graph);
+
+#ifndef CTK_GTK3
+    cr = gdk_cairo_create(widget->window);
+    gdk_cairo_region(cr, event->region);
+    cairo_clip(cr);
+#endif
+
+    cairo_set_source_surface(cr, ctk_graph->c_surface, 0, 0);
+    cairo_paint(cr);
+
+#ifndef CTK_GTK3
+    cairo_destroy(cr);
+#endif
+
+    return FALSE;
+}
+
+static gboolean ctk_graph_configure_event
+(
+ GtkWidget *widget,
+ GdkEventConfigure *event
+ )
+{
+    CtkGraph *ctk_graph = CTK_GRAPH(widget);
+
+    if (ctk_graph->c_surface &&
+        ctk_graph->width == event->width &&
+        ctk_graph->height == event->height) {
+        return FALSE;
+    }
+
+    ctk_graph->width = event->width;
+    ctk_graph->height = event->height;
+
+    if (ctk_graph->c_surface) cairo_surface_destroy(ctk_graph->c_surface);
+
+    ctk_graph->c_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                      ctk_graph->width,
+                                                      ctk_graph->height);
+    ctk_graph->serial = 0;
+
+    update(ctk_graph);
+
+    return FALSE;
+}
+
+#ifdef CTK_GTK3
+static void ctk_graph_get_preferred_height(
+    GtkWidget *widget,
+    gint *minimum_height,
+    gint *natural_height
+)
+{
+    *minimum_height = *natural_height = REQUESTED_HEIGHT;
+}
+
+static void ctk_graph_get_preferred_width(
+    GtkWidget *widget,
+    gint *minimum_width,
+    gint *natural_width
+)
+{
+    *minimum_width = *natural_width = REQUESTED_WIDTH;
+}
+#else
+static void ctk_graph_size_request(
+    GtkWidget *widget,
+    GtkRequisition *requisition
+)
+{
+    requisition->width  = REQUESTED_WIDTH;
+    requisition->height = REQUESTED_HEIGHT;
+}
+#endif
+
+
+
+/*
+ * history_recorded() - a tick was recorded; update the plot if the graph
+ * is visible.  Hidden graphs are brought up to date when exposed.
+ */
+
+static void history_recorded(GObject *object, gpointer arg1,
+                             gpointer user_data)
+{
+    CtkGraph *ctk_graph = CTK_GRAPH(user_data);
+    GtkWidget *widget = GTK_WIDGET(ctk_graph);
+
+    if (ctk_widget_is_drawable(widget)) {
+        update(ctk_graph);
+        gtk_widget_queue_draw(widget);
+    }
+}
+
+
+
+GtkWidget* ctk_graph_new(CtkEvent *ctk_event, CtkEventHistory *history,
+                         gint lower, gint upper)
+{
+    GObject *object;
+    CtkGraph *ctk_graph;
+
+    object = g_object_new(CTK_TYPE_GRAPH, NULL);
+
+    ctk_graph = CTK_GRAPH(object);
+
+    ctk_graph->ctk_event = ctk_event;
+    ctk_graph->history = history;
+    ctk_graph->lower = lower;
+    ctk_graph->upper = (upper > lower) ? upper : lower + 1;
+
+    ctk_graph->c_surface = NULL;
+    ctk_graph->serial = 0;
+
+    g_signal_connect_object(G_OBJECT(ctk_event), "CTK_EVENT_HistoryNotify",
+                            G_CALLBACK(history_recorded),
+                            (gpointer) ctk_graph, 0);
+
+    return GTK_WIDGET(object);
+}
+
+
+
+/*
+ * value_to_y() - the vertical position of the center of the pixel that
+ * plots the given value.
+ */
+
+static double value_to_y(CtkGraph *ctk_graph, gint value)
+{
+    gint lower = ctk_graph->lower;
+    gint upper = ctk_graph->upper;
+    double y;
+
+    if (value < lower) value = lower;
+    if (value > upper) value = upper;
+
+    y = (ctk_graph->height - 1) -
+        (double) (value - lower) * (ctk_graph->height - 1) / (upper - lower);
+
+    return (gint) y + 0.5;
+}
+
+
+
+/*
+ * plot() - clear the surface from column x0 to the right edge, and plot
+ * the values of the ticks from first to serial - 1 into it; the newest
+ * tick is plotted at the right edge.
+ */
+
+static void plot(CtkGraph *ctk_graph, guint64 serial, guint64 first, gint x0)
+{
+    cairo_t *cr = cairo_create(ctk_graph->c_surface);
+    gboolean has_point = FALSE;
+    guint64 tick;
+    gint value, i;
+    double x, y;
+
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
+    cairo_set_line_width(cr, 1.0);
+
+    /* background */
+
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+    cairo_rectangle(cr, x0, 0, ctk_graph->width - x0, ctk_graph->height);
+    cairo_fill(cr);
+
+    /* grid lines at each quarter of the range */
+
+    cairo_set_source_rgb(cr, 0.25, 0.25, 0.25);
+    for (i = 1; i < 4; i++) {
+        y = (gint) (ctk_graph->height * i / 4) + 0.5;
+        cairo_move_to(cr, x0, y);
+        cairo_line_to(cr, ctk_graph->width, y);
+    }
+    cairo_stroke(cr);
+
+    /* history; the line is broken where there is no data */
+
+    cairo_set_source_rgb(cr, 0.0, 1.0, 0.0);
+    for (tick = first; tick < serial; tick++) {
+        value = ctk_event_get_history_value(ctk_graph->ctk_event,
+                                            ctk_graph->history, tick);
+        if (value == CTK_EVENT_HISTORY_NO_DATA) {
+            has_point = FALSE;
+            continue;
+        }
+
+        x = ctk_graph->width - 1 - (gint) (serial - 1 - tick) * STEP + 0.5;
+        y = value_to_y(ctk_graph, value);
+
+        if (has_point) {
+            cairo_line_to(cr, x, y);
+        } else {
+            cairo_move_to(cr, x, y);
+        }
+        has_point = TRUE;
+    }
+    cairo_stroke(cr);
+
+    cairo_destroy(cr);
+}
+
+
+
+/*
+ * scroll() - move the contents of the surface dx pixels to the left.
+ */
+
+static void scroll(CtkGraph *ctk_graph, gint dx)
+{
+    cairo_surface_t *surface = ctk_graph->c_surface;
+    unsigned char *data;
+    int stride, y;
+
+    cairo_surface_flush(surface);
+
+    data = cairo_image_surface_get_data(surface);
+    stride = cairo_image_surface_get_stride(surface);
+
+    for (y = 0; y < ctk_graph->height; y++) {
+        memmove(data + y * stride, data + y * stride + dx * 4,
+                (ctk_graph->width - dx) * 4);
+    }
+
+    cairo_surface_mark_dirty(surface);
+}
+
+
+
+/*
+ * update() - bring the plot up to date with the history: scroll the
+ * surface by the number of new ticks and plot only those, or replot the
+ * whole history when the surface is new, when more ticks than fit in the
+ * graph were recorded, or when a new value is out of the range of the
+ * graph (which is then extended).
+ */
+
+static void update(CtkGraph *ctk_graph)
+{
+    guint64 serial = ctk_graph->ctk_event->history_serial;
+    guint64 visible, first, tick;
+    gint value, upper, dx;
+
+    if (!ctk_graph->c_surface || ctk_graph->width <= 0 ||
+        (ctk_graph->serial == serial && serial != 0)) {
+        return;
+    }
+
+    visible = ctk_graph->width / STEP + 1;
+    first = (serial > visible) ? serial - visible : 0;
+
+    if (ctk_graph->serial > first) {
+        first = ctk_graph->serial;
+    }
+
+    upper = ctk_graph->upper;
+    for (tick = first; tick < serial; tick++) {
+        value = ctk_event_get_history_value(ctk_graph->ctk_event,
+                                            ctk_graph->history, tick);
+        if (value != CTK_EVENT_HISTORY_NO_DATA && value > upper) {
+            upper = value;
+        }
+    }
+    if (upper > ctk_graph->upper) {
+        ctk_graph->upper = upper + (upper - ctk_graph->lower) / 8;
+        ctk_graph->serial = 0;
+    }
+
+    if (ctk_graph->serial == 0 ||
+        serial - ctk_graph->serial >= visible - 1) {
+        first = (serial > visible) ? serial - visible : 0;
+        plot(ctk_graph, serial, first, 0);
+    } else {
+        dx = (gint) (serial - ctk_graph->serial) * STEP;
+        scroll(ctk_graph, dx);
+        plot(ctk_graph, serial, ctk_graph->serial - 1, ctk_graph->width - dx);
+    }
+
+    ctk_graph->serial = serial;
+}
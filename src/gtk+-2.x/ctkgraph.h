@@ -0,0 +1,78 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef __CTK_GRAPH_H__
+#define __CTK_GRAPH_H__
+
+#include "ctkevent.h"
+
+G_BEGIN_DECLS
+
+#define CTK_TYPE_GRAPH (ctk_graph_get_type())
+
+#define CTK_GRAPH(obj) \
+    (G_TYPE_CHECK_INSTANCE_CAST ((obj), CTK_TYPE_GRAPH, CtkGraph))
+
+#define CTK_GRAPH_CLASS(klass) \
+    (G_TYPE_CHECK_CLASS_CAST ((klass), CTK_TYPE_GRAPH, CtkGraphClass))
+
+#define CTK_IS_GRAPH(obj) \
+    (G_TYPE_CHECK_INSTANCE_TYPE ((obj), CTK_TYPE_GRAPH))
+
+#define CTK_IS_GRAPH_CLASS(class) \
+    (G_TYPE_CHECK_CLASS_TYPE ((klass), CTK_TYPE_GRAPH))
+
+#define CTK_GRAPH_GET_CLASS(obj) \
+    (G_TYPE_INSTANCE_GET_CLASS ((obj), CTK_TYPE_GRAPH, CtkGraphClass))
+
+
+typedef struct _CtkGraph       CtkGraph;
+typedef struct _CtkGraphClass  CtkGraphClass;
+
+struct _CtkGraph
+{
+    GtkDrawingArea parent;
+
+    CtkEvent *ctk_event;
+    CtkEventHistory *history;
+
+    gint lower, upper;
+
+    /*
+     * The history is plotted into c_surface, which is kept between
+     * ticks; serial is the number of ticks already plotted, or 0 when
+     * the surface needs to be replotted.
+     */
+    cairo_surface_t *c_surface;
+    guint64 serial;
+
+    gint width, height;
+};
+
+struct _CtkGraphClass
+{
+    GtkDrawingAreaClass parent_class;
+};
+
+GType       ctk_graph_get_type  (void) G_GNUC_CONST;
+GtkWidget*  ctk_graph_new       (CtkEvent *, CtkEventHistory *, gint, gint);
+
+G_END_DECLS
+
+#endif /* __CTK_GRAPH_H__ */
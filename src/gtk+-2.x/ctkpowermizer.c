@@ -25,17 +25,18 @@
 #include <NvCtrlAttributesPrivate.h>
 
 #include "msg.h"
+#include "common-utils.h"
 
 #include "ctkutils.h"
 #include "ctkhelp.h"
 #include "ctkpowermizer.h"
 #include "ctkbanner.h"
+#include "ctkgraph.h"
 #include "ctkdropdownmenu.h"
 
 
 
 #define FRAME_PADDING 10
-#define DEFAULT_UPDATE_POWERMIZER_INFO_TIME_INTERVAL 1000
 
 static gboolean update_powermizer_info(gpointer);
 static void update_powermizer_menu_info(CtkPowermizer *ctk_powermizer);
@@ -69,6 +70,11 @@ static const char *__power_source_help =
 static const char *__power_draw_help =
 "This indicates the current power usage of the GPU, in Watts.";
 
+static const char *__power_draw_history_help =
+"This graph shows the power usage of the GPU over the last minutes, "
+"relative to its maximum Total Graphics Power (TGP); the current power "
+"usage is at the right.";
+
 static const char *__default_tgp_help =
 "This indicates the default Total Graphics Power (TGP) of the GPU, in Watts.";
 
@@ -610,9 +616,9 @@ static void update_perf_mode_table(CtkPowermizer *ctk_powermizer,
 
     /* Get the current list of perf levels */
 
-    ret = NvCtrlGetStringAttribute(ctrl_target,
-                                   NV_CTRL_STRING_PERFORMANCE_MODES,
-                                   &perf_modes);
+    ret = ctk_event_get_string_sample(ctk_powermizer->ctk_event, ctrl_target,
+                                      NV_CTRL_STRING_PERFORMANCE_MODES,
+                                      &perf_modes);
 
     if (ret != NvCtrlSuccess) {
         /* Bail */
@@ -924,8 +930,9 @@ static gboolean update_powermizer_info(gpointer user_data)
     char *clock_string = NULL;
     perfModeEntry pEntry;
 
-    ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE,
-                             &adaptive_clock);
+    ret = ctk_event_get_sample(ctk_powermizer->ctk_event, ctrl_target,
+                               NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE,
+                               &adaptive_clock);
     if (ret == NvCtrlSuccess && ctk_powermizer->adaptive_clock_status) { 
 
         if (adaptive_clock == NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE_ENABLED) {
@@ -944,9 +951,9 @@ static gboolean update_powermizer_info(gpointer user_data)
 
     /* Get the current values of clocks */
 
-    ret = NvCtrlGetStringAttribute(ctrl_target,
-                                   NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS,
-                                   &clock_string);
+    ret = ctk_event_get_string_sample(ctk_powermizer->ctk_event, ctrl_target,
+                                      NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS,
+                                      &clock_string);
 
     if (ret == NvCtrlSuccess && ctk_powermizer->gpu_clock) {
 
@@ -974,8 +981,8 @@ static gboolean update_powermizer_info(gpointer user_data)
     }
     free(clock_string);
 
-    ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_GPU_POWER_SOURCE,
-                             &power_source);
+    ret = ctk_event_get_sample(ctk_powermizer->ctk_event, ctrl_target,
+                               NV_CTRL_GPU_POWER_SOURCE, &power_source);
     if (ret == NvCtrlSuccess && ctk_powermizer->power_source) {
 
         if (power_source == NV_CTRL_GPU_POWER_SOURCE_AC) {
@@ -996,9 +1003,9 @@ static gboolean update_powermizer_info(gpointer user_data)
     }
 
     /* Power Draw */
-    ret = NvCtrlGetAttribute(ctrl_target,
-                             NV_CTRL_ATTR_NVML_GPU_GET_POWER_USAGE,
-                             &power_draw);
+    ret = ctk_event_get_sample(ctk_powermizer->ctk_event, ctrl_target,
+                               NV_CTRL_ATTR_NVML_GPU_GET_POWER_USAGE,
+                               &power_draw);
     if ((ret == NvCtrlSuccess) && ctk_powermizer->power_draw) {
         /* Round up to 1 watt for display  */
         if (power_draw < 1000) {
@@ -1051,9 +1058,9 @@ static gboolean update_powermizer_info(gpointer user_data)
         g_free(s);
     }
 
-    ret = NvCtrlGetAttribute(ctrl_target,
-                             NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL,
-                             &perf_level);
+    ret = ctk_event_get_sample(ctk_powermizer->ctk_event, ctrl_target,
+                               NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL,
+                               &perf_level);
     if (ret == NvCtrlSuccess && ctk_powermizer->performance_level) {
         s = g_strdup_printf("%d", perf_level);
         gtk_label_set_text(GTK_LABEL(ctk_powermizer->performance_level), s);
@@ -1150,13 +1157,13 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
     GtkWidget *hbox, *hbox2, *vbox, *vbox2, *hsep, *table;
     GtkWidget *banner, *label;
     CtkDropDownMenu *menu;
+    CtkEventHistory *history;
     ReturnStatus ret;
     gint nvclock_attribute = 0, mem_transfer_rate_attribute = 0;
     gint default_tgp = 0;
     gint max_tgp = 0;
     gint val;
     gint row = 0;
-    gchar *s = NULL;
     gint tmp;
     gboolean power_source_available = FALSE;
     gboolean power_draw_available = FALSE;
@@ -1249,6 +1256,7 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
     ctk_powermizer = CTK_POWERMIZER(object);
     ctk_powermizer->ctrl_target = ctrl_target;
     ctk_powermizer->ctk_config = ctk_config;
+    ctk_powermizer->ctk_event = ctk_event;
     ctk_powermizer->hasDecoupledClock = FALSE;
     ctk_powermizer->hasEditablePerfLevel = FALSE;
     ctk_powermizer->editable_performance_levels_unified = FALSE;
@@ -1421,6 +1429,14 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
                                          0.0,
                                          0.5,
                                          NULL);
+
+        history = ctk_event_add_history(ctk_event, ctrl_target,
+                                        NV_CTRL_ATTR_NVML_GPU_GET_POWER_USAGE,
+                                        CTRL_ATTRIBUTE_TYPE_INTEGER, 0);
+        add_table_widget_row(table, ctk_config, __power_draw_history_help,
+                             row++, "Power Draw History:",
+                             ctk_graph_new(ctk_event, history, 0,
+                                           max_tgp_available ? max_tgp : 0));
     } else {
         ctk_powermizer->power_draw = NULL;
     }
@@ -1539,18 +1555,6 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
         ctk_powermizer->performance_table_hbox1 = hbox;
     }
 
-    /* Register a timer callback to update the temperatures */
-
-    s = g_strdup_printf("PowerMizer Monitor (GPU %d)",
-                        NvCtrlGetTargetId(ctrl_target));
-
-    ctk_config_add_timer(ctk_powermizer->ctk_config,
-                         DEFAULT_UPDATE_POWERMIZER_INFO_TIME_INTERVAL,
-                         s,
-                         (GSourceFunc) update_powermizer_info,
-                         (gpointer) ctk_powermizer);
-    g_free(s);
-
     /* PowerMizer Settings */
 
     ret = NvCtrlGetValidAttributeValues(ctrl_target,
@@ -1855,6 +1859,8 @@ GtkTextBuffer *ctk_powermizer_create_help(GtkTextTagTable *table,
     if (ctk_powermizer->power_draw) {
         ctk_help_heading(b, &i, "Power Draw");
         ctk_help_para(b, &i, "%s", __power_draw_help);
+        ctk_help_heading(b, &i, "Power Draw History");
+        ctk_help_para(b, &i, "%s", __power_draw_history_help);
     }
     if (ctk_powermizer->default_tgp) {
         ctk_help_heading(b, &i, "Default TGP");
@@ -1900,24 +1906,64 @@ GtkTextBuffer *ctk_powermizer_create_help(GtkTextTagTable *table,
     return b;
 }
 
+/*
+ * Attributes shown on the page that are sampled by the GPU monitor while
+ * the page is visible
+ */
+static const struct {
+    int attribute;
+    CtrlAttributeType type;
+} __powermizer_samples[] = {
+    { NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE,       CTRL_ATTRIBUTE_TYPE_INTEGER },
+    { NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS, CTRL_ATTRIBUTE_TYPE_STRING  },
+    { NV_CTRL_GPU_POWER_SOURCE,               CTRL_ATTRIBUTE_TYPE_INTEGER },
+    { NV_CTRL_ATTR_NVML_GPU_GET_POWER_USAGE,  CTRL_ATTRIBUTE_TYPE_INTEGER },
+    { NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL,  CTRL_ATTRIBUTE_TYPE_INTEGER },
+    { NV_CTRL_STRING_PERFORMANCE_MODES,       CTRL_ATTRIBUTE_TYPE_STRING  },
+};
+
+static void powermizer_info_sampled(GObject *object,
+                                    gpointer arg1,
+                                    gpointer user_data)
+{
+    update_powermizer_info(user_data);
+}
+
 void ctk_powermizer_start_timer(GtkWidget *widget)
 {
     CtkPowermizer *ctk_powermizer = CTK_POWERMIZER(widget);
+    int i;
+
+    /* Have the GPU monitor sample the powermizer information */
 
-    /* Start the powermizer timer */
+    for (i = 0; i < ARRAY_LEN(__powermizer_samples); i++) {
+        ctk_event_add_sample(ctk_powermizer->ctk_event,
+                             ctk_powermizer->ctrl_target,
+                             __powermizer_samples[i].attribute,
+                             __powermizer_samples[i].type);
+    }
 
-    ctk_config_start_timer(ctk_powermizer->ctk_config,
-                           (GSourceFunc) update_powermizer_info,
-                           (gpointer) ctk_powermizer);
+    g_signal_connect(G_OBJECT(ctk_powermizer->ctk_event),
+                     "CTK_EVENT_SampleNotify",
+                     G_CALLBACK(powermizer_info_sampled),
+                     (gpointer) ctk_powermizer);
 }
 
 void ctk_powermizer_stop_timer(GtkWidget *widget)
 {
     CtkPowermizer *ctk_powermizer = CTK_POWERMIZER(widget);
+    int i;
+
+    /* Stop sampling the powermizer information */
 
-    /* Stop the powermizer timer */
+    g_signal_handlers_disconnect_by_func(G_OBJECT(ctk_powermizer->ctk_event),
+                                         G_CALLBACK(powermizer_info_sampled),
+                                         (gpointer) ctk_powermizer);
 
-    ctk_config_stop_timer(ctk_powermizer->ctk_config,
-                          (GSourceFunc) update_powermizer_info,
-                          (gpointer) ctk_powermizer);
+    for (i = 0; i < ARRAY_LEN(__powermizer_samples); i++) {
+        ctk_event_remove_sample(ctk_powermizer->ctk_event,
+                                ctk_powermizer->ctrl_target,
+                                __powermizer_samples[i].attribute,
+                                __powermizer_samples[i].type);
+    }
 }
@@ -51,6 +51,7 @@ struct _CtkPowermizer
 
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
+    CtkEvent *ctk_event;
 
     GtkWidget *adaptive_clock_status;
     GtkWidget *gpu_clock;
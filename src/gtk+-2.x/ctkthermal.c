@@ -26,13 +26,13 @@
 #include "ctkhelp.h"
 #include "ctkthermal.h"
 #include "ctkgauge.h"
+#include "ctkgraph.h"
 #include "ctkbanner.h"
 
 #define FRAME_PADDING 10
-#define DEFAULT_UPDATE_THERMAL_INFO_TIME_INTERVAL 1000
 
-static gboolean update_thermal_info(gpointer);
-static gboolean update_cooler_info(gpointer);
+static void update_thermal_info(CtkThermal *ctk_thermal);
+static void update_cooler_info(CtkThermal *ctk_thermal);
 static void sync_gui_sensitivity(CtkThermal *ctk_thermal);
 static void sync_gui_to_modify_cooler_level(CtkThermal *ctk_thermal);
 static gboolean sync_gui_to_update_cooler_event(gpointer user_data);
@@ -50,7 +50,8 @@ static void draw_sensor_gui(GtkWidget *vbox1, CtkThermal *ctk_thermal,
                             gint reading, gint lower, gint upper,
                             gint target, gint provider, gint slowdown);
 static GtkWidget *pack_gauge(GtkWidget *hbox, gint lower, gint upper,
-                             CtkConfig *ctk_config, const char *help);
+                             CtkThermal *ctk_thermal, CtrlTarget *ctrl_target,
+                             int attribute);
 
 static const char *__slowdown_threshold_help =
 "The Slowdown Threshold Temperature is the temperature "
@@ -79,6 +80,11 @@ static const char *__temp_level_help =
 "temperature relative to the maximum GPU Core Slowdown "
 "Threshold temperature.";
 
+static const char *__temp_history_help =
+"This graph shows the GPU core temperature over the last minutes, "
+"relative to the maximum GPU Core Slowdown Threshold temperature; the "
+"current temperature is at the right.";
+
 static const char *__thermal_sensor_id_help =
 "This shows the thermal sensor's index.";
 
@@ -159,13 +165,15 @@ GType ctk_thermal_get_type(void)
 
 
 /*
- * update_cooler_info() - Update all cooler information
+ * update_cooler_info() - Update all cooler information.  Values that
+ * could not be sampled are shown as "Unsupported" (or "Unknown", for the
+ * control type and cooling target), so that the whole table is always
+ * rebuilt.
  */
-static gboolean update_cooler_info(gpointer user_data)
+static void update_cooler_info(CtkThermal *ctk_thermal)
 {
     int i, speed, level, cooler_type, cooler_target;
     gchar *tmp_str;
-    CtkThermal *ctk_thermal;
     GtkWidget *table, *label, *eventbox;
     gint ret, ret2;
     gint row_idx; /* Where to insert into the cooler info table */
@@ -173,8 +181,6 @@ static gboolean update_cooler_info(gpointer user_data)
     int num_cols = 2;
     int current_speed_attr;
 
-    ctk_thermal = CTK_THERMAL(user_data);
-
     /* Since table cell management in GTK lacks, just remove and rebuild
      * the table from scratch.
      */
@@ -185,10 +191,13 @@ static gboolean update_cooler_info(gpointer user_data)
 
     /* Generate a new table */
 
-    ret = NvCtrlGetAttribute(ctk_thermal->cooler_control[0].ctrl_target,
-                             NV_CTRL_THERMAL_COOLER_CONTROL_TYPE, &cooler_type);
-    ret2 = NvCtrlGetAttribute(ctk_thermal->cooler_control[0].ctrl_target,
-                              NV_CTRL_THERMAL_COOLER_TARGET, &cooler_target);
+    ret = ctk_event_get_sample(ctk_thermal->ctk_event,
+                               ctk_thermal->cooler_control[0].ctrl_target,
+                               NV_CTRL_THERMAL_COOLER_CONTROL_TYPE,
+                               &cooler_type);
+    ret2 = ctk_event_get_sample(ctk_thermal->ctk_event,
+                                ctk_thermal->cooler_control[0].ctrl_target,
+                                NV_CTRL_THERMAL_COOLER_TARGET, &cooler_target);
     if (ret == NvCtrlSuccess && ret2 == NvCtrlSuccess) {
         cooler_extra_info = TRUE;
         ctk_thermal->thermal_cooler_extra_info_supported = cooler_extra_info;
@@ -270,9 +279,10 @@ static gboolean update_cooler_info(gpointer user_data)
                          GTK_FILL, GTK_FILL | GTK_EXPAND, 5, 0);
         free(tmp_str);
 
-        ret = NvCtrlGetAttribute(ctk_thermal->cooler_control[i].ctrl_target,
-                                 current_speed_attr,
-                                 &speed);
+        ret = ctk_event_get_sample(ctk_thermal->ctk_event,
+                                   ctk_thermal->cooler_control[i].ctrl_target,
+                                   current_speed_attr,
+                                   &speed);
         if (ret == NvCtrlSuccess) {
             tmp_str = g_strdup_printf("%d", speed);
         }
@@ -286,28 +296,26 @@ static gboolean update_cooler_info(gpointer user_data)
         free(tmp_str);
 
         if (cooler_extra_info) {
-            ret = NvCtrlGetAttribute(ctk_thermal->cooler_control[i].ctrl_target,
-                                     NV_CTRL_THERMAL_COOLER_LEVEL,
-                                     &level);
-            if (ret != NvCtrlSuccess) {
-                /* cooler information no longer available */
-                return FALSE;
+            ret = ctk_event_get_sample(ctk_thermal->ctk_event,
+                                       ctk_thermal->cooler_control[i].ctrl_target,
+                                       NV_CTRL_THERMAL_COOLER_LEVEL,
+                                       &level);
+            if (ret == NvCtrlSuccess) {
+                tmp_str = g_strdup_printf("%d", level);
+            } else {
+                tmp_str = g_strdup_printf("Unsupported");
             }
-            tmp_str = g_strdup_printf("%d", level);
             label = gtk_label_new(tmp_str);
             gtk_misc_set_alignment(GTK_MISC(label), 0.0f, 0.5f);
             gtk_table_attach(GTK_TABLE(table), label, 2, 3, row_idx, row_idx+1,
                              GTK_FILL, GTK_FILL | GTK_EXPAND, 5, 0);
             free(tmp_str);
 
-            ret = NvCtrlGetAttribute(ctk_thermal->cooler_control[i].ctrl_target,
-                                     NV_CTRL_THERMAL_COOLER_CONTROL_TYPE,
-                                     &cooler_type);
-            if (ret != NvCtrlSuccess && ret != NvCtrlNotSupported) {
-                return FALSE;
-            }
-
-            if (ret == NvCtrlNotSupported) {
+            ret = ctk_event_get_sample(ctk_thermal->ctk_event,
+                                       ctk_thermal->cooler_control[i].ctrl_target,
+                                       NV_CTRL_THERMAL_COOLER_CONTROL_TYPE,
+                                       &cooler_type);
+            if (ret != NvCtrlSuccess) {
                 tmp_str = g_strdup_printf("Unknown");
             } else if (cooler_type == NV_CTRL_THERMAL_COOLER_CONTROL_TYPE_VARIABLE) {
                 tmp_str = g_strdup_printf("Variable");
@@ -315,6 +323,8 @@ static gboolean update_cooler_info(gpointer user_data)
                 tmp_str = g_strdup_printf("Toggle");
             } else if (cooler_type == NV_CTRL_THERMAL_COOLER_CONTROL_TYPE_NONE) {
                 tmp_str = g_strdup_printf("Restricted");
+            } else {
+                tmp_str = g_strdup_printf("Unknown");
             }
             label = gtk_label_new(tmp_str);
             gtk_misc_set_alignment(GTK_MISC(label), 0.0f, 0.5f);
@@ -322,14 +332,11 @@ static gboolean update_cooler_info(gpointer user_data)
                              GTK_FILL, GTK_FILL | GTK_EXPAND, 5, 0);
             free(tmp_str);
 
-            ret = NvCtrlGetAttribute(ctk_thermal->cooler_control[i].ctrl_target,
-                                     NV_CTRL_THERMAL_COOLER_TARGET,
-                                     &cooler_target);
-            if (ret != NvCtrlSuccess && ret != NvCtrlNotSupported) {
-                return FALSE;
-            }
-
-            if (ret == NvCtrlNotSupported) {
+            ret = ctk_event_get_sample(ctk_thermal->ctk_event,
+                                       ctk_thermal->cooler_control[i].ctrl_target,
+                                       NV_CTRL_THERMAL_COOLER_TARGET,
+                                       &cooler_target);
+            if (ret != NvCtrlSuccess) {
                 tmp_str = g_strdup_printf("Unknown");
             } else {
 
@@ -347,6 +354,7 @@ static gboolean update_cooler_info(gpointer user_data)
                         tmp_str = g_strdup_printf("GPU, Memory, and Power Supply");
                         break;
                     default:
+                        tmp_str = g_strdup_printf("Unknown");
                         break;
                 }
             }
@@ -363,55 +371,58 @@ static gboolean update_cooler_info(gpointer user_data)
     /* X driver takes fraction of second to refresh newly set value */
 
     cooler_control_state_update_gui(ctk_thermal);
-
-    return TRUE;
 } /* update_cooler_info() */
 
 
 
-static gboolean update_thermal_info(gpointer user_data)
+/*
+ * update_thermal_info() - Update the temperatures and cooler information
+ * from the last sample; temperatures that could not be sampled are shown
+ * as "Unsupported".
+ */
+static void update_thermal_info(CtkThermal *ctk_thermal)
 {
     gint reading, ambient;
-    CtkThermal *ctk_thermal = CTK_THERMAL(user_data);
     gint ret, i, core;
     gchar *s;
 
     if (!ctk_thermal->thermal_sensor_target_type_supported) {
         CtrlTarget *ctrl_target = ctk_thermal->ctrl_target;
 
-        ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_GPU_CORE_TEMPERATURE,
-                                 &core);
-        if (ret != NvCtrlSuccess) {
-            /* thermal information no longer available */
-            return FALSE;
-        }
-
-        s = g_strdup_printf(" %d C ", core);
-        gtk_label_set_text(GTK_LABEL(ctk_thermal->core_label), s);
-        g_free(s);
+        ret = ctk_event_get_sample(ctk_thermal->ctk_event, ctrl_target,
+                                   NV_CTRL_GPU_CORE_TEMPERATURE, &core);
+        if (ret == NvCtrlSuccess) {
+            s = g_strdup_printf(" %d C ", core);
+            gtk_label_set_text(GTK_LABEL(ctk_thermal->core_label), s);
+            g_free(s);
 
-        ctk_gauge_set_current(CTK_GAUGE(ctk_thermal->core_gauge), core);
-        ctk_gauge_draw(CTK_GAUGE(ctk_thermal->core_gauge));
+            ctk_gauge_set_current(CTK_GAUGE(ctk_thermal->core_gauge), core);
+            ctk_gauge_draw(CTK_GAUGE(ctk_thermal->core_gauge));
+        } else {
+            gtk_label_set_text(GTK_LABEL(ctk_thermal->core_label),
+                               "Unsupported");
+        }
 
         if (ctk_thermal->ambient_label) {
-            ret = NvCtrlGetAttribute(ctrl_target,
-                                     NV_CTRL_AMBIENT_TEMPERATURE,
-                                     &ambient);
-            if (ret != NvCtrlSuccess) {
-                /* thermal information no longer available */
-                return FALSE;
+            ret = ctk_event_get_sample(ctk_thermal->ctk_event, ctrl_target,
+                                       NV_CTRL_AMBIENT_TEMPERATURE,
+                                       &ambient);
+            if (ret == NvCtrlSuccess) {
+                s = g_strdup_printf(" %d C ", ambient);
+                gtk_label_set_text(GTK_LABEL(ctk_thermal->ambient_label), s);
+                g_free(s);
+            } else {
+                gtk_label_set_text(GTK_LABEL(ctk_thermal->ambient_label),
+                                   "Unsupported");
             }
-            s = g_strdup_printf(" %d C ", ambient);
-            gtk_label_set_text(GTK_LABEL(ctk_thermal->ambient_label), s);
-            g_free(s);
         }
     } else {
         for (i = 0; i < ctk_thermal->sensor_count; i++) {
             CtrlTarget *ctrl_target = ctk_thermal->sensor_info[i].ctrl_target;
 
-            ret = NvCtrlGetAttribute(ctrl_target,
-                                     NV_CTRL_THERMAL_SENSOR_READING,
-                                     &reading);
+            ret = ctk_event_get_sample(ctk_thermal->ctk_event, ctrl_target,
+                                       NV_CTRL_THERMAL_SENSOR_READING,
+                                       &reading);
             /* querying THERMAL_SENSOR_READING failed: assume the temperature is 0 */
             if (ret != NvCtrlSuccess) {
                 reading = 0;
@@ -435,8 +446,6 @@ static gboolean update_thermal_info(gpointer user_data)
     if ( ctk_thermal->cooler_count ) {
         update_cooler_info(ctk_thermal);
     }
-    
-    return TRUE;
 } /* update_thermal_info() */
 
 
@@ -966,12 +975,16 @@ static const char *get_nvctrl_format_name(const nvctrlFormatName *nvctrlFormatNa
 
 
 /*
- * pack_gauge() - pack gauge gui in hbox
+ * pack_gauge() - pack gauge gui, and the graph of the temperature
+ * history, in hbox
  */
 static GtkWidget *pack_gauge(GtkWidget *hbox, gint lower, gint upper,
-                             CtkConfig *ctk_config, const char *help)
+                             CtkThermal *ctk_thermal, CtrlTarget *ctrl_target,
+                             int attribute)
 {
-    GtkWidget *vbox, *frame, *eventbox, *gauge;
+    GtkWidget *vbox, *frame, *eventbox, *gauge, *graph;
+    CtkConfig *ctk_config = ctk_thermal->ctk_config;
+    CtkEventHistory *history;
     
     /* GPU Core Temperature Gauge */
 
@@ -989,8 +1002,18 @@ static GtkWidget *pack_gauge(GtkWidget *hbox, gint lower, gint upper,
     eventbox = gtk_event_box_new();
     gtk_container_add(GTK_CONTAINER(eventbox), gauge);
     gtk_box_pack_start(GTK_BOX(hbox), eventbox, FALSE, FALSE, 0);
-    ctk_config_set_tooltip(ctk_config, eventbox, help);
-    
+    ctk_config_set_tooltip(ctk_config, eventbox, __temp_level_help);
+
+    /* Temperature history */
+
+    history = ctk_event_add_history(ctk_thermal->ctk_event, ctrl_target,
+                                    attribute, CTRL_ATTRIBUTE_TYPE_INTEGER, 0);
+    graph = ctk_graph_new(ctk_thermal->ctk_event, history, lower, upper);
+    eventbox = gtk_event_box_new();
+    gtk_container_add(GTK_CONTAINER(eventbox), graph);
+    gtk_box_pack_start(GTK_BOX(hbox), eventbox, FALSE, FALSE, FRAME_PADDING);
+    ctk_config_set_tooltip(ctk_config, eventbox, __temp_history_help);
+
     return gauge;
 } /* pack_gauge() */
 
@@ -1107,8 +1130,9 @@ static void draw_sensor_gui(GtkWidget *vbox1, CtkThermal *ctk_thermal,
 
     /* GPU Core Temperature Gauge */
     ctk_thermal->sensor_info[cur_sensor_idx].core_gauge =
-        pack_gauge(hbox, lower, upper,
-                   ctk_thermal->ctk_config, __temp_level_help);
+        pack_gauge(hbox, lower, upper, ctk_thermal,
+                   ctk_thermal->sensor_info[cur_sensor_idx].ctrl_target,
+                   NV_CTRL_THERMAL_SENSOR_READING);
      
     /* add horizontal bar between sensors */
     if (cur_sensor_idx+1 != ctk_thermal->sensor_count) {
@@ -1254,6 +1278,7 @@ GtkWidget* ctk_thermal_new(CtrlTarget *ctrl_target,
     ctk_thermal = CTK_THERMAL(object);
     ctk_thermal->ctrl_target = ctrl_target;
     ctk_thermal->ctk_config = ctk_config;
+    ctk_thermal->ctk_event = ctk_event;
     ctk_thermal->settings_changed = FALSE;
     ctk_thermal->show_fan_control_frame = TRUE;
     ctk_thermal->cooler_count = cooler_count;
@@ -1452,8 +1477,9 @@ GtkWidget* ctk_thermal_new(CtrlTarget *ctrl_target,
 
         /* GPU Core Temperature Gauge */
 
-        ctk_thermal->core_gauge = pack_gauge(hbox1, 25, upper,
-                                             ctk_config, __temp_level_help);
+        ctk_thermal->core_gauge = pack_gauge(hbox1, 25, upper, ctk_thermal,
+                                             ctrl_target,
+                                             NV_CTRL_GPU_CORE_TEMPERATURE);
     }
 sensor_end:
     
@@ -1680,18 +1706,6 @@ end:
     sync_gui_to_modify_cooler_level(ctk_thermal);
     update_thermal_info(ctk_thermal);
     
-    /* Register a timer callback to update the temperatures */
-
-    s = g_strdup_printf("Thermal Monitor (GPU %d)",
-                        NvCtrlGetTargetId(ctrl_target));
-
-    ctk_config_add_timer(ctk_thermal->ctk_config,
-                         DEFAULT_UPDATE_THERMAL_INFO_TIME_INTERVAL,
-                         s,
-                         (GSourceFunc) update_thermal_info,
-                         (gpointer) ctk_thermal);
-    g_free(s);
-    
     gtk_widget_show_all(GTK_WIDGET(ctk_thermal));
     
     return GTK_WIDGET(ctk_thermal);
@@ -1755,6 +1769,8 @@ GtkTextBuffer *ctk_thermal_create_help(GtkTextTagTable *table,
     if (any_sensor) {
         ctk_help_heading(b, &i, "Level");
         ctk_help_para(b, &i, "%s", __temp_level_help);
+        ctk_help_heading(b, &i, "History");
+        ctk_help_para(b, &i, "%s", __temp_history_help);
     }
 
 
@@ -1802,24 +1818,133 @@ done:
     return b;
 }
 
+/*
+ * add_thermal_sample() - Have the GPU monitor sample the attribute, and
+ * record it so that exactly the same attributes are removed when the page
+ * is hidden.
+ */
+static void add_thermal_sample(CtkThermal *ctk_thermal,
+                               CtrlTarget *ctrl_target, int attrib)
+{
+    ThermalSamplePtr sample;
+
+    ctk_thermal->samples = nvrealloc(ctk_thermal->samples,
+                                     sizeof(ThermalSampleRec) *
+                                     (ctk_thermal->sample_count + 1));
+    sample = &ctk_thermal->samples[ctk_thermal->sample_count++];
+
+    sample->ctrl_target = ctrl_target;
+    sample->attrib = attrib;
+
+    ctk_event_add_sample(ctk_thermal->ctk_event, ctrl_target, attrib,
+                         CTRL_ATTRIBUTE_TYPE_INTEGER);
+}
+
+/*
+ * add_thermal_samples() - Add the temperatures and cooler information
+ * shown on the page to the attributes sampled by the GPU monitor.
+ */
+static void add_thermal_samples(CtkThermal *ctk_thermal)
+{
+    CtrlTarget *cooler_target;
+    int i;
+
+    if (ctk_thermal->samples) {
+        return;
+    }
+
+    if (!ctk_thermal->thermal_sensor_target_type_supported) {
+        add_thermal_sample(ctk_thermal, ctk_thermal->ctrl_target,
+                           NV_CTRL_GPU_CORE_TEMPERATURE);
+        if (ctk_thermal->ambient_label) {
+            add_thermal_sample(ctk_thermal, ctk_thermal->ctrl_target,
+                               NV_CTRL_AMBIENT_TEMPERATURE);
+        }
+    } else {
+        for (i = 0; i < ctk_thermal->sensor_count; i++) {
+            add_thermal_sample(ctk_thermal,
+                               ctk_thermal->sensor_info[i].ctrl_target,
+                               NV_CTRL_THERMAL_SENSOR_READING);
+        }
+    }
+
+    for (i = 0; i < ctk_thermal->cooler_count; i++) {
+        cooler_target = ctk_thermal->cooler_control[i].ctrl_target;
+
+        if (ctk_thermal->thermal_cooler_extra_info_supported) {
+            add_thermal_sample(ctk_thermal, cooler_target,
+                               NV_CTRL_THERMAL_COOLER_SPEED);
+            add_thermal_sample(ctk_thermal, cooler_target,
+                               NV_CTRL_THERMAL_COOLER_LEVEL);
+            add_thermal_sample(ctk_thermal, cooler_target,
+                               NV_CTRL_THERMAL_COOLER_CONTROL_TYPE);
+            add_thermal_sample(ctk_thermal, cooler_target,
+                               NV_CTRL_THERMAL_COOLER_TARGET);
+        } else {
+            add_thermal_sample(ctk_thermal, cooler_target,
+                               NV_CTRL_THERMAL_COOLER_CURRENT_LEVEL);
+        }
+    }
+}
+
+/*
+ * remove_thermal_samples() - Remove the attributes registered by
+ * add_thermal_samples() from the attributes sampled by the GPU monitor.
+ * The set of attributes shown on the page may have changed since (see
+ * update_cooler_info()), so the recorded set is removed rather than
+ * the current one.
+ */
+static void remove_thermal_samples(CtkThermal *ctk_thermal)
+{
+    int i;
+
+    for (i = 0; i < ctk_thermal->sample_count; i++) {
+        ctk_event_remove_sample(ctk_thermal->ctk_event,
+                                ctk_thermal->samples[i].ctrl_target,
+                                ctk_thermal->samples[i].attrib,
+                                CTRL_ATTRIBUTE_TYPE_INTEGER);
+    }
+
+    nvfree(ctk_thermal->samples);
+    ctk_thermal->samples = NULL;
+    ctk_thermal->sample_count = 0;
+}
+
+static void thermal_info_sampled(GObject *object,
+                                 gpointer arg1,
+                                 gpointer user_data)
+{
+    update_thermal_info(CTK_THERMAL(user_data));
+}
+
 void ctk_thermal_start_timer(GtkWidget *widget)
 {
     CtkThermal *ctk_thermal = CTK_THERMAL(widget);
 
-    /* Start the thermal timer */
+    /* Have the GPU monitor sample the thermal information */
 
-    ctk_config_start_timer(ctk_thermal->ctk_config,
-                           (GSourceFunc) update_thermal_info,
-                           (gpointer) ctk_thermal);
+    add_thermal_samples(ctk_thermal);
+
+    if (!ctk_thermal->sample_handler) {
+        ctk_thermal->sample_handler =
+            g_signal_connect(G_OBJECT(ctk_thermal->ctk_event),
+                             "CTK_EVENT_SampleNotify",
+                             G_CALLBACK(thermal_info_sampled),
+                             (gpointer) ctk_thermal);
+    }
 }
 
 void ctk_thermal_stop_timer(GtkWidget *widget)
 {
     CtkThermal *ctk_thermal = CTK_THERMAL(widget);
 
-    /* Stop the thermal timer */
+    /* Stop sampling the thermal information */
+
+    if (ctk_thermal->sample_handler) {
+        g_signal_handler_disconnect(G_OBJECT(ctk_thermal->ctk_event),
+                                    ctk_thermal->sample_handler);
+        ctk_thermal->sample_handler = 0;
+    }
 
-    ctk_config_stop_timer(ctk_thermal->ctk_config,
-                          (GSourceFunc) update_thermal_info,
-                          (gpointer) ctk_thermal);
+    remove_thermal_samples(ctk_thermal);
 }
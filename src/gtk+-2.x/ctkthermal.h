@@ -74,12 +74,18 @@ typedef struct _SensorInfo {
     GtkWidget *core_gauge;
 } SensorInfoRec, *SensorInfoPtr;
 
+typedef struct _ThermalSample {
+    CtrlTarget *ctrl_target;
+    int attrib;
+} ThermalSampleRec, *ThermalSamplePtr;
+
 struct _CtkThermal
 {
     GtkVBox parent;
 
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
+    CtkEvent *ctk_event;
 
     GtkWidget *core_label;
     GtkWidget *core_gauge;
@@ -106,6 +112,11 @@ struct _CtkThermal
     gboolean thermal_sensor_target_type_supported;
     gboolean thermal_cooler_extra_info_supported;
 
+    /* Attributes registered with the GPU monitor while the page is shown */
+    ThermalSamplePtr samples;
+    int sample_count;
+    gulong sample_handler; /* "CTK_EVENT_SampleNotify" handler, or 0 */
+
     gboolean any_sensor_target_supported;
     gboolean any_sensor_provider_supported;
     gboolean any_sensor_slowdown_supported;
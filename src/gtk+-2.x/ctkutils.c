@@ -704,6 +704,35 @@ GtkWidget *add_table_row(GtkWidget *table,
 
 
 
+/*
+ * add_table_widget_row() - like add_table_row_with_help_text(), with the
+ * given widget (at its requested size) in place of the value label
+ */
+void add_table_widget_row(GtkWidget *table, CtkConfig *ctk_config,
+                          const char *help, const gint row,
+                          const gchar *name, GtkWidget *widget)
+{
+    GtkWidget *label, *hbox, *eventbox;
+
+    label = gtk_label_new(name);
+    gtk_label_set_selectable(GTK_LABEL(label), TRUE);
+    gtk_misc_set_alignment(GTK_MISC(label), 0.0, 0.5);
+    gtk_table_attach(GTK_TABLE(table), label, 0, 1, row, row + 1,
+                     GTK_FILL, GTK_EXPAND | GTK_FILL, 0, 0);
+
+    hbox = gtk_hbox_new(FALSE, 0);
+    eventbox = gtk_event_box_new();
+    gtk_container_add(GTK_CONTAINER(eventbox), widget);
+    gtk_box_pack_start(GTK_BOX(hbox), eventbox, FALSE, FALSE, 0);
+    gtk_table_attach(GTK_TABLE(table), hbox, 1, 2, row, row + 1,
+                     GTK_FILL, GTK_EXPAND | GTK_FILL, 0, 0);
+    if ((help != NULL) || (ctk_config != NULL)) {
+        ctk_config_set_tooltip(ctk_config, eventbox, help);
+    }
+}
+
+
+
 /** ctk_get_parent_window() ******************************************
  *
  * Returns the parent window of a widget, if one exists
@@ -163,6 +163,10 @@ GtkWidget *add_table_row(GtkWidget *, const gint,
                          const gfloat, const gfloat, const gchar *,
                          const gfloat, const gfloat, const gchar *);
 
+void add_table_widget_row(GtkWidget *table, CtkConfig *ctk_config,
+                          const char *help, const gint row,
+                          const gchar *name, GtkWidget *widget);
+
 GtkWidget * ctk_get_parent_window(GtkWidget *child);
 
 void ctk_display_error_msg(GtkWidget *parent, gchar *msg);
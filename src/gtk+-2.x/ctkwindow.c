@@ -72,6 +72,8 @@
 
 #include "ctkpowermode.h"
 
+#define DEFAULT_GPU_MONITOR_TIME_INTERVAL 1000
+
 /* column enumeration */
 
 enum {
@@ -850,6 +852,7 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
     for (node = system->targets[GPU_TARGET]; node; node = node->next) {
 
         gchar *gpu_name;
+        gchar *timer_name;
         GtkWidget *child;
         CtrlTarget *gpu_target = node->t;
         UpdateDisplaysData *data;
@@ -868,6 +871,21 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
         ctk_event = CTK_EVENT(ctk_event_new(gpu_target));
 
+        /*
+         * sample the changing values (temperatures, clocks, utilization)
+         * shown on the gpu's pages from a single timer; the pages add
+         * what they show to the sampled attributes while visible
+         */
+
+        timer_name = g_strdup_printf("GPU Monitor (GPU %d)",
+                                     NvCtrlGetTargetId(gpu_target));
+        ctk_config_add_timer(ctk_config, DEFAULT_GPU_MONITOR_TIME_INTERVAL,
+                             timer_name, (GSourceFunc) ctk_event_sample,
+                             (gpointer) ctk_event);
+        ctk_config_start_timer(ctk_config, (GSourceFunc) ctk_event_sample,
+                               (gpointer) ctk_event);
+        g_free(timer_name);
+
         /* create the gpu entry */
 
         gtk_tree_store_append(ctk_window->tree_store, &iter, NULL);
@@ -129,7 +129,7 @@ static uintptr_t version_flags(Display *dpy, XExtDisplayInfo *info)
     uintptr_t data = (uintptr_t)info->data;
 
     /* If necessary, determine the NV-CONTROL version */
-    if (data & NVCTRL_EXT_NEED_CHECK) {
+    if (data == NVCTRL_EXT_NEED_CHECK) {
         int major, minor;
         data = 0;
         if (XNVCTRLQueryVersion(dpy, &major, &minor)) {
@@ -437,6 +437,147 @@ Bool XNVCTRLQueryTargetAttribute64 (
 }
 
 
+/*
+ * State shared with QueryAttributesBatchHandler() while the replies to a
+ * batch of attribute queries are read back.  The replies to all but the
+ * last request of the batch are consumed asynchronously by the handler.
+ */
+
+typedef struct {
+    unsigned long first_request;
+    int count;
+    Bool value_64;
+    XNVCTRLAttributeQuery *queries;
+} QueryAttributesBatchState;
+
+static Bool QueryAttributesBatchHandler (
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    QueryAttributesBatchState *state = (QueryAttributesBatchState *) data;
+    unsigned long index = dpy->last_request_read - state->first_request;
+    XNVCTRLAttributeQuery *query;
+    union {
+        xnvCtrlQueryAttributeReply rep32;
+        xnvCtrlQueryAttribute64Reply rep64;
+    } replbuf, *repl;
+
+    if (index >= (unsigned long) state->count)
+        return False;
+
+    query = &state->queries[index];
+
+    /* Leave errors to the regular Xlib error handling */
+    if (rep->generic.type == X_Error) {
+        query->exists = False;
+        return False;
+    }
+
+    repl = (void *) _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                    (SIZEOF(xnvCtrlQueryAttributeReply) -
+                                     SIZEOF(xReply)) >> 2,
+                                    True);
+
+    if (state->value_64) {
+        query->exists = repl->rep64.flags;
+        if (query->exists) query->value = repl->rep64.value_64;
+    } else {
+        query->exists = repl->rep32.flags;
+        if (query->exists) query->value = repl->rep32.value;
+    }
+
+    return True;
+}
+
+Bool XNVCTRLQueryTargetAttributesBatch (
+    Display *dpy,
+    XNVCTRLAttributeQuery *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display (dpy);
+    QueryAttributesBatchState state;
+    _XAsyncHandler async;
+    union {
+        xnvCtrlQueryAttributeReply rep32;
+        xnvCtrlQueryAttribute64Reply rep64;
+    } rep;
+    xnvCtrlQueryAttributeReq *req;
+    XNVCTRLAttributeQuery *last;
+    Bool value_64;
+    int i;
+
+    if(!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension (dpy, info, False);
+
+    if (count <= 0)
+        return True;
+
+    /*
+     * Resolve the version-dependent flags now: this may require a round
+     * trip, which cannot be made once the display is locked below.
+     */
+    value_64 = (version_flags(dpy, info) & NVCTRL_EXT_64_BIT_ATTRIBUTES) != 0;
+
+    for (i = 0; i < count; i++) {
+        queries[i].exists = False;
+    }
+
+    LockDisplay (dpy);
+
+    state.first_request = 0;
+    state.count = count - 1;
+    state.value_64 = value_64;
+    state.queries = queries;
+
+    async.next = dpy->async_handlers;
+    async.handler = QueryAttributesBatchHandler;
+    async.data = (XPointer) &state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        int target_type = queries[i].target_type;
+        int target_id = queries[i].target_id;
+
+        XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
+
+        GetReq (nvCtrlQueryAttribute, req);
+        if (i == 0) state.first_request = dpy->request;
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = value_64 ? X_nvCtrlQueryAttribute64 :
+                                    X_nvCtrlQueryAttribute;
+        req->target_type = target_type;
+        req->target_id = target_id;
+        req->display_mask = queries[i].display_mask;
+        req->attribute = queries[i].attribute;
+    }
+
+    /*
+     * Wait for the reply to the last request; replies are returned in
+     * order, so by then the handler has seen all of the earlier ones.
+     */
+    last = &queries[count - 1];
+    if (_XReply (dpy, (xReply *) &rep, 0, xTrue)) {
+        if (value_64) {
+            last->exists = rep.rep64.flags;
+            if (last->exists) last->value = rep.rep64.value_64;
+        } else {
+            last->exists = rep.rep32.flags;
+            if (last->exists) last->value = rep.rep32.value;
+        }
+    }
+
+    DeqAsyncHandler (dpy, &async);
+    UnlockDisplay (dpy);
+    SyncHandle ();
+    return True;
+}
+
+
 Bool XNVCTRLQueryTargetStringAttribute (
     Display *dpy,
     int target_type,
@@ -741,6 +882,170 @@ Bool XNVCTRLQueryValidTargetAttributeValues (
 }
 
 
+
+/*
+ * State shared with QueryValidValuesBatchHandler() while the replies to a
+ * batch of valid values queries are read back; see
+ * QueryAttributesBatchState.
+ */
+
+typedef struct {
+    unsigned long first_request;
+    int count;
+    Bool value_64;
+    XNVCTRLValidValuesQuery *queries;
+} QueryValidValuesBatchState;
+
+static void CopyValidValuesReply (
+    XNVCTRLValidValuesQuery *query,
+    Bool value_64,
+    const void *reply
+){
+    if (value_64) {
+        const xnvCtrlQueryValidAttributeValues64Reply *rep = reply;
+
+        query->exists = rep->flags;
+        if (!query->exists) return;
+
+        query->values.type = rep->attr_type;
+        if (rep->attr_type == ATTRIBUTE_TYPE_RANGE) {
+            query->values.u.range.min = rep->min_64;
+            query->values.u.range.max = rep->max_64;
+        }
+        if (rep->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+            query->values.u.bits.ints = rep->bits_64;
+        }
+        query->values.permissions = rep->perms;
+    } else {
+        const xnvCtrlQueryValidAttributeValuesReply *rep = reply;
+
+        query->exists = rep->flags;
+        if (!query->exists) return;
+
+        query->values.type = rep->attr_type;
+        if (rep->attr_type == ATTRIBUTE_TYPE_RANGE) {
+            query->values.u.range.min = rep->min;
+            query->values.u.range.max = rep->max;
+        }
+        if (rep->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+            query->values.u.bits.ints = rep->bits;
+        }
+        query->values.permissions = rep->perms;
+    }
+}
+
+static Bool QueryValidValuesBatchHandler (
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    QueryValidValuesBatchState *state = (QueryValidValuesBatchState *) data;
+    unsigned long index = dpy->last_request_read - state->first_request;
+    union {
+        xnvCtrlQueryValidAttributeValuesReply rep32;
+        xnvCtrlQueryValidAttributeValues64Reply rep64;
+    } replbuf, *repl;
+
+    if (index >= (unsigned long) state->count)
+        return False;
+
+    /* Leave errors to the regular Xlib error handling */
+    if (rep->generic.type == X_Error) {
+        state->queries[index].exists = False;
+        return False;
+    }
+
+    repl = (void *) _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                    state->value_64 ?
+                                    sz_xnvCtrlQueryValidAttributeValues64Reply_extra :
+                                    0,
+                                    True);
+
+    CopyValidValuesReply(&state->queries[index], state->value_64, repl);
+
+    return True;
+}
+
+Bool XNVCTRLQueryValidTargetAttributeValuesBatch (
+    Display *dpy,
+    XNVCTRLValidValuesQuery *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display (dpy);
+    QueryValidValuesBatchState state;
+    _XAsyncHandler async;
+    union {
+        xnvCtrlQueryValidAttributeValuesReply rep32;
+        xnvCtrlQueryValidAttributeValues64Reply rep64;
+    } rep;
+    xnvCtrlQueryValidAttributeValuesReq *req;
+    uintptr_t flags;
+    Bool value_64;
+    int i;
+
+    if(!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension (dpy, info, False);
+
+    if (count <= 0)
+        return True;
+
+    /* May require a round trip; see XNVCTRLQueryTargetAttributesBatch() */
+    flags = version_flags(dpy, info);
+    if (!(flags & NVCTRL_EXT_EXISTS))
+        return False;
+    value_64 = (flags & NVCTRL_EXT_64_BIT_ATTRIBUTES) != 0;
+
+    for (i = 0; i < count; i++) {
+        queries[i].exists = False;
+    }
+
+    LockDisplay (dpy);
+
+    state.first_request = 0;
+    state.count = count - 1;
+    state.value_64 = value_64;
+    state.queries = queries;
+
+    async.next = dpy->async_handlers;
+    async.handler = QueryValidValuesBatchHandler;
+    async.data = (XPointer) &state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        int target_type = queries[i].target_type;
+        int target_id = queries[i].target_id;
+
+        XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
+
+        GetReq (nvCtrlQueryValidAttributeValues, req);
+        if (i == 0) state.first_request = dpy->request;
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = value_64 ? X_nvCtrlQueryValidAttributeValues64 :
+                                    X_nvCtrlQueryValidAttributeValues;
+        req->target_type = target_type;
+        req->target_id = target_id;
+        req->display_mask = queries[i].display_mask;
+        req->attribute = queries[i].attribute;
+    }
+
+    /* Replies are returned in order; see XNVCTRLQueryTargetAttributesBatch() */
+    if (_XReply (dpy, (xReply *) &rep,
+                 value_64 ? sz_xnvCtrlQueryValidAttributeValues64Reply_extra : 0,
+                 xTrue)) {
+        CopyValidValuesReply(&queries[count - 1], value_64, &rep);
+    }
+
+    DeqAsyncHandler (dpy, &async);
+    UnlockDisplay (dpy);
+    SyncHandle ();
+    return True;
+}
+
+
 Bool XNVCTRLQueryValidAttributeValues (
     Display *dpy,
     int screen,
@@ -265,6 +265,50 @@ Bool XNVCTRLQueryTargetAttribute64 (
 );
 
 
+/*
+ * XNVCTRLAttributeQuery - describes one query of a batch issued with
+ * XNVCTRLQueryTargetAttributesBatch().  The caller fills in the target,
+ * display_mask and attribute fields; exists and value are filled in by
+ * the library.
+ */
+
+typedef struct {
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+    Bool exists;
+    int64_t value;
+} XNVCTRLAttributeQuery;
+
+
+/*
+ * XNVCTRLQueryTargetAttributesBatch -
+ *
+ *  Queries each of the 'count' attributes described by 'queries'.  All
+ *  of the requests are sent to the X server before any reply is read,
+ *  so the whole batch costs a single round trip rather than one round
+ *  trip per attribute.
+ *
+ *  For each query, exists is set to what XNVCTRLQueryTargetAttribute64()
+ *  would have returned for it and, if the attribute exists, value will
+ *  contain the value of the attribute.
+ *
+ *  Returns False if the NV-CONTROL extension is not present, True
+ *  otherwise.
+ *
+ *  Possible errors (one per failing query):
+ *     BadValue - The target doesn't exist.
+ *     BadMatch - The NVIDIA driver does not control the target.
+ */
+
+Bool XNVCTRLQueryTargetAttributesBatch (
+    Display *dpy,
+    XNVCTRLAttributeQuery *queries,
+    int count
+);
+
+
 /*
  *  XNVCTRLQueryStringAttribute -
  *
@@ -398,6 +442,45 @@ Bool XNVCTRLQueryValidTargetAttributeValues (
 );
 
 
+/*
+ * XNVCTRLValidValuesQuery - describes one query of a batch issued with
+ * XNVCTRLQueryValidTargetAttributeValuesBatch().  The caller fills in the
+ * target, display_mask and attribute fields; exists and values are filled
+ * in by the library.
+ */
+
+typedef struct {
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+    Bool exists;
+    NVCTRLAttributeValidValuesRec values;
+} XNVCTRLValidValuesQuery;
+
+
+/*
+ * XNVCTRLQueryValidTargetAttributeValuesBatch -
+ *
+ *  Queries the valid values of each of the 'count' attributes described
+ *  by 'queries', sending all of the requests before reading any reply,
+ *  like XNVCTRLQueryTargetAttributesBatch().
+ *
+ *  For each query, exists is set to what
+ *  XNVCTRLQueryValidTargetAttributeValues() would have returned for it
+ *  and, if the attribute exists, values will indicate its valid values.
+ *
+ *  Returns False if the NV-CONTROL extension is not present, True
+ *  otherwise.
+ */
+
+Bool XNVCTRLQueryValidTargetAttributeValuesBatch (
+    Display *dpy,
+    XNVCTRLValidValuesQuery *queries,
+    int count
+);
+
+
 /*
  * XNVCTRLQueryValidTargetStringAttributeValues -
  *
@@ -197,6 +197,7 @@ NvCtrlAttributeHandle *NvCtrlAttributeInit(CtrlSystem *system,
     h->dpy = system->dpy;
     h->target_type = target_type;
     h->target_id = target_id;
+    h->cache = system->cache;
 
     /* initialize the NV-CONTROL attributes */
 
@@ -711,22 +712,13 @@ ReturnStatus NvCtrlGetValidAttributeValues(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetValidAttributeValues() */
 
 
-ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
-                                     CtrlAttributeType attr_type,
-                                     int attr,
-                                     CtrlAttributePerms *perms)
+static ReturnStatus GetAttributePerms(const NvCtrlAttributePrivateHandle *h,
+                                      CtrlAttributeType attr_type,
+                                      int attr,
+                                      CtrlAttributePerms *perms)
 {
-    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
     ReturnStatus ret = NvCtrlError;
 
-    if (h == NULL) {
-        return NvCtrlBadHandle;
-    }
-
-    if (perms == NULL) {
-        return NvCtrlBadArgument;
-    }
-
     switch (attr_type) {
         case CTRL_ATTRIBUTE_TYPE_INTEGER:
         case CTRL_ATTRIBUTE_TYPE_STRING:
@@ -756,6 +748,38 @@ ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
 }
 
 
+ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
+                                     CtrlAttributeType attr_type,
+                                     int attr,
+                                     CtrlAttributePerms *perms)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (perms == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_PERMS,
+                                   attr_type, 0, attr, perms, &ret)) {
+        return ret;
+    }
+
+    ret = GetAttributePerms(h, attr_type, attr, perms);
+
+    NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_PERMS,
+                              attr_type, 0, attr, perms, ret);
+
+    return ret;
+
+} /* NvCtrlGetAttributePerms() */
+
+
 
 ReturnStatus NvCtrlGetStringAttribute(const CtrlTarget *ctrl_target,
                                       int attr, char **ptr)
@@ -773,9 +797,9 @@ ReturnStatus NvCtrlSetStringAttribute(CtrlTarget *ctrl_target,
 } /* NvCtrlSetStringAttribute() */
 
 
-ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
-                                         unsigned int display_mask,
-                                         int attr, int64_t *val)
+static ReturnStatus GetDisplayAttribute64(const CtrlTarget *ctrl_target,
+                                          unsigned int display_mask,
+                                          int attr, int64_t *val)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
 
@@ -847,8 +871,126 @@ ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
 
     return NvCtrlNoAttribute;
     
+} /* GetDisplayAttribute64() */
+
+
+ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
+                                         unsigned int display_mask,
+                                         int attr, int64_t *val)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_VALUE,
+                                   CTRL_ATTRIBUTE_TYPE_INTEGER, display_mask,
+                                   attr, val, &ret)) {
+        return ret;
+    }
+
+    ret = GetDisplayAttribute64(ctrl_target, display_mask, attr, val);
+
+    NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_VALUE,
+                              CTRL_ATTRIBUTE_TYPE_INTEGER, display_mask,
+                              attr, val, ret);
+
+    return ret;
+
 } /* NvCtrlGetDisplayAttribute64() */
 
+
+ReturnStatus NvCtrlGetDisplayAttributes(const CtrlTarget *ctrl_target,
+                                        CtrlAttributeQuery *queries,
+                                        int count)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    int *nvctrl_queries;
+    int i, n = 0;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (count <= 0) {
+        return NvCtrlSuccess;
+    }
+
+    if (queries == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    nvctrl_queries = nvalloc(sizeof(int) * count);
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeQuery *q = &queries[i];
+
+        if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_VALUE,
+                                       CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                       q->display_mask, q->attr, &q->val,
+                                       &q->status)) {
+            continue;
+        }
+
+        /*
+         * Defer the queries that NvCtrlGetDisplayAttribute64() would
+         * send to NV-CONTROL; everything else is resolved right away.
+         */
+
+        if (h->nv &&
+            (q->attr >= 0) && (q->attr <= NV_CTRL_LAST_ATTRIBUTE) &&
+            (h->target_type >= 0) && (h->target_type < MAX_TARGET_TYPES)) {
+
+            switch (h->target_type) {
+                case GPU_TARGET:
+                case THERMAL_SENSOR_TARGET:
+                case COOLER_TARGET:
+                    q->status = NvCtrlNvmlGetAttribute(ctrl_target, q->attr,
+                                                       &q->val);
+                    if (q->status == NvCtrlSuccess) {
+                        NvCtrlAttributeCacheStore(cache, h,
+                                                  CTRL_ATTRIBUTE_CACHE_VALUE,
+                                                  CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                                  q->display_mask, q->attr,
+                                                  &q->val, q->status);
+                        continue;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            nvctrl_queries[n++] = i;
+            continue;
+        }
+
+        q->status = NvCtrlGetDisplayAttribute64(ctrl_target, q->display_mask,
+                                                q->attr, &q->val);
+    }
+
+    if (n > 0) {
+        NvCtrlNvControlGetAttributes(h, queries, nvctrl_queries, n);
+
+        for (i = 0; i < n; i++) {
+            const CtrlAttributeQuery *q = &queries[nvctrl_queries[i]];
+
+            NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_VALUE,
+                                      CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                      q->display_mask, q->attr,
+                                      &q->val, q->status);
+        }
+    }
+
+    nvfree(nvctrl_queries);
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlGetDisplayAttributes() */
+
 ReturnStatus NvCtrlGetDisplayAttribute(const CtrlTarget *ctrl_target,
                                        unsigned int display_mask,
                                        int attr, int *val)
@@ -867,9 +1009,9 @@ ReturnStatus NvCtrlGetDisplayAttribute(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetDisplayAttribute() */
 
 
-ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
-                                       unsigned int display_mask,
-                                       int attr, int val)
+static ReturnStatus SetDisplayAttribute(CtrlTarget *ctrl_target,
+                                        unsigned int display_mask,
+                                        int attr, int val)
 {
     NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
     ReturnStatus ret = NvCtrlMissingExtension;
@@ -919,6 +1061,33 @@ ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
 }
 
 
+/*
+ * Assignments may have side effects on other attributes of the same
+ * target, so drop everything cached for it.  This is done again once the
+ * assignment completes, in case another thread cached a result while it
+ * was in flight.
+ */
+
+ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
+                                       unsigned int display_mask,
+                                       int attr, int val)
+{
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+    ret = SetDisplayAttribute(ctrl_target, display_mask, attr, val);
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+
+    return ret;
+}
+
+
 ReturnStatus NvCtrlGetVoidDisplayAttribute(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask,
                                            int attr, void **ptr)
@@ -957,10 +1126,10 @@ ReturnStatus NvCtrlGetVoidDisplayAttribute(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetVoidDisplayAttribute() */
 
 
-ReturnStatus
-NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
-                                     unsigned int display_mask, int attr,
-                                     CtrlAttributeValidValues *val)
+static ReturnStatus
+GetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
+                               unsigned int display_mask, int attr,
+                               CtrlAttributeValidValues *val)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
     ReturnStatus ret = NvCtrlMissingExtension;
@@ -1006,9 +1175,138 @@ NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
 
     return NvCtrlNoAttribute;
     
+} /* GetValidDisplayAttributeValues() */
+
+
+ReturnStatus
+NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
+                                     unsigned int display_mask, int attr,
+                                     CtrlAttributeValidValues *val)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                                   CTRL_ATTRIBUTE_TYPE_INTEGER, display_mask,
+                                   attr, val, &ret)) {
+        return ret;
+    }
+
+    ret = GetValidDisplayAttributeValues(ctrl_target, display_mask, attr, val);
+
+    NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                              CTRL_ATTRIBUTE_TYPE_INTEGER, display_mask,
+                              attr, val, ret);
+
+    return ret;
+
 } /* NvCtrlGetValidDisplayAttributeValues() */
 
 
+ReturnStatus
+NvCtrlGetValidDisplayAttributeValuesBatch(const CtrlTarget *ctrl_target,
+                                          CtrlAttributeValidQuery *queries,
+                                          int count)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    int *nvctrl_queries;
+    int i, n = 0;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (count <= 0) {
+        return NvCtrlSuccess;
+    }
+
+    if (queries == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    nvctrl_queries = nvalloc(sizeof(int) * count);
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeValidQuery *q = &queries[i];
+
+        if (NvCtrlAttributeCacheLookup(cache, h,
+                                       CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                                       CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                       q->display_mask, q->attr,
+                                       &q->valid, &q->status)) {
+            continue;
+        }
+
+        /*
+         * Defer the queries that GetValidDisplayAttributeValues() would
+         * send to NV-CONTROL; everything else is resolved right away.
+         */
+
+        if (h->nv &&
+            (q->attr >= 0) && (q->attr <= NV_CTRL_LAST_ATTRIBUTE)) {
+
+            switch (h->target_type) {
+                case GPU_TARGET:
+                case THERMAL_SENSOR_TARGET:
+                case COOLER_TARGET:
+                    q->status = NvCtrlNvmlGetValidAttributeValues(ctrl_target,
+                                                                  q->attr,
+                                                                  &q->valid);
+                    if (q->status == NvCtrlSuccess) {
+                        break;
+                    }
+                    /* Fall through */
+                case DISPLAY_TARGET:
+                case X_SCREEN_TARGET:
+                case FRAMELOCK_TARGET:
+                case NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET:
+                case MUX_TARGET:
+                    nvctrl_queries[n++] = i;
+                    continue;
+                default:
+                    q->status = NvCtrlBadHandle;
+                    break;
+            }
+        } else {
+            q->status = GetValidDisplayAttributeValues(ctrl_target,
+                                                       q->display_mask,
+                                                       q->attr, &q->valid);
+        }
+
+        NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                                  CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                  q->display_mask, q->attr, &q->valid,
+                                  q->status);
+    }
+
+    if (n > 0) {
+        NvCtrlNvControlGetValidAttributeValuesBatch(h, queries,
+                                                    nvctrl_queries, n);
+
+        for (i = 0; i < n; i++) {
+            CtrlAttributeValidQuery *q = &queries[nvctrl_queries[i]];
+
+            NvCtrlAttributeCacheStore(cache, h,
+                                      CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                                      CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                      q->display_mask, q->attr, &q->valid,
+                                      q->status);
+        }
+    }
+
+    nvfree(nvctrl_queries);
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlGetValidDisplayAttributeValuesBatch() */
+
+
 /*
  * GetValidStringDisplayAttributeValuesExtraAttr() -fill the
  * CtrlAttributeValidValues strucure for extra string attributes i.e.
@@ -1031,14 +1329,14 @@ GetValidStringDisplayAttributeValuesExtraAttr(CtrlAttributeValidValues *val)
 
 
 /*
- * NvCtrlGetValidStringDisplayAttributeValues() -fill the
+ * GetValidStringDisplayAttributeValues() -fill the
  * CtrlAttributeValidValues structure for String attributes
  */
 
-ReturnStatus
-NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
-                                           unsigned int display_mask, int attr,
-                                           CtrlAttributeValidValues *val)
+static ReturnStatus
+GetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
+                                     unsigned int display_mask, int attr,
+                                     CtrlAttributeValidValues *val)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
     ReturnStatus ret = NvCtrlMissingExtension;
@@ -1121,12 +1419,43 @@ NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
 
     return NvCtrlNoAttribute;
 
+} /* GetValidStringDisplayAttributeValues() */
+
+
+ReturnStatus
+NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
+                                           unsigned int display_mask, int attr,
+                                           CtrlAttributeValidValues *val)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                                   CTRL_ATTRIBUTE_TYPE_STRING, display_mask,
+                                   attr, val, &ret)) {
+        return ret;
+    }
+
+    ret = GetValidStringDisplayAttributeValues(ctrl_target, display_mask,
+                                               attr, val);
+
+    NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+                              CTRL_ATTRIBUTE_TYPE_STRING, display_mask,
+                              attr, val, ret);
+
+    return ret;
+
 } /* NvCtrlGetValidStringDisplayAttributeValues() */
 
 
-ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
-                                             unsigned int display_mask,
-                                             int attr, char **ptr)
+static ReturnStatus GetStringDisplayAttribute(const CtrlTarget *ctrl_target,
+                                              unsigned int display_mask,
+                                              int attr, char **ptr)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
 
@@ -1208,12 +1537,41 @@ ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
             return NvCtrlBadHandle;
     }
 
-} /* NvCtrlGetStringDisplayAttribute() */
+} /* GetStringDisplayAttribute() */
 
 
-ReturnStatus NvCtrlSetStringDisplayAttribute(CtrlTarget *ctrl_target,
+ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
                                              unsigned int display_mask,
-                                             int attr, const char *ptr)
+                                             int attr, char **ptr)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (NvCtrlAttributeCacheLookup(cache, h, CTRL_ATTRIBUTE_CACHE_STRING,
+                                   CTRL_ATTRIBUTE_TYPE_STRING, display_mask,
+                                   attr, ptr, &ret)) {
+        return ret;
+    }
+
+    ret = GetStringDisplayAttribute(ctrl_target, display_mask, attr, ptr);
+
+    NvCtrlAttributeCacheStore(cache, h, CTRL_ATTRIBUTE_CACHE_STRING,
+                              CTRL_ATTRIBUTE_TYPE_STRING, display_mask,
+                              attr, ptr, ret);
+
+    return ret;
+
+} /* NvCtrlGetStringDisplayAttribute() */
+
+
+static ReturnStatus SetStringDisplayAttribute(CtrlTarget *ctrl_target,
+                                              unsigned int display_mask,
+                                              int attr, const char *ptr)
 {
     NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
 
@@ -1254,6 +1612,28 @@ ReturnStatus NvCtrlSetStringDisplayAttribute(CtrlTarget *ctrl_target,
 }
 
 
+/* See NvCtrlSetDisplayAttribute() for the cache invalidation */
+
+ReturnStatus NvCtrlSetStringDisplayAttribute(CtrlTarget *ctrl_target,
+                                             unsigned int display_mask,
+                                             int attr, const char *ptr)
+{
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+    ret = SetStringDisplayAttribute(ctrl_target, display_mask, attr, ptr);
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+
+    return ret;
+}
+
+
 ReturnStatus NvCtrlGetBinaryAttribute(const CtrlTarget *ctrl_target,
                                       unsigned int display_mask, int attr,
                                       unsigned char **data, int *len)
@@ -1300,9 +1680,9 @@ ReturnStatus NvCtrlGetBinaryAttribute(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetBinaryAttribute() */
 
 
-ReturnStatus NvCtrlStringOperation(CtrlTarget *ctrl_target,
-                                   unsigned int display_mask, int attr,
-                                   const char *ptrIn, char **ptrOut)
+static ReturnStatus StringOperation(CtrlTarget *ctrl_target,
+                                    unsigned int display_mask, int attr,
+                                    const char *ptrIn, char **ptrOut)
 {
     NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
 
@@ -1320,6 +1700,28 @@ ReturnStatus NvCtrlStringOperation(CtrlTarget *ctrl_target,
 }
 
 
+/* See NvCtrlSetDisplayAttribute() for the cache invalidation */
+
+ReturnStatus NvCtrlStringOperation(CtrlTarget *ctrl_target,
+                                   unsigned int display_mask, int attr,
+                                   const char *ptrIn, char **ptrOut)
+{
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+    CtrlAttributeCache *cache = getAttributeCache(ctrl_target);
+    ReturnStatus ret;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+    ret = StringOperation(ctrl_target, display_mask, attr, ptrIn, ptrOut);
+    NvCtrlAttributeCacheInvalidate(cache, h, INVALID_TARGET, 0, -1);
+
+    return ret;
+}
+
+
 char *NvCtrlAttributesStrError(ReturnStatus status)
 {
     switch (status) {
@@ -1358,6 +1760,13 @@ void NvCtrlAttributeClose(NvCtrlAttributeHandle *handle)
         return;
     }
 
+    /*
+     * Drop the results cached for this handle, so that they cannot be
+     * mistaken for those of a handle later allocated at the same address.
+     */
+
+    NvCtrlAttributeCacheInvalidate(h->cache, h, INVALID_TARGET, 0, -1);
+
     /*
      * XXX should free any additional resources allocated by each
      * subsystem
@@ -1759,6 +2168,7 @@ NvCtrlEventHandle *NvCtrlGetEventHandle(const CtrlTarget *ctrl_target)
         evt_h->fd = ConnectionNumber(h->dpy);
         evt_h->nvctrl_event_base = (h->nv) ? h->nv->event_base : -1;
         evt_h->xrandr_event_base = (h->xrandr) ? h->xrandr->event_base : -1;
+        evt_h->system = ctrl_target->system;
 
         /* Add it to the list of event handles */
         evt_hnode = nvalloc(sizeof(*evt_hnode));
@@ -1880,18 +2290,11 @@ static int get_screen_of_root(Display *dpy, Window root)
     return screen;
 }
 
-ReturnStatus
-NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
+static ReturnStatus
+EventHandleNextEvent(NvCtrlEventPrivateHandle *evt_h, CtrlEvent *event)
 {
-    NvCtrlEventPrivateHandle *evt_h;
     XEvent xevent;
 
-    if (!handle) {
-        return NvCtrlBadArgument;
-    }
-
-    evt_h = (NvCtrlEventPrivateHandle*)handle;
-
     memset(event, 0, sizeof(CtrlEvent));
 
 
@@ -2047,3 +2450,25 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
     return NvCtrlSuccess;
 }
 
+
+ReturnStatus
+NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
+{
+    NvCtrlEventPrivateHandle *evt_h;
+    ReturnStatus status;
+
+    if (!handle) {
+        return NvCtrlBadArgument;
+    }
+
+    evt_h = (NvCtrlEventPrivateHandle*)handle;
+
+    status = EventHandleNextEvent(evt_h, event);
+
+    if ((status == NvCtrlSuccess) && evt_h->system) {
+        NvCtrlAttributeCacheHandleEvent(evt_h->system->cache, event);
+    }
+
+    return status;
+}
+
@@ -103,6 +103,7 @@ typedef struct _CtrlTarget CtrlTarget;
 typedef struct _CtrlTargetNode CtrlTargetNode;
 typedef struct _CtrlSystem CtrlSystem;
 typedef struct _CtrlSystemList CtrlSystemList;
+typedef struct _CtrlAttributeCache CtrlAttributeCache;
 
 struct _CtrlTarget {
     NvCtrlAttributeHandle *h; /* handle for this target */
@@ -147,6 +148,7 @@ struct _CtrlSystem {
     CtrlTargetNode *targets[MAX_TARGET_TYPES]; /* Shadows targetTypeTable */
     CtrlTargetNode *physical_screens;
     CtrlSystemList *system_list; /* pointer to the system list being tracked */
+    CtrlAttributeCache *cache;   /* attribute query cache; NULL if disabled */
 };
 
 /* Tracks all systems referenced by command line and/or the configuration
@@ -498,6 +500,30 @@ typedef struct {
 } CtrlAttributeValidValues;
 
 
+/*
+ * Used to query several integer attributes at once; see
+ * NvCtrlGetDisplayAttributes()
+ */
+typedef struct {
+    unsigned int display_mask;
+    int attr;
+    int64_t val;
+    ReturnStatus status;
+} CtrlAttributeQuery;
+
+
+/*
+ * Used to query the valid values of several integer attributes at once;
+ * see NvCtrlGetValidDisplayAttributeValuesBatch()
+ */
+typedef struct {
+    unsigned int display_mask;
+    int attr;
+    CtrlAttributeValidValues valid;
+    ReturnStatus status;
+} CtrlAttributeValidQuery;
+
+
 /*
  * Event handle and event structure used to provide an event mechanism to
  * communicate different backends with the frontend
@@ -561,6 +587,40 @@ typedef struct {
 #define NV_CTRL_STRING_NV_CONTROL_LAST_ATTRIBUTE  (NV_CTRL_STRING_NV_CONTROL_VERSION)
 
 
+/*
+ * Additional binary attributes for NvCtrlGetBinaryAttribute(); these are
+ * in addition to the ones in NVCtrl.h
+ */
+
+#define NV_CTRL_BINARY_DATA_ATTR_BASE        (NV_CTRL_BINARY_DATA_LAST_ATTRIBUTE + 1)
+
+/*
+ * NV_CTRL_BINARY_DATA_GPU_UTILIZATION - Returns a CtrlGpuUtilization
+ * structure with the current utilization of the GPU's engines, in percent.
+ * This carries the same values as NV_CTRL_STRING_GPU_UTILIZATION without
+ * formatting them into a string; it is filled directly from NVML when
+ * there is no NV-CONTROL connection.
+ */
+
+#define NV_CTRL_BINARY_DATA_GPU_UTILIZATION  (NV_CTRL_BINARY_DATA_ATTR_BASE + 0)
+
+#define NV_CTRL_BINARY_DATA_ATTR_LAST_ATTRIBUTE \
+        (NV_CTRL_BINARY_DATA_GPU_UTILIZATION)
+
+#define CTRL_GPU_UTILIZATION_GRAPHICS  0x1
+#define CTRL_GPU_UTILIZATION_MEMORY    0x2
+#define CTRL_GPU_UTILIZATION_VIDEO     0x4
+#define CTRL_GPU_UTILIZATION_PCIE      0x8
+
+typedef struct {
+    unsigned int valid;   /* CTRL_GPU_UTILIZATION_* bits of the fields set */
+    int graphics;
+    int memory;
+    int video;
+    int pcie;
+} CtrlGpuUtilization;
+
+
 /*
  * Valid string attributes for NvCtrlGetStringAttribute(); these are
  * in addition to the ones in NVCtrl.h
@@ -854,6 +914,28 @@ ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
                                          unsigned int display_mask,
                                          int attr, int64_t *val);
 
+/*
+ * NvCtrlGetDisplayAttributes() - query several integer attributes of the
+ * same target at once.  Each query's val and status are set as if
+ * NvCtrlGetDisplayAttribute64() had been called for it, but all of the
+ * queries answered by NV-CONTROL are sent to the X server as one pipelined
+ * batch, costing a single round trip.
+ */
+
+ReturnStatus NvCtrlGetDisplayAttributes(const CtrlTarget *ctrl_target,
+                                        CtrlAttributeQuery *queries,
+                                        int count);
+
+/*
+ * NvCtrlSetAttributeCache() - enable or disable caching of attribute query
+ * results for the systems connected to afterwards.  Valid values and
+ * permissions are cached until an attribute change event or an assignment
+ * invalidates them; current values are additionally only cached for
+ * value_ttl milliseconds (a default is used if value_ttl is not positive).
+ */
+
+void NvCtrlSetAttributeCache(Bool enable, int value_ttl);
+
 ReturnStatus NvCtrlGetVoidDisplayAttribute(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask,
                                            int attr, void **val);
@@ -862,6 +944,20 @@ ReturnStatus
 NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
                                      unsigned int display_mask, int attr,
                                      CtrlAttributeValidValues *val);
+
+/*
+ * NvCtrlGetValidDisplayAttributeValuesBatch() - query the valid values of
+ * several integer attributes of the same target at once.  Each query's
+ * valid and status are set as if NvCtrlGetValidDisplayAttributeValues()
+ * had been called for it, but the queries answered by NV-CONTROL are sent
+ * to the X server as one pipelined batch.
+ */
+
+ReturnStatus
+NvCtrlGetValidDisplayAttributeValuesBatch(const CtrlTarget *ctrl_target,
+                                          CtrlAttributeValidQuery *queries,
+                                          int count);
+
 ReturnStatus
 NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask, int attr,
@@ -0,0 +1,523 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * Optional per-CtrlSystem cache of attribute query results.
+ *
+ * Attribute permissions and valid values rarely change, so they are kept
+ * until an attribute change event or an assignment invalidates them.
+ * Current values (integer and string) may change at any time without an
+ * event being generated (e.g. temperatures and clocks), so they are only
+ * kept for a short, configurable time.
+ */
+
+#include "NvCtrlAttributes.h"
+#include "NvCtrlAttributesPrivate.h"
+
+#include "common-utils.h"
+#include "msg.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+
+#define CACHE_INITIAL_BUCKETS 256
+#define CACHE_DEFAULT_VALUE_TTL_MS 1000
+
+typedef struct _CacheEntry CacheEntry;
+
+struct _CacheEntry {
+    CacheEntry *next;
+
+    /* key */
+    const NvCtrlAttributePrivateHandle *h;
+    CtrlAttributeCacheKind kind;
+    CtrlAttributeType attr_type;
+    unsigned int display_mask;
+    int attr;
+
+    ReturnStatus status;
+    int64_t expires;       /* in milliseconds; 0 if the entry never expires */
+
+    union {
+        int64_t val;
+        char *str;
+        CtrlAttributeValidValues valid;
+        CtrlAttributePerms perms;
+    } data;
+};
+
+struct _CtrlAttributeCache {
+    pthread_mutex_t lock;  /* queries may be made from several threads */
+
+    CacheEntry **buckets;
+    unsigned int num_buckets;
+    unsigned int num_entries;
+    int value_ttl;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long invalidations;
+};
+
+
+/* Whether systems created from now on should get a cache */
+
+static Bool __cache_enabled = NV_FALSE;
+static int __cache_value_ttl = CACHE_DEFAULT_VALUE_TTL_MS;
+
+
+
+/*
+ * NvCtrlSetAttributeCache() - enable or disable the attribute cache for the
+ * systems connected to afterwards.  'value_ttl' is the time, in
+ * milliseconds, for which current attribute values are cached; if it is
+ * not positive, a default is used.
+ */
+
+void NvCtrlSetAttributeCache(Bool enable, int value_ttl)
+{
+    __cache_enabled = enable;
+    __cache_value_ttl =
+        (value_ttl > 0) ? value_ttl : CACHE_DEFAULT_VALUE_TTL_MS;
+}
+
+
+
+static int64_t get_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((int64_t) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+
+
+static unsigned int hash_key(const NvCtrlAttributePrivateHandle *h,
+                             CtrlAttributeCacheKind kind,
+                             CtrlAttributeType attr_type,
+                             unsigned int display_mask, int attr)
+{
+    uintptr_t hash = (uintptr_t) h;
+
+    hash = (hash * 31) + kind;
+    hash = (hash * 31) + attr_type;
+    hash = (hash * 31) + display_mask;
+    hash = (hash * 31) + (unsigned int) attr;
+
+    /* mix the high bits into the low bits used to pick a bucket */
+
+    hash ^= (hash >> 16);
+    hash *= 0x45d9f3b;
+    hash ^= (hash >> 16);
+
+    return (unsigned int) hash;
+}
+
+
+
+static void free_entry(CacheEntry *entry)
+{
+    if (entry->kind == CTRL_ATTRIBUTE_CACHE_STRING) {
+        nvfree(entry->data.str);
+    }
+    nvfree(entry);
+}
+
+
+
+static void grow_buckets(CtrlAttributeCache *cache)
+{
+    unsigned int num_buckets = cache->num_buckets * 2;
+    CacheEntry **buckets = nvalloc(sizeof(*buckets) * num_buckets);
+    unsigned int i;
+
+    for (i = 0; i < cache->num_buckets; i++) {
+        while (cache->buckets[i]) {
+            CacheEntry *entry = cache->buckets[i];
+            unsigned int b = hash_key(entry->h, entry->kind, entry->attr_type,
+                                      entry->display_mask, entry->attr) &
+                             (num_buckets - 1);
+
+            cache->buckets[i] = entry->next;
+            entry->next = buckets[b];
+            buckets[b] = entry;
+        }
+    }
+
+    nvfree(cache->buckets);
+    cache->buckets = buckets;
+    cache->num_buckets = num_buckets;
+}
+
+
+
+/*
+ * NvCtrlAttributeCacheCreate() - allocate a new cache, if caching has been
+ * enabled with NvCtrlSetAttributeCache(); otherwise, return NULL.
+ */
+
+CtrlAttributeCache *NvCtrlAttributeCacheCreate(void)
+{
+    CtrlAttributeCache *cache;
+
+    if (!__cache_enabled) {
+        return NULL;
+    }
+
+    cache = nvalloc(sizeof(*cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->num_buckets = CACHE_INITIAL_BUCKETS;
+    cache->buckets = nvalloc(sizeof(*cache->buckets) * cache->num_buckets);
+    cache->value_ttl = __cache_value_ttl;
+
+    return cache;
+}
+
+
+
+void NvCtrlAttributeCacheFree(CtrlAttributeCache *cache)
+{
+    unsigned int i;
+
+    if (!cache) {
+        return;
+    }
+
+    for (i = 0; i < cache->num_buckets; i++) {
+        while (cache->buckets[i]) {
+            CacheEntry *entry = cache->buckets[i];
+            cache->buckets[i] = entry->next;
+            free_entry(entry);
+        }
+    }
+
+    nvfree(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    nvfree(cache);
+}
+
+
+
+static CacheEntry **find_entry(CtrlAttributeCache *cache,
+                               const NvCtrlAttributePrivateHandle *h,
+                               CtrlAttributeCacheKind kind,
+                               CtrlAttributeType attr_type,
+                               unsigned int display_mask, int attr)
+{
+    unsigned int b = hash_key(h, kind, attr_type, display_mask, attr) &
+                     (cache->num_buckets - 1);
+    CacheEntry **pentry;
+
+    for (pentry = &cache->buckets[b]; *pentry; pentry = &(*pentry)->next) {
+        CacheEntry *entry = *pentry;
+
+        if ((entry->h == h) &&
+            (entry->kind == kind) &&
+            (entry->attr_type == attr_type) &&
+            (entry->display_mask == display_mask) &&
+            (entry->attr == attr)) {
+            return pentry;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * NvCtrlAttributeCacheLookup() - look up a cached query result.  If found,
+ * the cached data is copied to 'data' (for strings, a newly allocated copy
+ * is returned), the cached status to 'status', and NV_TRUE is returned.
+ */
+
+static Bool cache_lookup(CtrlAttributeCache *cache,
+                         const NvCtrlAttributePrivateHandle *h,
+                         CtrlAttributeCacheKind kind,
+                         CtrlAttributeType attr_type,
+                         unsigned int display_mask, int attr,
+                         void *data, ReturnStatus *status)
+{
+    CacheEntry **pentry;
+    CacheEntry *entry;
+
+    pentry = find_entry(cache, h, kind, attr_type, display_mask, attr);
+
+    if (!pentry) {
+        cache->misses++;
+        return NV_FALSE;
+    }
+
+    entry = *pentry;
+
+    if (entry->expires && (get_time_ms() >= entry->expires)) {
+        *pentry = entry->next;
+        free_entry(entry);
+        cache->num_entries--;
+        cache->misses++;
+        return NV_FALSE;
+    }
+
+    *status = entry->status;
+
+    if (entry->status == NvCtrlSuccess) {
+        switch (kind) {
+        case CTRL_ATTRIBUTE_CACHE_VALUE:
+            *(int64_t *) data = entry->data.val;
+            break;
+        case CTRL_ATTRIBUTE_CACHE_STRING:
+            *(char **) data = nvstrdup(entry->data.str);
+            break;
+        case CTRL_ATTRIBUTE_CACHE_VALID_VALUES:
+            *(CtrlAttributeValidValues *) data = entry->data.valid;
+            break;
+        case CTRL_ATTRIBUTE_CACHE_PERMS:
+            *(CtrlAttributePerms *) data = entry->data.perms;
+            break;
+        }
+    }
+
+    cache->hits++;
+
+    return NV_TRUE;
+}
+
+Bool NvCtrlAttributeCacheLookup(CtrlAttributeCache *cache,
+                                const NvCtrlAttributePrivateHandle *h,
+                                CtrlAttributeCacheKind kind,
+                                CtrlAttributeType attr_type,
+                                unsigned int display_mask, int attr,
+                                void *data, ReturnStatus *status)
+{
+    Bool found;
+
+    if (!cache || !h) {
+        return NV_FALSE;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    found = cache_lookup(cache, h, kind, attr_type, display_mask, attr,
+                         data, status);
+    pthread_mutex_unlock(&cache->lock);
+
+    return found;
+}
+
+
+
+/*
+ * NvCtrlAttributeCacheStore() - record the result of a query.  Only
+ * results that describe the attribute itself (success, or the attribute
+ * not being available) are cached; transient failures are not.
+ */
+
+static void cache_store(CtrlAttributeCache *cache,
+                        const NvCtrlAttributePrivateHandle *h,
+                        CtrlAttributeCacheKind kind,
+                        CtrlAttributeType attr_type,
+                        unsigned int display_mask, int attr,
+                        const void *data, ReturnStatus status)
+{
+    CacheEntry **pentry;
+    CacheEntry *entry;
+    unsigned int b;
+
+    pentry = find_entry(cache, h, kind, attr_type, display_mask, attr);
+    if (pentry) {
+        entry = *pentry;
+        *pentry = entry->next;
+        free_entry(entry);
+        cache->num_entries--;
+    }
+
+    if (cache->num_entries >= cache->num_buckets * 2) {
+        grow_buckets(cache);
+    }
+
+    entry = nvalloc(sizeof(*entry));
+    entry->h = h;
+    entry->kind = kind;
+    entry->attr_type = attr_type;
+    entry->display_mask = display_mask;
+    entry->attr = attr;
+    entry->status = status;
+
+    if ((kind == CTRL_ATTRIBUTE_CACHE_VALUE) ||
+        (kind == CTRL_ATTRIBUTE_CACHE_STRING)) {
+        entry->expires = get_time_ms() + cache->value_ttl;
+    }
+
+    if (status == NvCtrlSuccess) {
+        switch (kind) {
+        case CTRL_ATTRIBUTE_CACHE_VALUE:
+            entry->data.val = *(const int64_t *) data;
+            break;
+        case CTRL_ATTRIBUTE_CACHE_STRING:
+            entry->data.str = nvstrdup(*(char * const *) data);
+            break;
+        case CTRL_ATTRIBUTE_CACHE_VALID_VALUES:
+            entry->data.valid = *(const CtrlAttributeValidValues *) data;
+            break;
+        case CTRL_ATTRIBUTE_CACHE_PERMS:
+            entry->data.perms = *(const CtrlAttributePerms *) data;
+            break;
+        }
+    }
+
+    b = hash_key(h, kind, attr_type, display_mask, attr) &
+        (cache->num_buckets - 1);
+    entry->next = cache->buckets[b];
+    cache->buckets[b] = entry;
+    cache->num_entries++;
+}
+
+void NvCtrlAttributeCacheStore(CtrlAttributeCache *cache,
+                               const NvCtrlAttributePrivateHandle *h,
+                               CtrlAttributeCacheKind kind,
+                               CtrlAttributeType attr_type,
+                               unsigned int display_mask, int attr,
+                               const void *data, ReturnStatus status)
+{
+    if (!cache || !h) {
+        return;
+    }
+
+    if ((status != NvCtrlSuccess) &&
+        (status != NvCtrlAttributeNotAvailable) &&
+        (status != NvCtrlNoAttribute) &&
+        (status != NvCtrlNotSupported)) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    cache_store(cache, h, kind, attr_type, display_mask, attr, data, status);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+
+/*
+ * NvCtrlAttributeCacheInvalidate() - drop the cached results matching the
+ * given handle (or, if NULL, every target of the given type and id; a
+ * target_type of INVALID_TARGET matches all targets) and attribute (or
+ * all attributes, if attr is -1).
+ */
+
+void NvCtrlAttributeCacheInvalidate(CtrlAttributeCache *cache,
+                                    const NvCtrlAttributePrivateHandle *h,
+                                    CtrlTargetType target_type,
+                                    int target_id, int attr)
+{
+    unsigned int i;
+
+    if (!cache) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (i = 0; i < cache->num_buckets; i++) {
+        CacheEntry **pentry = &cache->buckets[i];
+
+        while (*pentry) {
+            CacheEntry *entry = *pentry;
+            Bool match;
+
+            if (h) {
+                match = (entry->h == h);
+            } else {
+                match = (target_type == INVALID_TARGET) ||
+                        ((entry->h->target_type == target_type) &&
+                         (entry->h->target_id == target_id));
+            }
+
+            if (match && ((attr == -1) || (entry->attr == attr))) {
+                *pentry = entry->next;
+                free_entry(entry);
+                cache->num_entries--;
+                cache->invalidations++;
+            } else {
+                pentry = &entry->next;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+
+
+/*
+ * NvCtrlAttributeCacheHandleEvent() - invalidate the cached results made
+ * stale by the given event.
+ */
+
+void NvCtrlAttributeCacheHandleEvent(CtrlAttributeCache *cache,
+                                     const CtrlEvent *event)
+{
+    if (!cache) {
+        return;
+    }
+
+    switch (event->type) {
+    case CTRL_EVENT_TYPE_INTEGER_ATTRIBUTE:
+        NvCtrlAttributeCacheInvalidate(cache, NULL, event->target_type,
+                                       event->target_id,
+                                       event->int_attr.attribute);
+        break;
+    case CTRL_EVENT_TYPE_STRING_ATTRIBUTE:
+        NvCtrlAttributeCacheInvalidate(cache, NULL, event->target_type,
+                                       event->target_id,
+                                       event->str_attr.attribute);
+        break;
+    case CTRL_EVENT_TYPE_SCREEN_CHANGE:
+        /* a mode change may affect any target on the system */
+        NvCtrlAttributeCacheInvalidate(cache, NULL, INVALID_TARGET, 0, -1);
+        break;
+    case CTRL_EVENT_TYPE_BINARY_ATTRIBUTE:
+    case CTRL_EVENT_TYPE_UNKNOWN:
+        /* binary data is never cached */
+        break;
+    }
+}
+
+
+
+void NvCtrlAttributeCachePrintStats(const CtrlAttributeCache *cache,
+                                    const char *display)
+{
+    unsigned long lookups;
+
+    if (!cache) {
+        return;
+    }
+
+    lookups = cache->hits + cache->misses;
+
+    nv_info_msg("", "Attribute cache for '%s': %lu lookups, %lu hits (%lu%%), "
+                "%lu misses, %lu invalidations.",
+                display ? display : "", lookups, cache->hits,
+                lookups ? (cache->hits * 100) / lookups : 0,
+                cache->misses, cache->invalidations);
+}
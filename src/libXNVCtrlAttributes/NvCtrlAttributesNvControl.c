@@ -25,6 +25,7 @@
 #include "common-utils.h"
 #include "msg.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -239,6 +240,74 @@ ReturnStatus NvCtrlNvControlGetAttribute(const NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlGetAttribute() */
 
 
+/*
+ * NvCtrlNvControlGetAttributes() - query the NV-CONTROL integer attributes
+ * of queries[indices[0..count-1]] in a single batched request.
+ */
+
+ReturnStatus
+NvCtrlNvControlGetAttributes(const NvCtrlAttributePrivateHandle *h,
+                             CtrlAttributeQuery *queries,
+                             const int *indices, int count)
+{
+    const CtrlTargetTypeInfo *targetTypeInfo;
+    XNVCTRLAttributeQuery *batch;
+    ReturnStatus status = NvCtrlSuccess;
+    int i;
+
+    if (!h->nv) {
+        status = NvCtrlMissingExtension;
+        goto fail;
+    }
+
+    targetTypeInfo = NvCtrlGetTargetTypeInfo(h->target_type);
+    if (targetTypeInfo == NULL) {
+        status = NvCtrlBadHandle;
+        goto fail;
+    }
+
+    batch = nvalloc(sizeof(*batch) * count);
+
+    for (i = 0; i < count; i++) {
+        const CtrlAttributeQuery *q = &queries[indices[i]];
+
+        batch[i].target_type = targetTypeInfo->nvctrl;
+        batch[i].target_id = h->target_id;
+        batch[i].display_mask = q->display_mask;
+        batch[i].attribute = q->attr;
+    }
+
+    if (!XNVCTRLQueryTargetAttributesBatch(h->dpy, batch, count)) {
+        nvfree(batch);
+        status = NvCtrlMissingExtension;
+        goto fail;
+    }
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeQuery *q = &queries[indices[i]];
+
+        if (batch[i].exists) {
+            q->val = batch[i].value;
+            q->status = NvCtrlSuccess;
+        } else {
+            q->status = NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    nvfree(batch);
+
+    return NvCtrlSuccess;
+
+ fail:
+    for (i = 0; i < count; i++) {
+        queries[indices[i]].status = status;
+    }
+
+    return status;
+
+} /* NvCtrlNvControlGetAttributes() */
+
+
 ReturnStatus NvCtrlNvControlSetAttribute (NvCtrlAttributePrivateHandle *h,
                                           unsigned int display_mask,
                                           int attr, int val)
@@ -432,6 +501,75 @@ NvCtrlNvControlGetValidAttributeValues(const NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlGetValidAttributeValues() */
 
 
+/*
+ * NvCtrlNvControlGetValidAttributeValuesBatch() - query the NV-CONTROL
+ * valid values of queries[indices[0..count-1]] in a single batched
+ * request.
+ */
+
+ReturnStatus
+NvCtrlNvControlGetValidAttributeValuesBatch(const NvCtrlAttributePrivateHandle *h,
+                                            CtrlAttributeValidQuery *queries,
+                                            const int *indices, int count)
+{
+    const CtrlTargetTypeInfo *targetTypeInfo;
+    XNVCTRLValidValuesQuery *batch;
+    ReturnStatus status = NvCtrlSuccess;
+    int i;
+
+    if (!h->nv) {
+        status = NvCtrlMissingExtension;
+        goto fail;
+    }
+
+    targetTypeInfo = NvCtrlGetTargetTypeInfo(h->target_type);
+    if (targetTypeInfo == NULL) {
+        status = NvCtrlBadHandle;
+        goto fail;
+    }
+
+    batch = nvalloc(sizeof(*batch) * count);
+
+    for (i = 0; i < count; i++) {
+        const CtrlAttributeValidQuery *q = &queries[indices[i]];
+
+        batch[i].target_type = targetTypeInfo->nvctrl;
+        batch[i].target_id = h->target_id;
+        batch[i].display_mask = q->display_mask;
+        batch[i].attribute = q->attr;
+    }
+
+    if (!XNVCTRLQueryValidTargetAttributeValuesBatch(h->dpy, batch, count)) {
+        nvfree(batch);
+        status = NvCtrlMissingExtension;
+        goto fail;
+    }
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeValidQuery *q = &queries[indices[i]];
+
+        if (batch[i].exists) {
+            convertFromNvCtrlValidValues(&q->valid, &batch[i].values);
+            q->status = NvCtrlSuccess;
+        } else {
+            q->status = NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    nvfree(batch);
+
+    return NvCtrlSuccess;
+
+ fail:
+    for (i = 0; i < count; i++) {
+        queries[indices[i]].status = status;
+    }
+
+    return status;
+
+} /* NvCtrlNvControlGetValidAttributeValuesBatch() */
+
+
 ReturnStatus
 NvCtrlNvControlGetValidStringDisplayAttributeValues
                                        (const NvCtrlAttributePrivateHandle *h,
@@ -577,6 +715,123 @@ NvCtrlNvControlSetStringAttribute (NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlSetStringAttribute() */
 
 
+/*
+ * ParseGpuUtilization() - parse the "graphics=N, memory=N, video=N,
+ * PCIe=N" string reported by NV_CTRL_STRING_GPU_UTILIZATION into a
+ * CtrlGpuUtilization structure.  Unknown and malformed entries are
+ * skipped.
+ */
+
+static void ParseGpuUtilization(const char *str, CtrlGpuUtilization *util)
+{
+    static const struct {
+        const char *name;
+        unsigned int bit;
+        size_t offset;
+    } fields[] = {
+        { "graphics", CTRL_GPU_UTILIZATION_GRAPHICS,
+          offsetof(CtrlGpuUtilization, graphics) },
+        { "memory",   CTRL_GPU_UTILIZATION_MEMORY,
+          offsetof(CtrlGpuUtilization, memory) },
+        { "video",    CTRL_GPU_UTILIZATION_VIDEO,
+          offsetof(CtrlGpuUtilization, video) },
+        { "PCIe",     CTRL_GPU_UTILIZATION_PCIE,
+          offsetof(CtrlGpuUtilization, pcie) },
+    };
+    const char *name, *eq;
+    char *end;
+    size_t name_len;
+    long value;
+    int i;
+
+    while (*str) {
+        while (*str == ' ' || *str == ',') {
+            str++;
+        }
+
+        name = str;
+        eq = strchr(name, '=');
+        if (eq == NULL) {
+            break;
+        }
+        name_len = eq - name;
+        while (name_len && name[name_len - 1] == ' ') {
+            name_len--;
+        }
+
+        value = strtol(eq + 1, &end, 10);
+        str = strchr(end, ',');
+        if (str == NULL) {
+            str = end + strlen(end);
+        }
+        if (end == eq + 1) {
+            continue;
+        }
+
+        for (i = 0; i < ARRAY_LEN(fields); i++) {
+            if (strlen(fields[i].name) == name_len &&
+                strncasecmp(fields[i].name, name, name_len) == 0) {
+                *(int *)((char *) util + fields[i].offset) = (int) value;
+                util->valid |= fields[i].bit;
+                break;
+            }
+        }
+    }
+}
+
+
+/*
+ * GetGpuUtilization() - the X driver reports GPU utilization only as a
+ * string; query it and return it as a CtrlGpuUtilization structure for
+ * NV_CTRL_BINARY_DATA_GPU_UTILIZATION.
+ */
+
+static ReturnStatus GetGpuUtilization(const NvCtrlAttributePrivateHandle *h,
+                                      unsigned int display_mask,
+                                      unsigned char **data, int *len)
+{
+    const CtrlTargetTypeInfo *targetTypeInfo;
+    CtrlGpuUtilization *util;
+    char *tmp;
+
+    if (h->target_type != GPU_TARGET) {
+        return NvCtrlBadHandle;
+    }
+
+    targetTypeInfo = NvCtrlGetTargetTypeInfo(h->target_type);
+    if (targetTypeInfo == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (!XNVCTRLQueryTargetStringAttribute(h->dpy, targetTypeInfo->nvctrl,
+                                           h->target_id, display_mask,
+                                           NV_CTRL_STRING_GPU_UTILIZATION,
+                                           &tmp)) {
+        return NvCtrlAttributeNotAvailable;
+    }
+
+    util = calloc(1, sizeof(CtrlGpuUtilization));
+    if (util == NULL) {
+        if (tmp) {
+            XFree(tmp);
+        }
+        return NvCtrlError;
+    }
+
+    if (tmp) {
+        ParseGpuUtilization(tmp, util);
+        XFree(tmp);
+    }
+
+    *data = (unsigned char *) util;
+    if (len) {
+        *len = sizeof(CtrlGpuUtilization);
+    }
+
+    return NvCtrlSuccess;
+}
+
+
 ReturnStatus
 NvCtrlNvControlGetBinaryAttribute(const NvCtrlAttributePrivateHandle *h,
                                   unsigned int display_mask, int attr,
@@ -589,6 +844,10 @@ NvCtrlNvControlGetBinaryAttribute(const NvCtrlAttributePrivateHandle *h,
 
     if (!h->nv) return NvCtrlMissingExtension;
 
+    if (attr == NV_CTRL_BINARY_DATA_GPU_UTILIZATION) {
+        return GetGpuUtilization(h, display_mask, data, len);
+    }
+
     /* the X_nvCtrlQueryBinaryData opcode was added in 1.7 */
 
     if (NV_VERSION2(h->nv->major_version, h->nv->minor_version) <
@@ -21,10 +21,14 @@
  *  NVML backend
  */
 
+#define _GNU_SOURCE /* needed for secure_getenv */
+
 #include <stdlib.h> /* 64 bit malloc */
 #include <string.h>
 #include <assert.h>
 #include <dlfcn.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "NvCtrlAttributes.h"
 #include "NvCtrlAttributesPrivate.h"
@@ -39,6 +43,9 @@
 
 #define MAX_NVML_STR_LEN 64
 
+#define NVML_LIBRARY_NAME "libnvidia-ml.so.1"
+#define NVML_LIBRARY_ENV  "NVIDIA_SETTINGS_NVML_LIBRARY"
+
 static inline const NvCtrlNvmlAttributes *
 getNvmlHandleConst(const NvCtrlAttributePrivateHandle *h)
 {
@@ -157,26 +164,26 @@ static Bool NvmlMissing(const CtrlTarget *ctrl_target)
 /*
  * Unload the NVML library if it was successfully loaded.
  */
-static void UnloadNvml(NvCtrlNvmlAttributes *nvml)
+static void UnloadNvml(NvCtrlNvmlContext *ctx)
 {
-    if (nvml == NULL) {
+    if (ctx == NULL) {
         return;
     }
 
-    if (nvml->lib.handle == NULL) {
+    if (ctx->lib.handle == NULL) {
         return;
     }
 
-    if (nvml->lib.Shutdown != NULL) {
-        nvmlReturn_t ret = nvml->lib.Shutdown();
+    if (ctx->lib.Shutdown != NULL) {
+        nvmlReturn_t ret = ctx->lib.Shutdown();
         if (ret != NVML_SUCCESS) {
             printNvmlError(ret);
         }
     }
 
-    dlclose(nvml->lib.handle);
+    dlclose(ctx->lib.handle);
 
-    memset(&nvml->lib, 0, sizeof(nvml->lib));
+    memset(&ctx->lib, 0, sizeof(ctx->lib));
 }
 
 /*
@@ -191,7 +198,7 @@ static nvmlReturn_t NvmlStubFunction (void)
 /*
  * Load and initializes the NVML library.
  */
-static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
+static Bool LoadNvml(NvCtrlNvmlContext *ctx)
 {
     enum {
         _OPTIONAL,
@@ -199,10 +206,25 @@ static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
     };
 
     nvmlReturn_t ret;
+    const char *libName;
+
+    /*
+     * Allow a different NVML implementation to be loaded, e.g. to run
+     * without NVIDIA hardware; the override is ignored when running with
+     * elevated privileges.
+     */
+#if defined(__GLIBC__)
+    libName = secure_getenv(NVML_LIBRARY_ENV);
+#else
+    libName = issetugid() ? NULL : getenv(NVML_LIBRARY_ENV);
+#endif
+    if ((libName == NULL) || (libName[0] == '\0')) {
+        libName = NVML_LIBRARY_NAME;
+    }
 
-    nvml->lib.handle = dlopen("libnvidia-ml.so.1", RTLD_LAZY);
+    ctx->lib.handle = dlopen(libName, RTLD_LAZY);
 
-    if (nvml->lib.handle == NULL) {
+    if (ctx->lib.handle == NULL) {
         goto fail;
     }
 
@@ -211,13 +233,13 @@ static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
 #define EXPAND_STRING(_symbol) STRINGIFY_SYMBOL(_symbol)
 
 #define GET_SYMBOL(_required, _proc)                                           \
-    nvml->lib._proc = dlsym(nvml->lib.handle, "nvml" STRINGIFY_SYMBOL(_proc)); \
-    nvml->lib._proc = dlsym(nvml->lib.handle, EXPAND_STRING(nvml ## _proc));   \
-    if (nvml->lib._proc == NULL) {                                             \
+    ctx->lib._proc = dlsym(ctx->lib.handle, "nvml" STRINGIFY_SYMBOL(_proc));   \
+    ctx->lib._proc = dlsym(ctx->lib.handle, EXPAND_STRING(nvml ## _proc));     \
+    if (ctx->lib._proc == NULL) {                                              \
         if (_required) {                                                       \
             goto fail;                                                         \
         } else {                                                               \
-            nvml->lib._proc = (void*) NvmlStubFunction;                        \
+            ctx->lib._proc = (void*) NvmlStubFunction;                         \
         }                                                                      \
     }
 
@@ -285,7 +307,7 @@ static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
 #undef EXPAND_STRING
 #undef STRINGIFY_SYMBOL
 
-    ret = nvml->lib.Init();
+    ret = ctx->lib.Init();
 
     if (ret != NVML_SUCCESS) {
         printNvmlError(ret);
@@ -295,45 +317,178 @@ static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
     return True;
 
 fail:
-    UnloadNvml(nvml);
+    UnloadNvml(ctx);
     return False;
 }
 
 
 /*
- * Creates and fills an IDs dictionary so we can translate from NV-CONTROL IDs
- * to NVML indexes
+ * NVML GPU UUIDs, fetched once and sorted so that each NV-CONTROL GPU can be
+ * matched against them with a binary search rather than by re-querying every
+ * NVML device.
+ */
+
+typedef struct {
+    char uuid[MAX_NVML_STR_LEN];
+    unsigned int index;
+} NvmlUuidEntry;
+
+/*
+ * NV-CONTROL GPU id to NVML device index dictionary.  NV-CONTROL ids are
+ * per X server, so one dictionary is built per display connection and
+ * shared, by reference count, by all the NVML handles of that connection.
+ */
+
+struct __NvCtrlNvmlIds {
+    Display *dpy;                /* NULL if matched without NV-CONTROL */
+    int refcount;
+    unsigned int count;          /* number of NVML devices */
+    unsigned int *nvctrlToNvml;
+    NvCtrlNvmlIds *next;
+};
+
+static NvmlUuidEntry *__nvml_uuids = NULL;
+static unsigned int __nvml_uuid_count = 0;
+static unsigned int __nvml_device_count = 0;
+static NvCtrlNvmlIds *__nvml_ids = NULL;
+
+
+
+static int nvmlUuidEntryCmp(const void *a, const void *b)
+{
+    const NvmlUuidEntry *ea = a;
+    const NvmlUuidEntry *eb = b;
+
+    return strcmp(ea->uuid, eb->uuid);
+}
+
+
+
+/*
+ * Fetch the UUIDs of all NVML devices, unless already done.
+ */
+
+static Bool fetchNvmlUuids(const NvCtrlNvmlContext *ctx,
+                           unsigned int nvmlGpuCount)
+{
+    unsigned int i, n = 0;
+
+    if (__nvml_uuids && (__nvml_device_count == nvmlGpuCount)) {
+        return TRUE;
+    }
+
+    nvfree(__nvml_uuids);
+    __nvml_uuids = nvalloc(nvmlGpuCount * sizeof(NvmlUuidEntry));
+
+    for (i = 0; i < nvmlGpuCount; i++) {
+        if (ctx->devices[i] == NULL) {
+            continue;
+        }
+
+        if (NVML_SUCCESS != ctx->lib.DeviceGetUUID(ctx->devices[i],
+                                                   __nvml_uuids[n].uuid,
+                                                   MAX_NVML_STR_LEN)) {
+            continue;
+        }
+
+        __nvml_uuids[n].index = i;
+        n++;
+    }
+
+    qsort(__nvml_uuids, n, sizeof(NvmlUuidEntry), nvmlUuidEntryCmp);
+
+    __nvml_uuid_count = n;
+    __nvml_device_count = nvmlGpuCount;
+
+    return TRUE;
+}
+
+
+
+/*
+ * Drop a reference to an IDs dictionary, freeing it (and, once no
+ * dictionaries remain, the UUID table) when it is no longer used.
+ */
+
+static void releaseNvmlIds(NvCtrlNvmlIds *ids)
+{
+    NvCtrlNvmlIds **pids;
+
+    if (ids == NULL || --ids->refcount > 0) {
+        return;
+    }
+
+    for (pids = &__nvml_ids; *pids; pids = &(*pids)->next) {
+        if (*pids == ids) {
+            *pids = ids->next;
+            break;
+        }
+    }
+
+    nvfree(ids->nvctrlToNvml);
+    nvfree(ids);
+
+    if (__nvml_ids == NULL) {
+        nvfree(__nvml_uuids);
+        __nvml_uuids = NULL;
+        __nvml_uuid_count = 0;
+        __nvml_device_count = 0;
+    }
+}
+
+
+
+/*
+ * Returns an IDs dictionary so we can translate from NV-CONTROL IDs to NVML
+ * indexes, creating and filling it if this is the first handle of the
+ * display connection.  The dictionary must be released with
+ * releaseNvmlIds().
  *
  * XXX Needed while using NV-CONTROL as fallback during the migration process
  */
 
-static Bool matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
-                                   const NvCtrlAttributePrivateHandle *h,
-                                   int nvmlGpuCount,
-                                   unsigned int **idsDictionary)
+static NvCtrlNvmlIds *matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
+                                             const NvCtrlAttributePrivateHandle *h,
+                                             unsigned int nvmlGpuCount)
 {
-    char nvmlUUID[MAX_NVML_STR_LEN];
+    Display *dpy = h->nv ? h->dpy : NULL;
+    NvCtrlNvmlIds *ids;
     char *nvctrlUUID = NULL;
-    nvmlDevice_t device;
-    int i, j;
+    int i;
     int nvctrlGpuCount = 0;
 
+    /* Reuse the dictionary already built for this connection, if any */
+    for (ids = __nvml_ids; ids; ids = ids->next) {
+        if ((ids->dpy == dpy) && (ids->count == nvmlGpuCount)) {
+            ids->refcount++;
+            return ids;
+        }
+    }
+
     /* Get the gpu count returned by NV-CONTROL. */
     if (h->nv && !XNVCTRLQueryTargetCount(h->dpy, NV_CTRL_TARGET_TYPE_GPU,
                                           &nvctrlGpuCount)) {
-        return FALSE;
+        return NULL;
+    }
+
+    if (h->nv && !fetchNvmlUuids(nvml->ctx, nvmlGpuCount)) {
+        return NULL;
     }
 
-    *idsDictionary = nvalloc(nvmlGpuCount * sizeof(unsigned int));
+    ids = nvalloc(sizeof(*ids));
+    ids->dpy = dpy;
+    ids->refcount = 1;
+    ids->count = nvmlGpuCount;
+    ids->nvctrlToNvml = nvalloc(nvmlGpuCount * sizeof(unsigned int));
 
     /* Fallback case is to use same id either for NV-CONTROL and NVML */
     for (i = 0; i < nvmlGpuCount; i++) {
-        (*idsDictionary)[i] = i;
+        ids->nvctrlToNvml[i] = i;
     }
 
     if (h->nv != NULL) {
         for (i = 0; i < nvctrlGpuCount; i++) {
-            Bool gpuUUIDMatchFound = FALSE;
+            NvmlUuidEntry key, *match;
 
             /* Get GPU UUID through NV-CONTROL */
             if (!XNVCTRLQueryTargetStringAttribute(h->dpy,
@@ -349,39 +504,143 @@ static Bool matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
             }
 
             /* Look for the same UUID through NVML */
-            for (j = 0; j < nvmlGpuCount; j++) {
-                if (NVML_SUCCESS != nvml->lib.DeviceGetHandleByIndex(j, &device)) {
-                    continue;
-                }
-
-                if (NVML_SUCCESS != nvml->lib.DeviceGetUUID(device, nvmlUUID,
-                                                            MAX_NVML_STR_LEN)) {
-                    continue;
-                }
-
-                if (strcmp(nvctrlUUID, nvmlUUID) == 0) {
-                    /* We got a match */
-                    gpuUUIDMatchFound = TRUE;
-                    (*idsDictionary)[i] = j;
-                    break;
-                }
-            }
+            strncpy(key.uuid, nvctrlUUID, sizeof(key.uuid) - 1);
+            key.uuid[sizeof(key.uuid) - 1] = '\0';
 
             XFree(nvctrlUUID);
 
+            match = bsearch(&key, __nvml_uuids, __nvml_uuid_count,
+                            sizeof(NvmlUuidEntry), nvmlUuidEntryCmp);
+
             /* Fail if mismatch between gpu UUID returned by NV-CONTROL and
              * NVML
              */
-            if (!gpuUUIDMatchFound) {
+            if (match == NULL) {
                 goto fail;
             }
+
+            if (i < nvmlGpuCount) {
+                ids->nvctrlToNvml[i] = match->index;
+            }
         }
     }
-    return TRUE;
+
+    ids->next = __nvml_ids;
+    __nvml_ids = ids;
+
+    return ids;
 
 fail:
-    nvfree(*idsDictionary);
-    return FALSE;
+    nvfree(ids->nvctrlToNvml);
+    nvfree(ids);
+    return NULL;
+}
+
+
+
+/*
+ * The NVML library and the per-GPU information gathered at load time are
+ * shared by all the NVML private handles of the process.
+ *
+ * Handles may be created and closed from several threads (e.g., by the
+ * frame lock monitor, which connects to each X server from its own
+ * thread), so the context, the IDs dictionaries and the UUID table are
+ * only accessed with __nvml_lock held.
+ */
+
+static NvCtrlNvmlContext *__nvml_context = NULL;
+static pthread_mutex_t __nvml_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * Releases a reference to the NVML context, unloading the library when the
+ * last handle using it is closed.
+ */
+
+static void releaseNvmlContext(NvCtrlNvmlContext *ctx)
+{
+    if (ctx == NULL || --ctx->refcount > 0) {
+        return;
+    }
+
+    UnloadNvml(ctx);
+    nvfree(ctx->devices);
+    nvfree(ctx->sensorCountPerGPU);
+    nvfree(ctx->coolerCountPerGPU);
+    nvfree(ctx);
+
+    if (__nvml_context == ctx) {
+        __nvml_context = NULL;
+    }
+}
+
+
+
+/*
+ * Returns a reference to the NVML context, loading NVML and gathering the
+ * device handles and per-GPU thermal sensor and cooler counts the first
+ * time it is called.
+ */
+
+static NvCtrlNvmlContext *acquireNvmlContext(void)
+{
+    NvCtrlNvmlContext *ctx;
+    unsigned int count;
+    unsigned int i;
+
+    if (__nvml_context != NULL) {
+        __nvml_context->refcount++;
+        return __nvml_context;
+    }
+
+    ctx = nvalloc(sizeof(NvCtrlNvmlContext));
+    ctx->refcount = 1;
+
+    if (!LoadNvml(ctx)) {
+        nvfree(ctx);
+        return NULL;
+    }
+
+    if (ctx->lib.DeviceGetCount(&count) != NVML_SUCCESS) {
+        releaseNvmlContext(ctx);
+        return NULL;
+    }
+    ctx->deviceCount = count;
+
+    ctx->devices = nvalloc(count * sizeof(nvmlDevice_t));
+    ctx->sensorCountPerGPU = nvalloc(count * sizeof(unsigned int));
+    ctx->sensorCount = 0;
+    ctx->coolerCountPerGPU = nvalloc(count * sizeof(unsigned int));
+    ctx->coolerCount = 0;
+
+    for (i = 0; i < count; i++) {
+        nvmlDevice_t device;
+        nvmlReturn_t ret = ctx->lib.DeviceGetHandleByIndex(i, &device);
+        if (ret == NVML_SUCCESS) {
+            unsigned int fans;
+            nvmlGpuThermalSettings_t pThermalSettings;
+
+            ctx->devices[i] = device;
+
+            ret = ctx->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
+                                                    &pThermalSettings);
+            if (ret == NVML_SUCCESS) {
+                ctx->sensorCountPerGPU[i] = pThermalSettings.count;
+                ctx->sensorCount += pThermalSettings.count;
+            }
+
+            ret = ctx->lib.DeviceGetNumFans(device, &fans);
+            if (ret == NVML_SUCCESS) {
+                ctx->coolerCountPerGPU[i] = fans;
+                ctx->coolerCount += fans;
+            }
+        }
+    }
+
+    __nvml_context = ctx;
+
+    return ctx;
 }
 
 
@@ -394,82 +653,62 @@ fail:
 NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *h)
 {
     NvCtrlNvmlAttributes *nvml = NULL;
-    unsigned int count;
-    unsigned int *nvctrlToNvmlId;
+    const NvCtrlNvmlContext *ctx;
+    const unsigned int *nvctrlToNvmlId;
+    unsigned int sensorCount = 0, coolerCount = 0;
     int i;
     int nvctrlCoolerCount;
 
     /* Check parameters */
     if (h == NULL || !TARGET_TYPE_IS_NVML_COMPATIBLE(h->target_type)) {
-        goto fail;
+        return NULL;
     }
 
     /* Create storage for NVML attributes */
     nvml = nvalloc(sizeof(NvCtrlNvmlAttributes));
 
-    if (!LoadNvml(nvml)) {
-        goto fail;
-    }
+    pthread_mutex_lock(&__nvml_lock);
 
-    /* Initialize NVML attributes */
-    if (nvml->lib.DeviceGetCount(&count) != NVML_SUCCESS) {
+    nvml->ctx = acquireNvmlContext();
+    if (nvml->ctx == NULL) {
         goto fail;
     }
-    nvml->deviceCount = count;
-
-    nvml->sensorCountPerGPU = nvalloc(count * sizeof(unsigned int));
-    nvml->sensorCount = 0;
-    nvml->coolerCountPerGPU = nvalloc(count * sizeof(unsigned int));
-    nvml->coolerCount = 0;
+    ctx = nvml->ctx;
 
     /* Fill the NV-CONTROL to NVML IDs dictionary */
-    if (!matchNvCtrlWithNvmlIds(nvml, h, count, &nvctrlToNvmlId)) {
+    nvml->ids = matchNvCtrlWithNvmlIds(nvml, h, ctx->deviceCount);
+    if (nvml->ids == NULL) {
         goto fail;
     }
+    nvctrlToNvmlId = nvml->ids->nvctrlToNvml;
 
-    /*
-     * Fill 'sensorCountPerGPU', 'coolerCountPerGPU' and properly set
-     * 'deviceIdx'
-     */
+    pthread_mutex_unlock(&__nvml_lock);
+
+    /* Properly set 'deviceIdx' */
     nvml->deviceIdx = h->target_id; /* Fallback */
 
     if (h->target_type == GPU_TARGET) {
         nvml->deviceIdx = nvctrlToNvmlId[h->target_id];
     }
 
-    for (i = 0; i < count; i++) {
+    for (i = 0; i < ctx->deviceCount; i++) {
         int devIdx = nvctrlToNvmlId[i];
-        nvmlDevice_t device;
-        nvmlReturn_t ret = nvml->lib.DeviceGetHandleByIndex(devIdx, &device);
-        if (ret == NVML_SUCCESS) {
-            unsigned int fans;
-            nvmlGpuThermalSettings_t pThermalSettings;
 
-            ret = nvml->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
-                                                     &pThermalSettings);
-            if (ret == NVML_SUCCESS) {
-                if ((h->target_type == THERMAL_SENSOR_TARGET) &&
-                    (h->target_id == nvml->sensorCount)) {
-
-                    nvml->deviceIdx = devIdx;
-                }
-
-                nvml->sensorCountPerGPU[devIdx] = pThermalSettings.count;
-                nvml->sensorCount += pThermalSettings.count;
-            }
+        if ((h->target_type == THERMAL_SENSOR_TARGET) &&
+            (ctx->sensorCountPerGPU[devIdx] > 0) &&
+            (h->target_id == sensorCount)) {
 
-            ret = nvml->lib.DeviceGetNumFans(device, &fans);
-            if (ret == NVML_SUCCESS) {
-                if ((h->target_type == COOLER_TARGET) &&
-                    (h->target_id == nvml->coolerCount)) {
+            nvml->deviceIdx = devIdx;
+        }
+        sensorCount += ctx->sensorCountPerGPU[devIdx];
 
-                    nvml->deviceIdx = devIdx;
-                }
+        if ((h->target_type == COOLER_TARGET) &&
+            (ctx->coolerCountPerGPU[devIdx] > 0) &&
+            (h->target_id == coolerCount)) {
 
-                nvml->coolerCountPerGPU[devIdx] = fans;
-                nvml->coolerCount += fans;
-            }
+            nvml->deviceIdx = devIdx;
         }
+        coolerCount += ctx->coolerCountPerGPU[devIdx];
     }
 
     /*
@@ -478,18 +717,16 @@ NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *h)
     if (h->nv &&
         (!XNVCTRLQueryTargetCount(h->dpy, NV_CTRL_TARGET_TYPE_COOLER,
                                    &nvctrlCoolerCount) ||
-         (nvctrlCoolerCount != nvml->coolerCount))) {
+         (nvctrlCoolerCount != ctx->coolerCount))) {
         nv_warning_msg("Inconsistent number of fans detected.");
     }
 
-    nvfree(nvctrlToNvmlId);
-
     return nvml;
 
  fail:
-    UnloadNvml(nvml);
-    nvfree(nvml->sensorCountPerGPU);
-    nvfree(nvml->coolerCountPerGPU);
+    releaseNvmlIds(nvml->ids);
+    releaseNvmlContext(nvml->ctx);
+    pthread_mutex_unlock(&__nvml_lock);
     nvfree(nvml);
     return NULL;
 }
@@ -507,9 +744,10 @@ void NvCtrlNvmlAttributesClose(NvCtrlAttributePrivateHandle *h)
         return;
     }
 
-    UnloadNvml(h->nvml);
-    nvfree(h->nvml->sensorCountPerGPU);
-    nvfree(h->nvml->coolerCountPerGPU);
+    pthread_mutex_lock(&__nvml_lock);
+    releaseNvmlIds(h->nvml->ids);
+    releaseNvmlContext(h->nvml->ctx);
+    pthread_mutex_unlock(&__nvml_lock);
     nvfree(h->nvml);
     h->nvml = NULL;
 }
@@ -542,13 +780,13 @@ ReturnStatus NvCtrlNvmlQueryTargetCount(const CtrlTarget *ctrl_target,
 
     switch (target_type) {
         case GPU_TARGET:
-            *val = (int)(h->nvml->deviceCount);
+            *val = (int)(h->nvml->ctx->deviceCount);
             break;
         case THERMAL_SENSOR_TARGET:
-            *val = (int)(h->nvml->sensorCount);
+            *val = (int)(h->nvml->ctx->sensorCount);
             break;
         case COOLER_TARGET:
-            *val = (int)(h->nvml->coolerCount);
+            *val = (int)(h->nvml->ctx->coolerCount);
             break;
         default:
             return NvCtrlBadArgument;
@@ -577,11 +815,11 @@ static ReturnStatus NvCtrlNvmlGetGeneralStringAttribute(const CtrlTarget *ctrl_t
 
     switch (attr) {
         case NV_CTRL_STRING_NVIDIA_DRIVER_VERSION:
-            ret = h->nvml->lib.SystemGetDriverVersion(res, MAX_NVML_STR_LEN);
+            ret = h->nvml->ctx->lib.SystemGetDriverVersion(res, MAX_NVML_STR_LEN);
             break;
 
         case NV_CTRL_STRING_NVML_VERSION:
-            ret = h->nvml->lib.SystemGetNVMLVersion(res, MAX_NVML_STR_LEN);
+            ret = h->nvml->ctx->lib.SystemGetNVMLVersion(res, MAX_NVML_STR_LEN);
             break;
 
         default:
@@ -620,19 +858,19 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_STRING_PRODUCT_NAME:
-                ret = nvml->lib.DeviceGetName(device, res, MAX_NVML_STR_LEN);
+                ret = nvml->ctx->lib.DeviceGetName(device, res, MAX_NVML_STR_LEN);
                 break;
 
             case NV_CTRL_STRING_VBIOS_VERSION:
-                ret = nvml->lib.DeviceGetVbiosVersion(device, res, MAX_NVML_STR_LEN);
+                ret = nvml->ctx->lib.DeviceGetVbiosVersion(device, res, MAX_NVML_STR_LEN);
                 break;
 
             case NV_CTRL_STRING_GPU_UUID:
-                ret = nvml->lib.DeviceGetUUID(device, res, MAX_NVML_STR_LEN);
+                ret = nvml->ctx->lib.DeviceGetUUID(device, res, MAX_NVML_STR_LEN);
                 break;
 
             case NV_CTRL_STRING_GPU_UTILIZATION:
@@ -647,7 +885,7 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
                     return NvCtrlNotSupported;
                 }
 
-                ret = nvml->lib.DeviceGetUtilizationRates(device, &util);
+                ret = nvml->ctx->lib.DeviceGetUtilizationRates(device, &util);
 
                 if (ret != NVML_SUCCESS) {
                     break;
@@ -664,7 +902,7 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
                 nvmlDevicePerfModes_t perfModes;
 
                 perfModes.version = nvmlDevicePerfModes_v1;
-                ret = nvml->lib.DeviceGetPerformanceModes(device, &perfModes);
+                ret = nvml->ctx->lib.DeviceGetPerformanceModes(device, &perfModes);
                 if (ret == NVML_SUCCESS) {
                     strcpy(res, perfModes.str);
                 }
@@ -676,7 +914,7 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
                 nvmlDeviceCurrentClockFreqs_t currentClockFreqs;
 
                 currentClockFreqs.version = nvmlDeviceCurrentClockFreqs_v1;
-                ret = nvml->lib.DeviceGetCurrentClockFreqs(device, &currentClockFreqs);
+                ret = nvml->ctx->lib.DeviceGetCurrentClockFreqs(device, &currentClockFreqs);
                 if (ret == NVML_SUCCESS) {
                     strcpy(res, currentClockFreqs.str);
                 }
@@ -775,7 +1013,7 @@ static ReturnStatus NvCtrlNvmlSetGPUStringAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS:
@@ -858,7 +1096,7 @@ static nvmlReturn_t nvmlClockOffsetHelper(nvmlDevice_t device,
                 nvmlDeviceArchitecture_t arch;
 
                 /* attributes are supported on Maxwell GPUs only */
-                ret = nvml->lib.DeviceGetArchitecture(device, &arch);
+                ret = nvml->ctx->lib.DeviceGetArchitecture(device, &arch);
                 if ((ret != NVML_SUCCESS) || (arch != NVML_DEVICE_ARCH_MAXWELL)) {
                     return NVML_ERROR_NOT_SUPPORTED;
                 }
@@ -885,7 +1123,7 @@ static nvmlReturn_t nvmlClockOffsetHelper(nvmlDevice_t device,
                 info.pstate = NVML_PSTATE_0;
                 if (val || valid_values) {
                     /* get current clock offset and valid values */
-                    ret = nvml->lib.DeviceGetClockOffsets(device, &info);
+                    ret = nvml->ctx->lib.DeviceGetClockOffsets(device, &info);
 
                     if (ret != NVML_SUCCESS) {
                         return ret;
@@ -904,7 +1142,7 @@ static nvmlReturn_t nvmlClockOffsetHelper(nvmlDevice_t device,
                 if (setVal) {
                     /* set new clock offset value */
                     info.clockOffsetMHz = *setVal;
-                    ret = nvml->lib.DeviceSetClockOffsets(device, &info);
+                    ret = nvml->ctx->lib.DeviceSetClockOffsets(device, &info);
                     return ret;
                 }
             }
@@ -958,16 +1196,16 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
             case NV_CTRL_USED_DEDICATED_GPU_MEMORY:
                 {
-                    if (nvml->lib.DeviceGetMemoryInfo_v2) {
+                    if (nvml->ctx->lib.DeviceGetMemoryInfo_v2) {
                         nvmlMemory_v2_t memory;
                         memory.version = nvmlMemory_v2;
-                        ret = nvml->lib.DeviceGetMemoryInfo_v2(device, &memory);
+                        ret = nvml->ctx->lib.DeviceGetMemoryInfo_v2(device, &memory);
                         if (ret == NVML_SUCCESS) {
                             switch (attr) {
                                 case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
@@ -980,7 +1218,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                         }
                     } else {
                         nvmlMemory_t memory;
-                        ret = nvml->lib.DeviceGetMemoryInfo(device, &memory);
+                        ret = nvml->ctx->lib.DeviceGetMemoryInfo(device, &memory);
                         if (ret == NVML_SUCCESS) {
                             switch (attr) {
                                 case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
@@ -1002,7 +1240,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_PCI_ID:
                 {
                     nvmlPciInfo_t pci;
-                    ret = nvml->lib.DeviceGetPciInfo(device, &pci);
+                    ret = nvml->ctx->lib.DeviceGetPciInfo(device, &pci);
                     if (ret == NVML_SUCCESS) {
                         switch (attr) {
                             case NV_CTRL_PCI_DOMAIN:
@@ -1035,21 +1273,21 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                 break;
 
             case NV_CTRL_GPU_PCIE_GENERATION:
-                ret = nvml->lib.DeviceGetMaxPcieLinkGeneration(device, &res);
+                ret = nvml->ctx->lib.DeviceGetMaxPcieLinkGeneration(device, &res);
                 break;
 
             case NV_CTRL_GPU_PCIE_CURRENT_LINK_WIDTH:
-                ret = nvml->lib.DeviceGetCurrPcieLinkWidth(device, &res);
+                ret = nvml->ctx->lib.DeviceGetCurrPcieLinkWidth(device, &res);
                 break;
             case NV_CTRL_GPU_PCIE_MAX_LINK_WIDTH:
-                ret = nvml->lib.DeviceGetMaxPcieLinkWidth(device, &res);
+                ret = nvml->ctx->lib.DeviceGetMaxPcieLinkWidth(device, &res);
                 break;
             case NV_CTRL_GPU_SLOWDOWN_THRESHOLD:
-                ret = nvml->lib.DeviceGetTemperatureThreshold(device,
+                ret = nvml->ctx->lib.DeviceGetTemperatureThreshold(device,
                           NVML_TEMPERATURE_THRESHOLD_SLOWDOWN ,&res);
                 break;
             case NV_CTRL_GPU_SHUTDOWN_THRESHOLD:
-                ret = nvml->lib.DeviceGetTemperatureThreshold(device,
+                ret = nvml->ctx->lib.DeviceGetTemperatureThreshold(device,
                           NVML_TEMPERATURE_THRESHOLD_SHUTDOWN ,&res);
                 break;
             case NV_CTRL_GPU_CORE_TEMPERATURE:
@@ -1058,7 +1296,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                         .version = nvmlTemperature_v1,
                         .sensorType = NVML_TEMPERATURE_GPU,
                     };
-                    ret = nvml->lib.DeviceGetTemperatureV(device,
+                    ret = nvml->ctx->lib.DeviceGetTemperatureV(device,
                                                           &temperature);
                     res = (unsigned)temperature.temperature;
                 }
@@ -1068,7 +1306,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_GPU_ECC_SUPPORTED:
                 {
                     nvmlEnableState_t current, pending;
-                    ret = nvml->lib.DeviceGetEccMode(device, &current, &pending);
+                    ret = nvml->ctx->lib.DeviceGetEccMode(device, &current, &pending);
                     switch (attr) {
                         case NV_CTRL_GPU_ECC_CONFIGURATION_SUPPORTED:
                             res = (ret == NVML_SUCCESS) ?
@@ -1093,7 +1331,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_GPU_ECC_STATUS:
                 {
                     nvmlEnableState_t current, pending;
-                    ret = nvml->lib.DeviceGetEccMode(device, &current, &pending);
+                    ret = nvml->ctx->lib.DeviceGetEccMode(device, &current, &pending);
                     if (ret == NVML_SUCCESS) {
                         switch (attr) {
                             case NV_CTRL_GPU_ECC_STATUS:
@@ -1110,7 +1348,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_GPU_ECC_DEFAULT_CONFIGURATION:
                 {
                     nvmlEnableState_t defaultMode;
-                    ret = nvml->lib.DeviceGetDefaultEccMode(device, &defaultMode);
+                    ret = nvml->ctx->lib.DeviceGetDefaultEccMode(device, &defaultMode);
                     if (ret == NVML_SUCCESS) {
                         res = defaultMode;
                     }
@@ -1144,7 +1382,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                             break;
                     }
 
-                    ret = nvml->lib.DeviceGetTotalEccErrors(device, errorType,
+                    ret = nvml->ctx->lib.DeviceGetTotalEccErrors(device, errorType,
                                                         counterType, &eccCounts);
                     if (ret == NVML_SUCCESS) {
                         if (val) {
@@ -1156,40 +1394,40 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                 break;
 
             case NV_CTRL_GPU_CORES:
-                ret = nvml->lib.DeviceGetNumGpuCores(device, &res);
+                ret = nvml->ctx->lib.DeviceGetNumGpuCores(device, &res);
                 break;
             case NV_CTRL_GPU_MEMORY_BUS_WIDTH:
-                ret = nvml->lib.DeviceGetMemoryBusWidth(device, &res);
+                ret = nvml->ctx->lib.DeviceGetMemoryBusWidth(device, &res);
                 break;
             case NV_CTRL_IRQ:
-                ret = nvml->lib.DeviceGetIrqNum(device, &res);
+                ret = nvml->ctx->lib.DeviceGetIrqNum(device, &res);
                 break;
             case NV_CTRL_GPU_POWER_SOURCE:
                 assert(NV_CTRL_GPU_POWER_SOURCE_AC == NVML_POWER_SOURCE_AC);
                 assert(NV_CTRL_GPU_POWER_SOURCE_BATTERY == NVML_POWER_SOURCE_BATTERY);
                 assert(NV_CTRL_GPU_POWER_SOURCE_UNDERSIZED == NVML_POWER_SOURCE_UNDERSIZED);
-                ret = nvml->lib.DeviceGetPowerSource(device, &res);
+                ret = nvml->ctx->lib.DeviceGetPowerSource(device, &res);
                 break;
             case NV_CTRL_ATTR_NVML_GPU_GET_POWER_USAGE:
-                ret = nvml->lib.DeviceGetPowerUsage(device, &res);
+                ret = nvml->ctx->lib.DeviceGetPowerUsage(device, &res);
                 break;
 
             case NV_CTRL_ATTR_NVML_GPU_MAX_TGP:
                 {
                     unsigned int minLimit;
-                    ret = nvml->lib.DeviceGetPowerManagementLimitConstraints(device,
+                    ret = nvml->ctx->lib.DeviceGetPowerManagementLimitConstraints(device,
                                                                              &minLimit, &res);
                 }
                 break;
 
             case NV_CTRL_ATTR_NVML_GPU_DEFAULT_TGP:
-                ret = nvml->lib.DeviceGetPowerManagementDefaultLimit(device, &res);
+                ret = nvml->ctx->lib.DeviceGetPowerManagementDefaultLimit(device, &res);
                 break;
 
             case NV_CTRL_GPU_COOLER_MANUAL_CONTROL:
                 {
                     nvmlFanControlPolicy_t policy;
-                    int count = nvml->coolerCountPerGPU[nvml->deviceIdx];
+                    int count = nvml->ctx->coolerCountPerGPU[nvml->deviceIdx];
 
                     /* Return early if GPU has no fan */
                     if (count == 0) {
@@ -1197,7 +1435,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                     }
 
                     /* Get cooler control policy */
-                    ret = nvml->lib.DeviceGetFanControlPolicy_v2(device, 0, &policy);
+                    ret = nvml->ctx->lib.DeviceGetFanControlPolicy_v2(device, 0, &policy);
                     res = (policy == NVML_FAN_POLICY_MANUAL) ?
                         NV_CTRL_GPU_COOLER_MANUAL_CONTROL_TRUE :
                         NV_CTRL_GPU_COOLER_MANUAL_CONTROL_FALSE;
@@ -1211,8 +1449,8 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                     nvmlReturn_t ret1;
                     int i = 0;
 
-                    ret = nvml->lib.DeviceGetPerformanceState(device, &pState);
-                    ret1 = nvml->lib.DeviceGetSupportedPerformanceStates(device, pStates, NVML_MAX_GPU_PERF_PSTATES);
+                    ret = nvml->ctx->lib.DeviceGetPerformanceState(device, &pState);
+                    ret1 = nvml->ctx->lib.DeviceGetSupportedPerformanceStates(device, pStates, NVML_MAX_GPU_PERF_PSTATES);
                     if ((ret != NVML_SUCCESS) || (ret1 != NVML_SUCCESS)) {
                         return NvCtrlNotSupported;
                     }
@@ -1240,13 +1478,13 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                 break;
 
             case NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE:
-                ret = nvml->lib.DeviceGetAdaptiveClockInfoStatus(device, &res);
+                ret = nvml->ctx->lib.DeviceGetAdaptiveClockInfoStatus(device, &res);
                 break;
 
             case NV_CTRL_GPU_PCIE_MAX_LINK_SPEED:
                 {
                     unsigned int nvmlPcieSpeed;
-                    ret = nvml->lib.DeviceGetPcieLinkMaxSpeed(device, &nvmlPcieSpeed);
+                    ret = nvml->ctx->lib.DeviceGetPcieLinkMaxSpeed(device, &nvmlPcieSpeed);
                     if (ret == NVML_SUCCESS) {
                         ret = convertNvmlPcieSpeedToNvctrlPcieSpeed(nvmlPcieSpeed, &res);
                     }
@@ -1254,7 +1492,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                 break;
 
             case NV_CTRL_GPU_PCIE_CURRENT_LINK_SPEED:
-                ret = nvml->lib.DeviceGetPcieSpeed(device, &res);
+                ret = nvml->ctx->lib.DeviceGetPcieSpeed(device, &res);
                 break;
 
             case NV_CTRL_GPU_POWER_MIZER_MODE:
@@ -1268,7 +1506,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
                            NV_CTRL_GPU_POWER_MIZER_MODE_AUTO);
                     assert(NVML_POWER_MIZER_MODE_PREFER_CONSISTENT_PERFORMANCE ==
                            NV_CTRL_GPU_POWER_MIZER_MODE_PREFER_CONSISTENT_PERFORMANCE);
-                    ret = nvml->lib.DeviceGetPowerMizerMode_v1(device,
+                    ret = nvml->ctx->lib.DeviceGetPowerMizerMode_v1(device,
                                                                &powerMizerMode);
                     res = powerMizerMode.currentMode;
                     break;
@@ -1349,7 +1587,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_ATTR_NVML_GPU_VIRTUALIZATION_MODE:
                 {
                     nvmlGpuVirtualizationMode_t mode;
-                    ret = nvml->lib.DeviceGetVirtualizationMode(device, &mode);
+                    ret = nvml->ctx->lib.DeviceGetVirtualizationMode(device, &mode);
                     res = mode;
                 }
                 break;
@@ -1357,7 +1595,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
             case NV_CTRL_ATTR_NVML_GPU_GRID_LICENSE_SUPPORTED:
                 {
                     nvmlGridLicensableFeatures_t gridLicensableFeatures;
-                    ret = nvml->lib.DeviceGetGridLicensableFeatures(device,
+                    ret = nvml->ctx->lib.DeviceGetGridLicensableFeatures(device,
                                                           &gridLicensableFeatures);
                     res = !!(gridLicensableFeatures.isGridLicenseSupported);
                 }
@@ -1398,14 +1636,14 @@ static ReturnStatus NvCtrlNvmlGetGridLicensableFeatures(const CtrlTarget *ctrl_t
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
         if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_ATTR_NVML_GPU_GRID_LICENSABLE_FEATURES:
                 {
                     nvmlGridLicensableFeatures_t *gridLicensableFeatures;
                     gridLicensableFeatures = (nvmlGridLicensableFeatures_t *)nvalloc(sizeof(nvmlGridLicensableFeatures_t));
-                    ret = nvml->lib.DeviceGetGridLicensableFeatures(device,
+                    ret = nvml->ctx->lib.DeviceGetGridLicensableFeatures(device,
                                                                     gridLicensableFeatures);
                     if (ret == NVML_SUCCESS) {
                         *val = gridLicensableFeatures;
@@ -1442,14 +1680,14 @@ static ReturnStatus NvCtrlNvmlDeviceGetGspFeatures(const CtrlTarget *ctrl_target
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
     switch (attr) {
         case NV_CTRL_ATTR_NVML_GSP_FIRMWARE_MODE:
             {
                 unsigned int isEnabled_t = 0;
                 unsigned int defaultMode_t = 0;
-                ret = nvml->lib.DeviceGetGspFirmwareMode(device,
+                ret = nvml->ctx->lib.DeviceGetGspFirmwareMode(device,
                                                          &isEnabled_t, &defaultMode_t);
                 if (ret == NVML_SUCCESS) {
                     *isEnabled = isEnabled_t;
@@ -1487,7 +1725,7 @@ static void getDeviceAndTargetIndex(const NvCtrlAttributePrivateHandle *h,
     }
 
     count = 0;
-    for (i = 0; i < h->nvml->deviceCount; i++) {
+    for (i = 0; i < h->nvml->ctx->deviceCount; i++) {
         int tmp = count + targetCountPerGPU[i];
         *deviceIdx = i;
         if (h->target_id < tmp) {
@@ -1599,14 +1837,14 @@ static ReturnStatus NvCtrlNvmlGetThermalAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* Get the proper device according to the sensor ID */
-    getDeviceAndTargetIndex(h, nvml->sensorCount, nvml->sensorCountPerGPU,
+    getDeviceAndTargetIndex(h, nvml->ctx->sensorCount, nvml->ctx->sensorCountPerGPU,
                             &deviceId, &sensorId);
     if (sensorId == -1) {
         return NvCtrlBadHandle;
     }
 
 
-    ret = nvml->lib.DeviceGetHandleByIndex(deviceId, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_SENSOR_READING:
@@ -1615,7 +1853,7 @@ static ReturnStatus NvCtrlNvmlGetThermalAttribute(const CtrlTarget *ctrl_target,
                 {
                     nvmlGpuThermalSettings_t pThermalSettings;
 
-                    ret = nvml->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
+                    ret = nvml->ctx->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
                                                              &pThermalSettings);
                     if (ret == NVML_SUCCESS) {
                         switch (attr) {
@@ -1714,20 +1952,20 @@ static ReturnStatus NvCtrlNvmlGetCoolerAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* Get the proper device according to the cooler ID */
-    getDeviceAndTargetIndex(h, nvml->coolerCount, nvml->coolerCountPerGPU,
+    getDeviceAndTargetIndex(h, nvml->ctx->coolerCount, nvml->ctx->coolerCountPerGPU,
                             &deviceId, &coolerId);
     if (coolerId == -1) {
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(deviceId, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_LEVEL:
-                ret = nvml->lib.DeviceGetTargetFanSpeed(device, coolerId, &res);
+                ret = nvml->ctx->lib.DeviceGetTargetFanSpeed(device, coolerId, &res);
                 break;
             case NV_CTRL_THERMAL_COOLER_CURRENT_LEVEL:
-                ret = nvml->lib.DeviceGetFanSpeed_v2(device, coolerId, &res);
+                ret = nvml->ctx->lib.DeviceGetFanSpeed_v2(device, coolerId, &res);
                 break;
             case NV_CTRL_THERMAL_COOLER_TARGET:
             case NV_CTRL_THERMAL_COOLER_CONTROL_TYPE:
@@ -1735,7 +1973,7 @@ static ReturnStatus NvCtrlNvmlGetCoolerAttribute(const CtrlTarget *ctrl_target,
                     nvmlCoolerInfo_t coolerInfo;
                     coolerInfo.version = nvmlCoolerInfo_v1;
                     coolerInfo.index = coolerId;
-                    ret = nvml->lib.DeviceGetCoolerInfo(device, &coolerInfo);
+                    ret = nvml->ctx->lib.DeviceGetCoolerInfo(device, &coolerInfo);
                     if (ret == NVML_SUCCESS) {
                         switch (attr) {
                             case NV_CTRL_THERMAL_COOLER_CONTROL_TYPE:
@@ -1753,7 +1991,7 @@ static ReturnStatus NvCtrlNvmlGetCoolerAttribute(const CtrlTarget *ctrl_target,
                     nvmlFanSpeedInfo_t fanSpeed;
                     fanSpeed.version = nvmlFanSpeedInfo_v1;
                     fanSpeed.fan = coolerId;
-                    ret = nvml->lib.DeviceGetFanSpeedRPM(device, &fanSpeed);
+                    ret = nvml->ctx->lib.DeviceGetFanSpeedRPM(device, &fanSpeed);
                     if (ret == NVML_SUCCESS) {
                         *val = fanSpeed.speed;
                         return NvCtrlSuccess;
@@ -1874,11 +2112,11 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_GPU_ECC_CONFIGURATION:
-                ret = nvml->lib.DeviceSetEccMode(device, val);
+                ret = nvml->ctx->lib.DeviceSetEccMode(device, val);
                 break;
 
             case NV_CTRL_GPU_ECC_RESET_ERROR_STATUS:
@@ -1892,7 +2130,7 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
                             counterType = NVML_AGGREGATE_ECC;
                             break;
                     }
-                    ret = nvml->lib.DeviceClearEccErrorCounts(device,
+                    ret = nvml->ctx->lib.DeviceClearEccErrorCounts(device,
                                                               counterType);
                 }
                 break;
@@ -1900,10 +2138,10 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
             case NV_CTRL_GPU_COOLER_MANUAL_CONTROL:
                 {
                     int i = 0;
-                    int count = nvml->coolerCountPerGPU[nvml->deviceIdx];
+                    int count = nvml->ctx->coolerCountPerGPU[nvml->deviceIdx];
 
                     for (i = 0; i < count; i++) {
-                        ret = nvml->lib.DeviceSetFanControlPolicy(device, i, val);
+                        ret = nvml->ctx->lib.DeviceSetFanControlPolicy(device, i, val);
                     }
                 }
                 break;
@@ -1919,7 +2157,7 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
                 {
                     nvmlDevicePowerMizerModes_v1_t powerMizerMode;
                     powerMizerMode.mode = val;
-                    ret = nvml->lib.DeviceSetPowerMizerMode_v1(device, &powerMizerMode);
+                    ret = nvml->ctx->lib.DeviceSetPowerMizerMode_v1(device, &powerMizerMode);
                     break;
                 }
 
@@ -1973,21 +2211,21 @@ static ReturnStatus NvCtrlNvmlSetCoolerAttribute(CtrlTarget *ctrl_target,
     }
 
     /* Get the proper device according to the cooler ID */
-    getDeviceAndTargetIndex(h, nvml->coolerCount, nvml->coolerCountPerGPU,
+    getDeviceAndTargetIndex(h, nvml->ctx->coolerCount, nvml->ctx->coolerCountPerGPU,
                             &deviceId, &coolerId);
     if (coolerId == -1) {
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(deviceId, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_LEVEL:
-                ret = nvml->lib.DeviceSetFanSpeed_v2(device, coolerId, val);
+                ret = nvml->ctx->lib.DeviceSetFanSpeed_v2(device, coolerId, val);
                 break;
 
             case NV_CTRL_THERMAL_COOLER_LEVEL_SET_DEFAULT:
-                ret = nvml->lib.DeviceSetDefaultFanSpeed_v2(device, coolerId);
+                ret = nvml->ctx->lib.DeviceSetDefaultFanSpeed_v2(device, coolerId);
                 break;
 
             default:
@@ -2063,7 +2301,7 @@ static nvmlReturn_t getDeviceMemoryCounts(const CtrlTarget *ctrl_target,
          i < NVML_MEMORY_LOCATION_COUNT;
          i++) {
 
-        ret = nvml->lib.DeviceGetMemoryErrorCounter(device, errorType,
+        ret = nvml->ctx->lib.DeviceGetMemoryErrorCounter(device, errorType,
                                                     counterType, i, &count);
         if (ret == NVML_SUCCESS) {
             anySuccess = NVML_SUCCESS;
@@ -2099,7 +2337,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_BINARY_DATA_COOLERS_USED_BY_GPU:
@@ -2109,7 +2347,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
                 int offset = 0;
                 int i = 0;
 
-                ret = nvml->lib.DeviceGetNumFans(device, &count);
+                ret = nvml->ctx->lib.DeviceGetNumFans(device, &count);
                 if (ret != NVML_SUCCESS) {
                     return NvCtrlNotSupported;
                 }
@@ -2128,7 +2366,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
 
                 /* Calculate global fan index offset for this GPU */
                 for (i = 0; i < nvml->deviceIdx; i++) {
-                    offset += nvml->coolerCountPerGPU[i];
+                    offset += nvml->ctx->coolerCountPerGPU[i];
                 }
 
                 fan_data[0] = count;
@@ -2145,7 +2383,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
                 int i = 0;
                 nvmlGpuThermalSettings_t pThermalSettings;
 
-                ret = nvml->lib.DeviceGetThermalSettings(device,
+                ret = nvml->ctx->lib.DeviceGetThermalSettings(device,
                                                          NVML_THERMAL_TARGET_ALL,
                                                          &pThermalSettings);
                 if (ret != NVML_SUCCESS) {
@@ -2168,7 +2406,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
 
                 /* Calculate global sensor index offset for this GPU */
                 for (i = 0; i < nvml->deviceIdx; i++) {
-                    offset += nvml->sensorCountPerGPU[i];
+                    offset += nvml->ctx->sensorCountPerGPU[i];
                 }
 
                 sensor_data[0] = count;
@@ -2201,6 +2439,34 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
                                             NVML_AGGREGATE_ECC,
                                             data, len);
                 break;
+            case NV_CTRL_BINARY_DATA_GPU_UTILIZATION:
+            {
+                nvmlUtilization_t util;
+                CtrlGpuUtilization *gpu_util;
+
+                if (ctrl_target->system->has_nv_control) {
+                    /*
+                     * Not all utilization types are currently available via
+                     * NVML so, if accessible, get the rates from X.
+                     */
+                    return NvCtrlNotSupported;
+                }
+
+                ret = nvml->ctx->lib.DeviceGetUtilizationRates(device, &util);
+                if (ret != NVML_SUCCESS) {
+                    break;
+                }
+
+                gpu_util = nvalloc(sizeof(CtrlGpuUtilization));
+                gpu_util->valid = CTRL_GPU_UTILIZATION_GRAPHICS |
+                                  CTRL_GPU_UTILIZATION_MEMORY;
+                gpu_util->graphics = util.gpu;
+                gpu_util->memory = util.memory;
+
+                *data = (unsigned char *) gpu_util;
+                *len  = sizeof(CtrlGpuUtilization);
+                break;
+            }
             case NV_CTRL_BINARY_DATA_FRAMELOCKS_USED_BY_GPU:
             case NV_CTRL_BINARY_DATA_DISPLAYS_CONNECTED_TO_GPU:
             case NV_CTRL_BINARY_DATA_DISPLAYS_ON_GPU:
@@ -2417,7 +2683,7 @@ NvCtrlNvmlGetGPUValidAttributeValues(const CtrlTarget *ctrl_target, int attr,
 
     val->permissions.write = NV_FALSE;
 
-    ret = nvml->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(nvml->deviceIdx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
@@ -2480,7 +2746,7 @@ NvCtrlNvmlGetGPUValidAttributeValues(const CtrlTarget *ctrl_target, int attr,
             case NV_CTRL_GPU_POWER_MIZER_MODE:
                 {
                     nvmlDevicePowerMizerModes_v1_t powerMizerMode;
-                    ret = nvml->lib.DeviceGetPowerMizerMode_v1(device, &powerMizerMode);
+                    ret = nvml->ctx->lib.DeviceGetPowerMizerMode_v1(device, &powerMizerMode);
                     val->allowed_ints = powerMizerMode.supportedPowerMizerModes;
                     val->valid_type = CTRL_ATTRIBUTE_VALID_TYPE_INT_BITS;
                     break;
@@ -2557,21 +2823,21 @@ NvCtrlNvmlGetThermalValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
     /* Get the proper device and sensor ID according to the target ID */
-    getDeviceAndTargetIndex(h, nvml->sensorCount, nvml->sensorCountPerGPU,
+    getDeviceAndTargetIndex(h, nvml->ctx->sensorCount, nvml->ctx->sensorCountPerGPU,
                             &deviceId, &sensorId);
     if (sensorId == -1) {
         return NvCtrlBadHandle;
     }
 
 
-    ret = nvml->lib.DeviceGetHandleByIndex(deviceId, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_SENSOR_READING:
                 {
                     nvmlGpuThermalSettings_t pThermalSettings;
 
-                    ret = nvml->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
+                    ret = nvml->ctx->lib.DeviceGetThermalSettings(device, NVML_THERMAL_TARGET_ALL, //sensorIndex
                                                              &pThermalSettings);
                     if (ret == NVML_SUCCESS) {
                         val->valid_type = CTRL_ATTRIBUTE_VALID_TYPE_RANGE;
@@ -2617,14 +2883,14 @@ NvCtrlNvmlGetCoolerValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
     /* Get the proper device and cooler ID according to the target ID */
-    getDeviceAndTargetIndex(h, nvml->coolerCount, nvml->coolerCountPerGPU,
+    getDeviceAndTargetIndex(h, nvml->ctx->coolerCount, nvml->ctx->coolerCountPerGPU,
                             &deviceId, &coolerId);
     if (coolerId == -1) {
         return NvCtrlBadHandle;
     }
 
 
-    ret = nvml->lib.DeviceGetHandleByIndex(deviceId, &device);
+    ret = nvml->ctx->lib.DeviceGetHandleByIndex(deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_CURRENT_LEVEL:
@@ -2635,7 +2901,7 @@ NvCtrlNvmlGetCoolerValidAttributeValues(const CtrlTarget *ctrl_target,
                 return NvCtrlSuccess;
 
             case NV_CTRL_THERMAL_COOLER_LEVEL:
-                ret = nvml->lib.DeviceGetMinMaxFanSpeed(device, &minSpeed, &maxSpeed);
+                ret = nvml->ctx->lib.DeviceGetMinMaxFanSpeed(device, &minSpeed, &maxSpeed);
                 if (ret == NVML_SUCCESS) {
                     /* Range as a percent */
                     val->valid_type = CTRL_ATTRIBUTE_VALID_TYPE_RANGE;
@@ -118,6 +118,8 @@ typedef struct __NvCtrlXvBlitterAttributes NvCtrlXvBlitterAttributes;
 typedef struct __NvCtrlXvAttribute NvCtrlXvAttribute;
 typedef struct __NvCtrlXrandrAttributes NvCtrlXrandrAttributes;
 typedef struct __NvCtrlNvmlAttributes NvCtrlNvmlAttributes;
+typedef struct __NvCtrlNvmlContext NvCtrlNvmlContext;
+typedef struct __NvCtrlNvmlIds NvCtrlNvmlIds;
 typedef struct __NvCtrlEventPrivateHandle NvCtrlEventPrivateHandle;
 typedef struct __NvCtrlEventPrivateHandleNode NvCtrlEventPrivateHandleNode;
 
@@ -161,7 +163,14 @@ struct __NvCtrlXrandrAttributes {
     XRRCrtcGamma *pGammaRamp;
 };
 
-struct __NvCtrlNvmlAttributes {
+/*
+ * NVML library and device information, loaded once and shared by all the
+ * NVML private handles.
+ */
+
+struct __NvCtrlNvmlContext {
+    int refcount;
+
     struct {
         void *handle;
 
@@ -224,18 +233,26 @@ struct __NvCtrlNvmlAttributes {
         typeof(nvmlDeviceSetPowerMizerMode_v1)               (*DeviceSetPowerMizerMode_v1);
     } lib;
 
-    unsigned int deviceIdx; /* XXX Needed while using NV-CONTROL as fallback */
     unsigned int deviceCount;
+    nvmlDevice_t *devices;  /* NULL entries for devices that failed to open */
     unsigned int sensorCount;
     unsigned int *sensorCountPerGPU;
     unsigned int coolerCount;
     unsigned int *coolerCountPerGPU;
 };
 
+struct __NvCtrlNvmlAttributes {
+    NvCtrlNvmlContext *ctx; /* Shared NVML library and device information */
+
+    unsigned int deviceIdx; /* XXX Needed while using NV-CONTROL as fallback */
+    NvCtrlNvmlIds *ids;     /* Shared NV-CONTROL to NVML id dictionary */
+};
+
 struct __NvCtrlAttributePrivateHandle {
     Display *dpy;                   /* display connection */
     CtrlTargetType target_type;     /* Type of target this handle controls */
     int target_id;                  /* screen num, gpu num (etc) of target */
+    CtrlAttributeCache *cache;      /* cache of the owning system, if any */
 
     /* Common attributes */
     NvCtrlNvControlAttributes *nv;  /* NV-CONTROL extension info */
@@ -262,6 +279,7 @@ struct __NvCtrlEventPrivateHandle {
     int fd;                /* file descriptor to poll for new events */
     int nvctrl_event_base; /* NV-CONTROL base for indexing & identifying evts */
     int xrandr_event_base; /* RandR base for indexing & identifying evts */
+    CtrlSystem *system;    /* system whose attribute cache events invalidate */
 };
 
 struct __NvCtrlEventPrivateHandleNode {
@@ -297,6 +315,16 @@ static inline const NvCtrlAttributePrivateHandle
     return (const NvCtrlAttributePrivateHandle *)(ctrl_target->h);
 }
 
+static inline CtrlAttributeCache
+*getAttributeCache(const CtrlTarget *ctrl_target)
+{
+    if (!isTargetValid(ctrl_target) || (ctrl_target->system == NULL)) {
+        return NULL;
+    }
+
+    return ctrl_target->system->cache;
+}
+
 
 NvCtrlNvControlAttributes *
 NvCtrlInitNvControlAttributes (NvCtrlAttributePrivateHandle *);
@@ -432,6 +460,15 @@ NvCtrlNvControlQueryTargetCount(const NvCtrlAttributePrivateHandle *,
 ReturnStatus NvCtrlNvControlGetAttribute(const NvCtrlAttributePrivateHandle *,
                                          unsigned int, int, int64_t *);
 
+ReturnStatus
+NvCtrlNvControlGetAttributes(const NvCtrlAttributePrivateHandle *,
+                             CtrlAttributeQuery *, const int *, int);
+
+ReturnStatus
+NvCtrlNvControlGetValidAttributeValuesBatch(const NvCtrlAttributePrivateHandle *,
+                                            CtrlAttributeValidQuery *,
+                                            const int *, int);
+
 ReturnStatus
 NvCtrlNvControlSetAttribute (NvCtrlAttributePrivateHandle *, unsigned int,
                              int, int);
@@ -525,4 +562,38 @@ NvCtrlNvmlGetAttributePerms(const NvCtrlAttributePrivateHandle *,
                             CtrlAttributeType, int,
                             CtrlAttributePerms *);
 
+
+/* Attribute query cache; see NvCtrlAttributesCache.c */
+
+typedef enum {
+    CTRL_ATTRIBUTE_CACHE_VALUE = 0,
+    CTRL_ATTRIBUTE_CACHE_STRING,
+    CTRL_ATTRIBUTE_CACHE_VALID_VALUES,
+    CTRL_ATTRIBUTE_CACHE_PERMS,
+} CtrlAttributeCacheKind;
+
+CtrlAttributeCache *NvCtrlAttributeCacheCreate(void);
+void NvCtrlAttributeCacheFree(CtrlAttributeCache *cache);
+
+Bool NvCtrlAttributeCacheLookup(CtrlAttributeCache *cache,
+                                const NvCtrlAttributePrivateHandle *h,
+                                CtrlAttributeCacheKind kind,
+                                CtrlAttributeType attr_type,
+                                unsigned int display_mask, int attr,
+                                void *data, ReturnStatus *status);
+void NvCtrlAttributeCacheStore(CtrlAttributeCache *cache,
+                               const NvCtrlAttributePrivateHandle *h,
+                               CtrlAttributeCacheKind kind,
+                               CtrlAttributeType attr_type,
+                               unsigned int display_mask, int attr,
+                               const void *data, ReturnStatus status);
+void NvCtrlAttributeCacheInvalidate(CtrlAttributeCache *cache,
+                                    const NvCtrlAttributePrivateHandle *h,
+                                    CtrlTargetType target_type,
+                                    int target_id, int attr);
+void NvCtrlAttributeCacheHandleEvent(CtrlAttributeCache *cache,
+                                     const CtrlEvent *event);
+void NvCtrlAttributeCachePrintStats(const CtrlAttributeCache *cache,
+                                    const char *display);
+
 #endif /* __NVCTRL_ATTRIBUTES_PRIVATE__ */
@@ -143,6 +143,10 @@ static void nv_free_ctrl_system(CtrlSystem *system)
 
     /* cleanup everything else */
 
+    NvCtrlAttributeCachePrintStats(system->cache, system->display);
+    NvCtrlAttributeCacheFree(system->cache);
+    system->cache = NULL;
+
     free(system->display);
     system->display = NULL;
 
@@ -1095,6 +1099,7 @@ static CtrlSystem *nv_alloc_ctrl_system(const char *display,
 
     system = nvalloc(sizeof(*system));
     system->limit_subsystems = limit_subsystems;
+    system->cache = NvCtrlAttributeCacheCreate();
 
     /* Connect to the system and load target information */
 
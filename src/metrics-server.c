@@ -0,0 +1,990 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * metrics-server.c - a minimal HTTP/1.0 server, listening on a UNIX or TCP
+ * socket, that answers every request with the most recently published
+ * metrics text.
+ *
+ * The server runs in its own thread and only ever copies the published
+ * text to the client: it never queries the driver, so a scrape neither
+ * waits for nor delays the sampling done by the publishing thread.  The
+ * published text is reference counted, so that a new sample can be
+ * published while an older one is still being sent.
+ *
+ * Clients are served concurrently, with non-blocking sockets multiplexed
+ * by poll(), and each client is dropped if it has not been answered
+ * within METRICS_SERVER_TIMEOUT_MS of being accepted, so that neither a
+ * slow nor a stalled client holds up the others.
+ *
+ * nv_serve_attribute_queries() implements --serve on top of it: it samples
+ * the attributes like --watch does, and publishes each sample rendered in
+ * the Prometheus text exposition format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "metrics-server.h"
+#include "query-assign.h"
+#include "msg.h"
+#include "common-utils.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define METRICS_SERVER_DEFAULT_HOST "127.0.0.1"
+#define METRICS_SERVER_BACKLOG 16
+#define METRICS_SERVER_REQUEST_MAX 4096
+#define METRICS_SERVER_TIMEOUT_MS 2000
+#define METRICS_SERVER_MAX_CLIENTS 32
+
+
+typedef struct {
+    int refs;
+    char *text;
+    size_t len;
+} MetricsSnapshot;
+
+typedef struct {
+    int fd;
+    int64_t deadline;   /* CLOCK_MONOTONIC ms by which to be done */
+
+    /* the request header, read until the end of the header */
+    char request[METRICS_SERVER_REQUEST_MAX];
+    size_t request_len;
+
+    /* the response, once the request has been read */
+    int responding;
+    char header[256];
+    size_t header_len;
+    MetricsSnapshot *snapshot;
+    const char *body;
+    size_t body_len;
+    size_t sent;        /* bytes of header and body sent so far */
+} MetricsClient;
+
+struct _MetricsServer {
+    int listen_fd;
+    int wake_fds[2];    /* written to by nv_metrics_server_stop() */
+    char *unix_path;    /* socket file to remove when stopping, if any */
+
+    pthread_t thread;
+
+    pthread_mutex_t lock; /* protects snapshot and its reference count */
+    MetricsSnapshot *snapshot;
+};
+
+
+
+/*
+ * snapshot_unref() - drop a reference to 'snapshot', freeing it when the
+ * last reference is gone.  Must be called with the server lock held.
+ */
+
+static void snapshot_unref(MetricsSnapshot *snapshot)
+{
+    if (snapshot && --snapshot->refs == 0) {
+        nvfree(snapshot->text);
+        nvfree(snapshot);
+    }
+}
+
+
+
+/*
+ * open_unix_socket() - create a listening socket bound to the file 'path'.
+ * A socket file left behind by a previous instance that no longer accepts
+ * connections is replaced; a socket that is still being served, or any
+ * other kind of file, is not.  Returns the socket, or -1 on failure.
+ */
+
+static int open_unix_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if ((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            close(fd);
+            errno = EADDRINUSE;
+            return -1;
+        }
+        if (errno == ECONNREFUSED) {
+            unlink(path);
+        }
+
+        /* a socket that attempted to connect cannot be bound */
+
+        close(fd);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+    }
+
+    if ((bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) ||
+        (listen(fd, METRICS_SERVER_BACKLOG) < 0)) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+
+
+/*
+ * open_tcp_socket() - create a listening socket bound to 'port' on the
+ * address 'host'; a NULL 'host' binds to all addresses.  Returns the
+ * socket, or -1 on failure, with errno set or *gai_err set to the
+ * getaddrinfo() error.
+ */
+
+static int open_tcp_socket(const char *host, const char *port, int *gai_err)
+{
+    struct addrinfo hints, *res, *ai;
+    int fd = -1, err = 0, one = 1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    *gai_err = getaddrinfo(host, port, &hints, &res);
+    if (*gai_err != 0) {
+        return -1;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            err = errno;
+            continue;
+        }
+
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        if ((bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) &&
+            (listen(fd, METRICS_SERVER_BACKLOG) == 0)) {
+            break;
+        }
+
+        err = errno;
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(res);
+
+    if (fd < 0) {
+        errno = err;
+    }
+
+    return fd;
+}
+
+
+
+static int64_t now_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+
+/*
+ * client_close() - close the connection to 'client' and release the
+ * snapshot it was being sent.
+ */
+
+static void client_close(MetricsServer *server, MetricsClient *client)
+{
+    if (client->snapshot) {
+        pthread_mutex_lock(&server->lock);
+        snapshot_unref(client->snapshot);
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    close(client->fd);
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+}
+
+
+
+/*
+ * client_respond() - prepare the response to the request read from
+ * 'client': the currently published snapshot, or an error.
+ */
+
+static void client_respond(MetricsServer *server, MetricsClient *client)
+{
+    const char *status, *type;
+    int head, len;
+
+    head = (strncmp(client->request, "HEAD ", 5) == 0);
+
+    if (!head && (strncmp(client->request, "GET ", 4) != 0)) {
+        status = "405 Method Not Allowed";
+        type = "text/plain";
+        client->body = "Only GET and HEAD requests are supported.\n";
+        client->body_len = strlen(client->body);
+    } else {
+        pthread_mutex_lock(&server->lock);
+        client->snapshot = server->snapshot;
+        if (client->snapshot) {
+            client->snapshot->refs++;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        if (!client->snapshot) {
+            status = "503 Service Unavailable";
+            type = "text/plain";
+            client->body = "No sample has been taken yet.\n";
+            client->body_len = strlen(client->body);
+        } else {
+            status = "200 OK";
+            type = "text/plain; version=0.0.4; charset=utf-8";
+            client->body = client->snapshot->text;
+            client->body_len = client->snapshot->len;
+        }
+    }
+
+    len = snprintf(client->header, sizeof(client->header),
+                   "HTTP/1.0 %s\r\n"
+                   "Content-Type: %s\r\n"
+                   "Content-Length: %zu\r\n"
+                   "Connection: close\r\n"
+                   "\r\n",
+                   status, type, client->body_len);
+
+    client->header_len = len;
+
+    if (head) {
+        client->body_len = 0;
+    }
+
+    client->responding = 1;
+}
+
+
+
+/*
+ * client_read() - read what is available of the request header of
+ * 'client', and prepare the response once it is complete.  Returns 0 if
+ * the client went away before sending a request line.
+ */
+
+static int client_read(MetricsServer *server, MetricsClient *client)
+{
+    size_t size = sizeof(client->request);
+    ssize_t n;
+
+    n = recv(client->fd, client->request + client->request_len,
+             size - 1 - client->request_len, 0);
+    if (n < 0) {
+        return (errno == EINTR) || (errno == EAGAIN) ||
+               (errno == EWOULDBLOCK);
+    }
+
+    client->request_len += n;
+    client->request[client->request_len] = '\0';
+
+    if ((n == 0) || (client->request_len == size - 1) ||
+        strstr(client->request, "\r\n\r\n") ||
+        strstr(client->request, "\n\n")) {
+
+        if (!strchr(client->request, '\n')) {
+            return 0;
+        }
+
+        client_respond(server, client);
+    }
+
+    return 1;
+}
+
+
+
+/*
+ * client_write() - send what the socket of 'client' accepts of the
+ * response.  Returns 0 once the response has been sent, or if the client
+ * went away or stopped reading.
+ */
+
+static int client_write(MetricsClient *client)
+{
+    const char *buf;
+    size_t len;
+    ssize_t n;
+
+    while (client->sent < client->header_len + client->body_len) {
+        if (client->sent < client->header_len) {
+            buf = client->header + client->sent;
+            len = client->header_len - client->sent;
+        } else {
+            buf = client->body + (client->sent - client->header_len);
+            len = client->body_len - (client->sent - client->header_len);
+        }
+
+        n = send(client->fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+        }
+        client->sent += n;
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * server_thread() - accept and answer clients until woken up by
+ * nv_metrics_server_stop().  At most METRICS_SERVER_MAX_CLIENTS clients
+ * are served at a time; further connections wait in the listen backlog.
+ */
+
+static void *server_thread(void *data)
+{
+    MetricsServer *server = data;
+    MetricsClient *clients;
+    struct pollfd pfds[METRICS_SERVER_MAX_CLIENTS + 2];
+    int slot[METRICS_SERVER_MAX_CLIENTS + 2];
+    int64_t now, timeout;
+    int i, n, num_clients = 0, fd, ok;
+
+    clients = nvalloc(sizeof(*clients) * METRICS_SERVER_MAX_CLIENTS);
+    for (i = 0; i < METRICS_SERVER_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+
+    while (1) {
+        pfds[0].fd = server->wake_fds[0];
+        pfds[0].events = POLLIN;
+        n = 1;
+
+        if (num_clients < METRICS_SERVER_MAX_CLIENTS) {
+            pfds[n].fd = server->listen_fd;
+            pfds[n].events = POLLIN;
+            slot[n++] = -1;
+        }
+
+        now = now_ms();
+        timeout = -1;
+
+        for (i = 0; i < METRICS_SERVER_MAX_CLIENTS; i++) {
+            if (clients[i].fd < 0) {
+                continue;
+            }
+            pfds[n].fd = clients[i].fd;
+            pfds[n].events = clients[i].responding ? POLLOUT : POLLIN;
+            slot[n++] = i;
+
+            if ((timeout < 0) || (clients[i].deadline - now < timeout)) {
+                timeout = NV_MAX(clients[i].deadline - now, 0);
+            }
+        }
+
+        if (poll(pfds, n, (int) timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (pfds[0].revents) {
+            break;
+        }
+
+        now = now_ms();
+
+        for (i = 1; i < n; i++) {
+            MetricsClient *client;
+
+            if (slot[i] < 0) {
+                if (!(pfds[i].revents & POLLIN)) {
+                    continue;
+                }
+
+                fd = accept(server->listen_fd, NULL, NULL);
+                if (fd < 0) {
+                    continue;
+                }
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+                for (client = clients; client->fd >= 0; client++) {
+                }
+                client->fd = fd;
+                client->deadline = now + METRICS_SERVER_TIMEOUT_MS;
+                num_clients++;
+                continue;
+            }
+
+            client = &clients[slot[i]];
+            ok = 1;
+
+            if (pfds[i].revents) {
+                if (!client->responding) {
+                    ok = client_read(server, client);
+                }
+                if (ok && client->responding) {
+                    ok = client_write(client);
+                }
+            }
+
+            if (!ok || (now >= client->deadline)) {
+                client_close(server, client);
+                num_clients--;
+            }
+        }
+    }
+
+    for (i = 0; i < METRICS_SERVER_MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) {
+            client_close(server, &clients[i]);
+        }
+    }
+
+    nvfree(clients);
+
+    return NULL;
+}
+
+
+
+/*
+ * nv_metrics_server_start() - listen on 'address' and start answering
+ * requests from a new thread.  'address' is either "unix:PATH" or
+ * "[HOST:]PORT"; HOST defaults to the loopback address, and may be '*' to
+ * listen on all addresses.  IPv6 addresses must be enclosed in brackets.
+ *
+ * Until nv_metrics_server_publish() is first called, requests are
+ * answered with "503 Service Unavailable".
+ *
+ * Returns NULL and prints an error message on failure.
+ */
+
+MetricsServer *nv_metrics_server_start(const char *address)
+{
+    MetricsServer *server;
+    sigset_t all, old;
+    char *host = NULL, *port, *copy = NULL;
+    int gai_err = 0, ret;
+
+    server = nvalloc(sizeof(*server));
+    server->wake_fds[0] = server->wake_fds[1] = -1;
+
+    if (strncmp(address, "unix:", 5) == 0) {
+        server->unix_path = nvstrdup(address + 5);
+        server->listen_fd = open_unix_socket(server->unix_path);
+    } else {
+        copy = nvstrdup(address);
+        port = strrchr(copy, ':');
+
+        if (port) {
+            *port++ = '\0';
+            host = copy;
+            if (host[0] == '[' && host[strlen(host) - 1] == ']') {
+                host[strlen(host) - 1] = '\0';
+                host++;
+            }
+            if (host[0] == '\0' || strcmp(host, "*") == 0) {
+                host = NULL;
+            }
+        } else {
+            port = copy;
+            host = METRICS_SERVER_DEFAULT_HOST;
+        }
+
+        server->listen_fd = open_tcp_socket(host, port, &gai_err);
+    }
+
+    if (server->listen_fd < 0) {
+        nv_error_msg("Unable to listen on '%s' (%s).", address,
+                     gai_err ? gai_strerror(gai_err) : strerror(errno));
+        goto fail;
+    }
+
+    if (pipe(server->wake_fds) < 0) {
+        nv_error_msg("Unable to create a pipe (%s).", strerror(errno));
+        goto fail;
+    }
+
+    pthread_mutex_init(&server->lock, NULL);
+
+    /*
+     * block all signals in the server thread, so that SIGINT and SIGTERM
+     * are delivered to (and interrupt the sleep of) the sampling thread
+     */
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    ret = pthread_create(&server->thread, NULL, server_thread, server);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (ret != 0) {
+        nv_error_msg("Unable to create the server thread (%s).",
+                     strerror(ret));
+        pthread_mutex_destroy(&server->lock);
+        goto fail;
+    }
+
+    nvfree(copy);
+
+    return server;
+
+ fail:
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        if (server->unix_path) {
+            unlink(server->unix_path);
+        }
+    }
+    if (server->wake_fds[0] >= 0) {
+        close(server->wake_fds[0]);
+        close(server->wake_fds[1]);
+    }
+    nvfree(server->unix_path);
+    nvfree(server);
+    nvfree(copy);
+
+    return NULL;
+
+} /* nv_metrics_server_start() */
+
+
+
+/*
+ * nv_metrics_server_publish() - replace the text served by 'server' with
+ * the 'len' bytes at 'text'.  The server takes ownership of 'text', which
+ * must have been allocated with malloc().
+ */
+
+void nv_metrics_server_publish(MetricsServer *server, char *text, size_t len)
+{
+    MetricsSnapshot *snapshot = nvalloc(sizeof(*snapshot));
+    MetricsSnapshot *old;
+
+    snapshot->refs = 1;
+    snapshot->text = text;
+    snapshot->len = len;
+
+    pthread_mutex_lock(&server->lock);
+    old = server->snapshot;
+    server->snapshot = snapshot;
+    snapshot_unref(old);
+    pthread_mutex_unlock(&server->lock);
+}
+
+
+
+/*
+ * nv_metrics_server_stop() - stop the server thread, close the listening
+ * socket and free 'server'.
+ */
+
+void nv_metrics_server_stop(MetricsServer *server)
+{
+    char c = 0;
+    ssize_t ret;
+
+    if (!server) {
+        return;
+    }
+
+    do {
+        ret = write(server->wake_fds[1], &c, 1);
+    } while (ret < 0 && errno == EINTR);
+
+    pthread_join(server->thread, NULL);
+
+    close(server->wake_fds[0]);
+    close(server->wake_fds[1]);
+    close(server->listen_fd);
+
+    if (server->unix_path) {
+        unlink(server->unix_path);
+        nvfree(server->unix_path);
+    }
+
+    snapshot_unref(server->snapshot);
+    pthread_mutex_destroy(&server->lock);
+
+    nvfree(server);
+
+} /* nv_metrics_server_stop() */
+
+
+
+/*
+ * Serve mode (--serve): the queries are resolved and sampled as in watch
+ * mode, but instead of being printed, each sample is rendered in the
+ * Prometheus text exposition format and published to a metrics server
+ * thread.  Scrapes are answered from the most recently published text, so
+ * that a scrape never waits for a driver query.
+ */
+
+#define SERVE_METRIC_PREFIX "nvidia_settings_"
+#define SERVE_DEFAULT_INTERVAL 5.0
+
+/* The attributes served when no --query is given */
+
+static const char *serve_default_queries[] = {
+    "GPUCoreTemp",
+    "GPUCurrentFanSpeed",
+    "GPUCurrentFanSpeedRPM",
+    "GPUCurrentClockFreqsString",
+    "GPUUtilization",
+    "UsedDedicatedGPUMemory",
+    "TotalDedicatedGPUMemory",
+    "GpuGetPowerUsage",
+};
+
+typedef struct {
+    FILE *out;
+    const WatchSample *s;
+} ServeTokenData;
+
+
+
+/*
+ * serve_print_metric_name() - print the metric name for the attribute
+ * 'name': the CamelCase attribute name in snake_case, with a common
+ * prefix (e.g., "GPUCoreTemp" becomes "nvidia_settings_gpu_core_temp").
+ */
+
+static void serve_print_metric_name(FILE *out, const char *name)
+{
+    const unsigned char *c = (const unsigned char *) name;
+    int i;
+
+    fputs(SERVE_METRIC_PREFIX, out);
+
+    for (i = 0; c[i]; i++) {
+        if (isupper(c[i]) && (i > 0) &&
+            (islower(c[i - 1]) || isdigit(c[i - 1]) ||
+             (isupper(c[i - 1]) && islower(c[i + 1])))) {
+            fputc('_', out);
+        }
+        fputc(isalnum(c[i]) ? tolower(c[i]) : '_', out);
+    }
+}
+
+
+
+/*
+ * serve_print_escaped() - print 'str' with backslashes and newlines
+ * escaped, and, if 'quoted' is set, double quotes; this is the escaping
+ * of label values, while HELP texts are printed unquoted.
+ */
+
+static void serve_print_escaped(FILE *out, const char *str, Bool quoted)
+{
+    for (; str && *str; str++) {
+        if (*str == '\\') {
+            fputs("\\\\", out);
+        } else if (*str == '\n') {
+            fputs("\\n", out);
+        } else if (quoted && *str == '"') {
+            fputs("\\\"", out);
+        } else {
+            fputc(*str, out);
+        }
+    }
+}
+
+
+
+/*
+ * serve_print_value() - print one line of the metric for 's', with the
+ * label key="'key'" if 'key' is not NULL.  'value' is the text of the
+ * value for string attributes; values of string attributes which are not
+ * numbers are not printed.
+ */
+
+static void serve_print_value(FILE *out, const WatchSample *s,
+                              const char *key, const char *value)
+{
+    const CtrlTargetTypeInfo *info = s->t->targetTypeInfo;
+    double d = 0.0;
+    char *end;
+
+    if (value) {
+        d = strtod(value, &end);
+        if (end == value || *end != '\0') {
+            return;
+        }
+    }
+
+    serve_print_metric_name(out, s->a->name);
+
+    fprintf(out, "{target=\"%s:%d\"",
+            info ? info->parsed_name : "", NvCtrlGetTargetId(s->t));
+
+    if (s->mask) {
+        fprintf(out, ",display_mask=\"0x%08x\"", s->mask);
+    }
+
+    if (key) {
+        fputs(",key=\"", out);
+        serve_print_escaped(out, key, NV_TRUE);
+        fputc('"', out);
+    }
+
+    if (value) {
+        fprintf(out, "} %.17g\n", d);
+    } else {
+        fprintf(out, "} %d\n", s->val);
+    }
+}
+
+
+
+static void serve_apply_token(char *token, char *value, void *data)
+{
+    ServeTokenData *t = data;
+
+    serve_print_value(t->out, t->s, token, value);
+}
+
+
+
+/*
+ * serve_print_sample() - print the metric lines for the last value read
+ * for 's'.  Strings of "token=value, ..." pairs (such as the current
+ * clock frequencies or the utilization) are printed as one line per
+ * token, with the token as the "key" label.
+ */
+
+static void serve_print_sample(FILE *out, const WatchSample *s)
+{
+    ServeTokenData data;
+
+    if (s->a->type != CTRL_ATTRIBUTE_TYPE_STRING) {
+        serve_print_value(out, s, NULL, NULL);
+    } else if (s->str && strchr(s->str, '=')) {
+        data.out = out;
+        data.s = s;
+        parse_token_value_pairs(s->str, serve_apply_token, &data);
+    } else if (s->str) {
+        serve_print_value(out, s, NULL, s->str);
+    }
+}
+
+
+
+/*
+ * serve_render() - render the last values read for all samples in the
+ * Prometheus text exposition format.  The samples of each attribute are
+ * grouped under a single HELP and TYPE line.  Returns the text, which
+ * must be freed with free(), and its length in 'len'; or NULL on failure.
+ */
+
+static char *serve_render(const WatchSample *samples, int num_samples,
+                          const struct timespec *when, double duration,
+                          size_t *len)
+{
+    char *text = NULL;
+    FILE *out;
+    int i, j;
+
+    out = open_memstream(&text, len);
+    if (!out) {
+        return NULL;
+    }
+
+    for (i = 0; i < num_samples; i++) {
+        const AttributeTableEntry *a = samples[i].a;
+
+        /* skip attributes already printed with an earlier sample */
+
+        for (j = 0; j < i && samples[j].a != a; j++) {
+        }
+        if (j < i) {
+            continue;
+        }
+
+        fputs("# HELP ", out);
+        serve_print_metric_name(out, a->name);
+        fputc(' ', out);
+        serve_print_escaped(out, a->desc, NV_FALSE);
+        fputs("\n# TYPE ", out);
+        serve_print_metric_name(out, a->name);
+        fputs(" gauge\n", out);
+
+        for (j = i; j < num_samples; j++) {
+            if (samples[j].a == a && samples[j].have_value) {
+                serve_print_sample(out, &samples[j]);
+            }
+        }
+    }
+
+    fprintf(out,
+            "# HELP " SERVE_METRIC_PREFIX "last_sample_timestamp_seconds "
+            "Time at which the attributes were last sampled.\n"
+            "# TYPE " SERVE_METRIC_PREFIX "last_sample_timestamp_seconds "
+            "gauge\n"
+            SERVE_METRIC_PREFIX "last_sample_timestamp_seconds %lld.%03ld\n"
+            "# HELP " SERVE_METRIC_PREFIX "sample_duration_seconds "
+            "Time taken to sample all attributes.\n"
+            "# TYPE " SERVE_METRIC_PREFIX "sample_duration_seconds gauge\n"
+            SERVE_METRIC_PREFIX "sample_duration_seconds %.6f\n",
+            (long long) when->tv_sec, when->tv_nsec / 1000000, duration);
+
+    if (fclose(out) != 0) {
+        free(text);
+        return NULL;
+    }
+
+    return text;
+}
+
+
+
+/*
+ * nv_serve_attribute_queries() - resolve the attributes given with
+ * --query (or, if there are none, a default set of thermal, cooler,
+ * clock, utilization, memory and power attributes), start a metrics
+ * server on op->serve_address, and publish the sampled values every
+ * op->watch_interval seconds (SERVE_DEFAULT_INTERVAL if unset) until
+ * SIGINT or SIGTERM is received.
+ *
+ * If any errors are encountered while resolving the queries or starting
+ * the server, an error message is printed and NV_FALSE is returned.
+ * Otherwise, NV_TRUE is returned.
+ */
+
+int nv_serve_attribute_queries(const Options *op, CtrlSystemList *systems)
+{
+    WatchSample *samples = NULL;
+    int num_samples = 0;
+    MetricsServer *server;
+    WatchTimer timer;
+    struct timespec begin, end, when;
+    double duration;
+    size_t len;
+    char *text;
+    int query, i, val = NV_FALSE;
+
+    if (op->num_queries) {
+        for (query = 0; query < op->num_queries; query++) {
+            if (!nv_watch_add_query(op->queries[query], op->ctrl_display,
+                                    systems, NV_FALSE,
+                                    &samples, &num_samples)) {
+                goto done;
+            }
+        }
+    } else {
+        for (query = 0; query < ARRAY_LEN(serve_default_queries); query++) {
+            if (!nv_watch_add_query(serve_default_queries[query],
+                                    op->ctrl_display, systems, NV_TRUE,
+                                    &samples, &num_samples)) {
+                goto done;
+            }
+        }
+    }
+
+    if (num_samples == 0) {
+        nv_error_msg("None of the queried attributes can be served.");
+        goto done;
+    }
+
+    server = nv_metrics_server_start(op->serve_address);
+    if (!server) {
+        goto done;
+    }
+
+    nv_watch_timer_start(&timer, op->watch_interval > 0.0 ?
+                         op->watch_interval : SERVE_DEFAULT_INTERVAL);
+
+    do {
+        clock_gettime(CLOCK_REALTIME, &when);
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+
+        for (i = 0; i < num_samples; i++) {
+            nv_watch_sample(&samples[i]);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        duration = (end.tv_sec - begin.tv_sec) +
+                   (end.tv_nsec - begin.tv_nsec) / 1000000000.0;
+
+        text = serve_render(samples, num_samples, &when, duration, &len);
+        if (text) {
+            nv_metrics_server_publish(server, text, len);
+        }
+    } while (nv_watch_timer_wait(&timer));
+
+    nv_watch_timer_stop(&timer);
+
+    nv_metrics_server_stop(server);
+
+    val = NV_TRUE;
+
+ done:
+    for (i = 0; i < num_samples; i++) {
+        free(samples[i].str);
+    }
+    nvfree(samples);
+
+    return val;
+
+} /* nv_serve_attribute_queries() */
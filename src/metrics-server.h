@@ -0,0 +1,41 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2026 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+/*
+ * metrics-server.h - prototypes for the HTTP server that hands out the
+ * most recently published metrics text (--serve).
+ */
+
+#ifndef __METRICS_SERVER_H__
+#define __METRICS_SERVER_H__
+
+#include <stddef.h>
+
+#include "NvCtrlAttributes.h"
+#include "command-line.h"
+
+typedef struct _MetricsServer MetricsServer;
+
+MetricsServer *nv_metrics_server_start(const char *address);
+void nv_metrics_server_publish(MetricsServer *server, char *text, size_t len);
+void nv_metrics_server_stop(MetricsServer *server);
+
+int nv_serve_attribute_queries(const Options *op, CtrlSystemList *systems);
+
+#endif /* __METRICS_SERVER_H__ */
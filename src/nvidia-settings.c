@@ -22,6 +22,9 @@
 #include "command-line.h"
 #include "config-file.h"
 #include "query-assign.h"
+#include "metrics-server.h"
+#include "framelock-monitor.h"
+#include "app-profiles.h"
 #include "msg.h"
 #include "version.h"
 #include "wayland-connector.h"
@@ -314,6 +317,53 @@ int main(int argc, char **argv)
 
     op = parse_command_line(argc, argv, &systems);
 
+    /*
+     * Queries may be made from several threads, and frame lock status is
+     * sampled in the background (by --framelock-status, and for remote X
+     * servers on the GUI's frame lock page); Xlib must be told so before
+     * any display connection is opened.
+     */
+
+    if (op->jobs > 1 || op->framelock_status ||
+        (!op->num_assignments && !op->num_queries)) {
+        XInitThreads();
+    }
+
+    /*
+     * Checking which application profile rules apply to a process only
+     * requires the configuration files; there is no need to connect to
+     * the X server.
+     */
+
+    if (op->app_profile_match) {
+        ret = nv_app_profile_print_matching_rules(op->app_profile_match,
+                                                  op->output_format !=
+                                                  OUTPUT_FORMAT_TEXT,
+                                                  op->output_format ==
+                                                  OUTPUT_FORMAT_NDJSON);
+        return ret ? 0 : 1;
+    }
+
+    /*
+     * Serving metrics does not use the user interface, and falls back to
+     * NVML when no X server is available.
+     */
+
+    if (op->serve_address) {
+        ret = nv_serve_attribute_queries(op, &systems);
+        NvCtrlFreeAllSystems(&systems);
+        return ret ? 0 : 1;
+    }
+
+    /*
+     * Printing the frame lock status does not use the user interface; each
+     * X server is connected to by its own thread.
+     */
+
+    if (op->framelock_status) {
+        return nv_print_framelock_status(op) ? 0 : 1;
+    }
+
     /*
      * Using the default library names, along with a possible path or name
      * specified by the user, attempt to dlopen the appropriate user interface
@@ -212,6 +212,89 @@ static const NVGetoptOption __options[] = {
       "appropriately named library. If this is the exact location, the "
       "'use-gtk2' option is ignored.\n" },
 
+    { "jobs", 'j', NVGETOPT_INTEGER_ARGUMENT | NVGETOPT_HELP_ALWAYS, "N",
+      "Query the GPUs, fans and thermal sensors of the system using up to "
+      "&N& threads when processing the 'all' and target list queries (e.g. "
+      "^'--query all'^ or ^'--query gpus'^).  The output is identical to "
+      "that of a sequential query." },
+
+    { "output", OUTPUT_FORMAT_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, "FORMAT",
+      "Print the results of the '--query' command line option in the given "
+      "&FORMAT&.  Valid values for &FORMAT& are 'text' (the default), "
+      "'json' (a single JSON array, with one object per queried value or "
+      "target) and 'ndjson' (one JSON object per line).  Each object "
+      "records the target, the attribute name, its display device mask if "
+      "the attribute is display device specific, its value, and its valid "
+      "values and permissions.  Together with '--watch', &FORMAT& may also "
+      "be 'csv' (one comma separated row per sampled value)." },
+
+    { "watch", WATCH_OPTION,
+      NVGETOPT_DOUBLE_ARGUMENT | NVGETOPT_HELP_ALWAYS, "INTERVAL",
+      "Connect once and re-query the attributes given with '--query' every "
+      "&INTERVAL& seconds (fractions are allowed) until interrupted.  "
+      "Samples are taken at fixed points in time, so that the time spent "
+      "querying does not accumulate as drift.  Each printed value is "
+      "prefixed with the time at which it was sampled.  Only attribute "
+      "queries are supported; target list queries such as 'gpus' or 'all' "
+      "are not." },
+
+    { "watch-changes", WATCH_CHANGES_OPTION,
+      NVGETOPT_IS_BOOLEAN | NVGETOPT_HELP_ALWAYS, NULL,
+      "With '--watch', print all values on the first sample and afterwards "
+      "only the values that changed since the previous sample." },
+
+    { "serve", SERVE_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, "ADDRESS",
+      "Connect once, re-query the attributes given with '--query' every "
+      "'--watch' seconds (5 seconds by default), and serve the most recent "
+      "values in the Prometheus text exposition format over HTTP on "
+      "&ADDRESS& until interrupted.  &ADDRESS& is either 'unix:PATH', for "
+      "a UNIX domain socket, or '[HOST:]PORT', for a TCP socket on the "
+      "loopback address or on HOST ('*' for all addresses).  Without "
+      "'--query', the GPU temperature, fan speeds, clock frequencies, "
+      "utilization, memory usage and power draw are served.  Requests are "
+      "answered from the values of the previous sample, so that they never "
+      "wait for the driver, and clients are served concurrently.  A UNIX "
+      "domain socket is only replaced if no other process is serving it.  "
+      "This does not require an X server." },
+
+    { "framelock-status", FRAMELOCK_STATUS_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, "HOSTS",
+      "Print the frame lock status of the X servers in the comma separated "
+      "list &HOSTS& as a sync matrix, with one row per GPU tied to an RTX "
+      "PRO Sync device: whether the device receives sync, detects a house "
+      "sync signal and at which rate, its sync rate and the state of its "
+      "RJ45 ports, and whether the GPU has frame lock enabled, is in sync "
+      "and has stereo sync.  Each X server is connected to and queried in "
+      "its own thread, so that a slow or unreachable X server does not "
+      "delay the others.  With '--watch', the matrix is printed every "
+      "&INTERVAL& seconds until interrupted, each time showing the most "
+      "recent sample of each X server.  '--output' selects the format of "
+      "the matrix.  An X server named 'stub:NAME[@MS]' is not connected "
+      "to, but simulated, taking MS milliseconds per sample; this allows "
+      "testing without a frame lock cluster." },
+
+    { "app-profile-match", APP_PROFILE_MATCH_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, "PROCESS[,DSO...]",
+      "Load the application profile configuration files from the default "
+      "search path, print the rules which apply to the process with the "
+      "executable path &PROCESS& that has loaded the given shared objects, "
+      "in order of priority, along with the settings which result from "
+      "their profiles, and exit.  This does not require a connection to "
+      "the X server.  Use '--output=json' to print the result as a JSON "
+      "object, or '--output=ndjson' to print it on a single line." },
+
+    { "attribute-cache", ATTRIBUTE_CACHE_OPTION,
+      NVGETOPT_INTEGER_ARGUMENT | NVGETOPT_ARGUMENT_IS_OPTIONAL |
+      NVGETOPT_HELP_ALWAYS, "TTL",
+      "Cache the results of attribute queries made while running, so that "
+      "repeated queries of the same attribute do not each require a round "
+      "trip to the X server or NVML.  Valid values and permissions are "
+      "cached until the attribute changes; current values are cached for at "
+      "most &TTL& milliseconds (1000 by default).  Cache hit and miss "
+      "statistics are printed on exit." },
+
     { NULL, 0, 0, NULL, NULL},
 };
 
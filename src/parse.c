@@ -376,22 +376,123 @@ const int attributeTableLen = ARRAY_LEN(attributeTable);
 
 
 /*
- * returns the corresponding attribute entry for the given attribute constant.
- *
+ * Lookup indices over attributeTable[], built on first use by
+ * nv_build_attribute_table_index().  'byName' holds every entry sorted by
+ * case-insensitive name, and 'byAttr[type]' maps an attribute constant of the
+ * given type directly to its entry.  When the table contains duplicates, the
+ * first entry in table order wins, matching the behavior of a linear scan.
  */
-const AttributeTableEntry *nv_get_attribute_entry(const int attr,
-                                                  const CtrlAttributeType type)
+
+#define NUM_ATTRIBUTE_TYPES (CTRL_ATTRIBUTE_TYPE_COLOR + 1)
+
+static struct {
+    int built;
+    const AttributeTableEntry **byName;
+    const AttributeTableEntry **byAttr[NUM_ATTRIBUTE_TYPES];
+    int byAttrLen[NUM_ATTRIBUTE_TYPES];
+} attributeIndex;
+
+
+/*
+ * case-insensitive ordering consistent with nv_strcasecmp()
+ */
+static int attribute_name_cmp(const char *a, const char *b)
+{
+    while (*a && (toupper(*a) == toupper(*b))) {
+        a++;
+        b++;
+    }
+
+    return toupper(*a) - toupper(*b);
+}
+
+static int attribute_entry_name_cmp(const void *a, const void *b)
+{
+    const AttributeTableEntry *ea = *(const AttributeTableEntry * const *) a;
+    const AttributeTableEntry *eb = *(const AttributeTableEntry * const *) b;
+    int ret = attribute_name_cmp(ea->name, eb->name);
+
+    /* keep duplicate names in table order */
+
+    if (ret == 0) {
+        ret = (ea < eb) ? -1 : (ea > eb);
+    }
+
+    return ret;
+}
+
+/*
+ * nv_build_attribute_table_index() - build the lookup indices if that has
+ * not been done yet.  This is done on first use, but must be called
+ * explicitly before attributes can be looked up from several threads.
+ */
+
+void nv_build_attribute_table_index(void)
 {
     int i;
 
+    if (attributeIndex.built) {
+        return;
+    }
+
+    attributeIndex.byName =
+        nvalloc(sizeof(*attributeIndex.byName) * attributeTableLen);
+
     for (i = 0; i < attributeTableLen; i++) {
         const AttributeTableEntry *a = attributeTable + i;
-        if ((a->attr == attr) && (a->type == type)) {
-            return a;
+
+        attributeIndex.byName[i] = a;
+
+        if ((a->type >= 0) && (a->type < NUM_ATTRIBUTE_TYPES) &&
+            (a->attr >= attributeIndex.byAttrLen[a->type])) {
+            attributeIndex.byAttrLen[a->type] = a->attr + 1;
         }
     }
 
-    return NULL;
+    qsort(attributeIndex.byName, attributeTableLen,
+          sizeof(*attributeIndex.byName), attribute_entry_name_cmp);
+
+    for (i = 0; i < NUM_ATTRIBUTE_TYPES; i++) {
+        if (attributeIndex.byAttrLen[i] > 0) {
+            attributeIndex.byAttr[i] =
+                nvalloc(sizeof(*attributeIndex.byAttr[i]) *
+                        attributeIndex.byAttrLen[i]);
+        }
+    }
+
+    for (i = 0; i < attributeTableLen; i++) {
+        const AttributeTableEntry *a = attributeTable + i;
+
+        if ((a->type < 0) || (a->type >= NUM_ATTRIBUTE_TYPES) ||
+            (a->attr < 0)) {
+            continue;
+        }
+
+        if (!attributeIndex.byAttr[a->type][a->attr]) {
+            attributeIndex.byAttr[a->type][a->attr] = a;
+        }
+    }
+
+    attributeIndex.built = NV_TRUE;
+}
+
+
+
+/*
+ * returns the corresponding attribute entry for the given attribute constant.
+ *
+ */
+const AttributeTableEntry *nv_get_attribute_entry(const int attr,
+                                                  const CtrlAttributeType type)
+{
+    nv_build_attribute_table_index();
+
+    if ((type < 0) || (type >= NUM_ATTRIBUTE_TYPES) ||
+        (attr < 0) || (attr >= attributeIndex.byAttrLen[type])) {
+        return NULL;
+    }
+
+    return attributeIndex.byAttr[type][attr];
 }
 
 
@@ -402,15 +503,28 @@ const AttributeTableEntry *nv_get_attribute_entry(const int attr,
  */
 static const AttributeTableEntry *nv_get_attribute_entry_by_name(const char *name)
 {
-    int i;
+    int lo = 0, hi;
 
-    for (i = 0; i < attributeTableLen; i++) {
-        const AttributeTableEntry *t = attributeTable + i;
-        if (nv_strcasecmp(name, t->name)) {
-            return t;
+    nv_build_attribute_table_index();
+
+    /* find the first entry whose name is not less than 'name' */
+
+    hi = attributeTableLen;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (attribute_name_cmp(attributeIndex.byName[mid]->name, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
 
+    if ((lo < attributeTableLen) &&
+        nv_strcasecmp(name, attributeIndex.byName[lo]->name)) {
+        return attributeIndex.byName[lo];
+    }
+
     return NULL;
 }
 
@@ -281,6 +281,7 @@ void nv_parsed_attribute_clean(ParsedAttribute *p);
 
 const AttributeTableEntry *nv_get_attribute_entry(const int attr,
                                                   const CtrlAttributeType type);
+void nv_build_attribute_table_index(void);
 
 char *nv_standardize_screen_name(const char *display_name, int screen);
 
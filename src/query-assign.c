@@ -29,10 +29,16 @@
 #include <ctype.h>
 #include <string.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
 
 #include <X11/Xlib.h>
 #include "NVCtrlLib.h"
 
+#include <jansson.h>
+
 #include "parse.h"
 #include "msg.h"
 #include "query-assign.h"
@@ -46,13 +52,17 @@ static int process_attribute_queries(const Options *,
                                      int, char**, const char *,
                                      CtrlSystemList *);
 
+static int watch_attribute_queries(const Options *,
+                                   int, char **, const char *,
+                                   CtrlSystemList *);
+
 static int process_attribute_assignments(const Options *,
                                          int, char**, const char *,
                                          CtrlSystemList *);
 
 static int query_all(const Options *, const char *, CtrlSystemList *);
-static int query_all_targets(const char *display_name, const int target_type,
-                             CtrlSystemList *);
+static int query_all_targets(const Options *op, const char *display_name,
+                             const int target_type, CtrlSystemList *);
 
 static void print_valid_values(const Options *op, const AttributeTableEntry *a,
                                CtrlAttributeValidValues valid);
@@ -76,7 +86,13 @@ int nv_process_assignments_and_queries(const Options *op,
 {
     int ret;
 
-    if (op->num_queries) {
+    if (op->num_queries && (op->watch_interval > 0.0) && !op->list_targets) {
+        ret = watch_attribute_queries(op,
+                                      op->num_queries,
+                                      op->queries, op->ctrl_display,
+                                      systems);
+        if (!ret) return NV_FALSE;
+    } else if (op->num_queries) {
         ret = process_attribute_queries(op,
                                         op->num_queries,
                                         op->queries, op->ctrl_display,
@@ -725,7 +741,9 @@ static int process_attribute_queries(const Options *op,
     
     /* print a newline before we begin */
 
-    if (!op->terse) {
+    if (op->output_format != OUTPUT_FORMAT_TEXT) {
+        nv_json_output_begin(op);
+    } else if (!op->terse) {
         nv_msg(NULL, "");
     }
 
@@ -744,44 +762,44 @@ static int process_attribute_queries(const Options *op,
         
         if (nv_strcasecmp(queries[query], "screens") ||
             nv_strcasecmp(queries[query], "xscreens")) {
-            query_all_targets(display_name, X_SCREEN_TARGET, systems);
+            query_all_targets(op, display_name, X_SCREEN_TARGET, systems);
             continue;
         }
         
         if (nv_strcasecmp(queries[query], "gpus")) {
-            query_all_targets(display_name, GPU_TARGET, systems);
+            query_all_targets(op, display_name, GPU_TARGET, systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "framelocks")) {
-            query_all_targets(display_name, FRAMELOCK_TARGET, systems);
+            query_all_targets(op, display_name, FRAMELOCK_TARGET, systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "fans")) {
-            query_all_targets(display_name, COOLER_TARGET, systems);
+            query_all_targets(op, display_name, COOLER_TARGET, systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "thermalsensors")) {
-            query_all_targets(display_name, THERMAL_SENSOR_TARGET, systems);
+            query_all_targets(op, display_name, THERMAL_SENSOR_TARGET, systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "svps")) {
-            query_all_targets(display_name, 
+            query_all_targets(op, display_name, 
                               NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET, 
                               systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "dpys")) {
-            query_all_targets(display_name, DISPLAY_TARGET, systems);
+            query_all_targets(op, display_name, DISPLAY_TARGET, systems);
             continue;
         }
 
         if (nv_strcasecmp(queries[query], "muxes")) {
-            query_all_targets(display_name, MUX_TARGET, systems);
+            query_all_targets(op, display_name, MUX_TARGET, systems);
             continue;
         }
 
@@ -812,7 +830,7 @@ static int process_attribute_queries(const Options *op,
         if (ret == NV_FALSE) goto done;
 
         /* print a newline at the end */
-        if (!op->terse) {
+        if (!op->terse && (op->output_format == OUTPUT_FORMAT_TEXT)) {
             nv_msg(NULL, "");
         }
 
@@ -821,6 +839,8 @@ static int process_attribute_queries(const Options *op,
     val = NV_TRUE;
     
  done:
+
+    nv_json_output_end(op);
     
     return val;
     
@@ -1185,6 +1205,47 @@ static void print_valid_values(const Options *op, const AttributeTableEntry *a,
 
 
 
+/*
+ * format_queried_value() - format the (integer) attribute value that we
+ * queried from NV-CONTROL into 'val_str' the way it is shown to the user.
+ */
+
+static void format_queried_value(const Options *op,
+                                 const CtrlTarget *target,
+                                 const CtrlAttributeValidValues *v,
+                                 int val,
+                                 const AttributeTableEntry *a,
+                                 char *val_str, size_t len)
+{
+    char *tmp_d_str;
+
+    if (a->f.int_flags.is_display_id && op->dpy_string) {
+        const char *name = NvCtrlGetDisplayConfigName(target->system, val);
+        if (name) {
+            snprintf(val_str, len, "%s", name);
+        } else {
+            snprintf(val_str, len, "%d", val);
+        }
+    } else if (a->f.int_flags.is_display_mask && op->dpy_string) {
+        tmp_d_str = display_device_mask_to_display_device_name(val);
+        snprintf(val_str, len, "%s", tmp_d_str);
+        free(tmp_d_str);
+    } else if (a->f.int_flags.is_100Hz) {
+        snprintf(val_str, len, "%.2f Hz", ((float) val) / 100.0);
+    } else if (a->f.int_flags.is_1000Hz) {
+        snprintf(val_str, len, "%.3f Hz", ((float) val) / 1000.0);
+    } else if (v->valid_type == CTRL_ATTRIBUTE_VALID_TYPE_BITMASK) {
+        snprintf(val_str, len, "0x%08x", val);
+    } else if (a->f.int_flags.is_packed) {
+        snprintf(val_str, len, (val & 0xffff) == 0 ? "%d, N/A" : "%d,%d", val >> 16, val & 0xffff);
+    } else {
+        snprintf(val_str, len, "%d", val);
+    }
+
+} /* format_queried_value() */
+
+
+
 /*
  * print_queried_value() - print the (integer) attribute value that we queried
  * from NV-CONTROL
@@ -1211,30 +1272,7 @@ static void print_queried_value(const Options *op,
         return;
     }
 
-    /* assign val_str */
-
-    if (a->f.int_flags.is_display_id && op->dpy_string) {
-        const char *name = NvCtrlGetDisplayConfigName(target->system, val);
-        if (name) {
-            snprintf(val_str, 64, "%s", name);
-        } else {
-            snprintf(val_str, 64, "%d", val);
-        }
-    } else if (a->f.int_flags.is_display_mask && op->dpy_string) {
-        tmp_d_str = display_device_mask_to_display_device_name(val);
-        snprintf(val_str, 64, "%s", tmp_d_str);
-        free(tmp_d_str);
-    } else if (a->f.int_flags.is_100Hz) {
-        snprintf(val_str, 64, "%.2f Hz", ((float) val) / 100.0);
-    } else if (a->f.int_flags.is_1000Hz) {
-        snprintf(val_str, 64, "%.3f Hz", ((float) val) / 1000.0);
-    } else if (v->valid_type == CTRL_ATTRIBUTE_VALID_TYPE_BITMASK) {
-        snprintf(val_str, 64, "0x%08x", val);
-    } else if (a->f.int_flags.is_packed) {
-        snprintf(val_str, 64, (val & 0xffff) == 0 ? "%d, N/A" : "%d,%d", val >> 16, val & 0xffff);
-    } else {
-        snprintf(val_str, 64, "%d", val);
-    }
+    format_queried_value(op, target, v, val, a, val_str, sizeof(val_str));
 
     /* append the display device name, if necessary */
 
@@ -1277,297 +1315,1277 @@ static void print_queried_value(const Options *op,
 
 
 /*
- * print_additional_stereo_info() - print the available stereo modes
+ * Machine-readable query output: each queried value (or, for the target
+ * list queries, each target) is written as one JSON object as soon as it
+ * is known, so that memory use does not grow with the size of the system.
+ * With OUTPUT_FORMAT_JSON the objects are the elements of a single array;
+ * with OUTPUT_FORMAT_NDJSON each object is written on its own line.
  */
 
-static void print_additional_stereo_info(const char *name,
-                                         unsigned int valid_stereo_modes,
-                                         const char *indent)
+static int json_records_written = 0;
+
+void nv_json_output_begin(const Options *op)
 {
-    int bit;
+    json_records_written = 0;
 
-    nv_msg(indent, "\n");
-    nv_msg(indent, "Valid '%s' Values\n", name);
-    nv_msg(indent, "  value - description\n");
+    if (op->output_format == OUTPUT_FORMAT_JSON) {
+        fputs("[", stdout);
+    }
+}
 
-    for (bit = 0; bit < 32; bit++) {
-        if (valid_stereo_modes & (1 << bit)) {
-            nv_msg(indent, "   %2u   -   %s\n", 
-                   bit, NvCtrlGetStereoModeName(bit));
-        }
+void nv_json_output_end(const Options *op)
+{
+    if (op->output_format == OUTPUT_FORMAT_JSON) {
+        fputs(json_records_written ? "\n]\n" : "]\n", stdout);
+    }
+}
+
+void nv_json_output_record(const Options *op, json_t *record)
+{
+    if (!record) {
+        return;
+    }
+
+    if (op->output_format == OUTPUT_FORMAT_JSON) {
+        fputs(json_records_written ? ",\n" : "\n", stdout);
+        json_dumpf(record, stdout, JSON_PRESERVE_ORDER | JSON_INDENT(2));
+    } else {
+        json_dumpf(record, stdout, JSON_PRESERVE_ORDER | JSON_COMPACT);
+        fputs("\n", stdout);
+        fflush(stdout);
     }
+
+    json_records_written++;
+    json_decref(record);
 }
 
 
+
 /*
- * print_additional_fsaa_info() - print the currently available fsaa
- * modes with their corresponding names
+ * json_target_record() - create a JSON object identifying the target.
  */
 
-static void print_additional_fsaa_info(const char *name,
-                                       unsigned int valid_fsaa_modes,
-                                       const char *indent)
+static json_t *json_target_record(CtrlTarget *t)
 {
-    int bit;
+    json_t *record = json_object();
 
-    nv_msg(indent, "\n");
-    nv_msg(indent, "Note to assign 'FSAA' on the commandline, you may also "
-           "need to assign\n");
-    nv_msg(indent, "'FSAAAppControlled' and 'FSAAAppEnhanced' to 0.\n");
-    nv_msg(indent, "\n");
-    nv_msg(indent, "Valid '%s' Values\n", name);
-    nv_msg(indent, "  value - description\n");
+    json_object_set_new(record, "target",
+                        json_string(t->name ? t->name : ""));
+    json_object_set_new(record, "target_type",
+                        json_string(t->targetTypeInfo ?
+                                    t->targetTypeInfo->parsed_name : ""));
+    json_object_set_new(record, "target_id",
+                        json_integer(NvCtrlGetTargetId(t)));
 
-    for (bit = 0; bit < 32; bit++) {
-        /* FSAA is not a packed attribute */
-        if (valid_fsaa_modes & (1 << bit)) {
-            nv_msg(indent, "   %2u   -   %s\n", 
-                   bit, NvCtrlGetMultisampleModeName(bit));
-        }
-    }
+    return record;
 }
 
 
 
 /*
- * print_additional_info() - after printing the main information about
- * a queried attribute, we may want to add some more when in verbose mode.
- * This function is designed to handle this. Add a new 'case' here when
- * you want to print this additional information for a specific attr.
+ * json_valid_values() - create a JSON object describing the valid values
+ * and permissions of an attribute, i.e. what print_valid_values() prints.
  */
 
-static void print_additional_info(const char *name,
-                                  int attr,
-                                  CtrlAttributeValidValues valid,
-                                  const char *indent)
+static json_t *json_valid_values(const AttributeTableEntry *a,
+                                 const CtrlAttributeValidValues *valid)
 {
-    switch (attr) {
+    json_t *obj = json_object();
+    json_t *perms, *targets, *values;
+    const char *type = "unknown";
+    int bit, i;
 
-    case NV_CTRL_FSAA_MODE:
-        print_additional_fsaa_info(name, valid.allowed_ints, indent);
+    switch (valid->valid_type) {
+    case CTRL_ATTRIBUTE_VALID_TYPE_STRING:
+        type = "string";
         break;
-
-    case NV_CTRL_STEREO:
-        if (valid.valid_type == CTRL_ATTRIBUTE_VALID_TYPE_INT_BITS) {
-            print_additional_stereo_info(name, valid.allowed_ints, indent);
+    case CTRL_ATTRIBUTE_VALID_TYPE_64BIT_INTEGER:
+        type = "64bit-integer";
+        break;
+    case CTRL_ATTRIBUTE_VALID_TYPE_INTEGER:
+        if ((a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+            a->f.int_flags.is_packed) {
+            type = "packed-integer";
+        } else {
+            type = "integer";
+        }
+        break;
+    case CTRL_ATTRIBUTE_VALID_TYPE_BITMASK:
+        type = "bitmask";
+        break;
+    case CTRL_ATTRIBUTE_VALID_TYPE_BOOL:
+        type = "bool";
+        break;
+    case CTRL_ATTRIBUTE_VALID_TYPE_RANGE:
+        type = "range";
+        json_object_set_new(obj, "min", json_integer(valid->range.min));
+        json_object_set_new(obj, "max", json_integer(valid->range.max));
+        break;
+    case CTRL_ATTRIBUTE_VALID_TYPE_INT_BITS:
+        type = "int-bits";
+        values = json_array();
+        for (bit = 0; bit < 32; bit++) {
+            if (valid->allowed_ints & (1U << bit)) {
+                json_array_append_new(values, json_integer(bit));
+            }
         }
+        json_object_set_new(obj, "values", values);
+        break;
+    default:
         break;
+    }
 
-    // add more here
+    json_object_set_new(obj, "type", json_string(type));
+
+    perms = json_object();
+    json_object_set_new(perms, "read",
+                        json_boolean(valid->permissions.read));
+    json_object_set_new(perms, "write",
+                        json_boolean(valid->permissions.write));
+    json_object_set_new(perms, "display_specific",
+                        json_boolean(valid->permissions.valid_targets &
+                                     CTRL_TARGET_PERM_BIT(DISPLAY_TARGET)));
+
+    targets = json_array();
+    for (i = 0; i < MAX_TARGET_TYPES; i++) {
+        const CtrlTargetTypeInfo *targetTypeInfo = NvCtrlGetTargetTypeInfo(i);
 
+        if (valid->permissions.valid_targets &
+            targetTypeInfo->permission_bit) {
+            json_array_append_new(targets,
+                                  json_string(targetTypeInfo->parsed_name));
+        }
     }
+    json_object_set_new(perms, "target_types", targets);
+
+    json_object_set_new(obj, "permissions", perms);
 
+    return obj;
 }
 
 
 
 /*
- * query_all() - loop through all target types, and query all attributes
- * for those targets.  The current attribute values for all display
- * devices on all targets are printed, along with the valid values for
- * each attribute.
- *
- * If an error occurs, an error message is printed and NV_FALSE is
- * returned; if successful, NV_TRUE is returned.
+ * json_attribute_value_record() - create a JSON object for a queried
+ * attribute value; 'str' is the value of string attributes, 'val' that of
+ * integer attributes.
  */
 
-static int query_all(const Options *op, const char *display_name,
-                     CtrlSystemList *systems)
+static json_t *json_attribute_value_record(CtrlTarget *t,
+                                           const AttributeTableEntry *a,
+                                           uint32 mask,
+                                           const CtrlAttributeValidValues *valid,
+                                           int val, const char *str)
 {
-    int bit, entry, val, target_type;
-    uint32 mask;
-    ReturnStatus status;
-    CtrlAttributeValidValues valid;
-    CtrlSystem *system;
+    json_t *record = json_target_record(t);
 
-    system = NvCtrlConnectToLimitedSystem(display_name, systems, TRUE);
-    if (!system) {
-        return NV_FALSE;
+    json_object_set_new(record, "attribute", json_string(a->name));
+
+    if ((NvCtrlGetTargetType(t) != DISPLAY_TARGET) &&
+        (valid->permissions.valid_targets &
+         CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
+        json_object_set_new(record, "display_mask", json_integer(mask));
     }
 
-#define INDENT "  "
+    if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+        json_object_set_new(record, "value", json_string(str ? str : ""));
+    } else {
+        json_object_set_new(record, "value", json_integer(val));
+    }
 
-    /*
-     * Loop through all target types.
-     */
+    return record;
+}
 
-    for (target_type = 0; target_type < MAX_TARGET_TYPES; target_type++) {
-        CtrlTargetNode *node;
-        const CtrlTargetTypeInfo *targetTypeInfo =
-            NvCtrlGetTargetTypeInfo(target_type);
 
 
-        for (node = system->targets[target_type]; node; node = node->next) {
-            CtrlTarget *t = node->t;
+/*
+ * json_attribute_record() - like json_attribute_value_record(), but also
+ * describe the valid values of the attribute.
+ */
 
-            if (!t->h) continue;
+static json_t *json_attribute_record(CtrlTarget *t,
+                                     const AttributeTableEntry *a,
+                                     uint32 mask,
+                                     const CtrlAttributeValidValues *valid,
+                                     int val, const char *str)
+{
+    json_t *record = json_attribute_value_record(t, a, mask, valid, val, str);
 
-            nv_msg(NULL, "Attributes queryable via %s:", t->name);
+    json_object_set_new(record, "valid_values", json_valid_values(a, valid));
 
-            if (!op->terse) {
-                nv_msg(NULL, "");
-            }
+    return record;
+}
 
-            for (entry = 0; entry < attributeTableLen; entry++) {
-                const AttributeTableEntry *a = &attributeTable[entry];
 
-                /* skip the color attributes */
 
-                if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
-                    continue;
-                }
+/*
+ * parsed_attribute_display_mask() - return the display device mask to
+ * query or assign the parsed attribute 'p' with, on each of the targets
+ * resolved by resolve_attribute_targets().
+ *
+ * Display device specifications of display attributes are resolved into
+ * the display targets themselves, so those are processed with a mask of
+ * 0; only if the display device mask was "hijacked" for something other
+ * than a display device is it passed through unfiltered.
+ */
 
-                /* skip attributes that shouldn't be queried here */
+static uint32 parsed_attribute_display_mask(const ParsedAttribute *p)
+{
+    if (p->attr_entry->flags.hijack_display_device) {
+        return p->display_device_mask;
+    }
 
-                if (a->flags.no_query_all) {
-                    continue;
-                }
+    return 0;
+}
 
-                for (bit = 0; bit < 24; bit++) {
-                    mask = 1 << bit;
 
-                    /*
-                     * if this bit is not present in the screens's enabled
-                     * display device mask (and the X screen has enabled
-                     * display devices), skip to the next bit
-                     */
 
-                    if (targetTypeInfo->uses_display_devices &&
-                        ((t->d & mask) == 0x0) && (t->d)) continue;
+/*
+ * get_valid_attribute_values() - query the valid values of the attribute
+ * 'a' on target 't' and display device mask 'mask'.
+ */
 
-                    if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
-                        char *tmp_str = NULL;
+static ReturnStatus get_valid_attribute_values(CtrlTarget *t,
+                                               const AttributeTableEntry *a,
+                                               uint32 mask,
+                                               CtrlAttributeValidValues *valid)
+{
+    if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+        return NvCtrlGetValidStringDisplayAttributeValues(t, mask, a->attr,
+                                                          valid);
+    }
 
-                        status =
-                            NvCtrlGetValidStringDisplayAttributeValues(t,
-                                                                       mask,
-                                                                       a->attr,
-                                                                       &valid);
-                        if (status == NvCtrlAttributeNotAvailable) {
-                            goto exit_bit_loop;
-                        }
+    return NvCtrlGetValidDisplayAttributeValues(t, mask, a->attr, valid);
+}
 
-                        if (status != NvCtrlSuccess &&
-                            status != NvCtrlMissingExtension) {
-                            nv_error_msg("Error while querying valid values for "
-                                         "attribute '%s' on %s (%s).",
-                                         a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
 
-                        status = NvCtrlGetStringDisplayAttribute(t,
-                                                                 mask,
-                                                                 a->attr,
-                                                                 &tmp_str);
 
-                        if (status == NvCtrlAttributeNotAvailable) {
-                            goto exit_bit_loop;
-                        }
+/*
+ * Watch mode (--watch): the queries are parsed, connected and resolved to
+ * targets once; afterwards only the attribute values are re-queried, at
+ * fixed points in time, over the same connections.
+ */
 
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying attribute '%s' "
-                                         "on %s (%s).", a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
+static volatile sig_atomic_t watch_stop = 0;
 
-                        if (op->terse) {
-                            nv_msg("  ", "%s: %s", a->name, tmp_str);
-                        } else {
-                            nv_msg("  ",  "Attribute '%s' (%s%s): %s ",
-                                   a->name, t->name, "", tmp_str);
-                        }
-                        free(tmp_str);
-                        tmp_str = NULL;
+static void watch_signal_handler(int sig)
+{
+    watch_stop = 1;
+}
 
-                    } else {
 
-                        status = NvCtrlGetValidDisplayAttributeValues(t,
-                                                                      mask,
-                                                                      a->attr,
-                                                                      &valid);
 
-                        if (status == NvCtrlAttributeNotAvailable) {
-                            goto exit_bit_loop;
-                        }
+/*
+ * nv_watch_add_query() - parse the query string 'query', resolve its targets
+ * and append one WatchSample per target to 'samples'.  If 'optional' is
+ * set, an attribute that does not resolve to any target, or that is not
+ * available on a target, is silently skipped.
+ *
+ * If any errors are encountered, an error message is printed and
+ * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
+ */
 
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying valid values for "
-                                         "attribute '%s' on %s (%s).",
-                                         a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
+int nv_watch_add_query(const char *query, const char *display_name,
+                       CtrlSystemList *systems, Bool optional,
+                       WatchSample **samples, int *num_samples)
+{
+    ParsedAttribute p;
+    CtrlSystem *system;
+    CtrlTargetNode *n;
+    CtrlAttributeValidValues valid;
+    const AttributeTableEntry *a;
+    ReturnStatus status;
+    char *whence;
+    int ret, val = NV_FALSE;
 
-                        status = NvCtrlGetDisplayAttribute(t, mask, a->attr,
-                                                           &val);
+    ret = nv_parse_attribute_string(query, NV_PARSER_QUERY, &p);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        nv_error_msg("Error parsing query '%s' (%s).",
+                     query, nv_parse_strerror(ret));
+        return NV_FALSE;
+    }
 
-                        if (status == NvCtrlAttributeNotAvailable) {
-                            goto exit_bit_loop;
-                        }
+    whence = nvasprintf("in query '%s'", query);
+    a = p.attr_entry;
 
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying attribute '%s' "
-                                         "on %s (%s).", a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
+    if ((a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+        (a->type != CTRL_ATTRIBUTE_TYPE_STRING)) {
+        nv_error_msg("The attribute '%s' specified %s cannot be watched.",
+                     a->name, whence);
+        goto done;
+    }
 
-                        print_queried_value(op, t, &valid, val, a, mask,
-                                            INDENT, op->terse ?
-                                            VerboseLevelAbbreviated :
-                                            VerboseLevelVerbose);
+    nv_assign_default_display(&p, display_name);
 
-                    }
-                    print_valid_values(op, a, valid);
+    system = NvCtrlConnectToLimitedSystem(p.display, systems, TRUE);
+    if (!system) {
+        goto done;
+    }
 
-                    if (!op->terse) {
-                        nv_msg(NULL,"");
-                    }
+    ret = resolve_attribute_targets(&p, system, whence);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        if (optional) {
+            val = NV_TRUE;
+            goto done;
+        }
+        nv_error_msg("Error resolving target specification '%s' "
+                     "(%s), specified %s.",
+                     p.target_specification ? p.target_specification : "",
+                     nv_parse_strerror(ret),
+                     whence);
+        goto done;
+    }
 
-                    if ((valid.permissions.valid_targets &
-                         CTRL_TARGET_PERM_BIT(DISPLAY_TARGET)) &&
-                        target_type != DISPLAY_TARGET) {
-                        continue;
-                    }
+    for (n = p.targets; n; n = n->next) {
+        CtrlTarget *t = n->t;
+        WatchSample *s;
+        uint32 mask;
 
-                    /* fall through to exit_bit_loop */
+        if (!t->h) continue; /* no handle on this target; silently skip */
 
-exit_bit_loop:
+        mask = parsed_attribute_display_mask(&p);
 
-                    break; /* XXX force us out of the display device loop */
+        status = get_valid_attribute_values(t, a, mask, &valid);
 
-                } /* bit */
+        if (status != NvCtrlSuccess) {
+            if (!optional) {
+                nv_warning_msg("Attribute '%s' specified %s is not "
+                               "available on %s.", a->name, whence, t->name);
+            }
+            continue;
+        }
 
-            } /* entry */
+        *samples = nvrealloc(*samples,
+                             sizeof(WatchSample) * (*num_samples + 1));
+        s = &(*samples)[*num_samples];
+        memset(s, 0, sizeof(WatchSample));
 
-        } /* j (targets) */
+        s->t = t;
+        s->a = a;
+        s->mask = mask;
+        s->valid = valid;
 
-    } /* target_type */
+        (*num_samples)++;
+    }
 
-#undef INDENT
+    val = NV_TRUE;
 
-    return NV_TRUE;
+ done:
+    nv_parsed_attribute_clean(&p);
+    nvfree(whence);
 
-} /* query_all() */
+    return val;
+
+} /* nv_watch_add_query() */
 
 
 
 /*
- * get_product_name() Returns the (GPU, X screen, display device)
- * product name of the given target.
+ * nv_watch_sample() - re-query the value of the watched attribute 's'.
+ * Returns NV_TRUE if a value was read that differs from the value read by
+ * the previous sample (or if there was no previous value).
  */
 
-static char *get_product_name(CtrlTarget *ctrl_target, int attr)
+Bool nv_watch_sample(WatchSample *s)
 {
-    char *product_name = NULL;
     ReturnStatus status;
+    Bool changed = NV_FALSE;
 
-    status = NvCtrlGetStringAttribute(ctrl_target, attr, &product_name);
+    if (s->a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+        char *str = NULL;
 
-    if (status != NvCtrlSuccess) {
-        return strdup("Unknown");
+        status = NvCtrlGetStringDisplayAttribute(s->t, s->mask, s->a->attr,
+                                                 &str);
+        if (status == NvCtrlSuccess) {
+            changed = !s->have_value || !s->str || !str ||
+                      (strcmp(s->str, str) != 0);
+            free(s->str);
+            s->str = str;
+        }
+    } else {
+        int val;
+
+        status = NvCtrlGetDisplayAttribute(s->t, s->mask, s->a->attr, &val);
+        if (status == NvCtrlSuccess) {
+            changed = !s->have_value || (s->val != val);
+            s->val = val;
+        }
+    }
+
+    if (status != NvCtrlSuccess) {
+        /* only report the first of consecutive failures */
+        if (!s->failed) {
+            nv_warning_msg("Error querying attribute '%s' on %s (%s).",
+                           s->a->name, s->t->name,
+                           NvCtrlAttributesStrError(status));
+        }
+        s->failed = NV_TRUE;
+        s->have_value = NV_FALSE;
+        return NV_FALSE;
+    }
+
+    s->failed = NV_FALSE;
+    s->have_value = NV_TRUE;
+
+    return changed;
+
+} /* nv_watch_sample() */
+
+
+
+/*
+ * nv_watch_timer_start() - start taking samples every 'interval' seconds,
+ * until SIGINT or SIGTERM is received.
+ */
+
+void nv_watch_timer_start(WatchTimer *timer, double interval)
+{
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &timer->old_int);
+    sigaction(SIGTERM, &sa, &timer->old_term);
+
+    watch_stop = 0;
+
+    timer->interval_ns = (int64_t) (interval * 1000000000.0);
+    if (timer->interval_ns < 1) {
+        timer->interval_ns = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &timer->start);
+    timer->tick = 0;
+}
+
+
+
+/*
+ * nv_watch_timer_wait() - sleep until the next sample time of 'timer', or
+ * until SIGINT or SIGTERM is received.  Returns NV_FALSE in the latter
+ * case, after which no more samples should be taken.
+ *
+ * The sample time is computed from the start time and the sample number
+ * rather than by adding the interval to the time the previous sample
+ * finished, so that the time spent querying does not accumulate as
+ * drift.  Sample times that have already passed are skipped.
+ */
+
+Bool nv_watch_timer_wait(WatchTimer *timer)
+{
+    struct timespec now, next;
+    int64_t elapsed_ns, offset_ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_ns = (int64_t) (now.tv_sec - timer->start.tv_sec) * 1000000000 +
+                 (now.tv_nsec - timer->start.tv_nsec);
+    timer->tick = NV_MAX(timer->tick + 1,
+                         elapsed_ns / timer->interval_ns + 1);
+
+    offset_ns = timer->start.tv_nsec + timer->tick * timer->interval_ns;
+    next.tv_sec = timer->start.tv_sec + offset_ns / 1000000000;
+    next.tv_nsec = offset_ns % 1000000000;
+
+    /* an interrupted sleep returns early; loop to re-check watch_stop */
+
+    while (!watch_stop &&
+           clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                           &next, NULL) == EINTR) {
+    }
+
+    return !watch_stop;
+}
+
+
+
+/*
+ * nv_watch_timer_stop() - restore the SIGINT and SIGTERM handlers
+ * replaced by nv_watch_timer_start().
+ */
+
+void nv_watch_timer_stop(WatchTimer *timer)
+{
+    sigaction(SIGINT, &timer->old_int, NULL);
+    sigaction(SIGTERM, &timer->old_term, NULL);
+}
+
+
+
+/*
+ * nv_print_csv_string() - print 'str' as a quoted CSV field.
+ */
+
+void nv_print_csv_string(const char *str)
+{
+    fputc('"', stdout);
+
+    for (; str && *str; str++) {
+        if (*str == '"') {
+            fputc('"', stdout);
+        }
+        fputc(*str, stdout);
+    }
+
+    fputc('"', stdout);
+}
+
+
+
+/*
+ * watch_print_sample() - print the last value read for 's', sampled at
+ * wall clock time 'when', in the requested output format.
+ */
+
+static void watch_print_sample(const Options *op, WatchSample *s,
+                               const struct timespec *when)
+{
+    char d_str[64], val_str[64], time_str[32], *tmp_d_str;
+    Bool display_specific;
+    struct tm tm;
+    json_t *record;
+
+    display_specific =
+        (NvCtrlGetTargetType(s->t) != DISPLAY_TARGET) &&
+        (s->valid.permissions.valid_targets &
+         CTRL_TARGET_PERM_BIT(DISPLAY_TARGET));
+
+    switch (op->output_format) {
+
+    case OUTPUT_FORMAT_JSON:
+    case OUTPUT_FORMAT_NDJSON:
+        record = json_attribute_value_record(s->t, s->a, s->mask, &s->valid,
+                                             s->val, s->str);
+        json_object_set_new(record, "time",
+                            json_real(when->tv_sec +
+                                      when->tv_nsec / 1000000000.0));
+        nv_json_output_record(op, record);
+        break;
+
+    case OUTPUT_FORMAT_CSV:
+        printf("%lld.%03ld,", (long long) when->tv_sec,
+               when->tv_nsec / 1000000);
+        nv_print_csv_string(s->t->name);
+        printf(",%s,", s->a->name);
+        if (display_specific) {
+            printf("%u", s->mask);
+        }
+        fputc(',', stdout);
+        if (s->a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+            nv_print_csv_string(s->str);
+        } else {
+            printf("%d", s->val);
+        }
+        fputc('\n', stdout);
+        break;
+
+    case OUTPUT_FORMAT_TEXT:
+        if (s->a->type != CTRL_ATTRIBUTE_TYPE_STRING) {
+            format_queried_value(op, s->t, &s->valid, s->val, s->a,
+                                 val_str, sizeof(val_str));
+        }
+
+        if (op->terse) {
+            nv_msg(NULL, "%s", s->a->type == CTRL_ATTRIBUTE_TYPE_STRING ?
+                   (s->str ? s->str : "") : val_str);
+            break;
+        }
+
+        if (display_specific) {
+            tmp_d_str = display_device_mask_to_display_device_name(s->mask);
+            snprintf(d_str, sizeof(d_str), ", display device: %s", tmp_d_str);
+            free(tmp_d_str);
+        } else {
+            d_str[0] = '\0';
+        }
+
+        localtime_r(&when->tv_sec, &tm);
+        strftime(time_str, sizeof(time_str), "%H:%M:%S", &tm);
+
+        nv_msg("  ", "%s.%03ld  Attribute '%s' (%s%s): %s", time_str,
+               when->tv_nsec / 1000000, s->a->name, s->t->name, d_str,
+               s->a->type == CTRL_ATTRIBUTE_TYPE_STRING ?
+               (s->str ? s->str : "") : val_str);
+        break;
+    }
+
+} /* watch_print_sample() */
+
+
+
+/*
+ * watch_attribute_queries() - resolve the list of queries once, then
+ * sample and print their values every op->watch_interval seconds until
+ * SIGINT or SIGTERM is received.  Samples that could not be taken in time
+ * because querying took longer than the interval are skipped.
+ *
+ * If any errors are encountered while resolving the queries, an error
+ * message is printed and NV_FALSE is returned.  Otherwise, NV_TRUE is
+ * returned.
+ */
+
+static int watch_attribute_queries(const Options *op,
+                                   int num, char **queries,
+                                   const char *display_name,
+                                   CtrlSystemList *systems)
+{
+    WatchSample *samples = NULL;
+    int num_samples = 0;
+    WatchTimer timer;
+    struct timespec when;
+    int query, i, val = NV_FALSE;
+
+    for (query = 0; query < num; query++) {
+        if (!nv_watch_add_query(queries[query], display_name, systems,
+                                NV_FALSE, &samples, &num_samples)) {
+            goto done;
+        }
+    }
+
+    if (num_samples == 0) {
+        nv_error_msg("None of the queried attributes can be watched.");
+        goto done;
+    }
+
+    if (op->output_format == OUTPUT_FORMAT_CSV) {
+        printf("time,target,attribute,display_mask,value\n");
+    } else if (op->output_format != OUTPUT_FORMAT_TEXT) {
+        nv_json_output_begin(op);
+    }
+
+    nv_watch_timer_start(&timer, op->watch_interval);
+
+    do {
+        clock_gettime(CLOCK_REALTIME, &when);
+
+        for (i = 0; i < num_samples; i++) {
+            if (nv_watch_sample(&samples[i]) || (!op->watch_changes &&
+                                              samples[i].have_value)) {
+                watch_print_sample(op, &samples[i], &when);
+            }
+        }
+
+        fflush(stdout);
+    } while (nv_watch_timer_wait(&timer));
+
+    nv_watch_timer_stop(&timer);
+
+    if (op->output_format == OUTPUT_FORMAT_JSON ||
+        op->output_format == OUTPUT_FORMAT_NDJSON) {
+        nv_json_output_end(op);
+    }
+
+    val = NV_TRUE;
+
+ done:
+    for (i = 0; i < num_samples; i++) {
+        free(samples[i].str);
+    }
+    nvfree(samples);
+
+    return val;
+
+} /* watch_attribute_queries() */
+
+
+
+/*
+ * print_additional_stereo_info() - print the available stereo modes
+ */
+
+static void print_additional_stereo_info(const char *name,
+                                         unsigned int valid_stereo_modes,
+                                         const char *indent)
+{
+    int bit;
+
+    nv_msg(indent, "\n");
+    nv_msg(indent, "Valid '%s' Values\n", name);
+    nv_msg(indent, "  value - description\n");
+
+    for (bit = 0; bit < 32; bit++) {
+        if (valid_stereo_modes & (1 << bit)) {
+            nv_msg(indent, "   %2u   -   %s\n", 
+                   bit, NvCtrlGetStereoModeName(bit));
+        }
+    }
+}
+
+
+/*
+ * print_additional_fsaa_info() - print the currently available fsaa
+ * modes with their corresponding names
+ */
+
+static void print_additional_fsaa_info(const char *name,
+                                       unsigned int valid_fsaa_modes,
+                                       const char *indent)
+{
+    int bit;
+
+    nv_msg(indent, "\n");
+    nv_msg(indent, "Note to assign 'FSAA' on the commandline, you may also "
+           "need to assign\n");
+    nv_msg(indent, "'FSAAAppControlled' and 'FSAAAppEnhanced' to 0.\n");
+    nv_msg(indent, "\n");
+    nv_msg(indent, "Valid '%s' Values\n", name);
+    nv_msg(indent, "  value - description\n");
+
+    for (bit = 0; bit < 32; bit++) {
+        /* FSAA is not a packed attribute */
+        if (valid_fsaa_modes & (1 << bit)) {
+            nv_msg(indent, "   %2u   -   %s\n", 
+                   bit, NvCtrlGetMultisampleModeName(bit));
+        }
+    }
+}
+
+
+
+/*
+ * print_additional_info() - after printing the main information about
+ * a queried attribute, we may want to add some more when in verbose mode.
+ * This function is designed to handle this. Add a new 'case' here when
+ * you want to print this additional information for a specific attr.
+ */
+
+static void print_additional_info(const char *name,
+                                  int attr,
+                                  CtrlAttributeValidValues valid,
+                                  const char *indent)
+{
+    switch (attr) {
+
+    case NV_CTRL_FSAA_MODE:
+        print_additional_fsaa_info(name, valid.allowed_ints, indent);
+        break;
+
+    case NV_CTRL_STEREO:
+        if (valid.valid_type == CTRL_ATTRIBUTE_VALID_TYPE_INT_BITS) {
+            print_additional_stereo_info(name, valid.allowed_ints, indent);
+        }
+        break;
+
+    // add more here
+
+    }
+
+}
+
+
+
+/*
+ * run_parallel() - call func() on each of the given items, using up to 'jobs'
+ * threads (the calling thread included).  Returns once all items have been
+ * processed.  If threads cannot be created, the remaining work is done by
+ * the calling thread.
+ */
+
+typedef struct {
+    pthread_mutex_t lock;
+    void (*func)(void *);
+    void **items;
+    int count;
+    int next;
+} WorkQueue;
+
+static void *work_queue_thread(void *data)
+{
+    WorkQueue *queue = data;
+
+    while (1) {
+        int i;
+
+        pthread_mutex_lock(&queue->lock);
+        i = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (i >= queue->count) {
+            break;
+        }
+
+        queue->func(queue->items[i]);
+    }
+
+    return NULL;
+}
+
+static void run_parallel(int jobs, void (*func)(void *),
+                         void **items, int count)
+{
+    WorkQueue queue;
+    pthread_t *threads;
+    int i, num_threads = 0;
+
+    if (jobs > count) {
+        jobs = count;
+    }
+
+    if (jobs <= 1) {
+        for (i = 0; i < count; i++) {
+            func(items[i]);
+        }
+        return;
+    }
+
+    pthread_mutex_init(&queue.lock, NULL);
+    queue.func = func;
+    queue.items = items;
+    queue.count = count;
+    queue.next = 0;
+
+    threads = nvalloc(sizeof(pthread_t) * (jobs - 1));
+
+    for (i = 0; i < jobs - 1; i++) {
+        if (pthread_create(&threads[num_threads], NULL,
+                           work_queue_thread, &queue) == 0) {
+            num_threads++;
+        }
+    }
+
+    work_queue_thread(&queue);
+
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    nvfree(threads);
+    pthread_mutex_destroy(&queue.lock);
+
+} /* run_parallel() */
+
+
+
+/*
+ * Returns whether queries of the given target are answered by NVML (or
+ * fall back to NV-CONTROL), and can therefore be spread over worker
+ * threads.
+ */
+
+static Bool is_nvml_target_type(int target_type)
+{
+    return (target_type == GPU_TARGET) ||
+           (target_type == THERMAL_SENSOR_TARGET) ||
+           (target_type == COOLER_TARGET);
+}
+
+
+
+/*
+ * Values and valid values of an integer attribute, prefetched by
+ * prefetch_int_attributes(); queried is FALSE for the attributes that were
+ * not part of the batch.
+ */
+
+typedef struct {
+    Bool queried;
+    CtrlAttributeValidQuery valid;
+    CtrlAttributeQuery value;
+} QueryAllPrefetch;
+
+
+
+/*
+ * prefetch_int_attributes() - query, as two batches, the valid values and
+ * the value of every integer attribute that query_all() would report for
+ * the given target and display mask.  The returned array is indexed like
+ * attributeTable[].  The caller is responsible for freeing the array.
+ */
+
+static QueryAllPrefetch *prefetch_int_attributes(const CtrlTarget *t,
+                                                 uint32 mask)
+{
+    QueryAllPrefetch *prefetched;
+    CtrlAttributeValidQuery *valid_batch;
+    CtrlAttributeQuery *batch;
+    int *indices;
+    int entry, i, n = 0;
+
+    prefetched = nvalloc(sizeof(*prefetched) * attributeTableLen);
+    valid_batch = nvalloc(sizeof(*valid_batch) * attributeTableLen);
+    batch = nvalloc(sizeof(*batch) * attributeTableLen);
+    indices = nvalloc(sizeof(*indices) * attributeTableLen);
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        const AttributeTableEntry *a = &attributeTable[entry];
+
+        if ((a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) ||
+            a->flags.no_query_all) {
+            continue;
+        }
+
+        valid_batch[n].display_mask = mask;
+        valid_batch[n].attr = a->attr;
+        batch[n].display_mask = mask;
+        batch[n].attr = a->attr;
+        indices[n++] = entry;
+    }
+
+    NvCtrlGetValidDisplayAttributeValuesBatch(t, valid_batch, n);
+    NvCtrlGetDisplayAttributes(t, batch, n);
+
+    for (i = 0; i < n; i++) {
+        QueryAllPrefetch *p = &prefetched[indices[i]];
+
+        p->queried = TRUE;
+        p->valid = valid_batch[i];
+        p->value = batch[i];
+    }
+
+    nvfree(indices);
+    nvfree(batch);
+    nvfree(valid_batch);
+
+    return prefetched;
+
+} /* prefetch_int_attributes() */
+
+
+
+/*
+ * Results of the queries made by query_all() for a single target: one
+ * QueryAllResult is recorded per attribute and display device queried, in
+ * the order they are printed.
+ */
+
+typedef struct {
+    int entry;                      /* index into attributeTable[] */
+    uint32 mask;
+    ReturnStatus valid_status;
+    CtrlAttributeValidValues valid;
+    ReturnStatus status;
+    int val;
+    char *str;
+} QueryAllResult;
+
+typedef struct {
+    CtrlTarget *t;
+    int target_type;
+    QueryAllResult *results;
+    int num_results;
+} QueryAllTarget;
+
+
+
+/*
+ * query_all_fetch_target() - query all attributes of the target; the
+ * results are printed by query_all_print_target().  This does not print
+ * anything, so that several targets can be queried in parallel.
+ */
+
+static void query_all_fetch_target(void *data)
+{
+    QueryAllTarget *qt = data;
+    CtrlTarget *t = qt->t;
+    const CtrlTargetTypeInfo *targetTypeInfo =
+        NvCtrlGetTargetTypeInfo(qt->target_type);
+    QueryAllPrefetch *prefetched;
+    uint32 first_mask = 1;
+    uint32 mask;
+    int bit, entry, max_results = 0;
+
+    /*
+     * Batch the integer queries, valid values included, for the first
+     * display device bit visited below, which is the only one for most
+     * attributes.
+     */
+
+    if (targetTypeInfo->uses_display_devices && t->d) {
+        first_mask = t->d & ~(t->d - 1);
+    }
+
+    prefetched = prefetch_int_attributes(t, first_mask);
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        const AttributeTableEntry *a = &attributeTable[entry];
+
+        /* skip the color attributes */
+
+        if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
+            continue;
+        }
+
+        /* skip attributes that shouldn't be queried here */
+
+        if (a->flags.no_query_all) {
+            continue;
+        }
+
+        for (bit = 0; bit < 24; bit++) {
+            QueryAllResult *r;
+
+            mask = 1 << bit;
+
+            /*
+             * if this bit is not present in the screens's enabled
+             * display device mask (and the X screen has enabled
+             * display devices), skip to the next bit
+             */
+
+            if (targetTypeInfo->uses_display_devices &&
+                ((t->d & mask) == 0x0) && (t->d)) continue;
+
+            if (qt->num_results == max_results) {
+                max_results = max_results ? max_results * 2 : 64;
+                qt->results = nvrealloc(qt->results,
+                                        sizeof(*qt->results) * max_results);
+            }
+
+            r = &qt->results[qt->num_results++];
+            memset(r, 0, sizeof(*r));
+            r->entry = entry;
+            r->mask = mask;
+
+            if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+
+                r->valid_status =
+                    NvCtrlGetValidStringDisplayAttributeValues(t, mask,
+                                                               a->attr,
+                                                               &r->valid);
+                if (r->valid_status != NvCtrlSuccess &&
+                    r->valid_status != NvCtrlMissingExtension) {
+                    break;
+                }
+
+                r->status = NvCtrlGetStringDisplayAttribute(t, mask, a->attr,
+                                                            &r->str);
+            } else if ((mask == first_mask) && prefetched[entry].queried) {
+
+                const QueryAllPrefetch *p = &prefetched[entry];
+
+                r->valid_status = p->valid.status;
+                r->valid = p->valid.valid;
+                if (r->valid_status != NvCtrlSuccess) {
+                    break;
+                }
+
+                r->status = p->value.status;
+                r->val = p->value.val;
+            } else {
+
+                r->valid_status =
+                    NvCtrlGetValidDisplayAttributeValues(t, mask, a->attr,
+                                                         &r->valid);
+                if (r->valid_status != NvCtrlSuccess) {
+                    break;
+                }
+
+                r->status = NvCtrlGetDisplayAttribute(t, mask, a->attr,
+                                                      &r->val);
+            }
+
+            if (r->status != NvCtrlSuccess) {
+                break;
+            }
+
+            if (!(r->valid.permissions.valid_targets &
+                  CTRL_TARGET_PERM_BIT(DISPLAY_TARGET)) ||
+                qt->target_type == DISPLAY_TARGET) {
+                break; /* XXX force us out of the display device loop */
+            }
+
+        } /* bit */
+
+    } /* entry */
+
+    nvfree(prefetched);
+
+} /* query_all_fetch_target() */
+
+
+
+/*
+ * query_all_print_target() - print, and free, the results gathered by
+ * query_all_fetch_target().
+ */
+
+static void query_all_print_target(const Options *op, QueryAllTarget *qt)
+{
+    CtrlTarget *t = qt->t;
+    int i;
+
+#define INDENT "  "
+
+    if (op->output_format == OUTPUT_FORMAT_TEXT) {
+        nv_msg(NULL, "Attributes queryable via %s:", t->name);
+
+        if (!op->terse) {
+            nv_msg(NULL, "");
+        }
+    }
+
+    for (i = 0; i < qt->num_results; i++) {
+        QueryAllResult *r = &qt->results[i];
+        const AttributeTableEntry *a = &attributeTable[r->entry];
+
+        if (r->valid_status == NvCtrlAttributeNotAvailable) {
+            continue;
+        }
+
+        if (r->valid_status != NvCtrlSuccess &&
+            (a->type != CTRL_ATTRIBUTE_TYPE_STRING ||
+             r->valid_status != NvCtrlMissingExtension)) {
+            nv_error_msg("Error while querying valid values for "
+                         "attribute '%s' on %s (%s).",
+                         a->name, t->name,
+                         NvCtrlAttributesStrError(r->valid_status));
+            continue;
+        }
+
+        if (r->status == NvCtrlAttributeNotAvailable) {
+            continue;
+        }
+
+        if (r->status != NvCtrlSuccess) {
+            nv_error_msg("Error while querying attribute '%s' "
+                         "on %s (%s).", a->name, t->name,
+                         NvCtrlAttributesStrError(r->status));
+            continue;
+        }
+
+        if (op->output_format != OUTPUT_FORMAT_TEXT) {
+            nv_json_output_record(op,
+                                  json_attribute_record(t, a, r->mask,
+                                                        &r->valid, r->val,
+                                                        r->str));
+            continue;
+        }
+
+        if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+            if (op->terse) {
+                nv_msg("  ", "%s: %s", a->name, r->str);
+            } else {
+                nv_msg("  ",  "Attribute '%s' (%s%s): %s ",
+                       a->name, t->name, "", r->str);
+            }
+        } else {
+            print_queried_value(op, t, &r->valid, r->val, a, r->mask,
+                                INDENT, op->terse ?
+                                VerboseLevelAbbreviated :
+                                VerboseLevelVerbose);
+        }
+
+        print_valid_values(op, a, r->valid);
+
+        if (!op->terse) {
+            nv_msg(NULL,"");
+        }
+    }
+
+#undef INDENT
+
+    for (i = 0; i < qt->num_results; i++) {
+        free(qt->results[i].str);
+    }
+    nvfree(qt->results);
+    qt->results = NULL;
+    qt->num_results = 0;
+
+} /* query_all_print_target() */
+
+
+
+/*
+ * query_all() - loop through all target types, and query all attributes
+ * for those targets.  The current attribute values for all display
+ * devices on all targets are printed, along with the valid values for
+ * each attribute.
+ *
+ * With op->jobs > 1, the NVML-backed targets are queried in parallel
+ * before anything is printed; the output is the same in either case.
+ *
+ * If an error occurs, an error message is printed and NV_FALSE is
+ * returned; if successful, NV_TRUE is returned.
+ */
+
+static int query_all(const Options *op, const char *display_name,
+                     CtrlSystemList *systems)
+{
+    int target_type, i, count, num_parallel;
+    QueryAllTarget *targets;
+    void **parallel;
+    CtrlSystem *system;
+
+    system = NvCtrlConnectToLimitedSystem(display_name, systems, TRUE);
+    if (!system) {
+        return NV_FALSE;
+    }
+
+    /*
+     * Gather all targets of all target types, in the order they are
+     * printed.
+     */
+
+    count = 0;
+    for (target_type = 0; target_type < MAX_TARGET_TYPES; target_type++) {
+        CtrlTargetNode *node;
+        for (node = system->targets[target_type]; node; node = node->next) {
+            if (node->t->h) {
+                count++;
+            }
+        }
+    }
+
+    targets = nvalloc(sizeof(*targets) * (count + 1));
+    parallel = nvalloc(sizeof(*parallel) * (count + 1));
+
+    count = num_parallel = 0;
+    for (target_type = 0; target_type < MAX_TARGET_TYPES; target_type++) {
+        CtrlTargetNode *node;
+        for (node = system->targets[target_type]; node; node = node->next) {
+            if (!node->t->h) continue;
+
+            targets[count].t = node->t;
+            targets[count].target_type = target_type;
+
+            if ((op->jobs > 1) && is_nvml_target_type(target_type)) {
+                parallel[num_parallel++] = &targets[count];
+            }
+            count++;
+        }
+    }
+
+    /*
+     * Query the NVML-backed targets on worker threads first; the
+     * attribute table index is built lazily, so make sure it exists
+     * before the workers look attributes up.
+     */
+
+    if (num_parallel > 0) {
+        nv_build_attribute_table_index();
+        run_parallel(op->jobs, query_all_fetch_target, parallel, num_parallel);
+    }
+
+    for (i = 0; i < count; i++) {
+        if ((op->jobs <= 1) || !is_nvml_target_type(targets[i].target_type)) {
+            query_all_fetch_target(&targets[i]);
+        }
+        query_all_print_target(op, &targets[i]);
+    }
+
+    nvfree(parallel);
+    nvfree(targets);
+
+    return NV_TRUE;
+
+} /* query_all() */
+
+
+
+/*
+ * get_product_name() Returns the (GPU, X screen, display device)
+ * product name of the given target.
+ */
+
+static char *get_product_name(CtrlTarget *ctrl_target, int attr)
+{
+    char *product_name = NULL;
+    ReturnStatus status;
+
+    status = NvCtrlGetStringAttribute(ctrl_target, attr, &product_name);
+
+    if (status != NvCtrlSuccess) {
+        return strdup("Unknown");
     }
 
     return product_name;
@@ -1729,19 +2747,42 @@ static int print_target_connections(CtrlTarget *t,
 
 
 
+/*
+ * query_target_product_name() - run_parallel() callback that queries the
+ * product name of a target.
+ */
+
+typedef struct {
+    CtrlTarget *t;
+    char *product_name;
+} TargetProductName;
+
+static void query_target_product_name(void *data)
+{
+    TargetProductName *tpn = data;
+
+    tpn->product_name = get_product_name(tpn->t, NV_CTRL_STRING_PRODUCT_NAME);
+}
+
+
+
 /*
  * query_all_targets() - print a list of all the targets (of the
  * specified type) accessible via the Display connection.
+ *
+ * With op->jobs > 1, the product names of NVML-backed targets are queried
+ * in parallel before the list is printed.
  */
 
-static int query_all_targets(const char *display_name, const int target_type,
-                             CtrlSystemList *systems)
+static int query_all_targets(const Options *op, const char *display_name,
+                             const int target_type, CtrlSystemList *systems)
 {
     CtrlSystem *system;
     CtrlTargetNode *node;
     CtrlTarget *t;
     char *str, *name;
     const CtrlTargetTypeInfo *targetTypeInfo;
+    TargetProductName *product_names = NULL;
     int target_count;
     int idx;
 
@@ -1773,15 +2814,38 @@ static int query_all_targets(const char *display_name, const int target_type,
     /* print how many of the target type we have */
 
     target_count = NvCtrlGetTargetTypeCount(system, target_type);
-    nv_msg(NULL, "%d %s%s on %s",
-           target_count,
-           targetTypeInfo->name,
-           (target_count > 1) ? "s" : "",
-           str);
-    nv_msg(NULL, "");
+    if (op->output_format == OUTPUT_FORMAT_TEXT) {
+        nv_msg(NULL, "%d %s%s on %s",
+               target_count,
+               targetTypeInfo->name,
+               (target_count > 1) ? "s" : "",
+               str);
+        nv_msg(NULL, "");
+    }
 
     free(str);
 
+    /* query the product names up front, if requested */
+
+    if ((op->jobs > 1) && (target_type == GPU_TARGET)) {
+        void **items;
+
+        product_names = nvalloc(sizeof(*product_names) * target_count);
+        items = nvalloc(sizeof(*items) * target_count);
+
+        for (node = system->targets[target_type], idx = 0;
+             node && idx < target_count;
+             node = node->next, idx++) {
+            product_names[idx].t = node->t;
+            items[idx] = &product_names[idx];
+        }
+
+        nv_build_attribute_table_index();
+        run_parallel(op->jobs, query_target_product_name, items, idx);
+
+        nvfree(items);
+    }
+
     /* print information per target */
 
     for (node = system->targets[target_type], idx = 0;
@@ -1812,7 +2876,13 @@ static int query_all_targets(const char *display_name, const int target_type,
             extra_str = get_display_state_str(t);
             break;
         default:
-            product_name = get_product_name(t, NV_CTRL_STRING_PRODUCT_NAME);
+            if (product_names && idx < target_count &&
+                product_names[idx].t == t) {
+                product_name = product_names[idx].product_name;
+            } else {
+                product_name = get_product_name(t,
+                                                NV_CTRL_STRING_PRODUCT_NAME);
+            }
             break;
         }
 
@@ -1828,6 +2898,34 @@ static int query_all_targets(const char *display_name, const int target_type,
             name = "Not NVIDIA";
         }
 
+        if (op->output_format != OUTPUT_FORMAT_TEXT) {
+            json_t *record = json_target_record(t);
+            json_t *names = json_array();
+            int i;
+
+            json_object_set_new(record, "target", json_string(name));
+            json_object_set_new(record, "product_name",
+                                json_string(product_name));
+            if (extra_str) {
+                json_object_set_new(record, "state", json_string(extra_str));
+            }
+            for (i = 0; i < NV_PROTO_NAME_MAX; i++) {
+                if (t->protoNames[i]) {
+                    json_array_append_new(names,
+                                          json_string(t->protoNames[i]));
+                }
+            }
+            json_object_set_new(record, "names", names);
+
+            nv_json_output_record(op, record);
+
+            if (product_name != buff) {
+                free(product_name);
+            }
+            nvfree(extra_str);
+            continue;
+        }
+
         nv_msg("    ", "[%d] %s (%s)%s%s%s",
                idx,
                name,
@@ -1937,6 +3035,8 @@ static int query_all_targets(const char *display_name, const int target_type,
         }
     }
 
+    nvfree(product_names);
+
     return NV_TRUE;
 
 } /* query_all_targets() */
@@ -2038,7 +3138,11 @@ static int process_parsed_attribute_internal(const Options *op,
                 return NV_FALSE;
             } else {
 
-                if (op->terse) {
+                if (op->output_format != OUTPUT_FORMAT_TEXT) {
+                    nv_json_output_record(op,
+                                          json_attribute_record(t, a, d, &valid,
+                                                                0, tmp_str));
+                } else if (op->terse) {
                     nv_msg(NULL, "%s", tmp_str);
                 } else {
                     nv_msg("  ",  "Attribute '%s' (%s%s): %s",
@@ -2061,6 +3165,10 @@ static int process_parsed_attribute_internal(const Options *op,
                              a->name, t->name, str, whence,
                              NvCtrlAttributesStrError(status));
                 return NV_FALSE;
+            } else if (op->output_format != OUTPUT_FORMAT_TEXT) {
+                nv_json_output_record(op,
+                                      json_attribute_record(t, a, d, &valid,
+                                                            p->val.i, NULL));
             } else {
                 print_queried_value(op, t, &valid, p->val.i, a, d,
                                     "  ", op->terse ?
@@ -2530,30 +3638,9 @@ int nv_process_parsed_attribute(const Options *op,
             continue;
         }
 
-        /*
-         * special case the display device mask in the case that it
-         * was "hijacked" for something other than a display device:
-         * assign mask here so that it will be passed through to
-         * process_parsed_attribute_internal() unfiltered
-         */
-
-        if (a->flags.hijack_display_device) {
-            mask = p->display_device_mask;
-        } else {
-            mask = 0;
-        }
+        mask = parsed_attribute_display_mask(p);
 
-        if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
-            status = NvCtrlGetValidStringDisplayAttributeValues(t,
-                                                                mask,
-                                                                a->attr,
-                                                                &valid);
-        } else {
-            status = NvCtrlGetValidDisplayAttributeValues(t,
-                                                          mask,
-                                                          a->attr,
-                                                          &valid);
-        }
+        status = get_valid_attribute_values(t, a, mask, &valid);
 
         if (status != NvCtrlSuccess) {
             if (status == NvCtrlAttributeNotAvailable) {
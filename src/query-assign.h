@@ -25,6 +25,12 @@
 #ifndef __QUERY_ASSIGN_H__
 #define __QUERY_ASSIGN_H__
 
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <jansson.h>
+
 #include "NvCtrlAttributes.h"
 
 #include "parse.h"
@@ -39,5 +45,46 @@ int nv_process_parsed_attribute(const Options *op,
                                 int, int, char*, ...) NV_ATTRIBUTE_PRINTF(6, 7);
 
 
+/*
+ * The --watch sampling loop and the machine-readable query output, which
+ * are shared with the other periodic command line modes (--serve and
+ * --framelock-status).
+ */
+
+typedef struct {
+    CtrlTarget *t;
+    const AttributeTableEntry *a;
+    uint32 mask;
+    CtrlAttributeValidValues valid;
+
+    Bool have_value;    /* the previous sample succeeded */
+    Bool failed;        /* the previous sample failed */
+    int val;
+    char *str;
+} WatchSample;
+
+typedef struct {
+    struct timespec start;
+    int64_t interval_ns;
+    int64_t tick;       /* number of the last sample time */
+    struct sigaction old_int;
+    struct sigaction old_term;
+} WatchTimer;
+
+int nv_watch_add_query(const char *query, const char *display_name,
+                       CtrlSystemList *systems, Bool optional,
+                       WatchSample **samples, int *num_samples);
+Bool nv_watch_sample(WatchSample *s);
+
+void nv_watch_timer_start(WatchTimer *timer, double interval);
+Bool nv_watch_timer_wait(WatchTimer *timer);
+void nv_watch_timer_stop(WatchTimer *timer);
+
+void nv_print_csv_string(const char *str);
+void nv_json_output_begin(const Options *op);
+void nv_json_output_end(const Options *op);
+void nv_json_output_record(const Options *op, json_t *record);
+
+
 
 #endif /* __QUERY_ASSIGN_H__ */
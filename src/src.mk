@@ -21,6 +21,8 @@ SRC_SRC += parse.c
 SRC_SRC += query-assign.c
 SRC_SRC += app-profiles.c
 SRC_SRC += glxinfo.c
+SRC_SRC += metrics-server.c
+SRC_SRC += framelock-monitor.c
 
 NVIDIA_SETTINGS_SRC += $(SRC_SRC)
 
@@ -33,6 +35,8 @@ SRC_EXTRA_DIST += parse.h
 SRC_EXTRA_DIST += query-assign.h
 SRC_EXTRA_DIST += app-profiles.h
 SRC_EXTRA_DIST += glxinfo.h
+SRC_EXTRA_DIST += metrics-server.h
+SRC_EXTRA_DIST += framelock-monitor.h
 SRC_EXTRA_DIST += gen-manpage-opts.c
 
 NVIDIA_SETTINGS_EXTRA_DIST += $(SRC_EXTRA_DIST)
@@ -95,6 +99,7 @@ LIB_XNVCTRL_ATTRIBUTES_SRC += libXNVCtrlAttributes/NvCtrlAttributesVulkan.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += libXNVCtrlAttributes/NvCtrlAttributesXrandr.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += libXNVCtrlAttributes/NvCtrlAttributesUtils.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += libXNVCtrlAttributes/NvCtrlAttributesNvml.c
+LIB_XNVCTRL_ATTRIBUTES_SRC += libXNVCtrlAttributes/NvCtrlAttributesCache.c
 
 NVIDIA_SETTINGS_SRC += $(LIB_XNVCTRL_ATTRIBUTES_SRC)
 
@@ -141,6 +146,7 @@ GTK_SRC += gtk+-2.x/ctkui.c
 GTK_SRC += gtk+-2.x/ctkframelock.c
 GTK_SRC += gtk+-2.x/ctkgauge.c
 GTK_SRC += gtk+-2.x/ctkcurve.c
+GTK_SRC += gtk+-2.x/ctkgraph.c
 GTK_SRC += gtk+-2.x/ctkcolorcorrection.c
 GTK_SRC += gtk+-2.x/ctkcolorcorrectionpage.c
 GTK_SRC += gtk+-2.x/ctkscale.c
@@ -188,6 +194,7 @@ GTK_EXTRA_DIST += gtk+-2.x/ctkui.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkframelock.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkgauge.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkcurve.h
+GTK_EXTRA_DIST += gtk+-2.x/ctkgraph.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkcolorcorrection.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkcolorcorrectionpage.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkscale.h